@@ -52,12 +52,20 @@ struct _Font {
 #ifdef USE_PANGO_RENDERING
 	PangoFontDescription	*pango;
 #else
-	cairo_font_face_t	*cairofnt;
-	cairo_t			*cairo;
+	cairo_font_face_t	*cairofnt;		/* shared, see gdip_get_cairo_font_face */
 #endif
 };
 
+void gdip_fontconfig_warm (void) GDIP_INTERNAL;
+void gdip_fontconfig_fini (void) GDIP_INTERNAL;
 void gdip_font_clear_pattern_cache (void) GDIP_INTERNAL;
+void gdip_font_clear_metrics_cache (void) GDIP_INTERNAL;
+void gdip_font_clear_memory_fonts (void) GDIP_INTERNAL;
+void gdip_font_purge_metrics_cache (const char *tag) GDIP_INTERNAL;
+
+FT_Face gdip_family_memory_face (GpFontFamily *family, int style) GDIP_INTERNAL;
+char* gdip_font_face_key (GpFontFamily *family, const char *face, int style) GDIP_INTERNAL;
+BOOL gdip_font_key_has_tag (const char *key, const char *tag) GDIP_INTERNAL;
 
 #ifdef USE_PANGO_RENDERING
 
@@ -66,6 +74,8 @@ PangoFontDescription* gdip_get_pango_font_description (GpFont *font);
 #else
 
 cairo_font_face_t* gdip_get_cairo_font_face (GpFont *font);
+void gdip_font_clear_face_cache (void) GDIP_INTERNAL;
+void gdip_font_purge_face_cache (const char *tag) GDIP_INTERNAL;
 
 #endif
 
@@ -30,6 +30,8 @@
 #include "fontcollection-private.h"
 #include "fontfamily-private.h"
 #include "graphics-private.h"
+#include "glyph-cache.h"
+#include <fontconfig/fcfreetype.h>
 
 /* Generic fonts families */
 static GStaticMutex generic = G_STATIC_MUTEX_INIT;
@@ -48,35 +50,49 @@ gdip_createFontFamily (GpFontFamily **family)
 {
 	GpFontFamily *result = (GpFontFamily *) GdipAlloc (sizeof (GpFontFamily));
 	if (result) {
-		result->height = -1;
-		result->linespacing = -1;
-		result->celldescent = -1;
-		result->cellascent = -1;
+		result->has_metrics = 0;
 		result->pattern = NULL;
 		result->allocated = FALSE;
+		result->collection = NULL;
 	}
 	*family = result;
 }
 
+/*
+ * fontconfig is initialized on first font use, not by GdiplusStartup, since loading its
+ * configuration and caches is slow on hosts with many fonts and many processes never draw text
+ */
+static GStaticMutex fontconfig_mutex = G_STATIC_MUTEX_INIT;
+static BOOL fontconfig_ready = FALSE;
+static BOOL fontconfig_warming = FALSE;
+static pthread_t fontconfig_warm_thread;
+
+static GStaticMutex system_fonts_mutex = G_STATIC_MUTEX_INIT;
 static GpFontCollection *system_fonts = NULL;
+static BOOL system_fonts_listed = FALSE;
 
-// coverity[+alloc : arg-*0]
-GpStatus
-GdipNewInstalledFontCollection (GpFontCollection **font_collection)
-{	
-	if (!font_collection)
-		return InvalidParameter;
+static void
+gdip_fontconfig_init (void)
+{
+	g_static_mutex_lock (&fontconfig_mutex);
+	if (!fontconfig_ready) {
+		FcInit ();
+		fontconfig_ready = TRUE;
+	}
+	g_static_mutex_unlock (&fontconfig_mutex);
+}
 
-	/*
-	 * Ensure we leak this data only a single time, because:
-	 * (a) there is no API to free it;
-	 * (b) other libgdiplus structures depends on that allocated data;
-	 */
-	if (!system_fonts) {
+/* the installed collection lists its (scalable) families on first use */
+static void
+gdip_createSystemFontSet (GpFontCollection *font_collection)
+{
+	g_static_mutex_lock (&system_fonts_mutex);
+	if (!system_fonts_listed) {
 		FcObjectSet *os = FcObjectSetBuild (FC_FAMILY, FC_FOUNDRY, NULL);
 		FcPattern *pat = FcPatternCreate ();
 		FcValue val;
-		FcFontSet *col;
+
+		gdip_fontconfig_init ();
 
 		/* Only Scalable fonts for now */
 		val.type = FcTypeBool;
@@ -84,21 +100,84 @@ GdipNewInstalledFontCollection (GpFontCollection **font_collection)
 		FcPatternAdd (pat, FC_SCALABLE, val, TRUE);
 		FcObjectSetAdd (os, FC_SCALABLE);
 
-		col = FcFontList (0, pat, os);
+		font_collection->fontset = FcFontList (0, pat, os);
 		FcPatternDestroy (pat);
 		FcObjectSetDestroy (os);
-    
+		system_fonts_listed = TRUE;
+	}
+	g_static_mutex_unlock (&system_fonts_mutex);
+}
+
+// coverity[+alloc : arg-*0]
+GpStatus
+GdipNewInstalledFontCollection (GpFontCollection **font_collection)
+{	
+	if (!font_collection)
+		return InvalidParameter;
+
+	/*
+	 * Ensure we leak this data only a single time, because:
+	 * (a) there is no API to free it;
+	 * (b) other libgdiplus structures depends on that allocated data;
+	 */
+	g_static_mutex_lock (&system_fonts_mutex);
+	if (!system_fonts) {
 		system_fonts = (GpFontCollection *) GdipAlloc (sizeof (GpFontCollection));
 		if (system_fonts) {
-			system_fonts->fontset = col;
+			system_fonts->fontset = NULL;
 			system_fonts->config = NULL;
+			system_fonts->memory_fonts = NULL;
 		}
 	}
+	g_static_mutex_unlock (&system_fonts_mutex);
 
 	*font_collection = system_fonts;
 	return Ok;
 }
 
+static void*
+warm_fonts (void *data)
+{
+	GpFontCollection *collection;
+
+	if ((GdipNewInstalledFontCollection (&collection) == Ok) && collection)
+		gdip_createSystemFontSet (collection);
+	return NULL;
+}
+
+void
+gdip_fontconfig_warm (void)
+{
+	g_static_mutex_lock (&fontconfig_mutex);
+	if (!fontconfig_ready && !fontconfig_warming)
+		fontconfig_warming = (pthread_create (&fontconfig_warm_thread, NULL, warm_fonts, NULL) == 0);
+	g_static_mutex_unlock (&fontconfig_mutex);
+}
+
+void
+gdip_fontconfig_fini (void)
+{
+	BOOL warming;
+
+	g_static_mutex_lock (&fontconfig_mutex);
+	warming = fontconfig_warming;
+	fontconfig_warming = FALSE;
+	g_static_mutex_unlock (&fontconfig_mutex);
+
+	/* FcFini must not run under the warming thread */
+	if (warming)
+		pthread_join (fontconfig_warm_thread, NULL);
+
+	g_static_mutex_lock (&fontconfig_mutex);
+	if (fontconfig_ready) {
+#if HAVE_FCFINI
+		FcFini ();
+#endif
+		fontconfig_ready = FALSE;
+	}
+	g_static_mutex_unlock (&fontconfig_mutex);
+}
+
 // coverity[+alloc : arg-*0]
 GpStatus
 GdipNewPrivateFontCollection (GpFontCollection **font_collection)
@@ -108,15 +187,358 @@ GdipNewPrivateFontCollection (GpFontCollection **font_collection)
 	if (!font_collection)
 		return InvalidParameter;
 
+	gdip_fontconfig_init ();
+
 	result = (GpFontCollection *) GdipAlloc (sizeof (GpFontCollection));
 	if (result) {
 		result->fontset = NULL;
 		result->config = FcConfigCreate ();
+		result->memory_fonts = NULL;
     	}
 	*font_collection = result;
 	return Ok;
 }
 
+GpStatus
+GdipPrivateAddFontFile (GpFontCollection *font_collection,  GDIPCONST WCHAR *filename)
+{
+	BYTE *file;
+	
+	if (!font_collection || !filename)
+		return InvalidParameter;
+    
+	file = (BYTE*) ucs2_to_utf8 ((const gunichar2 *)filename, -1);
+	if (!file)
+		return OutOfMemory;
+
+	FcConfigAppFontAddFile (font_collection->config, file);
+    
+	GdipFree (file);
+	return Ok;
+}
+
+/*
+ * Fonts added by GdipPrivateAddMemoryFont. FreeType reads them from our own copy of the
+ * data and fontconfig only describes them. They are shared by content between the private
+ * collections and released with the last collection listing them. The cairo faces made
+ * from them have their own FT_Face on the same data, which goes away with the cairo face.
+ */
+typedef struct _MemoryFont GpMemoryFont;
+
+struct _MemoryFont {
+	guint32		hash;
+	int		length;
+	BYTE		*data;
+	int		count;
+	FT_Face		*faces;		/* their generic.data is the memory font */
+	FcPattern	**patterns;	/* one per face, with the face in FC_FT_FACE */
+	int		collections;	/* the private collections listing the faces */
+	int		users;		/* the font itself and the cairo faces reading the data */
+	GpMemoryFont	*released;	/* next one released by the same collection */
+};
+
+static GStaticMutex memory_fonts_mutex = G_STATIC_MUTEX_INIT;
+static GHashTable *memory_fonts = NULL;
+static GHashTable *memory_collections = NULL;	/* the private collections with memory fonts */
+static FT_Library memory_fonts_library = NULL;
+static int memory_cairo_faces = 0;		/* they keep the library alive after GdiplusShutdown */
+
+static guint32
+memory_font_hash (const BYTE *data, int length)
+{
+	guint32 hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < length; i++) {
+		hash ^= data [i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static guint
+memory_font_key_hash (gconstpointer key)
+{
+	return ((const GpMemoryFont*) key)->hash;
+}
+
+static gboolean
+memory_font_key_equal (gconstpointer a, gconstpointer b)
+{
+	const GpMemoryFont *mfa = (const GpMemoryFont*) a;
+	const GpMemoryFont *mfb = (const GpMemoryFont*) b;
+
+	return (mfa->hash == mfb->hash) && (mfa->length == mfb->length) && (memcmp (mfa->data, mfb->data, mfa->length) == 0);
+}
+
+/* note: MUST be executed inside memory_fonts_mutex */
+static void
+memory_font_free_faces (GpMemoryFont *mf)
+{
+	int i;
+
+	for (i = 0; i < mf->count; i++) {
+		FcPatternDestroy (mf->patterns [i]);
+		FT_Done_Face (mf->faces [i]);
+	}
+	if (mf->patterns)
+		GdipFree (mf->patterns);
+	if (mf->faces)
+		GdipFree (mf->faces);
+	mf->patterns = NULL;
+	mf->faces = NULL;
+	mf->count = 0;
+}
+
+/* note: MUST be executed inside memory_fonts_mutex */
+static void
+memory_font_unref (GpMemoryFont *mf)
+{
+	if (--mf->users > 0)
+		return;
+
+	GdipFree (mf->data);
+	GdipFree (mf);
+}
+
+static void
+memory_fonts_library_check (void)
+{
+	/* after GdiplusShutdown, once the last cairo face is gone */
+	if (!memory_fonts && (memory_cairo_faces == 0) && memory_fonts_library) {
+		FT_Done_FreeType (memory_fonts_library);
+		memory_fonts_library = NULL;
+	}
+}
+
+/* note: MUST be executed inside memory_fonts_mutex */
+static GpMemoryFont*
+memory_font_load (GDIPCONST BYTE *memory, int length, guint32 hash)
+{
+	GpMemoryFont *mf;
+	FT_Face face;
+	int i, count;
+
+	if (!memory_fonts_library && (FT_Init_FreeType (&memory_fonts_library) != 0)) {
+		memory_fonts_library = NULL;
+		return NULL;
+	}
+
+	mf = (GpMemoryFont*) GdipAlloc (sizeof (GpMemoryFont));
+	if (!mf)
+		return NULL;
+	memset (mf, 0, sizeof (GpMemoryFont));
+	mf->hash = hash;
+	mf->length = length;
+	mf->users = 1;
+	mf->data = (BYTE*) GdipAlloc (length);
+	if (!mf->data) {
+		GdipFree (mf);
+		return NULL;
+	}
+	memcpy (mf->data, memory, length);
+
+	/* the first face tells how many there are, e.g. in a TrueType collection */
+	if (FT_New_Memory_Face (memory_fonts_library, mf->data, length, 0, &face) != 0) {
+		memory_font_unref (mf);
+		return NULL;
+	}
+
+	count = (face->num_faces > 0) ? face->num_faces : 1;
+	mf->faces = (FT_Face*) GdipAlloc (count * sizeof (FT_Face));
+	mf->patterns = (FcPattern**) GdipAlloc (count * sizeof (FcPattern*));
+	if (!mf->faces || !mf->patterns) {
+		FT_Done_Face (face);
+		memory_font_free_faces (mf);
+		memory_font_unref (mf);
+		return NULL;
+	}
+
+	for (i = 0; i < count; i++) {
+		FcPattern *pattern;
+
+		if ((i > 0) && (FT_New_Memory_Face (memory_fonts_library, mf->data, length, i, &face) != 0))
+			continue;
+
+		pattern = FcFreeTypeQueryFace (face, (const FcChar8 *) "", i, NULL);
+		if (!pattern || !FcPatternAddFTFace (pattern, FC_FT_FACE, face)) {
+			if (pattern)
+				FcPatternDestroy (pattern);
+			FT_Done_Face (face);
+			continue;
+		}
+
+		face->generic.data = mf;
+		face->generic.finalizer = NULL;
+		mf->faces [mf->count] = face;
+		mf->patterns [mf->count] = pattern;
+		mf->count++;
+	}
+
+	if (mf->count == 0) {
+		memory_font_free_faces (mf);
+		memory_font_unref (mf);
+		return NULL;
+	}
+	return mf;
+}
+
+static BOOL
+fontset_has_memory_face (FcFontSet *set, FT_Face face)
+{
+	FT_Face other;
+	int i;
+
+	for (i = 0; i < set->nfont; i++) {
+		if ((FcPatternGetFTFace (set->fonts [i], FC_FT_FACE, 0, &other) == FcResultMatch) && (other == face))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* release the memory fonts only listed by the collection, and drop what the caches keep for their faces */
+static void
+memory_fonts_release (GpFontCollection *font_collection)
+{
+	GpMemoryFont *released = NULL;
+	GpMemoryFont *mf;
+	FT_Face face;
+	int i;
+
+	g_static_mutex_lock (&memory_fonts_mutex);
+	/* after GdiplusShutdown the fonts are already gone */
+	if (!memory_collections || !g_hash_table_remove (memory_collections, font_collection)) {
+		g_static_mutex_unlock (&memory_fonts_mutex);
+		return;
+	}
+
+	for (i = 0; i < font_collection->memory_fonts->nfont; i++) {
+		if (FcPatternGetFTFace (font_collection->memory_fonts->fonts [i], FC_FT_FACE, 0, &face) != FcResultMatch)
+			continue;
+
+		/* all the faces of a font are listed together, the first one stands for the font */
+		mf = (GpMemoryFont*) face->generic.data;
+		if ((face != mf->faces [0]) || (--mf->collections > 0))
+			continue;
+
+		g_hash_table_remove (memory_fonts, mf);
+		mf->released = released;
+		released = mf;
+	}
+	g_static_mutex_unlock (&memory_fonts_mutex);
+
+	/* nothing can find these faces anymore, the caches are purged outside of the lock like they are filled */
+	while (released) {
+		mf = released;
+		released = mf->released;
+
+		for (i = 0; i < mf->count; i++) {
+			char *tag = g_strdup_printf (":%p", (void*) mf->faces [i]);
+
+			gdip_font_purge_metrics_cache (tag);
+#ifndef USE_PANGO_RENDERING
+			gdip_glyph_cache_purge (tag);
+			gdip_font_purge_face_cache (tag);
+#endif
+			g_free (tag);
+		}
+
+		g_static_mutex_lock (&memory_fonts_mutex);
+		memory_font_free_faces (mf);
+		memory_font_unref (mf);
+		g_static_mutex_unlock (&memory_fonts_mutex);
+	}
+}
+
+static BOOL
+free_memory_font (gpointer key, gpointer value, gpointer user)
+{
+	GpMemoryFont *mf = (GpMemoryFont*) value;
+
+	memory_font_free_faces (mf);
+	memory_font_unref (mf);
+	return TRUE;
+}
+
+void
+gdip_font_clear_memory_fonts (void)
+{
+	g_static_mutex_lock (&memory_fonts_mutex);
+	if (memory_fonts) {
+		g_hash_table_foreach_remove (memory_fonts, free_memory_font, NULL);
+		g_hash_table_destroy (memory_fonts);
+		memory_fonts = NULL;
+	}
+	if (memory_collections) {
+		g_hash_table_destroy (memory_collections);
+		memory_collections = NULL;
+	}
+	memory_fonts_library_check ();
+	g_static_mutex_unlock (&memory_fonts_mutex);
+}
+
+/* the face loaded from memory for a family of a private collection, in the requested style when the collection has it too */
+FT_Face
+gdip_family_memory_face (GpFontFamily *family, int style)
+{
+	FcFontSet *set;
+	FcChar8 *name, *other;
+	FT_Face own, face, match = NULL, fallback = NULL;
+	int style_flags, i;
+
+	if (!family->collection || !family->pattern ||
+	    (FcPatternGetFTFace (family->pattern, FC_FT_FACE, 0, &own) != FcResultMatch) ||
+	    (FcPatternGetString (family->pattern, FC_FAMILY, 0, &name) != FcResultMatch))
+		return NULL;
+
+	style_flags = ((style & FontStyleBold) ? FT_STYLE_FLAG_BOLD : 0) | ((style & FontStyleItalic) ? FT_STYLE_FLAG_ITALIC : 0);
+
+	g_static_mutex_lock (&memory_fonts_mutex);
+	/* the faces go away with the collection, the families and fonts outliving it fall back on the name */
+	if (memory_collections && g_hash_table_lookup (memory_collections, family->collection)) {
+		set = family->collection->memory_fonts;
+		for (i = 0; !match && (i < set->nfont); i++) {
+			if ((FcPatternGetFTFace (set->fonts [i], FC_FT_FACE, 0, &face) != FcResultMatch) ||
+			    (FcPatternGetString (set->fonts [i], FC_FAMILY, 0, &other) != FcResultMatch) ||
+			    (strcmp ((char *) name, (char *) other) != 0))
+				continue;
+
+			if ((face->style_flags & (FT_STYLE_FLAG_BOLD | FT_STYLE_FLAG_ITALIC)) == style_flags)
+				match = face;
+			else if (face == own)
+				fallback = face;
+		}
+	}
+	g_static_mutex_unlock (&memory_fonts_mutex);
+
+	return match ? match : fallback;
+}
+
+/* the key of the caches by face name and style, the faces loaded from memory have their own entries */
+char*
+gdip_font_face_key (GpFontFamily *family, const char *face, int style)
+{
+	FT_Face memory = family ? gdip_family_memory_face (family, style) : NULL;
+
+	/* underline and strikeout are drawn by us, they don't select another face */
+	style &= (FontStyleBold | FontStyleItalic);
+	if (memory)
+		return g_strdup_printf ("%d:%s:%p", style, face, (void*) memory);
+	return g_strdup_printf ("%d:%s", style, face);
+}
+
+/* whether a cache key is for the memory face tagged ":%p", the tag ends the face key */
+BOOL
+gdip_font_key_has_tag (const char *key, const char *tag)
+{
+	const char *found = strstr (key, tag);
+
+	if (!found)
+		return FALSE;
+	found += strlen (tag);
+	return (*found == '\0') || (*found == ':');
+}
+
 // coverity[+free : arg-0]
 GpStatus
 GdipDeletePrivateFontCollection (GpFontCollection **font_collection)
@@ -133,30 +555,17 @@ GdipDeletePrivateFontCollection (GpFontCollection **font_collection)
 			FcConfigDestroy ((*font_collection)->config);
 			(*font_collection)->config = NULL;
 		}
+		if ((*font_collection)->memory_fonts != NULL) {
+			memory_fonts_release (*font_collection);
+			FcFontSetDestroy ((*font_collection)->memory_fonts);
+			(*font_collection)->memory_fonts = NULL;
+		}
 		GdipFree ((void *)*font_collection);
 	}
 
 	return Ok;
 }
 
-GpStatus
-GdipPrivateAddFontFile (GpFontCollection *font_collection,  GDIPCONST WCHAR *filename)
-{
-	BYTE *file;
-	
-	if (!font_collection || !filename)
-		return InvalidParameter;
-    
-	file = (BYTE*) ucs2_to_utf8 ((const gunichar2 *)filename, -1);
-	if (!file)
-		return OutOfMemory;
-
-	FcConfigAppFontAddFile (font_collection->config, file);
-    
-	GdipFree (file);
-	return Ok;
-}
-
 GpStatus
 GdipCloneFontFamily (GpFontFamily *fontFamily, GpFontFamily **clonedFontFamily)
 {
@@ -169,10 +578,9 @@ GdipCloneFontFamily (GpFontFamily *fontFamily, GpFontFamily **clonedFontFamily)
 	if (!result)
 		return OutOfMemory;
 
-	result->height = fontFamily->height;
-	result->linespacing = fontFamily->linespacing;
-	result->celldescent = fontFamily->celldescent;
-	result->cellascent = fontFamily->cellascent;
+	memcpy (result->metrics, fontFamily->metrics, sizeof (result->metrics));
+	result->has_metrics = fontFamily->has_metrics;
+	result->collection = fontFamily->collection;
 
 	if (fontFamily->pattern) {
 		result->pattern = FcPatternDuplicate (fontFamily->pattern);
@@ -243,6 +651,32 @@ gdip_createPrivateFontSet (GpFontCollection *font_collection)
 	FcPatternDestroy (pat);
 	FcObjectSetDestroy (os);
 
+	/* like FcFontList, list each family of the memory fonts once */
+	if (font_collection->memory_fonts) {
+		int i, j;
+
+		if (!col)
+			col = FcFontSetCreate ();
+
+		for (i = 0; col && (i < font_collection->memory_fonts->nfont); i++) {
+			FcPattern *memory = font_collection->memory_fonts->fonts [i];
+			FcChar8 *family, *other;
+			BOOL listed = FALSE;
+
+			if (FcPatternGetString (memory, FC_FAMILY, 0, &family) != FcResultMatch)
+				continue;
+
+			for (j = 0; !listed && (j < col->nfont); j++) {
+				if ((FcPatternGetString (col->fonts [j], FC_FAMILY, 0, &other) == FcResultMatch) &&
+				    (strcmp ((char *) family, (char *) other) == 0))
+					listed = TRUE;
+			}
+
+			if (!listed)
+				FcFontSetAdd (col, FcPatternDuplicate (memory));
+		}
+	}
+
 	font_collection->fontset = col;
 }
 
@@ -254,6 +688,8 @@ GdipGetFontCollectionFamilyCount (GpFontCollection *font_collection, int *numFou
 
 	if (font_collection->config)
 		gdip_createPrivateFontSet (font_collection);
+	else
+		gdip_createSystemFontSet (font_collection);
 
 	if (font_collection->fontset)
 		*numFound = font_collection->fontset->nfont;
@@ -273,11 +709,14 @@ GdipGetFontCollectionFamilyList (GpFontCollection *font_collection, int num_soug
 
 	if (font_collection->config)
 		gdip_createPrivateFontSet (font_collection);
+	else
+		gdip_createSystemFontSet (font_collection);
 
 	for (i = 0; i < font_collection->fontset->nfont; i++) {
 		gdip_createFontFamily(&gpfamilies[i]);
 		gpfamilies[i]->pattern = font_collection->fontset->fonts[i];
 		gpfamilies[i]->allocated = FALSE;
+		gpfamilies[i]->collection = font_collection->config ? font_collection : NULL;
 	}
 	
 	*num_found = font_collection->fontset->nfont;
@@ -355,6 +794,8 @@ create_fontfamily_from_name (char* name, GpFontFamily **fontFamily)
 	GpFontFamily *ff = NULL;
 	FcPattern *pat = NULL;
 
+	gdip_fontconfig_init ();
+
 	g_static_mutex_lock (&patterns_mutex);
 
 	if (patterns_hashtable) {
@@ -401,6 +842,7 @@ gdip_font_clear_pattern_cache (void)
 	if (patterns_hashtable) {
 		g_hash_table_foreach_remove (patterns_hashtable, free_cached_pattern, NULL);
 		g_hash_table_destroy (patterns_hashtable);
+		patterns_hashtable = NULL;
 	}
 	g_static_mutex_unlock (&patterns_mutex);
 }
@@ -408,6 +850,9 @@ gdip_font_clear_pattern_cache (void)
 static GpStatus
 create_fontfamily_from_collection (char* name, GpFontCollection *font_collection, GpFontFamily **fontFamily)
 {
+	if (!font_collection->config)
+		gdip_createSystemFontSet (font_collection);
+
 	/* note: fontset can be NULL when we supply an empty private collection */
 	if (font_collection->fontset) {
 		int i;
@@ -424,6 +869,7 @@ create_fontfamily_from_collection (char* name, GpFontCollection *font_collection
 				gdip_createFontFamily (fontFamily);
 				(*fontFamily)->pattern = *gpfam;
 				(*fontFamily)->allocated = FALSE;
+				(*fontFamily)->collection = font_collection->config ? font_collection : NULL;
 				return Ok;
 			}
 		}
@@ -561,7 +1007,7 @@ enum fsSelection {
 };
 
 static void
-gdip_get_fontfamily_details_from_freetype (GpFontFamily *family, FT_Face face)
+gdip_get_fontfamily_details_from_freetype (GpFontMetrics *metrics, FT_Face face)
 {
 	if (FT_IS_SFNT (face)) {
 		TT_HoriHeader *hhea = FT_Get_Sfnt_Table (face, ft_sfnt_hhea);
@@ -569,33 +1015,33 @@ gdip_get_fontfamily_details_from_freetype (GpFontFamily *family, FT_Face face)
 		
 		if (os2 && (os2->fsSelection & fsSelectionUseTypoMetrics)) {
 			/* Use the typographic Ascender, Descender, and LineGap values for everything. */
-			family->linespacing = os2->sTypoAscender - os2->sTypoDescender + os2->sTypoLineGap;
-			family->celldescent = -os2->sTypoDescender;
-			family->cellascent = os2->sTypoAscender;
+			metrics->linespacing = os2->sTypoAscender - os2->sTypoDescender + os2->sTypoLineGap;
+			metrics->celldescent = -os2->sTypoDescender;
+			metrics->cellascent = os2->sTypoAscender;
 		} else {
 			/* Calculate the LineSpacing for both the hhea table and the OS/2 table. */
 			int hhea_linespacing = hhea->Ascender + abs (hhea->Descender) + hhea->Line_Gap;
 			int os2_linespacing = os2 ? (os2->usWinAscent + os2->usWinDescent) : 0;
 			
 			/* The LineSpacing is the maximum of the two sumations. */
-			family->linespacing = MAX (hhea_linespacing, os2_linespacing);
+			metrics->linespacing = MAX (hhea_linespacing, os2_linespacing);
 			
 			/* If the OS/2 table exists, use usWinDescent as the
 			 * CellDescent. Otherwise use hhea's Descender value. */
-			family->celldescent = os2 ? os2->usWinDescent : hhea->Descender;
+			metrics->celldescent = os2 ? os2->usWinDescent : hhea->Descender;
 			
 			/* If the OS/2 table exists, use usWinAscent as the
 			 * CellAscent. Otherwise use hhea's Ascender value. */
-			family->cellascent = os2 ? os2->usWinAscent : hhea->Ascender;
+			metrics->cellascent = os2 ? os2->usWinAscent : hhea->Ascender;
 		}
 	} else {
 		/* Fall back to using whatever FreeType2 provides. */
-		family->celldescent = -face->descender;
-		family->cellascent = face->ascender;
-		family->linespacing = face->height;
+		metrics->celldescent = -face->descender;
+		metrics->cellascent = face->ascender;
+		metrics->linespacing = face->height;
 	}
 	
-	family->height = face->units_per_EM;
+	metrics->height = face->units_per_EM;
 }
 
 #ifdef USE_PANGO_RENDERING
@@ -617,7 +1063,7 @@ gdip_get_pango_font_description (GpFont *font)
 }
 
 static GpStatus
-gdip_get_fontfamily_details (GpFontFamily *family, FontStyle style)
+gdip_get_fontfamily_details (GpFontFamily *family, FontStyle style, GpFontMetrics *metrics)
 {
 	GpFont *font = NULL;
 	GpStatus status = GdipCreateFont (family, 8.0f, style, UnitPoint, &font);
@@ -629,7 +1075,7 @@ gdip_get_fontfamily_details (GpFontFamily *family, FontStyle style)
 
 		FT_Face face = pango_fc_font_lock_face ((PangoFcFont*)pf);
 		if (face) {
-			gdip_get_fontfamily_details_from_freetype (family, face);
+			gdip_get_fontfamily_details_from_freetype (metrics, face);
 
 			pango_fc_font_unlock_face ((PangoFcFont*)pf);
 		} else {
@@ -646,39 +1092,174 @@ gdip_get_fontfamily_details (GpFontFamily *family, FontStyle style)
 
 #else
 
-cairo_font_face_t*
-gdip_get_cairo_font_face (GpFont *font)
+/* cairo font faces are shared by all the fonts with the same face name, weight and slant */
+static GStaticMutex faces_mutex = G_STATIC_MUTEX_INIT;
+static GHashTable *faces_hashtable = NULL;
+
+/* what a cairo face made from a memory font releases with itself */
+typedef struct {
+	FT_Face		face;
+	GpMemoryFont	*font;
+} GpMemoryCairoFace;
+
+static const cairo_user_data_key_t memory_cairo_face_key;
+
+static void
+destroy_memory_cairo_face (void *data)
 {
-	if (!font->cairofnt) {
+	GpMemoryCairoFace *mcf = (GpMemoryCairoFace*) data;
+
+	g_static_mutex_lock (&memory_fonts_mutex);
+	FT_Done_Face (mcf->face);
+	memory_font_unref (mcf->font);
+	memory_cairo_faces--;
+	memory_fonts_library_check ();
+	g_static_mutex_unlock (&memory_fonts_mutex);
+	GdipFree (mcf);
+}
+
+/* cairo needs the FT_Face as long as the cairo face lives, which may be longer than the memory font */
+static cairo_font_face_t*
+create_memory_cairo_face (FT_Face memory)
+{
+	GpMemoryCairoFace *mcf = (GpMemoryCairoFace*) GdipAlloc (sizeof (GpMemoryCairoFace));
+	cairo_font_face_t *cairofnt;
+	GpMemoryFont *mf;
+
+	if (!mcf)
+		return NULL;
+
+	g_static_mutex_lock (&memory_fonts_mutex);
+	mf = (GpMemoryFont*) memory->generic.data;
+	if (FT_New_Memory_Face (memory_fonts_library, mf->data, mf->length, memory->face_index, &mcf->face) != 0) {
+		g_static_mutex_unlock (&memory_fonts_mutex);
+		GdipFree (mcf);
+		return NULL;
+	}
+	mcf->font = mf;
+	mf->users++;
+	memory_cairo_faces++;
+	g_static_mutex_unlock (&memory_fonts_mutex);
+
+	cairofnt = cairo_ft_font_face_create_for_ft_face (mcf->face, 0);
+	if (cairo_font_face_set_user_data (cairofnt, &memory_cairo_face_key, mcf, destroy_memory_cairo_face) != CAIRO_STATUS_SUCCESS) {
+		cairo_font_face_destroy (cairofnt);
+		destroy_memory_cairo_face (mcf);
+		return NULL;
+	}
+	return cairofnt;
+}
+
+static cairo_font_face_t*
+create_cairo_font_face (const char *face, int style, FT_Face memory)
+{
+	cairo_font_face_t *cairofnt;
+
+	if (memory)
+		return create_memory_cairo_face (memory);
+
 #if CAIRO_HAS_QUARTZ_FONT
-		FcPattern *pattern = FcPatternBuild (
-			NULL,
-			FC_FAMILY, FcTypeString,  font->face, 
-			FC_SLANT,  FcTypeInteger, ((font->style & FontStyleItalic) ? FC_SLANT_ITALIC : FC_SLANT_ROMAN), 
-			FC_WEIGHT, FcTypeInteger, ((font->style & FontStyleBold)   ? FC_WEIGHT_BOLD  : FC_WEIGHT_MEDIUM),
-			NULL);
-		
-		font->cairofnt = cairo_ft_font_face_create_for_pattern (pattern);
-		cairo_font_face_reference (font->cairofnt);
-		FcPatternDestroy (pattern);
+	FcPattern *pattern = FcPatternBuild (
+		NULL,
+		FC_FAMILY, FcTypeString,  face, 
+		FC_SLANT,  FcTypeInteger, ((style & FontStyleItalic) ? FC_SLANT_ITALIC : FC_SLANT_ROMAN), 
+		FC_WEIGHT, FcTypeInteger, ((style & FontStyleBold)   ? FC_WEIGHT_BOLD  : FC_WEIGHT_MEDIUM),
+		NULL);
+
+	cairofnt = cairo_ft_font_face_create_for_pattern (pattern);
+	FcPatternDestroy (pattern);
 #else
-		cairo_surface_t *surface = cairo_image_surface_create_for_data ((BYTE*)NULL, CAIRO_FORMAT_ARGB32, 0, 0, 0);
-		font->cairo = cairo_create (surface);
-
-		cairo_select_font_face (font->cairo, (const char *)font->face,
-			(font->style & FontStyleItalic) ? CAIRO_FONT_SLANT_ITALIC : CAIRO_FONT_SLANT_NORMAL,
-			(font->style & FontStyleBold) ? CAIRO_FONT_WEIGHT_BOLD : CAIRO_FONT_WEIGHT_NORMAL);
-		font->cairofnt = cairo_get_font_face (font->cairo);
-		cairo_font_face_reference (font->cairofnt);
-		cairo_surface_destroy (surface);
+	cairo_surface_t *surface = cairo_image_surface_create_for_data ((BYTE*)NULL, CAIRO_FORMAT_ARGB32, 0, 0, 0);
+	cairo_t *ct = cairo_create (surface);
+
+	cairo_select_font_face (ct, face,
+		(style & FontStyleItalic) ? CAIRO_FONT_SLANT_ITALIC : CAIRO_FONT_SLANT_NORMAL,
+		(style & FontStyleBold) ? CAIRO_FONT_WEIGHT_BOLD : CAIRO_FONT_WEIGHT_NORMAL);
+	cairofnt = cairo_font_face_reference (cairo_get_font_face (ct));
+	cairo_destroy (ct);
+	cairo_surface_destroy (surface);
 #endif
+	return cairofnt;
+}
 
+cairo_font_face_t*
+gdip_get_cairo_font_face (GpFont *font)
+{
+	if (!font->cairofnt) {
+		/* underline and strikeout are drawn by us, they don't select another face */
+		int style = font->style & (FontStyleBold | FontStyleItalic);
+		FT_Face memory = font->family ? gdip_family_memory_face (font->family, style) : NULL;
+		char *key = memory ? g_strdup_printf ("%d:%s:%p", style, font->face, (void*) memory) :
+			g_strdup_printf ("%d:%s", style, font->face);
+		cairo_font_face_t *cairofnt;
+
+		g_static_mutex_lock (&faces_mutex);
+
+		if (faces_hashtable) {
+			cairofnt = (cairo_font_face_t*) g_hash_table_lookup (faces_hashtable, key);
+		} else {
+			faces_hashtable = g_hash_table_new (g_str_hash, g_str_equal);
+			cairofnt = NULL;
+		}
+
+		if (cairofnt) {
+			g_free (key);
+		} else {
+			/* the table keeps a reference for the next fonts */
+			cairofnt = create_cairo_font_face ((const char *) font->face, style, memory);
+			if (cairofnt)
+				g_hash_table_insert (faces_hashtable, key, cairofnt);
+			else
+				g_free (key);
+		}
+
+		font->cairofnt = cairo_font_face_reference (cairofnt);
+		g_static_mutex_unlock (&faces_mutex);
 	}
 	return font->cairofnt;
 }
 
+static BOOL
+free_cached_face (gpointer key, gpointer value, gpointer user)
+{
+	g_free (key);
+	cairo_font_face_destroy ((cairo_font_face_t*) value);
+	return TRUE;
+}
+
+/* the fonts still alive keep their own reference on their face */
+void
+gdip_font_clear_face_cache (void)
+{
+	g_static_mutex_lock (&faces_mutex);
+	if (faces_hashtable) {
+		g_hash_table_foreach_remove (faces_hashtable, free_cached_face, NULL);
+		g_hash_table_destroy (faces_hashtable);
+		faces_hashtable = NULL;
+	}
+	g_static_mutex_unlock (&faces_mutex);
+}
+
+static BOOL
+free_tagged_face (gpointer key, gpointer value, gpointer user)
+{
+	if (!gdip_font_key_has_tag ((const char *) key, (const char *) user))
+		return FALSE;
+	return free_cached_face (key, value, user);
+}
+
+/* drop the faces made from a released memory face */
+void
+gdip_font_purge_face_cache (const char *tag)
+{
+	g_static_mutex_lock (&faces_mutex);
+	if (faces_hashtable)
+		g_hash_table_foreach_remove (faces_hashtable, free_tagged_face, (gpointer) tag);
+	g_static_mutex_unlock (&faces_mutex);
+}
+
 static GpStatus
-gdip_get_fontfamily_details (GpFontFamily *family, FontStyle style)
+gdip_get_fontfamily_details (GpFontFamily *family, FontStyle style, GpFontMetrics *metrics)
 {
 	GpFont *font = NULL;
 	GpStatus status = GdipCreateFont (family, 0.0f, style, UnitPoint, &font);
@@ -709,7 +1290,7 @@ gdip_get_fontfamily_details (GpFontFamily *family, FontStyle style)
 		cairo_font_options_destroy (options);
 
 		if (face) {
-			gdip_get_fontfamily_details_from_freetype (family, face);
+			gdip_get_fontfamily_details_from_freetype (metrics, face);
 
 			cairo_ft_scaled_font_unlock_face (scaled_ft);
 			cairo_scaled_font_destroy (scaled_ft);
@@ -724,64 +1305,176 @@ gdip_get_fontfamily_details (GpFontFamily *family, FontStyle style)
 }
 #endif
 
+/* the metrics of a family name and style are computed once and shared by all the families and fonts */
+static GStaticMutex metrics_mutex = G_STATIC_MUTEX_INIT;
+static GHashTable *metrics_hashtable = NULL;
+
+static GpStatus
+gdip_get_fontfamily_metrics (GpFontFamily *family, int style, GpFontMetrics **metrics)
+{
+	int index = style & (FontStyleBold | FontStyleItalic);
+	GpStatus status = Ok;
+	GpFontMetrics *cached;
+	FcChar8 *str;
+	FcResult r;
+	char *key;
+
+	/* a family reads its own copy without locking once it has it */
+	if (family->has_metrics & (1 << index)) {
+		*metrics = &family->metrics [index];
+		return Ok;
+	}
+
+	r = FcPatternGetString (family->pattern, FC_FAMILY, 0, &str);
+	status = gdip_status_from_fontconfig (r);
+	if (status != Ok)
+		return status;
+
+	key = gdip_font_face_key (family, (const char *) str, index);
+
+	g_static_mutex_lock (&metrics_mutex);
+
+	if (metrics_hashtable) {
+		cached = (GpFontMetrics*) g_hash_table_lookup (metrics_hashtable, key);
+	} else {
+		metrics_hashtable = g_hash_table_new (g_str_hash, g_str_equal);
+		cached = NULL;
+	}
+
+	if (cached) {
+		g_free (key);
+	} else {
+		cached = (GpFontMetrics*) GdipAlloc (sizeof (GpFontMetrics));
+		if (!cached) {
+			status = OutOfMemory;
+		} else {
+			status = gdip_get_fontfamily_details (family, index, cached);
+			if (status != Ok) {
+				GdipFree (cached);
+				cached = NULL;
+			}
+		}
+
+		if (cached)
+			g_hash_table_insert (metrics_hashtable, key, cached);
+		else
+			g_free (key);
+	}
+
+	if (cached) {
+		family->metrics [index] = *cached;
+		family->has_metrics |= (1 << index);
+		*metrics = &family->metrics [index];
+	}
+
+	g_static_mutex_unlock (&metrics_mutex);
+	return status;
+}
+
+static BOOL
+free_cached_metrics (gpointer key, gpointer value, gpointer user)
+{
+	g_free (key);
+	GdipFree (value);
+	return TRUE;
+}
+
+void
+gdip_font_clear_metrics_cache (void)
+{
+	g_static_mutex_lock (&metrics_mutex);
+	if (metrics_hashtable) {
+		g_hash_table_foreach_remove (metrics_hashtable, free_cached_metrics, NULL);
+		g_hash_table_destroy (metrics_hashtable);
+		metrics_hashtable = NULL;
+	}
+	g_static_mutex_unlock (&metrics_mutex);
+}
+
+static BOOL
+free_tagged_metrics (gpointer key, gpointer value, gpointer user)
+{
+	if (!gdip_font_key_has_tag ((const char *) key, (const char *) user))
+		return FALSE;
+	return free_cached_metrics (key, value, user);
+}
+
+/* drop the metrics of a released memory face */
+void
+gdip_font_purge_metrics_cache (const char *tag)
+{
+	g_static_mutex_lock (&metrics_mutex);
+	if (metrics_hashtable)
+		g_hash_table_foreach_remove (metrics_hashtable, free_tagged_metrics, (gpointer) tag);
+	g_static_mutex_unlock (&metrics_mutex);
+}
+
 GpStatus
 GdipGetEmHeight (GDIPCONST GpFontFamily *family, int style, guint16 *EmHeight)
 {
-	GpStatus status = Ok;
+	GpFontMetrics *metrics;
+	GpStatus status;
 
 	if (!family || !EmHeight)
 		return InvalidParameter;
 
-	if (family->height == -1)
-		status = gdip_get_fontfamily_details ((GpFontFamily*)family, style);
+	status = gdip_get_fontfamily_metrics ((GpFontFamily*)family, style, &metrics);
+	if (status != Ok)
+		return status;
 
-	*EmHeight = family->height;
-	return status;
+	*EmHeight = metrics->height;
+	return Ok;
 }
 
 GpStatus
 GdipGetCellAscent (GDIPCONST GpFontFamily *family, int style, guint16 *CellAscent)
 {
-	GpStatus status = Ok;
+	GpFontMetrics *metrics;
+	GpStatus status;
 
 	if (!family || !CellAscent)
 		return InvalidParameter;
 
-	if (family->cellascent == -1)
-		status = gdip_get_fontfamily_details ((GpFontFamily*)family, style);
+	status = gdip_get_fontfamily_metrics ((GpFontFamily*)family, style, &metrics);
+	if (status != Ok)
+		return status;
 
-	*CellAscent = family->cellascent;
-	return status;
+	*CellAscent = metrics->cellascent;
+	return Ok;
 }
 
 GpStatus
 GdipGetCellDescent (GDIPCONST GpFontFamily *family, int style, guint16 *CellDescent)
 {
-	GpStatus status = Ok;
+	GpFontMetrics *metrics;
+	GpStatus status;
 
 	if (!family || !CellDescent)
 		return InvalidParameter;
 
-	if (family->celldescent == -1)
-		status = gdip_get_fontfamily_details ((GpFontFamily*)family, style);
+	status = gdip_get_fontfamily_metrics ((GpFontFamily*)family, style, &metrics);
+	if (status != Ok)
+		return status;
 
-	*CellDescent = family->celldescent;
-	return status;
+	*CellDescent = metrics->celldescent;
+	return Ok;
 }
 
 GpStatus
 GdipGetLineSpacing (GDIPCONST GpFontFamily *family, int style, guint16 *LineSpacing)
 {
-	GpStatus status = Ok;
+	GpFontMetrics *metrics;
+	GpStatus status;
 
 	if (!family || !LineSpacing)
 		return InvalidParameter;
 
-	if (family->linespacing == -1)
-		status = gdip_get_fontfamily_details ((GpFontFamily*)family, style);
+	status = gdip_get_fontfamily_metrics ((GpFontFamily*)family, style, &metrics);
+	if (status != Ok)
+		return status;
 
-	*LineSpacing = family->linespacing;
-	return status;
+	*LineSpacing = metrics->linespacing;
+	return Ok;
 }
 
 GpStatus
@@ -836,7 +1529,6 @@ GdipCreateFont (GDIPCONST GpFontFamily* family, float emSize, int style, Unit un
 	result->pango = NULL;
 #else
 	result->cairofnt = NULL;
-	result->cairo = NULL;
 	gdip_get_cairo_font_face (result);
 #endif
 	*font = result;	        		
@@ -858,8 +1550,6 @@ GdipDeleteFont (GpFont* font)
 #else
 	if (font->cairofnt)
 		cairo_font_face_destroy (font->cairofnt);
-	if (font->cairo)
-		cairo_destroy (font->cairo);
 #endif
 
 	GdipFree (font->face);
@@ -1067,57 +1757,72 @@ GdipCreateFontFromLogfontW(void *hdc, GDIPCONST LOGFONTW *logfont, GpFont **font
 GpStatus
 GdipPrivateAddMemoryFont(GpFontCollection *fontCollection, GDIPCONST void *memory, int length)
 {
-	FcBool result;
-	FcChar8 fontfile[256];
-	int	f;
+	GpMemoryFont key, *mf;
+	GpStatus status = Ok;
+	int i;
 
-	if (!memory)
+	if (!fontCollection || !memory || (length <= 0))
 		return InvalidParameter;
 
-	strcpy((char *) fontfile, "/tmp/ffXXXXXX");
+	/* loading the same font again, in any collection, only costs the hash */
+	key.hash = memory_font_hash ((GDIPCONST BYTE*) memory, length);
+	key.length = length;
+	key.data = (BYTE*) memory;
+
+	g_static_mutex_lock (&memory_fonts_mutex);
 
-	f = mkstemp((char*)fontfile);
-	if (f == -1)
-		return FileNotFound;
+	if (!memory_fonts)
+		memory_fonts = g_hash_table_new (memory_font_key_hash, memory_font_key_equal);
+	if (!memory_collections)
+		memory_collections = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-	if (write(f, memory, length)!=length) {
-		close(f);
-		return FileNotFound;
+	mf = (GpMemoryFont*) g_hash_table_lookup (memory_fonts, &key);
+	if (!mf) {
+		/* FIXME - this doesn't seems to catch "bad" (e.g. invalid) font files */
+		mf = memory_font_load ((GDIPCONST BYTE*) memory, length, key.hash);
+		if (mf)
+			g_hash_table_insert (memory_fonts, mf, mf);
 	}
-	close(f);
 
-	/* FIXME - this doesn't seems to catch "bad" (e.g. invalid) font files */
-	result = FcConfigAppFontAddFile (fontCollection->config, fontfile);
+	if (!mf) {
+		status = FileNotFound;
+	} else {
+		if (!fontCollection->memory_fonts)
+			fontCollection->memory_fonts = FcFontSetCreate ();
 
-	/* FIXME - May we delete our temporary font file or does 
-	   FcConfigAppFontAddFile just reference our file?  */
-	/* unlink(fontfile); */
+		if (!fontCollection->memory_fonts) {
+			status = OutOfMemory;
+		} else if (!fontset_has_memory_face (fontCollection->memory_fonts, mf->faces [0])) {
+			/* the font is kept until the last collection listing it is deleted */
+			mf->collections++;
+			for (i = 0; i < mf->count; i++)
+				FcFontSetAdd (fontCollection->memory_fonts, FcPatternDuplicate (mf->patterns [i]));
+			g_hash_table_insert (memory_collections, fontCollection, fontCollection);
+		}
+	}
 
-	return result ? Ok : FileNotFound;
+	g_static_mutex_unlock (&memory_fonts_mutex);
+	return status;
 }
 
 GpStatus
 GdipGetFontHeight (GDIPCONST GpFont *font, GDIPCONST GpGraphics *graphics, float *height)
 {
 	GpStatus status;
-	guint16 emHeight, lineSpacing;
+	GpFontMetrics *metrics;
 	float emSize, h;
 
 	if (!font || !height || !graphics)
 		return InvalidParameter;
 
-	status = GdipGetEmHeight (font->family, font->style, &emHeight);
-	if (status != Ok)
-		return status;
-
-	status = GdipGetLineSpacing (font->family, font->style, &lineSpacing);
+	status = gdip_get_fontfamily_metrics (font->family, font->style, &metrics);
 	if (status != Ok)
 		return status;
 
 	/* Operations in display dpi's */	
 	emSize = gdip_unit_conversion (font->unit, UnitPixel, gdip_get_display_dpi (), gtMemoryBitmap, font->emSize);
 
-	h = lineSpacing * (emSize / emHeight);
+	h = metrics->linespacing * (emSize / metrics->height);
 	*height = gdip_unit_conversion (UnitPixel, graphics->page_unit, gdip_get_display_dpi (), graphics->type, h);
 	return Ok;
 }
@@ -1126,21 +1831,17 @@ GpStatus
 GdipGetFontHeightGivenDPI (GDIPCONST GpFont *font, float dpi, float *height)
 {
 	GpStatus status;
-	guint16 emHeight, lineSpacing;
+	GpFontMetrics *metrics;
 	float h;
 
 	if (!font || !height)
 		return InvalidParameter;
 
-	status = GdipGetEmHeight (font->family, font->style, &emHeight);
-	if (status != Ok)
-		return status;
-
-	status = GdipGetLineSpacing (font->family, font->style, &lineSpacing);
+	status = gdip_get_fontfamily_metrics (font->family, font->style, &metrics);
 	if (status != Ok)
 		return status;
 
-	h = lineSpacing * (font->emSize / emHeight);
+	h = metrics->linespacing * (font->emSize / metrics->height);
 	*height = gdip_unit_conversion (font->unit, UnitInch, dpi, gtMemoryBitmap, h) * dpi;
 	return Ok;
 }
@@ -40,6 +40,7 @@
 struct _FontCollection {
 	FcFontSet*	fontset;
 	FcConfig*	config;		/* Only for private collections */
+	FcFontSet*	memory_fonts;	/* Added by GdipPrivateAddMemoryFont, fontconfig doesn't know them */
 };
 
 #include "fontcollection.h"
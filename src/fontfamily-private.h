@@ -37,13 +37,20 @@
 
 #include "gdiplus-private.h"
 
-struct _FontFamily {
-        FcPattern*	pattern;
-	BOOL		allocated;
+/* in font design units */
+typedef struct {
 	short 		height;
 	short 		linespacing;
 	short		celldescent;
 	short		cellascent;
+} GpFontMetrics;
+
+struct _FontFamily {
+        FcPattern*	pattern;
+	BOOL		allocated;
+	GpFontMetrics	metrics [4];	/* for the bold and italic combinations, copied from the shared table */
+	int		has_metrics;	/* bit set of the valid metrics */
+	GpFontCollection *collection;	/* the private collection listing it, for its memory fonts */
 };
 
 #include "fontfamily.h"
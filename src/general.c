@@ -29,6 +29,8 @@
 #include "codecs-private.h"
 #include "graphics-private.h"
 #include "font-private.h"
+#include "glyph-cache.h"
+#include "text-layout-cache.h"
 #include "carbon-private.h"
 
 /* large table to avoid a division and three multiplications when premultiplying alpha into R, G and B */
@@ -43,10 +45,9 @@ GdiplusStartup (ULONG_PTR *token, const GdiplusStartupInput *input, GdiplusStart
 	/* don't initialize multiple time, e.g. for each appdomain */
 	if (!startup) {
 		startup = TRUE;
-		status = initCodecList ();
-		if (status != Ok)
-			return status;
-		FcInit ();
+		/* the codec list and fontconfig are initialized on first use */
+		if (getenv ("MONO_GDIP_WARM_FONTS") != NULL)
+			gdip_fontconfig_warm ();
 		*token = 1;
 		gdip_get_display_dpi();
 	}
@@ -59,9 +60,15 @@ GdiplusShutdown (ULONG_PTR token)
 	if (startup) {
 		releaseCodecList ();
 		gdip_font_clear_pattern_cache ();
-#if HAVE_FCFINI
-		FcFini ();
+		gdip_font_clear_metrics_cache ();
+#ifndef USE_PANGO_RENDERING
+		gdip_glyph_cache_clear ();
+		gdip_layout_cache_clear ();
+		gdip_font_clear_face_cache ();
 #endif
+		/* after the cairo faces made from them */
+		gdip_font_clear_memory_fonts ();
+		gdip_fontconfig_fini ();
 		startup = FALSE; /* in case we want to restart it */
 	}
 }
@@ -601,3 +608,78 @@ gdip_cairo_curve_to (GpGraphics *graphics, double x1, double y1, double x2, doub
 
 	cairo_curve_to (graphics->ct, x1, y1, x2, y2, x3, y3);
 }
+
+/* the conversions of gdip_cairo_move_to (and friends) as a matrix, to convert many points at once */
+void
+gdip_cairo_points_matrix (GpGraphics *graphics, BOOL convert_units, BOOL antialiasing, cairo_matrix_t *matrix)
+{
+	double sx = 1.0, sy = 1.0, x0 = 0.0, y0 = 0.0;
+
+	/* the unit conversion is a scaling */
+	if (convert_units && !OPTIMIZE_CONVERSION (graphics)) {
+		sx = gdip_unitx_convgr (graphics, 1.0f);
+		sy = gdip_unity_convgr (graphics, 1.0f);
+	}
+
+	if (antialiasing && !gdip_is_scaled (graphics)) {
+		x0 = graphics->aa_offset_x;
+		y0 = graphics->aa_offset_y;
+	}
+
+	cairo_matrix_init (matrix, sx, 0.0, 0.0, sy, x0, y0);
+}
+
+/* convert the points into cairo path data, @stride elements apart */
+void
+gdip_cairo_points (GpGraphics *graphics, GDIPCONST GpPointF *points, int count, BOOL convert_units, BOOL antialiasing,
+	cairo_path_data_t *data, int stride)
+{
+	cairo_matrix_t matrix;
+
+	gdip_cairo_points_matrix (graphics, convert_units, antialiasing, &matrix);
+	gdip_matrix_transform_cairo_points (&matrix, points, count, data, stride);
+
+#ifdef CAIRO_LOW_LIMIT
+	{
+		int i;
+		/* put everything between cairo limits */
+		for (i = 0; i < count; i++, data += stride) {
+			data->point.x = CAIRO_LIMIT (data->point.x);
+			data->point.y = CAIRO_LIMIT (data->point.y);
+		}
+	}
+#endif
+}
+
+/* same as gdip_cairo_move_to to the first point and gdip_cairo_line_to to the others, in one cairo call */
+void
+gdip_cairo_lines (GpGraphics *graphics, GDIPCONST GpPointF *points, int count, BOOL convert_units, BOOL antialiasing)
+{
+	cairo_path_data_t *data;
+	cairo_path_t path;
+	int i;
+
+	if (count < 1)
+		return;
+
+	data = (cairo_path_data_t*) GdipAlloc (sizeof (cairo_path_data_t) * count * 2);
+	if (!data) {
+		/* still draw, one point at a time */
+		gdip_cairo_move_to (graphics, points [0].X, points [0].Y, convert_units, antialiasing);
+		for (i = 1; i < count; i++)
+			gdip_cairo_line_to (graphics, points [i].X, points [i].Y, convert_units, antialiasing);
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		data [i * 2].header.type = (i == 0) ? CAIRO_PATH_MOVE_TO : CAIRO_PATH_LINE_TO;
+		data [i * 2].header.length = 2;
+	}
+	gdip_cairo_points (graphics, points, count, convert_units, antialiasing, data + 1, 2);
+
+	path.status = CAIRO_STATUS_SUCCESS;
+	path.data = data;
+	path.num_data = count * 2;
+	cairo_append_path (graphics->ct, &path);
+	GdipFree (data);
+}
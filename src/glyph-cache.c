@@ -0,0 +1,433 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "glyph-cache.h"
+#include "font-private.h"
+
+#ifndef USE_PANGO_RENDERING
+
+/*
+ * Outlines of the characters used by GdipAddPathString, for each face name,
+ * style and size. They are extracted like cairo_text_path does (hinted for
+ * their size) so the paths don't depend on the cache. Advances, used to
+ * measure and draw strings, are kept for each size, transform and font options.
+ */
+typedef struct {
+	cairo_font_face_t	*face;
+	double			size;
+	GHashTable		*outlines;	/* gunichar -> GpGlyphOutline */
+	int			bytes;		/* the face and its outlines, see glyph_cache_bytes */
+} GpGlyphFace;
+
+static GStaticMutex glyph_cache_mutex = G_STATIC_MUTEX_INIT;
+static GHashTable *glyph_faces = NULL;		/* "style:face:size" -> GpGlyphFace */
+static GHashTable *glyph_advances = NULL;	/* face, size, transform and options -> GpGlyphAdvances */
+static cairo_surface_t *glyph_surface = NULL;	/* scratch surface and context, used to extract the outlines */
+static cairo_t *glyph_cr = NULL;
+static int glyph_cache_bytes = 0;		/* the faces and their outlines */
+static int glyph_advances_bytes = 0;		/* the advance tables */
+static int glyph_cache_hits = 0;		/* outlines */
+static int glyph_cache_misses = 0;
+static int glyph_advances_hits = 0;
+static int glyph_advances_misses = 0;
+
+static void
+glyph_outline_free (gpointer data)
+{
+	GpGlyphOutline *outline = (GpGlyphOutline*) data;
+
+	if (outline->data)
+		GdipFree (outline->data);
+	GdipFree (outline);
+}
+
+static void
+glyph_face_free (gpointer data)
+{
+	GpGlyphFace *gface = (GpGlyphFace*) data;
+
+	g_hash_table_destroy (gface->outlines);
+	cairo_font_face_destroy (gface->face);
+	GdipFree (gface);
+}
+
+static gboolean
+glyph_face_remove (gpointer key, gpointer value, gpointer user)
+{
+	return TRUE;
+}
+
+static gboolean
+glyph_face_remove_others (gpointer key, gpointer value, gpointer user)
+{
+	return value != user;
+}
+
+static GpGlyphFace*
+glyph_face_new (GpFont *font)
+{
+	GpGlyphFace *gface;
+
+	gface = (GpGlyphFace*) GdipAlloc (sizeof (GpGlyphFace));
+	if (!gface)
+		return NULL;
+
+	/* the face outlives the (usually temporary) font */
+	gface->face = cairo_font_face_reference (gdip_get_cairo_font_face (font));
+	gface->size = font->sizeInPixels;
+	gface->outlines = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, glyph_outline_free);
+	gface->bytes = GLYPH_CACHE_FACE_BYTES;
+	return gface;
+}
+
+/* extract the outline of @ch, like cairo_text_path does for it */
+static GpGlyphOutline*
+glyph_outline_new (GpGlyphFace *gface, gunichar ch)
+{
+	GpGlyphOutline *outline;
+	cairo_text_extents_t extents;
+	cairo_path_t *cp;
+	char utf8 [7];
+	int i, n = 0;
+
+	/* the same settings as the context GdipAddPathString used to create for each call */
+	if (!glyph_cr) {
+		glyph_surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+		glyph_cr = cairo_create (glyph_surface);
+		if (cairo_status (glyph_cr) != CAIRO_STATUS_SUCCESS) {
+			cairo_destroy (glyph_cr);
+			cairo_surface_destroy (glyph_surface);
+			glyph_cr = NULL;
+			glyph_surface = NULL;
+			return NULL;
+		}
+	}
+
+	outline = (GpGlyphOutline*) GdipAlloc (sizeof (GpGlyphOutline));
+	if (!outline)
+		return NULL;
+
+	utf8 [g_unichar_to_utf8 (ch, utf8)] = '\0';
+
+	cairo_set_font_face (glyph_cr, gface->face);
+	cairo_set_font_size (glyph_cr, gface->size);
+	cairo_new_path (glyph_cr);
+	cairo_move_to (glyph_cr, 0, 0);
+	cairo_text_path (glyph_cr, utf8);
+	cairo_text_extents (glyph_cr, utf8, &extents);
+	cp = cairo_copy_path (glyph_cr);
+	cairo_new_path (glyph_cr);
+	/* don't keep the face alive once it's dropped from the cache */
+	cairo_set_font_face (glyph_cr, NULL);
+
+	outline->x_advance = extents.x_advance;
+	outline->y_advance = extents.y_advance;
+	outline->num_points = 0;
+	outline->data = (cp && (cp->num_data > 0)) ? (cairo_path_data_t*) GdipAlloc (sizeof (cairo_path_data_t) * cp->num_data) : NULL;
+
+	if (outline->data) {
+		for (i = 0; i < cp->num_data; i += cp->data [i].header.length) {
+			cairo_path_data_t *data = &cp->data [i];
+
+			/* the current point left after the glyph (at its advance) isn't part of the outline */
+			if ((data->header.type == CAIRO_PATH_MOVE_TO) && (i + data->header.length >= cp->num_data))
+				break;
+
+			memcpy (&outline->data [n], data, data->header.length * sizeof (cairo_path_data_t));
+			n += data->header.length;
+			outline->num_points += data->header.length - 1;
+		}
+	}
+	outline->num_data = n;
+
+	if (cp)
+		cairo_path_destroy (cp);
+	return outline;
+}
+
+#define GLYPH_FACES_MAX_BYTES	(GLYPH_CACHE_MAX_BYTES - GLYPH_ADVANCES_MAX_BYTES)
+
+/* make room for @bytes more, dropping all the other faces first and then the outlines of @gface */
+static void
+glyph_cache_trim (GpGlyphFace *gface, int bytes)
+{
+	if (glyph_cache_bytes + bytes <= GLYPH_FACES_MAX_BYTES)
+		return;
+
+	g_hash_table_foreach_remove (glyph_faces, glyph_face_remove_others, gface);
+	glyph_cache_bytes = gface ? gface->bytes : 0;
+	if (!gface || (glyph_cache_bytes + bytes <= GLYPH_FACES_MAX_BYTES))
+		return;
+
+	g_hash_table_foreach_remove (gface->outlines, glyph_face_remove, NULL);
+	gface->bytes = GLYPH_CACHE_FACE_BYTES;
+	glyph_cache_bytes = gface->bytes;
+}
+
+void
+gdip_glyph_cache_lock (void)
+{
+	g_static_mutex_lock (&glyph_cache_mutex);
+}
+
+void
+gdip_glyph_cache_unlock (void)
+{
+	g_static_mutex_unlock (&glyph_cache_mutex);
+}
+
+/*
+ * gdip_glyph_cache_get_outline:
+ *
+ * Return the outline of @ch in @font face, style and size, extracting it on a
+ * miss. The cache must be locked, and the outline is only valid until the next
+ * call.
+ */
+GpGlyphOutline*
+gdip_glyph_cache_get_outline (GpFont *font, gunichar ch)
+{
+	GpGlyphFace *gface;
+	GpGlyphOutline *outline;
+	char *face_key, *key;
+	int size;
+
+	/* underline and strikeout don't change the outlines */
+	face_key = gdip_font_face_key (font->family, (const char *) font->face, font->style);
+	key = g_strdup_printf ("%s:%.9g", face_key, font->sizeInPixels);
+	g_free (face_key);
+
+	if (!glyph_faces)
+		glyph_faces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, glyph_face_free);
+
+	gface = (GpGlyphFace*) g_hash_table_lookup (glyph_faces, key);
+	if (gface) {
+		outline = (GpGlyphOutline*) g_hash_table_lookup (gface->outlines, GUINT_TO_POINTER (ch));
+		if (outline) {
+			glyph_cache_hits++;
+			g_free (key);
+			return outline;
+		}
+		g_free (key);
+	} else {
+		gface = glyph_face_new (font);
+		if (!gface) {
+			g_free (key);
+			return NULL;
+		}
+		glyph_cache_trim (NULL, gface->bytes);
+		glyph_cache_bytes += gface->bytes;
+		g_hash_table_insert (glyph_faces, key, gface);
+	}
+
+	glyph_cache_misses++;
+
+	outline = glyph_outline_new (gface, ch);
+	if (!outline)
+		return NULL;
+
+	size = sizeof (GpGlyphOutline) + outline->num_data * sizeof (cairo_path_data_t);
+	glyph_cache_trim (gface, size);
+	gface->bytes += size;
+	glyph_cache_bytes += size;
+	g_hash_table_insert (gface->outlines, GUINT_TO_POINTER (ch), outline);
+	return outline;
+}
+
+static void
+glyph_advances_free (gpointer data)
+{
+	GpGlyphAdvances *advances = (GpGlyphAdvances*) data;
+
+	glyph_advances_bytes -= advances->bytes;
+	g_hash_table_destroy (advances->others);
+	GdipFree (advances);
+}
+
+/* make room for @bytes more, dropping all the other tables first and then the other characters of @advances */
+static void
+glyph_advances_trim (GpGlyphAdvances *advances, int bytes)
+{
+	if (glyph_advances_bytes + bytes <= GLYPH_ADVANCES_MAX_BYTES)
+		return;
+
+	g_hash_table_foreach_remove (glyph_advances, glyph_face_remove_others, advances);
+	if (!advances || (glyph_advances_bytes + bytes <= GLYPH_ADVANCES_MAX_BYTES))
+		return;
+
+	g_hash_table_foreach_remove (advances->others, glyph_face_remove, NULL);
+	glyph_advances_bytes -= advances->bytes - (int) sizeof (GpGlyphAdvances);
+	advances->bytes = sizeof (GpGlyphAdvances);
+}
+
+/*
+ * gdip_glyph_cache_get_advances:
+ *
+ * Return the advances table for the font, size, transform and font options
+ * set on @ct (and shared by all the fonts with the same face and style).
+ * The cache must be locked, and the table is only valid until the next call.
+ */
+GpGlyphAdvances*
+gdip_glyph_cache_get_advances (cairo_t *ct, GpFont *font)
+{
+	GpGlyphAdvances *advances;
+	cairo_font_options_t *options;
+	cairo_matrix_t fm, ctm;
+	char *face_key, *key;
+
+	/* the (hinted) advances depend on the size, the device transform and the hinting options */
+	cairo_get_font_matrix (ct, &fm);
+	cairo_get_matrix (ct, &ctm);
+	options = cairo_font_options_create ();
+	cairo_get_font_options (ct, options);
+	face_key = gdip_font_face_key (font->family, (const char *) font->face, font->style);
+	key = g_strdup_printf ("%s:%.9g,%.9g,%.9g,%.9g:%.17g,%.17g,%.17g,%.17g:%lu", face_key,
+		fm.xx, fm.yx, fm.xy, fm.yy, ctm.xx, ctm.yx, ctm.xy, ctm.yy,
+		cairo_font_options_hash (options));
+	g_free (face_key);
+	cairo_font_options_destroy (options);
+
+	if (!glyph_advances)
+		glyph_advances = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, glyph_advances_free);
+
+	advances = (GpGlyphAdvances*) g_hash_table_lookup (glyph_advances, key);
+	if (advances) {
+		g_free (key);
+		return advances;
+	}
+
+	glyph_advances_trim (NULL, sizeof (GpGlyphAdvances));
+
+	advances = (GpGlyphAdvances*) GdipAlloc (sizeof (GpGlyphAdvances));
+	if (!advances) {
+		g_free (key);
+		return NULL;
+	}
+
+	memset (advances->filled, 0, sizeof (advances->filled));
+	advances->others = g_hash_table_new (g_direct_hash, g_direct_equal);
+	advances->bytes = sizeof (GpGlyphAdvances);
+	glyph_advances_bytes += advances->bytes;
+	g_hash_table_insert (glyph_advances, key, advances);
+	return advances;
+}
+
+/* return the advance of @ch, measured with the font set on @ct the first time */
+float
+gdip_glyph_advances_get (GpGlyphAdvances *advances, cairo_t *ct, gunichar2 ch)
+{
+	cairo_text_extents_t extents;
+	gpointer key, value;
+	BYTE utf8 [5];
+	union {
+		float		f;
+		guint32		u;
+	} bits;
+
+	if (ch < GLYPH_ADVANCES_DENSE) {
+		if (advances->filled [ch / 32] & (1u << (ch % 32))) {
+			glyph_advances_hits++;
+			return advances->dense [ch];
+		}
+	} else if (g_hash_table_lookup_extended (advances->others, GUINT_TO_POINTER (ch), &key, &value)) {
+		glyph_advances_hits++;
+		bits.u = GPOINTER_TO_UINT (value);
+		return bits.f;
+	}
+
+	glyph_advances_misses++;
+	utf8 [utf8_encode_ucs2char (ch, utf8)] = '\0';
+	cairo_text_extents (ct, (const char *) utf8, &extents);
+	bits.f = extents.x_advance;
+
+	if (ch < GLYPH_ADVANCES_DENSE) {
+		advances->dense [ch] = bits.f;
+		advances->filled [ch / 32] |= (1u << (ch % 32));
+	} else {
+		glyph_advances_trim (advances, GLYPH_ADVANCES_ENTRY_BYTES);
+		advances->bytes += GLYPH_ADVANCES_ENTRY_BYTES;
+		glyph_advances_bytes += GLYPH_ADVANCES_ENTRY_BYTES;
+		g_hash_table_insert (advances->others, GUINT_TO_POINTER (ch), GUINT_TO_POINTER (bits.u));
+	}
+	return bits.f;
+}
+
+void
+gdip_glyph_cache_get_stats (int *outline_hits, int *outline_misses, int *advance_hits, int *advance_misses, int *bytes)
+{
+	g_static_mutex_lock (&glyph_cache_mutex);
+	*outline_hits = glyph_cache_hits;
+	*outline_misses = glyph_cache_misses;
+	*advance_hits = glyph_advances_hits;
+	*advance_misses = glyph_advances_misses;
+	*bytes = glyph_cache_bytes + glyph_advances_bytes;
+	g_static_mutex_unlock (&glyph_cache_mutex);
+}
+
+static gboolean
+glyph_key_has_tag (gpointer key, gpointer value, gpointer user)
+{
+	return gdip_font_key_has_tag ((const char *) key, (const char *) user);
+}
+
+static void
+glyph_face_count (gpointer key, gpointer value, gpointer user)
+{
+	*((int*) user) += ((GpGlyphFace*) value)->bytes;
+}
+
+/* drop the outlines and advances of a released memory face */
+void
+gdip_glyph_cache_purge (const char *tag)
+{
+	g_static_mutex_lock (&glyph_cache_mutex);
+	if (glyph_faces) {
+		g_hash_table_foreach_remove (glyph_faces, glyph_key_has_tag, (gpointer) tag);
+		glyph_cache_bytes = 0;
+		g_hash_table_foreach (glyph_faces, glyph_face_count, &glyph_cache_bytes);
+	}
+	if (glyph_advances)
+		g_hash_table_foreach_remove (glyph_advances, glyph_key_has_tag, (gpointer) tag);
+	g_static_mutex_unlock (&glyph_cache_mutex);
+}
+
+void
+gdip_glyph_cache_clear (void)
+{
+	g_static_mutex_lock (&glyph_cache_mutex);
+	if (glyph_faces) {
+		g_hash_table_destroy (glyph_faces);
+		glyph_faces = NULL;
+	}
+	if (glyph_advances) {
+		g_hash_table_destroy (glyph_advances);
+		glyph_advances = NULL;
+	}
+	if (glyph_cr) {
+		cairo_destroy (glyph_cr);
+		cairo_surface_destroy (glyph_surface);
+		glyph_cr = NULL;
+		glyph_surface = NULL;
+	}
+	glyph_cache_bytes = 0;
+	glyph_advances_bytes = 0;
+	g_static_mutex_unlock (&glyph_cache_mutex);
+}
+
+#endif
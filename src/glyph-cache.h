@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * NOTE: This is a private header files and everything is subject to changes.
+ */
+
+#ifndef __GLYPH_CACHE_H__
+#define __GLYPH_CACHE_H__
+
+#include "gdiplus-private.h"
+
+#ifndef USE_PANGO_RENDERING
+
+/* the cached faces, outlines and advances are dropped when they would use more memory than this */
+#define GLYPH_CACHE_MAX_BYTES		(4 * 1024 * 1024)
+
+/* the part of it for the advances, the faces and their outlines have the rest */
+#define GLYPH_ADVANCES_MAX_BYTES	(GLYPH_CACHE_MAX_BYTES / 4)
+
+/* what a face costs besides its outlines: the cairo font face and the FreeType face it keeps alive */
+#define GLYPH_CACHE_FACE_BYTES		(64 * 1024)
+
+/* the outline of a character at the font size, from the glyph origin */
+typedef struct {
+	int			num_data;
+	cairo_path_data_t	*data;		/* move, line, curve and close path entries */
+	int			num_points;	/* number of path points needed for the outline */
+	double			x_advance;
+	double			y_advance;
+} GpGlyphOutline;
+
+/* advances of the characters below this are kept in an array, the others in a hash table */
+#define GLYPH_ADVANCES_DENSE		0x800
+
+/* what a character of the hash table costs, with its node and its share of the buckets */
+#define GLYPH_ADVANCES_ENTRY_BYTES	32
+
+/* the advances of the characters for a face, size, transform and font options */
+typedef struct {
+	float			dense [GLYPH_ADVANCES_DENSE];
+	guint32			filled [GLYPH_ADVANCES_DENSE / 32];
+	GHashTable		*others;	/* gunichar2 -> advance, as its bits */
+	int			bytes;		/* the table and its other characters, see glyph_advances_bytes */
+} GpGlyphAdvances;
+
+void gdip_glyph_cache_lock (void) GDIP_INTERNAL;
+void gdip_glyph_cache_unlock (void) GDIP_INTERNAL;
+
+GpGlyphOutline* gdip_glyph_cache_get_outline (GpFont *font, gunichar ch) GDIP_INTERNAL;
+
+GpGlyphAdvances* gdip_glyph_cache_get_advances (cairo_t *ct, GpFont *font) GDIP_INTERNAL;
+float gdip_glyph_advances_get (GpGlyphAdvances *advances, cairo_t *ct, gunichar2 ch) GDIP_INTERNAL;
+
+void gdip_glyph_cache_get_stats (int *outline_hits, int *outline_misses, int *advance_hits, int *advance_misses, int *bytes) GDIP_INTERNAL;
+void gdip_glyph_cache_purge (const char *tag) GDIP_INTERNAL;
+void gdip_glyph_cache_clear (void) GDIP_INTERNAL;
+
+#endif
+
+#endif
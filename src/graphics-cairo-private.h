@@ -94,9 +94,13 @@ GpStatus cairo_DrawRectangles (GpGraphics *graphics, GpPen *pen, GDIPCONST GpRec
 GpStatus cairo_DrawRectanglesI (GpGraphics *graphics, GpPen *pen, GDIPCONST GpRect *rects, int count) GDIP_INTERNAL;
 GpStatus cairo_FillRectangles (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpRectF *rects, int count) GDIP_INTERNAL;
 GpStatus cairo_FillRectanglesI (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpRect *rects, int count) GDIP_INTERNAL;
+GpStatus cairo_FillRectanglesARGB (GpGraphics *graphics, GDIPCONST GpRectF *rects, GDIPCONST ARGB *colors, int count) GDIP_INTERNAL;
+GpStatus cairo_FillEllipsesARGB (GpGraphics *graphics, GDIPCONST GpRectF *rects, GDIPCONST ARGB *colors, int count) GDIP_INTERNAL;
 
 GpStatus cairo_DrawPath (GpGraphics *graphics, GpPen *pen, GpPath *path) GDIP_INTERNAL;
 GpStatus cairo_FillPath (GpGraphics *graphics, GpBrush *brush, GpPath *path) GDIP_INTERNAL;
+GpStatus cairo_DrawPaths (GpGraphics *graphics, GpPen *pen, GpPath **paths, int count) GDIP_INTERNAL;
+GpStatus cairo_FillPaths (GpGraphics *graphics, GpBrush *brush, GpPath **paths, int count) GDIP_INTERNAL;
 
 GpStatus cairo_DrawPie (GpGraphics *graphics, GpPen *pen, float x, float y, float width, float height, 
 	float startAngle, float sweepAngle) GDIP_INTERNAL;
@@ -26,6 +26,7 @@
 #include "graphics-cairo-private.h"
 #include "graphics-private.h"
 #include "graphics-path-private.h"
+#include "solidbrush-private.h"
 
 /*
  * NOTE: all parameter's validations are done inside graphics.c
@@ -33,12 +34,10 @@
 
 /* helper functions to avoid a lot of repetitive code */
 
-static GpStatus
-fill_graphics_with_brush (GpGraphics *graphics, GpBrush *brush, BOOL stroke)
+/* fill the current path with the source set by gdip_brush_setup */
+static void
+fill_graphics_path (GpGraphics *graphics, BOOL stroke)
 {
-	/* We do brush setup just before filling. */
-	gdip_brush_setup (graphics, brush);
-
 	/* don't stroke if scaled (since the pen thickness will be scaled too!) */
 	if (stroke && !gdip_is_scaled (graphics)) {
 		/* stroke only using 1 pixel width - see #413461 */
@@ -50,6 +49,15 @@ fill_graphics_with_brush (GpGraphics *graphics, GpBrush *brush, BOOL stroke)
 
 	cairo_close_path (graphics->ct);
 	cairo_fill (graphics->ct);
+}
+
+static GpStatus
+fill_graphics_with_brush (GpGraphics *graphics, GpBrush *brush, BOOL stroke)
+{
+	/* We do brush setup just before filling. */
+	gdip_brush_setup (graphics, brush);
+
+	fill_graphics_path (graphics, stroke);
 
 	/* Set the matrix back to graphics->copy_of_ctm for other functions.
 	 * This overwrites the matrix set by brush setup.
@@ -322,13 +330,339 @@ cairo_DrawBeziersI (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPoint *points,
 }
 
 
+/*
+ * Culling (see GdipSetGeometryCulling). Geometry is compared, in cairo user
+ * space (i.e. after the unit conversion), with the clip extents grown by a
+ * margin covering everything the pen can draw around its lines.
+ */
+typedef struct {
+	BOOL		enabled;
+	BOOL		cut;		/* lines can be cut without moving dashes */
+	double		x1;
+	double		y1;
+	double		x2;
+	double		y2;
+} GpCullRect;
+
+typedef struct {
+	double		x;
+	double		y;
+} GpCullPoint;
+
+/* polylines and polygons with less points are never cut */
+#define CULL_MIN_POINTS		64
+
 static void
-make_curve (GpGraphics *graphics, GDIPCONST GpPointF *points, GpPointF *tangents, int offset, int length,
+cull_init (GpCullRect *cull, GpGraphics *graphics, GpPen *pen)
+{
+	double px = 1, py = 1, pixel, margin;
+
+	/* the pen transform changes the line width, don't guess */
+	cull->enabled = graphics->culling && (!pen || gdip_is_matrix_empty (&pen->matrix));
+	cull->cut = FALSE;
+	if (!cull->enabled)
+		return;
+
+	cairo_clip_extents (graphics->ct, &cull->x1, &cull->y1, &cull->x2, &cull->y2);
+
+	/* lines are never thinner than a device pixel */
+	cairo_device_to_user_distance (graphics->ct, &px, &py);
+	pixel = sqrt (px * px + py * py);
+
+	/* antialiasing, then the line width grown by the miters and (anchor) caps */
+	margin = 2 * pixel;
+	if (pen) {
+		margin += MAX (pen->width, pixel) * MAX (pen->miter_limit, 2.0);
+		cull->cut = (pen->dash_style == DashStyleSolid);
+	} else {
+		cull->cut = TRUE;
+	}
+
+	cull->x1 -= margin;
+	cull->y1 -= margin;
+	cull->x2 += margin;
+	cull->y2 += margin;
+}
+
+static BOOL
+cull_rect_misses (GpCullRect *cull, double x1, double y1, double x2, double y2)
+{
+	return cull->enabled && ((x2 < cull->x1) || (x1 > cull->x2) || (y2 < cull->y1) || (y1 > cull->y2));
+}
+
+/* same unit conversion as gdip_cairo_line_to */
+static void
+cull_user_point (GpGraphics *graphics, GDIPCONST GpPointF *pt, GpCullPoint *user)
+{
+	user->x = pt->X;
+	user->y = pt->Y;
+	if (!OPTIMIZE_CONVERSION (graphics)) {
+		user->x = gdip_unitx_convgr (graphics, user->x);
+		user->y = gdip_unity_convgr (graphics, user->y);
+	}
+}
+
+static BOOL
+cull_segment_misses (GpCullRect *cull, GpCullPoint *p, GpCullPoint *q)
+{
+	return cull_rect_misses (cull, MIN (p->x, q->x), MIN (p->y, q->y), MAX (p->x, q->x), MAX (p->y, q->y));
+}
+
+/* return TRUE if none of the points can be visible */
+static BOOL
+cull_points (GpCullRect *cull, GpGraphics *graphics, GDIPCONST GpPointF *points, int count)
+{
+	GpCullPoint pt;
+	double x1, y1, x2, y2;
+	int i;
+
+	if (!cull->enabled || (count < 1))
+		return FALSE;
+
+	cull_user_point (graphics, &points [0], &pt);
+	x1 = x2 = pt.x;
+	y1 = y2 = pt.y;
+	for (i = 1; i < count; i++) {
+		cull_user_point (graphics, &points [i], &pt);
+		x1 = MIN (x1, pt.x);
+		y1 = MIN (y1, pt.y);
+		x2 = MAX (x2, pt.x);
+		y2 = MAX (y2, pt.y);
+	}
+	return cull_rect_misses (cull, x1, y1, x2, y2);
+}
+
+/*
+ * cull_clip_side:
+ *
+ * One Sutherland-Hodgman pass, keeping the part of the polygon where
+ * sign * (x - value) >= 0 (or y when @vertical is FALSE).
+ */
+static int
+cull_clip_side (GpCullPoint *in, int count, GpCullPoint *out, BOOL vertical, double value, double sign)
+{
+	int i, n = 0;
+
+	for (i = 0; i < count; i++) {
+		GpCullPoint *p = &in [(i + count - 1) % count];
+		GpCullPoint *q = &in [i];
+		double dp = sign * ((vertical ? p->x : p->y) - value);
+		double dq = sign * ((vertical ? q->x : q->y) - value);
+
+		if ((dp >= 0) != (dq >= 0)) {
+			double t = dp / (dp - dq);
+			out [n].x = p->x + (q->x - p->x) * t;
+			out [n].y = p->y + (q->y - p->y) * t;
+			n++;
+		}
+		if (dq >= 0)
+			out [n++] = *q;
+	}
+	return n;
+}
+
+/*
+ * cull_clip_polygon:
+ *
+ * Clip the polygon to the cull rectangle. Clipping keeps the winding number
+ * of every point inside the rectangle, so the visible part of a fill, or of a
+ * stroke (whose added edges lie outside of what is visible), doesn't change.
+ * Returns the clipped polygon (to be freed) or NULL if out of memory.
+ */
+static GpCullPoint*
+cull_clip_polygon (GpCullRect *cull, GpCullPoint *points, int count, int *clipped)
+{
+	GpCullPoint *in = points, *out = NULL;
+	int side;
+
+	for (side = 0; side < 4; side++) {
+		/* a pass adds at most one point for each edge it cuts */
+		out = (GpCullPoint*) GdipAlloc ((2 * count + 1) * sizeof (GpCullPoint));
+		if (!out)
+			break;
+
+		switch (side) {
+		case 0:
+			count = cull_clip_side (in, count, out, TRUE, cull->x1, 1);
+			break;
+		case 1:
+			count = cull_clip_side (in, count, out, TRUE, cull->x2, -1);
+			break;
+		case 2:
+			count = cull_clip_side (in, count, out, FALSE, cull->y1, 1);
+			break;
+		default:
+			count = cull_clip_side (in, count, out, FALSE, cull->y2, -1);
+			break;
+		}
+
+		if (in != points)
+			GdipFree (in);
+		in = out;
+	}
+
+	if (!out && (in != points)) {
+		GdipFree (in);
+		return NULL;
+	}
+	*clipped = count;
+	return out;
+}
+
+/*
+ * Line decimation (see GdipSetLineDecimation). Consecutive points falling in
+ * the same device pixel column are replaced by the topmost and bottommost of
+ * them, followed by the last one. The lines between them cover the same
+ * pixels, but only three of them are sent to cairo for each column.
+ */
+typedef struct {
+	GpGraphics	*graphics;
+	BOOL		enabled;
+	BOOL		convert_units;
+	BOOL		antialiasing;
+	cairo_matrix_t	device;		/* from the points to device space */
+	double		column;		/* device column of the current run */
+	double		y;		/* device y of the current point */
+	int		count;		/* points in the run, after the one starting it */
+	GpPointF	min;
+	GpPointF	max;
+	GpPointF	last;
+	double		min_y;
+	double		max_y;
+	int		min_index;
+	int		max_index;
+} GpLineDecimator;
+
+static void
+decimator_init (GpLineDecimator *d, GpGraphics *graphics, GpPen *pen, BOOL convert_units, BOOL antialiasing)
+{
+	d->graphics = graphics;
+	/* only stroked lines are decimated, and skipping points would move the dashes */
+	d->enabled = graphics->line_decimation && pen && (pen->dash_style == DashStyleSolid);
+	d->convert_units = convert_units;
+	d->antialiasing = antialiasing;
+	d->count = 0;
+	if (d->enabled) {
+		cairo_matrix_t points;
+
+		/* same conversions as gdip_cairo_line_to, followed by the cairo transform */
+		gdip_cairo_points_matrix (graphics, convert_units, antialiasing, &points);
+		cairo_matrix_multiply (&d->device, &points, graphics->copy_of_ctm);
+	}
+}
+
+static void
+decimator_device_point (GpLineDecimator *d, double x, double y, double *dx, double *dy)
+{
+	cairo_matrix_transform_point (&d->device, &x, &y);
+	*dx = floor (x);
+	*dy = y;
+}
+
+static void
+decimator_move_to (GpLineDecimator *d, double x, double y)
+{
+	gdip_cairo_move_to (d->graphics, x, y, d->convert_units, d->antialiasing);
+	if (d->enabled)
+		decimator_device_point (d, x, y, &d->column, &d->y);
+	d->count = 0;
+}
+
+/* draw the run kept for the current column */
+static void
+decimator_flush (GpLineDecimator *d)
+{
+	GpPointF *first = &d->min, *second = &d->max;
+	int first_index = d->min_index, second_index = d->max_index;
+
+	if (d->count == 0)
+		return;
+
+	if (first_index > second_index) {
+		first = &d->max;
+		second = &d->min;
+		first_index = d->max_index;
+		second_index = d->min_index;
+	}
+
+	if (first_index < d->count)
+		gdip_cairo_line_to (d->graphics, first->X, first->Y, d->convert_units, d->antialiasing);
+	if ((second_index != first_index) && (second_index < d->count))
+		gdip_cairo_line_to (d->graphics, second->X, second->Y, d->convert_units, d->antialiasing);
+	gdip_cairo_line_to (d->graphics, d->last.X, d->last.Y, d->convert_units, d->antialiasing);
+	d->count = 0;
+}
+
+static void
+decimator_line_to (GpLineDecimator *d, double x, double y)
+{
+	double column, dy;
+
+	if (!d->enabled) {
+		gdip_cairo_line_to (d->graphics, x, y, d->convert_units, d->antialiasing);
+		return;
+	}
+
+	decimator_device_point (d, x, y, &column, &dy);
+	d->y = dy;
+	if (column != d->column) {
+		decimator_flush (d);
+		gdip_cairo_line_to (d->graphics, x, y, d->convert_units, d->antialiasing);
+		d->column = column;
+		return;
+	}
+
+	d->count++;
+	d->last.X = x;
+	d->last.Y = y;
+	if ((d->count == 1) || (dy < d->min_y)) {
+		d->min = d->last;
+		d->min_y = dy;
+		d->min_index = d->count;
+	}
+	if ((d->count == 1) || (dy > d->max_y)) {
+		d->max = d->last;
+		d->max_y = dy;
+		d->max_index = d->count;
+	}
+}
+
+static void
+decimator_curve_to (GpLineDecimator *d, double x1, double y1, double x2, double y2, double x3, double y3)
+{
+	double c1, c2, c3, dy1, dy2, dy3, top, bottom;
+
+	if (d->enabled) {
+		decimator_device_point (d, x1, y1, &c1, &dy1);
+		decimator_device_point (d, x2, y2, &c2, &dy2);
+		decimator_device_point (d, x3, y3, &c3, &dy3);
+
+		/* a curve staying in the column, and within a pixel of its end points, is drawn as a line */
+		top = MIN (d->y, dy3) - 1;
+		bottom = MAX (d->y, dy3) + 1;
+		if ((c1 == d->column) && (c2 == d->column) && (c3 == d->column) &&
+			(dy1 >= top) && (dy1 <= bottom) && (dy2 >= top) && (dy2 <= bottom)) {
+			decimator_line_to (d, x3, y3);
+			return;
+		}
+
+		decimator_flush (d);
+		d->column = c3;
+		d->y = dy3;
+	}
+
+	gdip_cairo_curve_to (d->graphics, x1, y1, x2, y2, x3, y3, d->convert_units, d->antialiasing);
+}
+
+static void
+make_curve (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPointF *points, GpPointF *tangents, int offset, int length,
 	_CurveType type, BOOL antialiasing)
 {
+	GpLineDecimator d;
         int i;
 
-	gdip_cairo_move_to (graphics, points [offset].X, points [offset].Y, FALSE, antialiasing);
+	decimator_init (&d, graphics, pen, FALSE, antialiasing);
+	decimator_move_to (&d, points [offset].X, points [offset].Y);
 
 	for (i = offset; i < offset + length; i++) {
 		int j = i + 1;
@@ -342,7 +676,7 @@ make_curve (GpGraphics *graphics, GDIPCONST GpPointF *points, GpPointF *tangents
 		double x3 = points [j].X;
 		double y3 = points [j].Y;
 
-		gdip_cairo_curve_to (graphics, x1, y1, x2, y2, x3, y3, FALSE, antialiasing);
+		decimator_curve_to (&d, x1, y1, x2, y2, x3, y3);
         }
 
         if (type == CURVE_CLOSE) {
@@ -356,9 +690,12 @@ make_curve (GpGraphics *graphics, GDIPCONST GpPointF *points, GpPointF *tangents
 		double x3 = points [0].X;
 		double y3 = points [0].Y;
 
-		gdip_cairo_curve_to (graphics, x1, y1, x2, y2, x3, y3, FALSE, antialiasing);
+		decimator_curve_to (&d, x1, y1, x2, y2, x3, y3);
+		decimator_flush (&d);
 
                 cairo_close_path (graphics->ct);
+	} else {
+		decimator_flush (&d);
 	}
 }
 
@@ -370,7 +707,7 @@ cairo_DrawClosedCurve2 (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPointF *po
 	if (!tangents)
 		return OutOfMemory;
 
-	make_curve (graphics, points, tangents, 0, count - 1, CURVE_CLOSE, TRUE);
+	make_curve (graphics, pen, points, tangents, 0, count - 1, CURVE_CLOSE, TRUE);
 	status = stroke_graphics_with_pen (graphics, pen);
 
 	GdipFree (tangents);        
@@ -398,7 +735,7 @@ cairo_FillClosedCurve2 (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPointF
 	if (!tangents)
 		return OutOfMemory;
 
-	make_curve (graphics, points, tangents, 0, count - 1, CURVE_CLOSE, FALSE);
+	make_curve (graphics, NULL, points, tangents, 0, count - 1, CURVE_CLOSE, FALSE);
 	status = fill_graphics_with_brush (graphics, brush, FALSE);
 
 	GdipFree (tangents);
@@ -427,7 +764,7 @@ cairo_DrawCurve3 (GpGraphics *graphics, GpPen* pen, GDIPCONST GpPointF *points,
 	if (!tangents)
 		return OutOfMemory;
 
-	make_curve (graphics, points, tangents, offset, numOfSegments, CURVE_OPEN, TRUE);
+	make_curve (graphics, pen, points, tangents, offset, numOfSegments, CURVE_OPEN, TRUE);
 	status = stroke_graphics_with_pen (graphics, pen);
 
 	GdipFree (tangents);
@@ -502,26 +839,54 @@ cairo_DrawLine (GpGraphics *graphics, GpPen *pen, float x1, float y1, float x2,
 GpStatus 
 cairo_DrawLines (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPointF *points, int count)
 {
+	GpLineDecimator d;
+	GpCullRect cull;
 	int i;
-	float last_x, last_y, prev_x, prev_y;
 	GpStatus ret;
 
+	cull_init (&cull, graphics, pen);
+
 	/* We use graphics->copy_of_ctm matrix for path creation. We should have it set already. */
-	gdip_cairo_move_to (graphics, points [0].X, points [0].Y, TRUE, TRUE);
+	decimator_init (&d, graphics, pen, TRUE, TRUE);
+
+	if (cull.cut && (count >= CULL_MIN_POINTS)) {
+		/* only draw the runs of segments which can be visible */
+		GpCullPoint p, q;
+		BOOL drawing = FALSE;
+
+		cull_user_point (graphics, &points [0], &p);
+		for (i = 1; i < count; i++, p = q) {
+			cull_user_point (graphics, &points [i], &q);
+			if (cull_segment_misses (&cull, &p, &q)) {
+				if (drawing)
+					decimator_flush (&d);
+				drawing = FALSE;
+				continue;
+			}
 
-	for (i = 1; i < count; i++) {
-		gdip_cairo_line_to (graphics, points [i].X, points [i].Y, TRUE, TRUE);
-		prev_x = points [i - 1].X;
-		prev_y = points [i - 1].Y;
-		last_x = points [i].X;
-		last_y = points [i].Y;
+			if (!drawing)
+				decimator_move_to (&d, points [i - 1].X, points [i - 1].Y);
+			decimator_line_to (&d, points [i].X, points [i].Y);
+			drawing = TRUE;
+		}
+		decimator_flush (&d);
+	} else if (cull_points (&cull, graphics, points, count)) {
+		/* nothing can be visible */
+	} else if (!d.enabled) {
+		gdip_cairo_lines (graphics, points, count, TRUE, TRUE);
+	} else {
+		decimator_move_to (&d, points [0].X, points [0].Y);
+		for (i = 1; i < count; i++)
+			decimator_line_to (&d, points [i].X, points [i].Y);
+		decimator_flush (&d);
 	}
 
 	ret = stroke_graphics_with_pen (graphics, pen);
 
 	if (count > 1) {
 		gdip_pen_draw_custom_start_cap (graphics, pen, points [0].X, points [0].Y, points [1].X, points [1].Y);
-		gdip_pen_draw_custom_end_cap (graphics, pen, last_x, last_y, prev_x, prev_y);
+		gdip_pen_draw_custom_end_cap (graphics, pen, points [count - 1].X, points [count - 1].Y,
+			points [count - 2].X, points [count - 2].Y);
 	}
 
 	return ret;
@@ -530,126 +895,332 @@ cairo_DrawLines (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPointF *points, i
 GpStatus 
 cairo_DrawLinesI (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPoint *points, int count)
 {
-	int i;
-	float last_x, last_y, prev_x, prev_y;
-	GpStatus ret;
+	GpStatus status;
+	GpPointF *pt = convert_points (points, count);
+	if (!pt)
+		return OutOfMemory;
 
-	/* We use graphics->copy_of_ctm matrix for path creation. We should have it set already. */
-	gdip_cairo_move_to (graphics, points [0].X, points [0].Y, TRUE, TRUE);
+	status = cairo_DrawLines (graphics, pen, pt, count);
+	GdipFree (pt);
+	return status;
+}
 
-	for (i = 1; i < count; i++) {
-		gdip_cairo_line_to (graphics, points [i].X, points [i].Y, TRUE, TRUE);
-		prev_x = points [i - 1].X;
-		prev_y = points [i - 1].Y;
-		last_x = points [i].X;
-		last_y = points [i].Y;
-	}
+/* the cached cairo paths are built when drawn, and the same path may be drawn by several threads at once */
+static GStaticMutex path_cache_mutex = G_STATIC_MUTEX_INIT;
 
-	ret = stroke_graphics_with_pen (graphics, pen);
+/* the cached cairo path is only usable for the same path version, units, resolution and antialiasing offset */
+static BOOL
+gdip_path_cairo_cache_is_valid (GpGraphics *graphics, GpPath *path, BOOL antialiasing)
+{
+	GpPathCairoCache *cache = path->cairo_cache;
+
+	if ((cache->version != path->version) || (cache->antialiasing != antialiasing))
+		return FALSE;
+	if ((cache->page_unit != graphics->page_unit) || (cache->type != graphics->type) ||
+		(cache->dpi_x != graphics->dpi_x) || (cache->dpi_y != graphics->dpi_y))
+		return FALSE;
+	return !antialiasing || ((cache->aa_offset_x == graphics->aa_offset_x) && (cache->aa_offset_y == graphics->aa_offset_y));
+}
 
-	if (count > 1) {
-		gdip_pen_draw_custom_start_cap (graphics, pen, points [0].X, points [0].Y, points [1].X, points [1].Y);
-		gdip_pen_draw_custom_end_cap (graphics, pen, last_x, last_y, prev_x, prev_y);
+/* split the cached data into figures, with their bounds, so invisible ones can be skipped */
+static void
+gdip_path_cairo_cache_figures (GpPathCairoCache *cache)
+{
+	cairo_path_data_t *data = cache->data;
+	GpPathCairoFigure *figure = NULL;
+	int i, j, count = 0;
+
+	if ((cache->num_data == 0) || (data [0].header.type != CAIRO_PATH_MOVE_TO))
+		return;
+
+	for (i = 0; i < cache->num_data; i += data [i].header.length) {
+		if (data [i].header.type == CAIRO_PATH_MOVE_TO)
+			count++;
 	}
 
-	return ret;
+	/* without figures the whole path is drawn */
+	cache->figures = (GpPathCairoFigure*) GdipAlloc (count * sizeof (GpPathCairoFigure));
+	if (!cache->figures)
+		return;
+
+	for (i = 0; i < cache->num_data; i += data [i].header.length) {
+		if (data [i].header.type == CAIRO_PATH_MOVE_TO) {
+			figure = &cache->figures [cache->num_figures++];
+			figure->start = i;
+			figure->num_data = 0;
+			figure->x1 = figure->x2 = data [i + 1].point.x;
+			figure->y1 = figure->y2 = data [i + 1].point.y;
+		}
+
+		for (j = 1; j < data [i].header.length; j++) {
+			figure->x1 = MIN (figure->x1, data [i + j].point.x);
+			figure->y1 = MIN (figure->y1, data [i + j].point.y);
+			figure->x2 = MAX (figure->x2, data [i + j].point.x);
+			figure->y2 = MAX (figure->y2, data [i + j].point.y);
+		}
+		figure->num_data += data [i].header.length;
+	}
 }
 
-GpStatus
-gdip_plot_path (GpGraphics *graphics, GpPath *path, BOOL antialiasing)
+/* convert the whole path into cairo path data, kept with the path to be replayed later */
+static GpStatus
+gdip_path_cairo_cache_build (GpGraphics *graphics, GpPath *path, BOOL antialiasing)
 {
-        int length = path->count;
-        int i, idx = 0;
+	GpPathCairoCache *cache;
+	cairo_path_data_t *data, *plotted;
+	int pts [3];
+	int length = path->count;
+	int i, idx = 0, n = 0;
+
+	gdip_path_cairo_cache_invalidate (path);
+
+	cache = (GpPathCairoCache*) GdipAlloc (sizeof (GpPathCairoCache));
+	if (!cache)
+		return OutOfMemory;
+
+	/* worst case: a header and a point for each point, plus a close for each point */
+	data = (length > 0) ? (cairo_path_data_t*) GdipAlloc (sizeof (cairo_path_data_t) * length * 3) : NULL;
+	if ((length > 0) && !data) {
+		GdipFree (cache);
+		return OutOfMemory;
+	}
+
+	/* same conversions as gdip_cairo_move_to, gdip_cairo_line_to and gdip_cairo_curve_to, for all the points at once */
+	plotted = (length > 0) ? (cairo_path_data_t*) GdipAlloc (sizeof (cairo_path_data_t) * length) : NULL;
+	if ((length > 0) && !plotted) {
+		GdipFree (data);
+		GdipFree (cache);
+		return OutOfMemory;
+	}
+	if (length > 0)
+		gdip_cairo_points (graphics, (GpPointF*) path->points->data, length, TRUE, antialiasing, plotted, 1);
 
         for (i = 0; i < length; ++i) {
-                GpPointF pt = g_array_index (path->points, GpPointF, i);
                 BYTE type = g_array_index (path->types, BYTE, i);
-                GpPointF pts [3];
 
 		/* mask the bits so that we get only the type value not the other flags */
                 switch (type & PathPointTypePathTypeMask) {
                 case PathPointTypeStart:
-			gdip_cairo_move_to (graphics, pt.X, pt.Y, TRUE, antialiasing);
+			data [n].header.type = CAIRO_PATH_MOVE_TO;
+			data [n].header.length = 2;
+			data [n + 1] = plotted [i];
+			n += 2;
                         break;
 
                 case PathPointTypeLine:
-			gdip_cairo_line_to (graphics, pt.X, pt.Y, TRUE, antialiasing);
+			data [n].header.type = CAIRO_PATH_LINE_TO;
+			data [n].header.length = 2;
+			data [n + 1] = plotted [i];
+			n += 2;
                         break;
 
                 case PathPointTypeBezier:
                         /* make sure we only add at most 3 points to pts */
                         if (idx < 3) {
-                                pts [idx] = pt;
+                                pts [idx] = i;
                                 idx ++;
                         }
 
                         /* once we've added 3 pts, we can draw the curve */
                         if (idx == 3) {
-				gdip_cairo_curve_to (graphics, pts[0].X, pts[0].Y, pts[1].X, pts[1].Y,
-					pts[2].X, pts[2].Y, TRUE, antialiasing);
-
+				data [n].header.type = CAIRO_PATH_CURVE_TO;
+				data [n].header.length = 4;
+				data [n + 1] = plotted [pts [0]];
+				data [n + 2] = plotted [pts [1]];
+				data [n + 3] = plotted [pts [2]];
+				n += 4;
                                 idx = 0;
                         }
 
                         break;
                 default:
 			g_warning ("Unknown PathPointType %d", type);
+			GdipFree (plotted);
+			GdipFree (data);
+			GdipFree (cache);
                         return NotImplemented;
                 }
 
 		/* close the subpath */
-		if (type & PathPointTypeCloseSubpath)
-			cairo_close_path (graphics->ct);
+		if (type & PathPointTypeCloseSubpath) {
+			data [n].header.type = CAIRO_PATH_CLOSE_PATH;
+			data [n].header.length = 1;
+			n++;
+		}
         }
+
+	GdipFree (plotted);
+	cache->data = data;
+	cache->num_data = n;
+	cache->version = path->version;
+	cache->type = graphics->type;
+	cache->page_unit = graphics->page_unit;
+	cache->dpi_x = graphics->dpi_x;
+	cache->dpi_y = graphics->dpi_y;
+	cache->antialiasing = antialiasing;
+	cache->aa_offset_x = graphics->aa_offset_x;
+	cache->aa_offset_y = graphics->aa_offset_y;
+	cache->figures = NULL;
+	cache->num_figures = 0;
+	gdip_path_cairo_cache_figures (cache);
+	path->cairo_cache = cache;
+	return Ok;
+}
+
+static void
+gdip_append_path_data (GpGraphics *graphics, cairo_path_data_t *data, int num_data)
+{
+	cairo_path_t cpath;
+
+	cpath.status = CAIRO_STATUS_SUCCESS;
+	cpath.data = data;
+	cpath.num_data = num_data;
+	cairo_append_path (graphics->ct, &cpath);
+}
+
+/* like gdip_plot_path, but the figures which can't be visible are skipped */
+static GpStatus
+gdip_plot_path_culled (GpGraphics *graphics, GpPath *path, BOOL antialiasing, GpCullRect *cull)
+{
+	GpPathCairoCache *cache;
+	int i, start = 0, end = 0;
+
+	/* apply antialiasing offset (if required and if no scaling is in effect) */
+	antialiasing = antialiasing && !gdip_is_scaled (graphics);
+
+	/* another thread can't rebuild (and free) the cache until it's appended */
+	g_static_mutex_lock (&path_cache_mutex);
+	if (!path->cairo_cache || !gdip_path_cairo_cache_is_valid (graphics, path, antialiasing)) {
+		GpStatus status = gdip_path_cairo_cache_build (graphics, path, antialiasing);
+		if (status != Ok) {
+			g_static_mutex_unlock (&path_cache_mutex);
+			return status;
+		}
+	}
+
+	cache = path->cairo_cache;
+	if (cache->num_data == 0) {
+		g_static_mutex_unlock (&path_cache_mutex);
+		return Ok;
+	}
+
+	if (!cull || !cull->enabled || !cache->figures) {
+		gdip_append_path_data (graphics, cache->data, cache->num_data);
+		g_static_mutex_unlock (&path_cache_mutex);
+		return Ok;
+	}
+
+	/* consecutive visible figures are appended together */
+	for (i = 0; i < cache->num_figures; i++) {
+		GpPathCairoFigure *figure = &cache->figures [i];
+
+		if (cull_rect_misses (cull, figure->x1, figure->y1, figure->x2, figure->y2))
+			continue;
+
+		if (figure->start != end) {
+			if (end > start)
+				gdip_append_path_data (graphics, cache->data + start, end - start);
+			start = figure->start;
+		}
+		end = figure->start + figure->num_data;
+	}
+	if (end > start)
+		gdip_append_path_data (graphics, cache->data + start, end - start);
+	g_static_mutex_unlock (&path_cache_mutex);
 	return Ok;
 }
 
+/*
+ * Add the path to the current cairo path. The converted coordinates are cached
+ * with the path so redrawing an unchanged path is a single cairo_append_path.
+ */
+GpStatus
+gdip_plot_path (GpGraphics *graphics, GpPath *path, BOOL antialiasing)
+{
+	return gdip_plot_path_culled (graphics, path, antialiasing, NULL);
+}
+
+/* draw any custom pen caps, at the path start and end */
+static void
+draw_path_custom_caps (GpGraphics *graphics, GpPen *pen, GpPath *path)
+{
+	GpPointF *points = (GpPointF*) path->points->data;
+	int count = path->count;
+
+	/* To know the angle of the end cap, we need the penultimate point. */
+	if (count > 1) {
+		gdip_pen_draw_custom_start_cap (graphics, pen, points [0].X, points [0].Y, points [1].X, points [1].Y);
+		gdip_pen_draw_custom_end_cap (graphics, pen, points [count - 1].X, points [count - 1].Y, points [count - 2].X, points [count - 2].Y);
+	}
+}
+
 GpStatus
 cairo_DrawPath (GpGraphics *graphics, GpPen *pen, GpPath *path)
 {
-	GpStatus ret;
-	int count;
-	GpPointF *points;
+	GpStatus ret, status;
+	GpCullRect cull;
 
 	/* We use graphics->copy_of_ctm matrix for path creation. We should have it set already. */
-	GpStatus status = gdip_plot_path (graphics, path, TRUE);
+	cull_init (&cull, graphics, pen);
+	status = gdip_plot_path_culled (graphics, path, TRUE, &cull);
 	if (status != Ok)
 		return status;
 
 	ret = stroke_graphics_with_pen (graphics, pen);
 
 	/* Draw any custom pen end caps */
+	draw_path_custom_caps (graphics, pen, path);
+	return ret;
+}
+
+/*
+ * cairo_DrawPaths:
+ *
+ * Stroke each path like cairo_DrawPath does, but setup the pen only once.
+ * The paths are stroked one by one, so a translucent pen paints the areas
+ * where they overlap twice, like separate calls do.
+ */
+GpStatus
+cairo_DrawPaths (GpGraphics *graphics, GpPen *pen, GpPath **paths, int count)
+{
+	GpStatus status;
+	GpCullRect cull;
+	cairo_matrix_t pen_matrix;
+	int i;
 
-	status = GdipGetPointCount (path, &count);
+	/* the stroke uses the matrix of the pen setup, the paths use graphics->copy_of_ctm */
+	gdip_pen_setup (graphics, pen);
+	cairo_get_matrix (graphics->ct, &pen_matrix);
+	cairo_set_matrix (graphics->ct, graphics->copy_of_ctm);
 
-	/* To know the angle of the end cap, we need the penultimate point.
-	   Unfortunately there's no way of getting it without getting all
-	   the points :-(
-	 */
-	if (status == Ok && count > 1) {
-		points = gdip_calloc (count, sizeof(GpPointF));
-		if (points == NULL) {
-			return OutOfMemory;
+	cull_init (&cull, graphics, pen);
+	for (i = 0; i < count; i++) {
+		status = gdip_plot_path_culled (graphics, paths [i], TRUE, &cull);
+		if (status != Ok) {
+			cairo_new_path (graphics->ct);
+			return status;
 		}
-		status = GdipGetPathPoints (path, points, count);
 
-		if (status == Ok) {
-			gdip_pen_draw_custom_start_cap (graphics, pen, points [0].X, points [0].Y, points [1].X, points [1].Y);
-			gdip_pen_draw_custom_end_cap (graphics, pen, points [count - 1].X, points [count - 1].Y, points [count - 2].X, points [count - 2].Y);
-		}
+		cairo_set_matrix (graphics->ct, &pen_matrix);
+		cairo_stroke (graphics->ct);
+		cairo_set_matrix (graphics->ct, graphics->copy_of_ctm);
 
-		GdipFree (points);
+		draw_path_custom_caps (graphics, pen, paths [i]);
 	}
 
-	return ret;
+	return gdip_get_status (cairo_status (graphics->ct));
 }
 
 /* FIXME - this doesn't match MS behaviour when we use really complex paths with internal intersections */
 GpStatus
 cairo_FillPath (GpGraphics *graphics, GpBrush *brush, GpPath *path)
 {
+	GpStatus status;
+	GpCullRect cull;
+
 	/* We use graphics->copy_of_ctm matrix for path creation. We should have it set already. */
-	GpStatus status = gdip_plot_path (graphics, path, TRUE);
+	cull_init (&cull, graphics, NULL);
+	status = gdip_plot_path_culled (graphics, path, TRUE, &cull);
 	if (status != Ok)
 		return status;
 
@@ -659,6 +1230,44 @@ cairo_FillPath (GpGraphics *graphics, GpBrush *brush, GpPath *path)
 	return fill_graphics_with_brush (graphics, brush, TRUE);
 }
 
+/*
+ * cairo_FillPaths:
+ *
+ * Fill each path like cairo_FillPath does, but setup the brush only once.
+ * The paths aren't merged into fewer fills: overlapping paths must be
+ * painted twice and keep their own fill mode, and even paths that don't
+ * overlap share the antialiased pixels of their nearby edges. Telling the
+ * paths that are a pixel apart from all the others would cost more than the
+ * fills it saves on a grid of shapes, the case this is used for.
+ */
+GpStatus
+cairo_FillPaths (GpGraphics *graphics, GpBrush *brush, GpPath **paths, int count)
+{
+	GpStatus status = Ok;
+	GpCullRect cull;
+	int i;
+
+	/* the source keeps the brush transform, the paths use graphics->copy_of_ctm */
+	gdip_brush_setup (graphics, brush);
+	cairo_set_matrix (graphics->ct, graphics->copy_of_ctm);
+
+	cull_init (&cull, graphics, NULL);
+	for (i = 0; i < count; i++) {
+		status = gdip_plot_path_culled (graphics, paths [i], TRUE, &cull);
+		if (status != Ok) {
+			cairo_new_path (graphics->ct);
+			return status;
+		}
+
+		cairo_set_fill_rule (graphics->ct, gdip_convert_fill_mode (paths [i]->fill_mode));
+		// filled paths includes the stroke
+		fill_graphics_path (graphics, TRUE);
+	}
+
+	cairo_set_matrix (graphics->ct, graphics->copy_of_ctm);
+	return gdip_get_status (cairo_status (graphics->ct));
+}
+
 static void
 make_pie (GpGraphics *graphics, float x, float y, float width, float height,
 	float startAngle, float sweepAngle, BOOL antialiasing)
@@ -734,38 +1343,60 @@ cairo_FillPie (GpGraphics *graphics, GpBrush *brush, float x, float y, float wid
  * Polygons
  */
 
-static void
-make_polygon (GpGraphics *graphics, GDIPCONST GpPointF *points, int count, BOOL antialiasing)
+/*
+ * make_polygon_culled:
+ *
+ * Add the part of a large polygon which can be visible. Returns FALSE if the
+ * whole polygon must be added instead (out of memory, or nothing to cut).
+ */
+static BOOL
+make_polygon_culled (GpGraphics *graphics, GDIPCONST GpPointF *points, int count, BOOL antialiasing, GpCullRect *cull)
 {
-        int i;
+	GpCullPoint *user, *clipped;
+	BOOL inside = TRUE;
+	int i, n;
 
-	gdip_cairo_move_to (graphics, points [0].X, points [0].Y, TRUE, antialiasing);
+	user = (GpCullPoint*) GdipAlloc (count * sizeof (GpCullPoint));
+	if (!user)
+		return FALSE;
 
 	for (i = 0; i < count; i++) {
-		gdip_cairo_line_to (graphics, points [i].X, points [i].Y, TRUE, antialiasing);
+		cull_user_point (graphics, &points [i], &user [i]);
+		if ((user [i].x < cull->x1) || (user [i].x > cull->x2) || (user [i].y < cull->y1) || (user [i].y > cull->y2))
+			inside = FALSE;
 	}
 
-        /*
-         * Draw a line from the last point back to the first point if
-	 * they're not the same
-         */
-	if (points [0].X != points [count-1].X && points [0].Y != points [count-1].Y) {
-		gdip_cairo_line_to (graphics, points [0].X, points [0].Y, TRUE, antialiasing);
+	if (inside) {
+		GdipFree (user);
+		return FALSE;
 	}
 
-        cairo_close_path (graphics->ct);
+	clipped = cull_clip_polygon (cull, user, count, &n);
+	GdipFree (user);
+	if (!clipped)
+		return FALSE;
+
+	/* units are already converted */
+	if (n >= 3) {
+		gdip_cairo_move_to (graphics, clipped [0].x, clipped [0].y, FALSE, antialiasing);
+		for (i = 1; i < n; i++)
+			gdip_cairo_line_to (graphics, clipped [i].x, clipped [i].y, FALSE, antialiasing);
+		cairo_close_path (graphics->ct);
+	}
+
+	GdipFree (clipped);
+	return TRUE;
 }
 
 static void
-make_polygon_from_integers (GpGraphics *graphics, GDIPCONST GpPoint *points, int count, BOOL antialiasing)
+make_polygon (GpGraphics *graphics, GDIPCONST GpPointF *points, int count, BOOL antialiasing, GpCullRect *cull)
 {
-        int i;
-
-	gdip_cairo_move_to (graphics, points [0].X, points [0].Y, TRUE, antialiasing);
+	if (cull_points (cull, graphics, points, count))
+		return;
+	if (cull->cut && (count >= CULL_MIN_POINTS) && make_polygon_culled (graphics, points, count, antialiasing, cull))
+		return;
 
-	for (i = 0; i < count; i++) {
-		gdip_cairo_line_to (graphics, points [i].X, points [i].Y, TRUE, antialiasing);
-	}
+	gdip_cairo_lines (graphics, points, count, TRUE, antialiasing);
 
         /*
          * Draw a line from the last point back to the first point if
@@ -781,21 +1412,33 @@ make_polygon_from_integers (GpGraphics *graphics, GDIPCONST GpPoint *points, int
 GpStatus
 cairo_DrawPolygon (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPointF *points, int count)
 {
-	make_polygon (graphics, points, count, TRUE);
+	GpCullRect cull;
+
+	cull_init (&cull, graphics, pen);
+	make_polygon (graphics, points, count, TRUE, &cull);
 	return stroke_graphics_with_pen (graphics, pen);
 }
 
 GpStatus
 cairo_DrawPolygonI (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPoint *points, int count)
 {
-	make_polygon_from_integers (graphics, points, count, TRUE);
-	return stroke_graphics_with_pen (graphics, pen);
+	GpStatus status;
+	GpPointF *pt = convert_points (points, count);
+	if (!pt)
+		return OutOfMemory;
+
+	status = cairo_DrawPolygon (graphics, pen, pt, count);
+	GdipFree (pt);
+	return status;
 }
 
 GpStatus
 cairo_FillPolygon (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPointF *points, int count, FillMode fillMode)
 {
-	make_polygon (graphics, points, count, FALSE);
+	GpCullRect cull;
+
+	cull_init (&cull, graphics, NULL);
+	make_polygon (graphics, points, count, FALSE, &cull);
 	cairo_set_fill_rule (graphics->ct, gdip_convert_fill_mode (fillMode));
 	return fill_graphics_with_brush (graphics, brush, FALSE);
 }
@@ -803,9 +1446,14 @@ cairo_FillPolygon (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPointF *poi
 GpStatus
 cairo_FillPolygonI (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPoint *points, int count, FillMode fillMode)
 {
-	make_polygon_from_integers (graphics, points, count, FALSE);
-	cairo_set_fill_rule (graphics->ct, gdip_convert_fill_mode (fillMode));
-	return fill_graphics_with_brush (graphics, brush, FALSE);
+	GpStatus status;
+	GpPointF *pt = convert_points (points, count);
+	if (!pt)
+		return OutOfMemory;
+
+	status = cairo_FillPolygon (graphics, brush, pt, count, fillMode);
+	GdipFree (pt);
+	return status;
 }
 
 /*
@@ -947,6 +1595,200 @@ cairo_FillRectanglesI (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpRect *r
 	return fill_graphics_with_brush (graphics, brush, FALSE);
 }
 
+/*
+ * Batches of solid colored rectangles or ellipses. Items of the same color are
+ * grouped and each group is filled at once. An item can join the group of its
+ * color only if it doesn't overlap the groups created after it (which are
+ * filled later), so the stacking order is kept. Translucent items must not
+ * overlap (or touch) their own group either, since a group paints the union of
+ * its items only once. With antialiasing, the partially covered pixels of two
+ * items blend differently when filled together, so an item must also stay a
+ * pixel away from its own group and from the later ones. When an item can't
+ * join its group, all the groups are filled and the grouping starts again.
+ */
+#define BATCH_MAX_GROUPS	16
+
+typedef struct {
+	ARGB		color;
+	GpRectF		bounds;
+	int		first;		/* linked through next */
+	int		last;
+} GpBatchGroup;
+
+static BOOL
+batch_rects_near (GDIPCONST GpRectF *a, GDIPCONST GpRectF *b, float gap_x, float gap_y)
+{
+	return (a->X < b->X + b->Width + gap_x) && (b->X < a->X + a->Width + gap_x) &&
+		(a->Y < b->Y + b->Height + gap_y) && (b->Y < a->Y + a->Height + gap_y);
+}
+
+static BOOL
+batch_rects_touch (GDIPCONST GpRectF *a, GDIPCONST GpRectF *b)
+{
+	return (a->X <= b->X + b->Width) && (b->X <= a->X + a->Width) && (a->Y <= b->Y + b->Height) && (b->Y <= a->Y + a->Height);
+}
+
+static GpStatus
+batch_fill_groups (GpGraphics *graphics, GpSolidFill *brush, GDIPCONST GpRectF *rects, int *next, BOOL ellipses,
+	GpBatchGroup *groups, int num_groups)
+{
+	GpStatus status;
+	int g, i;
+
+	for (g = 0; g < num_groups; g++) {
+		for (i = groups [g].first; i >= 0; i = next [i]) {
+			if (ellipses)
+				make_ellipse (graphics, rects [i].X, rects [i].Y, rects [i].Width, rects [i].Height, TRUE, FALSE);
+			else
+				gdip_cairo_rectangle (graphics, rects [i].X, rects [i].Y, rects [i].Width, rects [i].Height, FALSE);
+		}
+
+		GdipSetSolidFillColor (brush, groups [g].color);
+		/* all the items have the same orientation, winding gives their union */
+		cairo_set_fill_rule (graphics->ct, CAIRO_FILL_RULE_WINDING);
+		status = fill_graphics_with_brush (graphics, (GpBrush*) brush, FALSE);
+		if (status != Ok)
+			return status;
+	}
+	return Ok;
+}
+
+static GpStatus
+batch_fill_argb (GpGraphics *graphics, GDIPCONST GpRectF *items, GDIPCONST ARGB *colors, int count, BOOL ellipses)
+{
+	GpBatchGroup groups [BATCH_MAX_GROUPS];
+	GpSolidFill *brush;
+	GpStatus status = Ok;
+	GpRectF *rects;
+	int *next;
+	int i, g, num_groups = 0;
+	BOOL antialias, aligned = TRUE;
+	float gap_x = 0, gap_y = 0;
+
+	/* the gaps (in world units) that keep the antialiased edges of two items in distinct pixels */
+	antialias = (cairo_get_antialias (graphics->ct) != CAIRO_ANTIALIAS_NONE);
+	if (antialias) {
+		double px = 1, py = 0, qx = 0, qy = 1;
+
+		cairo_device_to_user_distance (graphics->ct, &px, &py);
+		cairo_device_to_user_distance (graphics->ct, &qx, &qy);
+		/* a rotation or a shear would need more than the bounds, don't merge at all */
+		aligned = gdip_near_zero (py) && gdip_near_zero (qx);
+		gap_x = fabs (px);
+		gap_y = fabs (qy);
+		if (!OPTIMIZE_CONVERSION (graphics)) {
+			gap_x = gdip_convgr_unitx (graphics, gap_x);
+			gap_y = gdip_convgr_unity (graphics, gap_y);
+		}
+	}
+
+	next = (int*) GdipAlloc (count * sizeof (int));
+	rects = (GpRectF*) GdipAlloc (count * sizeof (GpRectF));
+	if (!next || !rects) {
+		if (next)
+			GdipFree (next);
+		if (rects)
+			GdipFree (rects);
+		return OutOfMemory;
+	}
+
+	status = GdipCreateSolidFill (colors [0], &brush);
+	if (status != Ok) {
+		GdipFree (next);
+		GdipFree (rects);
+		return status;
+	}
+
+	for (i = 0; i < count; i++) {
+		BOOL join;
+
+		/* don't draw/fill rectangles with negative width/height (bug #77129) */
+		if (!ellipses && ((items [i].Width < 0) || (items [i].Height < 0)))
+			continue;
+
+		/* all the ellipses must have the same orientation, their union is filled with winding */
+		rects [i] = items [i];
+		if (rects [i].Width < 0) {
+			rects [i].X += rects [i].Width;
+			rects [i].Width = -rects [i].Width;
+		}
+		if (rects [i].Height < 0) {
+			rects [i].Y += rects [i].Height;
+			rects [i].Height = -rects [i].Height;
+		}
+
+		for (g = 0; g < num_groups; g++) {
+			if (groups [g].color == colors [i])
+				break;
+		}
+
+		if (g == num_groups)
+			join = FALSE;
+		else if (antialias)
+			join = aligned && !batch_rects_near (&rects [i], &groups [g].bounds, gap_x, gap_y);
+		else
+			join = ((colors [i] >> 24) == 0xFF) || !batch_rects_touch (&rects [i], &groups [g].bounds);
+
+		if (join) {
+			int later;
+
+			for (later = g + 1; later < num_groups; later++) {
+				if (batch_rects_near (&rects [i], &groups [later].bounds, gap_x, gap_y))
+					break;
+			}
+
+			if (later == num_groups) {
+				GpRectF *bounds = &groups [g].bounds;
+				float right = MAX (bounds->X + bounds->Width, rects [i].X + rects [i].Width);
+				float bottom = MAX (bounds->Y + bounds->Height, rects [i].Y + rects [i].Height);
+
+				bounds->X = MIN (bounds->X, rects [i].X);
+				bounds->Y = MIN (bounds->Y, rects [i].Y);
+				bounds->Width = right - bounds->X;
+				bounds->Height = bottom - bounds->Y;
+				next [groups [g].last] = i;
+				groups [g].last = i;
+				next [i] = -1;
+				continue;
+			}
+		}
+
+		/* a new group, after filling the existing ones if needed */
+		if ((g < num_groups) || (num_groups == BATCH_MAX_GROUPS)) {
+			status = batch_fill_groups (graphics, brush, rects, next, ellipses, groups, num_groups);
+			if (status != Ok)
+				break;
+			num_groups = 0;
+		}
+
+		groups [num_groups].color = colors [i];
+		groups [num_groups].bounds = rects [i];
+		groups [num_groups].first = groups [num_groups].last = i;
+		next [i] = -1;
+		num_groups++;
+	}
+
+	if (status == Ok)
+		status = batch_fill_groups (graphics, brush, rects, next, ellipses, groups, num_groups);
+
+	GdipDeleteBrush ((GpBrush*) brush);
+	GdipFree (next);
+	GdipFree (rects);
+	return status;
+}
+
+GpStatus
+cairo_FillRectanglesARGB (GpGraphics *graphics, GDIPCONST GpRectF *rects, GDIPCONST ARGB *colors, int count)
+{
+	return batch_fill_argb (graphics, rects, colors, count, FALSE);
+}
+
+GpStatus
+cairo_FillEllipsesARGB (GpGraphics *graphics, GDIPCONST GpRectF *rects, GDIPCONST ARGB *colors, int count)
+{
+	return batch_fill_argb (graphics, rects, colors, count, TRUE);
+}
+
 /*
  * Regions
  */
@@ -1077,23 +1919,120 @@ cairo_SetSmoothingMode (GpGraphics *graphics, SmoothingMode mode)
 	best thing for now is keep track of what the user wants and let Cairo do its autoclipping
 */
 
+/* the cached clip path is only usable for the same clip/cairo matrix, units and resolution */
+static BOOL
+gdip_clip_cache_is_valid (GpGraphics *graphics, GpRegionClipCache *cache, cairo_matrix_t *ctm)
+{
+	return (cache->page_unit == graphics->page_unit) && (cache->type == graphics->type) &&
+		(cache->dpi_x == graphics->dpi_x) && (cache->dpi_y == graphics->dpi_y) &&
+		gdip_cairo_matrix_equal (&cache->clip_matrix, graphics->clip_matrix) &&
+		gdip_cairo_matrix_equal (&cache->ctm, ctm);
+}
+
+/* keep a private copy of the path cairo built for the clip so we can replay it later */
+static void
+gdip_clip_cache_store (GpGraphics *graphics, cairo_matrix_t *ctm)
+{
+	GpRegionClipCache *cache;
+	cairo_path_t *path = cairo_copy_path (graphics->ct);
+
+	if (!path)
+		return;
+	if (path->status != CAIRO_STATUS_SUCCESS) {
+		cairo_path_destroy (path);
+		return;
+	}
+
+	cache = (GpRegionClipCache*) GdipAlloc (sizeof (GpRegionClipCache));
+	if (cache) {
+		cache->num_data = path->num_data;
+		if (path->num_data > 0) {
+			cache->data = (cairo_path_data_t*) GdipAlloc (sizeof (cairo_path_data_t) * path->num_data);
+			if (cache->data) {
+				memcpy (cache->data, path->data, sizeof (cairo_path_data_t) * path->num_data);
+			} else {
+				GdipFree (cache);
+				cache = NULL;
+			}
+		} else {
+			cache->data = NULL;
+		}
+	}
+
+	if (cache) {
+		gdip_cairo_matrix_copy (&cache->clip_matrix, graphics->clip_matrix);
+		gdip_cairo_matrix_copy (&cache->ctm, ctm);
+		cache->page_unit = graphics->page_unit;
+		cache->type = graphics->type;
+		cache->dpi_x = graphics->dpi_x;
+		cache->dpi_y = graphics->dpi_y;
+
+		gdip_region_clip_cache_invalidate (graphics->clip);
+		graphics->clip->clip_cache = cache;
+	}
+
+	cairo_path_destroy (path);
+}
+
 GpStatus
 cairo_SetGraphicsClip (GpGraphics *graphics)
 {
 	GpRegion *work;
+	GpRegion *clip = graphics->clip;
+	GpMatrix *matrix = graphics->clip_matrix;
+	cairo_matrix_t ctm;
         GpRectF* rect;
         int i;
 
 	cairo_reset_clip (graphics->ct);
  
-	if (gdip_is_InfiniteRegion (graphics->clip))
+	if (gdip_is_InfiniteRegion (clip))
+		return Ok;
+
+	cairo_new_path (graphics->ct);
+	cairo_get_matrix (graphics->ct, &ctm);
+
+	/* replay the path built the last time this region was used as a clip */
+	if (clip->clip_cache && gdip_clip_cache_is_valid (graphics, clip->clip_cache, &ctm)) {
+		cairo_path_t path;
+		path.status = CAIRO_STATUS_SUCCESS;
+		path.data = clip->clip_cache->data;
+		path.num_data = clip->clip_cache->num_data;
+		cairo_append_path (graphics->ct, &path);
+		cairo_clip (graphics->ct);
+		return Ok;
+	}
+
+	/* rectangles stay rectangles under a scale/translate clip matrix, no need to clone the region */
+	if ((clip->type == RegionTypeRectF) && (matrix->xy == 0.0f) && (matrix->yx == 0.0f)) {
+	        for (i = 0, rect = clip->rects; i < clip->cnt; i++, rect++) {
+			float x = rect->X * matrix->xx + matrix->x0;
+			float y = rect->Y * matrix->yy + matrix->y0;
+			float width = rect->Width * matrix->xx;
+			float height = rect->Height * matrix->yy;
+
+			if (width < 0) {
+				x += width;
+				width = -width;
+			}
+			if (height < 0) {
+				y += height;
+				height = -height;
+			}
+			gdip_cairo_rectangle (graphics, x, y, width, height, FALSE);
+		}
+		/* a single rectangle is cheaper to rebuild than to cache */
+		if (clip->cnt > 1)
+			gdip_clip_cache_store (graphics, &ctm);
+		cairo_clip (graphics->ct);
 		return Ok;
+	}
 
-	if (gdip_is_matrix_empty (graphics->clip_matrix)) {
-		work = graphics->clip;
+	if (gdip_is_matrix_empty (matrix)) {
+		work = clip;
 	} else {
-		GdipCloneRegion (graphics->clip, &work);
-		GdipTransformRegion (work, graphics->clip_matrix);
+		GdipCloneRegion (clip, &work);
+		GdipTransformRegion (work, matrix);
 	}
 
 	switch (work->type) {
@@ -1124,13 +2063,16 @@ cairo_SetGraphicsClip (GpGraphics *graphics)
 		g_warning ("Unknown region type %d", work->type);
 		break;
 	}
-	
-	cairo_clip (graphics->ct);
 
 	/* destroy the clone, if one was needed */
-	if (work != graphics->clip)
+	if (work != clip)
 		GdipDeleteRegion (work);
 
+	/* the path (and, even more, the scans) are costly to rebuild for every save/restore or transform reset */
+	if ((clip->type == RegionTypePath) || (clip->cnt > 1))
+		gdip_clip_cache_store (graphics, &ctm);
+
+	cairo_clip (graphics->ct);
 	return Ok;
 }
 
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "graphics-path-private.h"
+
+/*
+ * path_edge_init:
+ *
+ * Initialize @edge as the edge from @p to @q, always stored top to bottom.
+ * Returns FALSE for horizontal edges, they never cross a scanline.
+ */
+static BOOL
+path_edge_init (GpPathEdge *edge, GpPointF *p, GpPointF *q)
+{
+	if (p->Y == q->Y)
+		return FALSE;
+
+	if (p->Y < q->Y) {
+		edge->x1 = p->X;
+		edge->y1 = p->Y;
+		edge->x2 = q->X;
+		edge->y2 = q->Y;
+		edge->dir = 1;
+	} else {
+		edge->x1 = q->X;
+		edge->y1 = q->Y;
+		edge->x2 = p->X;
+		edge->y2 = p->Y;
+		edge->dir = -1;
+	}
+	return TRUE;
+}
+
+/* update the winding number and crossing count of (x, y) with the edge */
+static void
+path_edge_cross (GpPathEdge *edge, float x, float y, int *winding, int *crossings)
+{
+	double cx;
+
+	if ((y < edge->y1) || (y >= edge->y2))
+		return;
+
+	cx = edge->x1 + (double) (y - edge->y1) * (edge->x2 - edge->x1) / (edge->y2 - edge->y1);
+	if (cx <= x) {
+		*winding += edge->dir;
+		(*crossings)++;
+	}
+}
+
+/*
+ * path_get_edges:
+ *
+ * Call @func for each edge of the (flattened) path, including the implicit
+ * edge closing each figure (like filling does).
+ */
+static void
+path_get_edges (GpPath *path, void (*func) (GpPathEdge *edge, void *data), void *data)
+{
+	GpPointF *points = (GpPointF*) path->points->data;
+	BYTE *types = path->types->data;
+	GpPathEdge edge;
+	int start, end, i;
+
+	for (start = 0; start < path->count; start = end) {
+		for (end = start + 1; end < path->count; end++) {
+			if ((types [end] & PathPointTypePathTypeMask) == PathPointTypeStart)
+				break;
+		}
+
+		for (i = start; i < end - 1; i++) {
+			if (path_edge_init (&edge, &points [i], &points [i + 1]))
+				func (&edge, data);
+		}
+		if (path_edge_init (&edge, &points [end - 1], &points [start]))
+			func (&edge, data);
+	}
+}
+
+typedef struct {
+	float	x;
+	float	y;
+	int	winding;
+	int	crossings;
+} PathPointTest;
+
+static void
+path_point_test_edge (GpPathEdge *edge, void *data)
+{
+	PathPointTest *test = (PathPointTest*) data;
+
+	path_edge_cross (edge, test->x, test->y, &test->winding, &test->crossings);
+}
+
+static void
+path_index_add_edge (GpPathEdge *edge, void *data)
+{
+	GpPathEdgeIndex *index = (GpPathEdgeIndex*) data;
+
+	if (index->cnt == 0) {
+		index->top = edge->y1;
+		index->bottom = edge->y2;
+	} else {
+		index->top = MIN (index->top, edge->y1);
+		index->bottom = MAX (index->bottom, edge->y2);
+	}
+	index->edges [index->cnt++] = *edge;
+}
+
+static int
+path_index_band (GpPathEdgeIndex *index, float y)
+{
+	int band = (int) ((y - index->top) / index->band_height);
+
+	return CLAMP (band, 0, index->bands - 1);
+}
+
+/* number of band entries needed for the edges with the current band count */
+static int
+path_index_entries (GpPathEdgeIndex *index)
+{
+	int i, total = 0;
+
+	for (i = 0; i < index->cnt; i++)
+		total += path_index_band (index, index->edges [i].y2) - path_index_band (index, index->edges [i].y1) + 1;
+	return total;
+}
+
+static GpPathEdgeIndex*
+path_index_create (GpPath *path)
+{
+	GpPathEdgeIndex *index;
+	GpPath *lines = path;
+	int i, j, total;
+
+	/* curves are tested on their flattened version */
+	if (gdip_path_has_curve (path)) {
+		if (GdipClonePath (path, &lines) != Ok)
+			return NULL;
+		if (GdipFlattenPath (lines, NULL, PATH_INDEX_FLATNESS) != Ok) {
+			GdipDeletePath (lines);
+			return NULL;
+		}
+	}
+
+	index = (GpPathEdgeIndex*) GdipAlloc (sizeof (GpPathEdgeIndex));
+	if (!index)
+		goto error;
+	memset (index, 0, sizeof (GpPathEdgeIndex));
+	index->version = path->version;
+
+	/* there's at most one edge for each point */
+	if (lines->count > 0) {
+		index->edges = (GpPathEdge*) GdipAlloc (lines->count * sizeof (GpPathEdge));
+		if (!index->edges)
+			goto error;
+		path_get_edges (lines, path_index_add_edge, index);
+	}
+
+	/* fewer, taller bands if too many long edges would be listed in each of them */
+	index->bands = CLAMP (index->cnt, 1, PATH_INDEX_MAX_BANDS);
+	do {
+		index->band_height = (index->bottom - index->top) / index->bands;
+		total = (index->cnt > 0) ? path_index_entries (index) : 0;
+		if (total <= PATH_INDEX_MAX_RATIO * index->cnt)
+			break;
+		index->bands /= 2;
+	} while (index->bands > 1);
+
+	index->band_start = (int*) GdipAlloc ((index->bands + 1) * sizeof (int));
+	if (!index->band_start)
+		goto error;
+	if (total > 0) {
+		index->band_edges = (int*) GdipAlloc (total * sizeof (int));
+		if (!index->band_edges)
+			goto error;
+	}
+
+	/* count the edges of each band, then list them */
+	memset (index->band_start, 0, (index->bands + 1) * sizeof (int));
+	for (i = 0; i < index->cnt; i++) {
+		int last = path_index_band (index, index->edges [i].y2);
+		for (j = path_index_band (index, index->edges [i].y1); j <= last; j++)
+			index->band_start [j + 1]++;
+	}
+	for (j = 0; j < index->bands; j++)
+		index->band_start [j + 1] += index->band_start [j];
+
+	for (i = 0; i < index->cnt; i++) {
+		int last = path_index_band (index, index->edges [i].y2);
+		for (j = path_index_band (index, index->edges [i].y1); j <= last; j++)
+			index->band_edges [index->band_start [j]++] = i;
+	}
+	/* filling moved each start to the next band start, shift them back */
+	for (j = index->bands; j > 0; j--)
+		index->band_start [j] = index->band_start [j - 1];
+	index->band_start [0] = 0;
+
+	if (lines != path)
+		GdipDeletePath (lines);
+	return index;
+
+error:
+	gdip_path_edge_index_free (index);
+	if (lines != path)
+		GdipDeletePath (lines);
+	return NULL;
+}
+
+void
+gdip_path_edge_index_free (GpPathEdgeIndex *index)
+{
+	if (!index)
+		return;
+
+	if (index->edges)
+		GdipFree (index->edges);
+	if (index->band_start)
+		GdipFree (index->band_start);
+	if (index->band_edges)
+		GdipFree (index->band_edges);
+	GdipFree (index);
+}
+
+/*
+ * gdip_path_contains_point:
+ *
+ * Return in @result if the point (@x, @y) is inside the path when filled
+ * with its fill mode. The edge index of the path is (re)built when needed.
+ */
+GpStatus
+gdip_path_contains_point (GpPath *path, float x, float y, BOOL *result)
+{
+	GpPathEdgeIndex *index;
+	PathPointTest test;
+	int i;
+
+	test.x = x;
+	test.y = y;
+	test.winding = 0;
+	test.crossings = 0;
+
+	index = path->edge_index;
+	if (!index || (index->version != path->version)) {
+		gdip_path_edge_index_free (index);
+		path->edge_index = index = NULL;
+
+		/* small paths are cheaper to scan than to index */
+		if ((path->count < PATH_INDEX_MIN_EDGES) && !gdip_path_has_curve (path)) {
+			path_get_edges (path, path_point_test_edge, &test);
+		} else {
+			path->edge_index = index = path_index_create (path);
+			if (!index)
+				return OutOfMemory;
+		}
+	}
+
+	if (index && (index->cnt > 0) && (y >= index->top) && (y < index->bottom)) {
+		int band = path_index_band (index, y);
+		for (i = index->band_start [band]; i < index->band_start [band + 1]; i++)
+			path_point_test_edge (&index->edges [index->band_edges [i]], &test);
+	}
+
+	if (path->fill_mode == FillModeAlternate)
+		*result = (test.crossings & 1);
+	else
+		*result = (test.winding != 0);
+	return Ok;
+}
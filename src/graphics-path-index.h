@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * NOTE: This is a private header files and everything is subject to changes.
+ */
+
+#ifndef __GRAPHICS_PATH_INDEX_H__
+#define __GRAPHICS_PATH_INDEX_H__
+
+#include "gdiplus-private.h"
+
+/*
+ * Paths with less edges than PATH_INDEX_MIN_EDGES (and no curves) are tested
+ * directly, building an index isn't worth it for them.
+ */
+#define PATH_INDEX_MIN_EDGES		32
+
+/* an index never has more bands than this, nor more entries than PATH_INDEX_MAX_RATIO per edge */
+#define PATH_INDEX_MAX_BANDS		1024
+#define PATH_INDEX_MAX_RATIO		8
+
+/* curves are flattened as finely as cairo does before testing them */
+#define PATH_INDEX_FLATNESS		0.01f
+
+/* a non horizontal edge, going down (dir = 1) or up (dir = -1) from (x1, y1) to (x2, y2) */
+typedef struct {
+	float	x1;
+	float	y1;
+	float	x2;
+	float	y2;
+	int	dir;
+} GpPathEdge;
+
+/*
+ * The edges of a (flattened) path, grouped in horizontal bands of equal
+ * height between the path top and bottom. Each band lists the edges crossing
+ * it, so a point is only tested against the edges of its band.
+ */
+typedef struct _PathEdgeIndex {
+	int		version;	/* version of the path the index was built for */
+	int		cnt;
+	GpPathEdge*	edges;
+	float		top;
+	float		bottom;
+	float		band_height;
+	int		bands;
+	int*		band_start;	/* bands + 1 offsets into band_edges */
+	int*		band_edges;
+} GpPathEdgeIndex;
+
+void gdip_path_edge_index_free (GpPathEdgeIndex *index) GDIP_INTERNAL;
+
+GpStatus gdip_path_contains_point (GpPath *path, float x, float y, BOOL *result) GDIP_INTERNAL;
+
+#endif
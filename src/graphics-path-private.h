@@ -38,6 +38,38 @@
 #include "gdiplus-private.h"
 #include "graphics-private.h"
 #include "stringformat-private.h"
+#include "graphics-path-index.h"
+
+/* a figure of the cached cairo path data, and its bounds */
+typedef struct {
+	int			start;
+	int			num_data;
+	double			x1;
+	double			y1;
+	double			x2;
+	double			y2;
+} GpPathCairoFigure;
+
+/*
+ * Cached cairo path data for a path, as built by gdip_plot_path. It's only
+ * valid for the path version and the graphics settings (units, resolution and
+ * antialiasing offset) it was built with. gdip_plot_path builds and reads it
+ * under a lock, as several threads may draw the same path.
+ */
+typedef struct {
+	cairo_path_data_t*	data;
+	int			num_data;
+	int			version;
+	int			type;
+	GpUnit			page_unit;
+	float			dpi_x;
+	float			dpi_y;
+	BOOL			antialiasing;
+	float			aa_offset_x;
+	float			aa_offset_y;
+	GpPathCairoFigure*	figures;	/* used to skip invisible figures, may be NULL */
+	int			num_figures;
+} GpPathCairoCache;
 
 typedef struct _Path {
 	FillMode fill_mode;
@@ -45,9 +77,21 @@ typedef struct _Path {
 	GByteArray *types;
 	GArray *points;
 	BOOL start_new_fig;	/* Flag to keep track if we need to start a new figure */
+	int version;		/* incremented each time the points or types are modified */
+	GpPathCairoCache *cairo_cache;
+	GpRectF bounds;		/* untransformed bounds, valid if bounds_version matches version */
+	int bounds_version;
+	GpPathEdgeIndex *edge_index;	/* built by gdip_path_contains_point */
 } Path;
 
+/* same as the default flatness of GDI+ */
+#define FlatnessDefault			0.25f
+
+/* must be called after changing the points or types of a path */
+#define gdip_path_modified(path)	((path)->version++)
+
 BOOL gdip_path_has_curve (GpPath *path) GDIP_INTERNAL;
+void gdip_path_cairo_cache_invalidate (GpPath *path) GDIP_INTERNAL;
 
 #include "graphics-path.h"
 
@@ -0,0 +1,979 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "graphics-path-stroke.h"
+
+/* round joins and caps are never split into more lines than this */
+#define STROKE_MAX_ARC		64
+
+/* anchor caps are larger than the line, this is their radius in pen widths */
+#define STROKE_ANCHOR_SIZE	1.0
+
+typedef struct {
+	double X;
+	double Y;
+} StrokeVector;
+
+typedef struct {
+	GpPointF	*points;
+	int		count;
+	int		size;
+} StrokePoints;
+
+typedef struct {
+	GpPen		*pen;
+	double		hw;		/* half of the pen width */
+	double		width;
+	double		tolerance;
+	GpStatus	status;
+	/* the outlines are added to outline or, when hit testing, their pieces are checked against (x, y) */
+	GpPath		*outline;
+	BOOL		hit_test;
+	double		x;
+	double		y;
+	BOOL		hit;
+	double		reach;		/* how far from the lines joins and caps can go */
+	/* work buffers for the current figure and dash */
+	GpPointF	*figure;
+	int		figure_size;
+	GpPointF	*dash;
+	int		dash_size;
+	/* work buffers for the outline of the current figure or dash */
+	GpPointF	*reverse;
+	int		reverse_size;
+	StrokePoints	left;
+	StrokePoints	right;
+	StrokePoints	start_cap;
+	StrokePoints	end_cap;
+	StrokePoints	contour;
+} GpStroker;
+
+/*
+ * stroke_reserve:
+ *
+ * Make sure the @buffer can hold @count points.
+ */
+static BOOL
+stroke_reserve (GpPointF **buffer, int *size, int count)
+{
+	GpPointF *points;
+	int new_size;
+
+	if (count <= *size)
+		return TRUE;
+
+	new_size = MAX (count, *size * 2);
+	points = (GpPointF*) GdipAlloc (new_size * sizeof (GpPointF));
+	if (!points)
+		return FALSE;
+
+	if (*buffer) {
+		memcpy (points, *buffer, *size * sizeof (GpPointF));
+		GdipFree (*buffer);
+	}
+	*buffer = points;
+	*size = new_size;
+	return TRUE;
+}
+
+/* make room for @more points at the end of @list */
+static BOOL
+stroke_list_reserve (GpStroker *stroker, StrokePoints *list, int more)
+{
+	if (stroke_reserve (&list->points, &list->size, list->count + more))
+		return TRUE;
+
+	stroker->status = OutOfMemory;
+	return FALSE;
+}
+
+/* add a point to @list (which must have room for it), unless it's the same as the previous one */
+static void
+stroke_add_point (StrokePoints *list, double x, double y)
+{
+	if ((list->count > 0) && (list->points [list->count - 1].X == (float) x) && (list->points [list->count - 1].Y == (float) y))
+		return;
+
+	list->points [list->count].X = x;
+	list->points [list->count].Y = y;
+	list->count++;
+}
+
+/* even-odd test, enough for the simple polygons created by the stroker */
+static BOOL
+stroke_polygon_contains (GpPointF *points, int count, double x, double y)
+{
+	BOOL inside = FALSE;
+	int i, j;
+
+	for (i = 0, j = count - 1; i < count; j = i++) {
+		if (((points [i].Y > y) != (points [j].Y > y)) &&
+			(x < (points [j].X - points [i].X) * (y - points [i].Y) / (points [j].Y - points [i].Y) + points [i].X))
+			inside = !inside;
+	}
+	return inside;
+}
+
+/*
+ * stroke_polygon:
+ *
+ * When hit testing, check one of the pieces of the outline (a segment, join or
+ * cap) against the point. The outline covers the union of all the pieces.
+ */
+static void
+stroke_polygon (GpStroker *stroker, GpPointF *points, int count)
+{
+	if (stroker->hit || (count < 3))
+		return;
+
+	stroker->hit = stroke_polygon_contains (points, count, stroker->x, stroker->y);
+}
+
+/*
+ * stroke_add_figure:
+ *
+ * Add a closed figure to the outline.
+ */
+static void
+stroke_add_figure (GpStroker *stroker, GpPointF *points, int count)
+{
+	GpStatus status;
+
+	if ((count > 1) && (points [0].X == points [count - 1].X) && (points [0].Y == points [count - 1].Y))
+		count--;
+
+	/* nothing to fill in less than a triangle */
+	if (count < 3)
+		return;
+
+	status = GdipAddPathPolygon (stroker->outline, points, count);
+	if (status != Ok)
+		stroker->status = status;
+}
+
+static void
+stroke_set_point (GpPointF *pt, double x, double y)
+{
+	pt->X = x;
+	pt->Y = y;
+}
+
+static double
+stroke_distance (GpPointF *p, GpPointF *q)
+{
+	double dx = q->X - p->X;
+	double dy = q->Y - p->Y;
+
+	return sqrt (dx * dx + dy * dy);
+}
+
+/*
+ * stroke_arc:
+ *
+ * Append the points of an arc around (@cx, @cy) to @points, the number of
+ * lines depends on the tolerance. Returns the number of points added.
+ */
+static int
+stroke_arc (GpStroker *stroker, GpPointF *points, double cx, double cy, double r, double start, double sweep)
+{
+	double step;
+	int i, n;
+
+	/* the distance between an arc and its chord is r * (1 - cos (step / 2)) */
+	if (stroker->tolerance < r)
+		step = 2 * acos (1 - stroker->tolerance / r);
+	else
+		step = M_PI / 2;
+
+	n = (int) ceil (fabs (sweep) / step);
+	if (n < 1)
+		n = 1;
+	else if (n > STROKE_MAX_ARC)
+		n = STROKE_MAX_ARC;
+
+	for (i = 0; i <= n; i++) {
+		double angle = start + sweep * i / n;
+		stroke_set_point (&points [i], cx + r * cos (angle), cy + r * sin (angle));
+	}
+	return n + 1;
+}
+
+/* the rectangle covering the segment from p to q (d is its direction) */
+static void
+stroke_segment (GpStroker *stroker, GpPointF *p, GpPointF *q, StrokeVector *d)
+{
+	GpPointF quad [4];
+	double nx = -d->Y * stroker->hw;
+	double ny = d->X * stroker->hw;
+
+	stroke_set_point (&quad [0], p->X + nx, p->Y + ny);
+	stroke_set_point (&quad [1], q->X + nx, q->Y + ny);
+	stroke_set_point (&quad [2], q->X - nx, q->Y - ny);
+	stroke_set_point (&quad [3], p->X - nx, p->Y - ny);
+	stroke_polygon (stroker, quad, 4);
+}
+
+/*
+ * stroke_join_points:
+ *
+ * Set @points to the outer side of the join at vertex @v, between a segment
+ * going in the direction @d1 and the next one going in the direction @d2. @s
+ * is the offset of the outer side: hw on the left of the lines, -hw on their
+ * right. The points go from the end of the first offset line to the start of
+ * the next one, there are at most STROKE_MAX_ARC + 1 of them.
+ */
+static int
+stroke_join_points (GpStroker *stroker, GpPointF *points, GpPointF *v, StrokeVector *d1, StrokeVector *d2, double s)
+{
+	double dot = d1->X * d2->X + d1->Y * d2->Y;
+	double hw = stroker->hw;
+	double o1x, o1y, o2x, o2y, limit;
+
+	o1x = v->X - d1->Y * s;
+	o1y = v->Y + d1->X * s;
+	o2x = v->X - d2->Y * s;
+	o2y = v->Y + d2->X * s;
+
+	stroke_set_point (&points [0], o1x, o1y);
+
+	switch (stroker->pen->line_join) {
+	case LineJoinRound: {
+		double start = atan2 (o1y - v->Y, o1x - v->X);
+		double sweep = atan2 (o2y - v->Y, o2x - v->X) - start;
+
+		/* always take the short way around */
+		if (sweep > M_PI)
+			sweep -= 2 * M_PI;
+		else if (sweep < -M_PI)
+			sweep += 2 * M_PI;
+		return stroke_arc (stroker, points, v->X, v->Y, hw, start, sweep);
+	}
+	case LineJoinMiter:
+	case LineJoinMiterClipped:
+		/* miter length (in half widths) is 1 / cos (turn / 2) */
+		limit = MAX (stroker->pen->miter_limit, 1.0);
+		if ((dot > -1) && (sqrt (2 / (1 + dot)) <= limit)) {
+			/* the miter point is along the bisector of the two normals */
+			double k = s / (1 + dot);
+			stroke_set_point (&points [1], v->X - (d1->Y + d2->Y) * k, v->Y + (d1->X + d2->X) * k);
+			stroke_set_point (&points [2], o2x, o2y);
+			return 3;
+		}
+
+		/* GDI+ clips the miter of LineJoinMiter at the limit, LineJoinMiterClipped becomes a bevel */
+		if ((stroker->pen->line_join == LineJoinMiter) && (dot > -1)) {
+			double bx = -(d1->Y + d2->Y) * s;
+			double by = (d1->X + d2->X) * s;
+			double blen = sqrt (bx * bx + by * by);
+			double l = limit * hw;
+			double t1, t2;
+
+			bx /= blen;
+			by /= blen;
+			t1 = (l - ((o1x - v->X) * bx + (o1y - v->Y) * by)) / (d1->X * bx + d1->Y * by);
+			t2 = (l - ((o2x - v->X) * bx + (o2y - v->Y) * by)) / -(d2->X * bx + d2->Y * by);
+			stroke_set_point (&points [1], o1x + d1->X * t1, o1y + d1->Y * t1);
+			stroke_set_point (&points [2], o2x - d2->X * t2, o2y - d2->Y * t2);
+			stroke_set_point (&points [3], o2x, o2y);
+			return 4;
+		}
+		/* fall through */
+	case LineJoinBevel:
+	default:
+		stroke_set_point (&points [1], o2x, o2y);
+		return 2;
+	}
+}
+
+/*
+ * stroke_join:
+ *
+ * Fill the gap on the outer side of vertex @v between a segment going in the
+ * direction @d1 and the next one going in the direction @d2.
+ */
+static void
+stroke_join (GpStroker *stroker, GpPointF *v, StrokeVector *d1, StrokeVector *d2)
+{
+	GpPointF points [STROKE_MAX_ARC + 2];
+	double cross = d1->X * d2->Y - d1->Y * d2->X;
+	double dot = d1->X * d2->X + d1->Y * d2->Y;
+
+	/* no gap for a straight line */
+	if ((fabs (cross) < 1e-9) && (dot > 0))
+		return;
+
+	/* the outer side is opposite to the direction of the turn */
+	stroke_set_point (&points [0], v->X, v->Y);
+	stroke_polygon (stroker, points, 1 + stroke_join_points (stroker, points + 1, v, d1, d2, (cross > 0) ? -stroker->hw : stroker->hw));
+}
+
+/*
+ * stroke_cap_points:
+ *
+ * Set @points to the polygon of the cap at the end point @p of a line, @d is
+ * the direction going out of the line. Returns the number of points (0 if the
+ * cap adds nothing to the line), at most STROKE_MAX_ARC + 1. The flat caps go
+ * from the left of the line to its right, the anchors are centered on @p.
+ */
+static int
+stroke_cap_points (GpStroker *stroker, GpPointF *points, GpPointF *p, StrokeVector *d, GpLineCap cap)
+{
+	double hw = stroker->hw;
+	double nx = -d->Y;
+	double ny = d->X;
+	double a = stroker->width * STROKE_ANCHOR_SIZE;
+
+	switch (cap) {
+	case LineCapSquare:
+		stroke_set_point (&points [0], p->X + nx * hw, p->Y + ny * hw);
+		stroke_set_point (&points [1], p->X + (nx + d->X) * hw, p->Y + (ny + d->Y) * hw);
+		stroke_set_point (&points [2], p->X + (d->X - nx) * hw, p->Y + (d->Y - ny) * hw);
+		stroke_set_point (&points [3], p->X - nx * hw, p->Y - ny * hw);
+		return 4;
+	case LineCapRound: {
+		/* half circle from one side of the line to the other, through the point in front */
+		double start = atan2 (ny, nx);
+		double sweep = (nx * d->Y - ny * d->X > 0) ? M_PI : -M_PI;
+		return stroke_arc (stroker, points, p->X, p->Y, hw, start, sweep);
+	}
+	case LineCapTriangle:
+		stroke_set_point (&points [0], p->X + nx * hw, p->Y + ny * hw);
+		stroke_set_point (&points [1], p->X + d->X * hw, p->Y + d->Y * hw);
+		stroke_set_point (&points [2], p->X - nx * hw, p->Y - ny * hw);
+		return 3;
+	case LineCapSquareAnchor:
+		stroke_set_point (&points [0], p->X + (d->X + nx) * a, p->Y + (d->Y + ny) * a);
+		stroke_set_point (&points [1], p->X + (nx - d->X) * a, p->Y + (ny - d->Y) * a);
+		stroke_set_point (&points [2], p->X - (d->X + nx) * a, p->Y - (d->Y + ny) * a);
+		stroke_set_point (&points [3], p->X + (d->X - nx) * a, p->Y + (d->Y - ny) * a);
+		return 4;
+	case LineCapRoundAnchor:
+		return stroke_arc (stroker, points, p->X, p->Y, a, 0, 2 * M_PI) - 1;
+	case LineCapDiamondAnchor:
+		stroke_set_point (&points [0], p->X + d->X * a, p->Y + d->Y * a);
+		stroke_set_point (&points [1], p->X + nx * a, p->Y + ny * a);
+		stroke_set_point (&points [2], p->X - d->X * a, p->Y - d->Y * a);
+		stroke_set_point (&points [3], p->X - nx * a, p->Y - ny * a);
+		return 4;
+	case LineCapArrowAnchor:
+		stroke_set_point (&points [0], p->X + d->X * a, p->Y + d->Y * a);
+		stroke_set_point (&points [1], p->X + (nx - d->X) * a, p->Y + (ny - d->Y) * a);
+		stroke_set_point (&points [2], p->X - (nx + d->X) * a, p->Y - (ny + d->Y) * a);
+		return 3;
+	case LineCapFlat:
+	case LineCapNoAnchor:
+	case LineCapCustom:
+	default:
+		/* custom caps are drawn separately, see gdip_pen_draw_custom_start_cap */
+		return 0;
+	}
+}
+
+/*
+ * stroke_cap:
+ *
+ * Add the cap at the end point @p of a line, @d is the direction going out of
+ * the line.
+ */
+static void
+stroke_cap (GpStroker *stroker, GpPointF *p, StrokeVector *d, GpLineCap cap)
+{
+	GpPointF points [STROKE_MAX_ARC + 2];
+
+	stroke_polygon (stroker, points, stroke_cap_points (stroker, points, p, d, cap));
+}
+
+/* when hit testing, the parts of the outline drawn around p and q can't cover a point this far */
+static BOOL
+stroke_is_far (GpStroker *stroker, GpPointF *p, GpPointF *q)
+{
+	return (stroker->x < MIN (p->X, q->X) - stroker->reach) || (stroker->x > MAX (p->X, q->X) + stroker->reach) ||
+		(stroker->y < MIN (p->Y, q->Y) - stroker->reach) || (stroker->y > MAX (p->Y, q->Y) + stroker->reach);
+}
+
+static void
+stroke_direction (GpPointF *p, GpPointF *q, StrokeVector *d)
+{
+	double dx = q->X - p->X;
+	double dy = q->Y - p->Y;
+	double len = sqrt (dx * dx + dy * dy);
+
+	d->X = dx / len;
+	d->Y = dy / len;
+}
+
+/*
+ * stroke_side_join:
+ *
+ * Set @points to the left side of the line around the vertex @v between @p and
+ * @q. On the outer side of a turn that's the join, on the inner side the point
+ * where both offset lines cross. Returns the number of points.
+ */
+static int
+stroke_side_join (GpStroker *stroker, GpPointF *points, GpPointF *p, GpPointF *v, GpPointF *q, StrokeVector *d1, StrokeVector *d2)
+{
+	double cross = d1->X * d2->Y - d1->Y * d2->X;
+	double dot = d1->X * d2->X + d1->Y * d2->Y;
+	double hw = stroker->hw;
+
+	if ((fabs (cross) < 1e-9) && (dot > 0)) {
+		/* a straight line */
+		stroke_set_point (&points [0], v->X - d1->Y * hw, v->Y + d1->X * hw);
+		return 1;
+	}
+
+	/* turning right, the left side is the outer one */
+	if (cross <= 0)
+		return stroke_join_points (stroker, points, v, d1, d2, hw);
+
+	if (dot > -1 + 1e-9) {
+		double k = hw / (1 + dot);
+		double x = v->X - (d1->Y + d2->Y) * k;
+		double y = v->Y + (d1->X + d2->X) * k;
+
+		/* the crossing is only on both offset lines if the segments are long enough */
+		if (((v->X - x) * d1->X + (v->Y - y) * d1->Y <= stroke_distance (p, v)) &&
+			((x - v->X) * d2->X + (y - v->Y) * d2->Y <= stroke_distance (v, q))) {
+			stroke_set_point (&points [0], x, y);
+			return 1;
+		}
+	}
+
+	/* otherwise go through the vertex, the small loop left is covered by FillModeWinding */
+	stroke_set_point (&points [0], v->X - d1->Y * hw, v->Y + d1->X * hw);
+	stroke_set_point (&points [1], v->X, v->Y);
+	stroke_set_point (&points [2], v->X - d2->Y * hw, v->Y + d2->X * hw);
+	return 3;
+}
+
+/*
+ * stroke_side:
+ *
+ * Set @side to the left side of the line going through the @count points. Open
+ * figures start and end on the normals of their end points.
+ */
+static BOOL
+stroke_side (GpStroker *stroker, StrokePoints *side, GpPointF *points, int count, BOOL closed)
+{
+	GpPointF join [STROKE_MAX_ARC + 2];
+	StrokeVector d1, d2;
+	double hw = stroker->hw;
+	int i, j, n, last;
+
+	side->count = 0;
+	if (!stroke_list_reserve (stroker, side, 2))
+		return FALSE;
+
+	if (!closed) {
+		stroke_direction (&points [0], &points [1], &d2);
+		stroke_add_point (side, points [0].X - d2.Y * hw, points [0].Y + d2.X * hw);
+	}
+
+	last = closed ? count : count - 1;
+	for (i = closed ? 0 : 1; i < last; i++) {
+		GpPointF *p = &points [(i + count - 1) % count];
+		GpPointF *v = &points [i];
+		GpPointF *q = &points [(i + 1) % count];
+
+		stroke_direction (p, v, &d1);
+		stroke_direction (v, q, &d2);
+		n = stroke_side_join (stroker, join, p, v, q, &d1, &d2);
+		if (!stroke_list_reserve (stroker, side, n + 1))
+			return FALSE;
+		for (j = 0; j < n; j++)
+			stroke_add_point (side, join [j].X, join [j].Y);
+	}
+
+	if (!closed) {
+		stroke_direction (&points [count - 2], &points [count - 1], &d1);
+		stroke_add_point (side, points [count - 1].X - d1.Y * hw, points [count - 1].Y + d1.X * hw);
+	}
+	return TRUE;
+}
+
+static BOOL
+stroke_is_anchor (GpLineCap cap)
+{
+	switch (cap) {
+	case LineCapSquareAnchor:
+	case LineCapRoundAnchor:
+	case LineCapDiamondAnchor:
+	case LineCapArrowAnchor:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/* turn the convex @polygon clockwise (with y going up), i.e. with its inside on the right of its edges */
+static void
+stroke_convex_orient (GpPointF *polygon, int count)
+{
+	double area = 0;
+	int i, j;
+
+	for (i = 0, j = count - 1; i < count; j = i++)
+		area += (double) polygon [j].X * polygon [i].Y - (double) polygon [i].X * polygon [j].Y;
+
+	if (area > 0) {
+		for (i = 0, j = count - 1; i < j; i++, j--) {
+			GpPointF temp = polygon [i];
+			polygon [i] = polygon [j];
+			polygon [j] = temp;
+		}
+	}
+}
+
+/* points on the edges (within rounding errors) count as inside */
+static BOOL
+stroke_convex_contains (GpPointF *polygon, int count, GpPointF *pt)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		GpPointF *a = &polygon [i];
+		GpPointF *b = &polygon [(i + 1) % count];
+		double ex = b->X - a->X;
+		double ey = b->Y - a->Y;
+
+		if ((ex * (pt->Y - a->Y) - ey * (pt->X - a->X)) > 1e-3 * sqrt (ex * ex + ey * ey))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * stroke_convex_crossing:
+ *
+ * Set @crossing to the point where the segment from @p to @q crosses the edges
+ * of the convex @polygon, and @along to its position on the edge. Returns the
+ * index of the edge, or -1.
+ */
+static int
+stroke_convex_crossing (GpPointF *polygon, int count, GpPointF *p, GpPointF *q, GpPointF *crossing, double *along)
+{
+	double rx = q->X - p->X;
+	double ry = q->Y - p->Y;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		GpPointF *a = &polygon [i];
+		GpPointF *b = &polygon [(i + 1) % count];
+		double ex = b->X - a->X;
+		double ey = b->Y - a->Y;
+		double den = rx * ey - ry * ex;
+		double t, u;
+
+		if (den == 0)
+			continue;
+
+		t = ((a->X - p->X) * ey - (a->Y - p->Y) * ex) / den;
+		u = ((a->X - p->X) * ry - (a->Y - p->Y) * rx) / den;
+		if ((t >= -1e-6) && (t <= 1 + 1e-6) && (u >= -1e-6) && (u <= 1 + 1e-6)) {
+			stroke_set_point (crossing, p->X + rx * t, p->Y + ry * t);
+			*along = u;
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+ * stroke_outline_cap:
+ *
+ * Set @points to the outline going around the cap at @p (@d is the direction
+ * going out of the line), from the end of the side @from to the start of the
+ * side @to. Anchors are larger than the line: both sides are cut where they
+ * get into the anchor and the outline goes around it in between.
+ */
+static BOOL
+stroke_outline_cap (GpStroker *stroker, StrokePoints *from, StrokePoints *to, GpPointF *p, StrokeVector *d, GpLineCap cap, StrokePoints *points)
+{
+	GpPointF anchor [STROKE_MAX_ARC + 2];
+	GpPointF exit, entry;
+	double exit_along, entry_along;
+	int count = stroke_cap_points (stroker, anchor, p, d, cap);
+	int i, k, exit_edge = -1, entry_edge = -1;
+
+	points->count = 0;
+	if (!stroke_list_reserve (stroker, points, count))
+		return FALSE;
+
+	if (!stroke_is_anchor (cap)) {
+		for (i = 0; i < count; i++)
+			stroke_add_point (points, anchor [i].X, anchor [i].Y);
+		return TRUE;
+	}
+
+	stroke_convex_orient (anchor, count);
+
+	/* the last point of @from before the anchor, and the first point of @to after it */
+	for (i = from->count - 1; (i >= 0) && stroke_convex_contains (anchor, count, &from->points [i]); i--)
+		;
+	for (k = 0; (k < to->count) && stroke_convex_contains (anchor, count, &to->points [k]); k++)
+		;
+
+	if ((i >= 0) && (i < from->count - 1) && (k > 0) && (k < to->count)) {
+		exit_edge = stroke_convex_crossing (anchor, count, &from->points [i], &from->points [i + 1], &exit, &exit_along);
+		entry_edge = stroke_convex_crossing (anchor, count, &to->points [k], &to->points [k - 1], &entry, &entry_along);
+	}
+
+	/* the line is all inside the anchor, or doesn't reach it: keep them apart */
+	if ((exit_edge < 0) || (entry_edge < 0)) {
+		stroke_add_figure (stroker, anchor, count);
+		return TRUE;
+	}
+
+	from->count = i + 1;
+	stroke_add_point (from, exit.X, exit.Y);
+	memmove (to->points + 1, to->points + k, (to->count - k) * sizeof (GpPointF));
+	to->points [0] = entry;
+	to->count -= k - 1;
+
+	/* the anchor edges are in the same direction as the outline, follow them around the front */
+	if ((exit_edge == entry_edge) && (entry_along >= exit_along))
+		return TRUE;
+
+	for (i = (exit_edge + 1) % count; ; i = (i + 1) % count) {
+		stroke_add_point (points, anchor [i].X, anchor [i].Y);
+		if (i == entry_edge)
+			break;
+	}
+	return TRUE;
+}
+
+/* append the points of @list to @contour (which must have room for them) */
+static void
+stroke_append (StrokePoints *contour, StrokePoints *list)
+{
+	int i;
+
+	for (i = 0; i < list->count; i++)
+		stroke_add_point (contour, list->points [i].X, list->points [i].Y);
+}
+
+/*
+ * stroke_outline:
+ *
+ * Add the outline of the line going through the @count points as a single
+ * figure: along the left side of the line, around the end cap, back along the
+ * right side and around the start cap. Closed figures have no caps, their
+ * outline is both sides of the line going in opposite directions.
+ */
+static void
+stroke_outline (GpStroker *stroker, GpPointF *points, int count, BOOL closed, GpLineCap start_cap, GpLineCap end_cap)
+{
+	StrokeVector d;
+	int i;
+
+	if (!stroke_reserve (&stroker->reverse, &stroker->reverse_size, count)) {
+		stroker->status = OutOfMemory;
+		return;
+	}
+	for (i = 0; i < count; i++)
+		stroker->reverse [i] = points [count - 1 - i];
+
+	/* the right side is the left side of the line going backward */
+	if (!stroke_side (stroker, &stroker->left, points, count, closed) ||
+		!stroke_side (stroker, &stroker->right, stroker->reverse, count, closed))
+		return;
+
+	if (closed) {
+		stroke_add_figure (stroker, stroker->left.points, stroker->left.count);
+		stroke_add_figure (stroker, stroker->right.points, stroker->right.count);
+		return;
+	}
+
+	stroke_direction (&points [count - 2], &points [count - 1], &d);
+	if (!stroke_outline_cap (stroker, &stroker->left, &stroker->right, &points [count - 1], &d, end_cap, &stroker->end_cap))
+		return;
+	stroke_direction (&points [1], &points [0], &d);
+	if (!stroke_outline_cap (stroker, &stroker->right, &stroker->left, &points [0], &d, start_cap, &stroker->start_cap))
+		return;
+
+	stroker->contour.count = 0;
+	if (!stroke_list_reserve (stroker, &stroker->contour, stroker->left.count + stroker->end_cap.count +
+		stroker->right.count + stroker->start_cap.count))
+		return;
+	stroke_append (&stroker->contour, &stroker->left);
+	stroke_append (&stroker->contour, &stroker->end_cap);
+	stroke_append (&stroker->contour, &stroker->right);
+	stroke_append (&stroker->contour, &stroker->start_cap);
+	stroke_add_figure (stroker, stroker->contour.points, stroker->contour.count);
+}
+
+/*
+ * stroke_lines:
+ *
+ * Stroke the @count points (without consecutive duplicates) of a figure.
+ * Open figures get @start_cap and @end_cap.
+ */
+static void
+stroke_lines (GpStroker *stroker, GpPointF *points, int count, BOOL closed, GpLineCap start_cap, GpLineCap end_cap)
+{
+	StrokeVector first, previous, d;
+	int i, segments;
+
+	if (count < 2)
+		return;
+
+	/* a figure with two points can't be closed */
+	if (count == 2)
+		closed = FALSE;
+
+	if (!stroker->hit_test) {
+		stroke_outline (stroker, points, count, closed, start_cap, end_cap);
+		return;
+	}
+
+	segments = closed ? count : count - 1;
+	for (i = 0; i < segments; i++) {
+		GpPointF *p = &points [i];
+		GpPointF *q = &points [(i + 1) % count];
+
+		stroke_direction (p, q, &d);
+		if (!stroke_is_far (stroker, p, q)) {
+			stroke_segment (stroker, p, q, &d);
+			if (i > 0)
+				stroke_join (stroker, p, &previous, &d);
+		}
+
+		if (i == 0)
+			first = d;
+		previous = d;
+	}
+
+	if (closed) {
+		if (!stroke_is_far (stroker, &points [0], &points [0]))
+			stroke_join (stroker, &points [0], &previous, &first);
+	} else {
+		StrokeVector back;
+		back.X = -first.X;
+		back.Y = -first.Y;
+		if (!stroke_is_far (stroker, &points [0], &points [0]))
+			stroke_cap (stroker, &points [0], &back, start_cap);
+		if (!stroke_is_far (stroker, &points [count - 1], &points [count - 1]))
+			stroke_cap (stroker, &points [count - 1], &previous, end_cap);
+	}
+}
+
+/* add a point to the current dash, unless it's the same as the previous one */
+static void
+stroke_dash_point (GpStroker *stroker, int *count, double x, double y)
+{
+	if ((*count > 0) && (stroker->dash [*count - 1].X == (float) x) && (stroker->dash [*count - 1].Y == (float) y))
+		return;
+	stroke_set_point (&stroker->dash [(*count)++], x, y);
+}
+
+/*
+ * stroke_dashes:
+ *
+ * Split the figure according to the pen dash pattern and stroke each dash.
+ */
+static BOOL
+stroke_dashes (GpStroker *stroker, GpPointF *points, int count, BOOL closed)
+{
+	GpPen *pen = stroker->pen;
+	GpLineCap dash_cap = (GpLineCap) pen->dash_cap;
+	double pattern = 0, remaining, offset;
+	int i, index = 0, dash_count = 0, segments;
+	BOOL on, at_start = TRUE;
+
+	for (i = 0; i < pen->dash_count; i++)
+		pattern += fabs (pen->dash_array [i]) * stroker->width;
+
+	/* nothing to split */
+	if (pattern <= 0) {
+		stroke_lines (stroker, points, count, closed, pen->line_cap, pen->end_cap);
+		return TRUE;
+	}
+
+	/* skip the dash offset (it's in pen widths too) */
+	offset = fmod (pen->dash_offset * stroker->width, pattern);
+	if (offset < 0)
+		offset += pattern;
+	remaining = fabs (pen->dash_array [0]) * stroker->width;
+	while (offset >= remaining) {
+		offset -= remaining;
+		index = (index + 1) % pen->dash_count;
+		remaining = fabs (pen->dash_array [index]) * stroker->width;
+	}
+	remaining -= offset;
+	on = ((index & 1) == 0);
+
+	/* a dash has at most all the points of the figure, and both its ends */
+	if (!stroke_reserve (&stroker->dash, &stroker->dash_size, count + 2))
+		return FALSE;
+	if (on)
+		stroker->dash [dash_count++] = points [0];
+
+	segments = closed ? count : count - 1;
+	for (i = 0; i < segments; i++) {
+		GpPointF *p = &points [i];
+		GpPointF *q = &points [(i + 1) % count];
+		double dx = q->X - p->X;
+		double dy = q->Y - p->Y;
+		double len = sqrt (dx * dx + dy * dy);
+		double t = 0;
+
+		while (len - t > remaining) {
+			t += remaining;
+			stroke_dash_point (stroker, &dash_count, p->X + dx * t / len, p->Y + dy * t / len);
+			if (on) {
+				/* end of a dash, the figure start and end get the line caps */
+				stroke_lines (stroker, stroker->dash, dash_count, FALSE,
+					(at_start && !closed) ? pen->line_cap : dash_cap, dash_cap);
+				dash_count = 0;
+			}
+			at_start = FALSE;
+
+			index = (index + 1) % pen->dash_count;
+			remaining = fabs (pen->dash_array [index]) * stroker->width;
+			on = !on;
+		}
+
+		remaining -= len - t;
+		if (on)
+			stroke_dash_point (stroker, &dash_count, q->X, q->Y);
+	}
+
+	if (on && (dash_count > 1))
+		stroke_lines (stroker, stroker->dash, dash_count, FALSE, (at_start && !closed) ? pen->line_cap : dash_cap,
+			closed ? dash_cap : pen->end_cap);
+	return TRUE;
+}
+
+static GpStatus
+stroke_path (GpStroker *stroker, GpPath *path)
+{
+	GpPointF *points = (GpPointF*) path->points->data;
+	BYTE *types = path->types->data;
+	GpStatus status = Ok;
+	int start, end;
+
+	if ((stroker->hw <= 0) || (path->count < 2))
+		return Ok;
+
+	for (start = 0; (start < path->count) && !stroker->hit && (stroker->status == Ok); start = end) {
+		BOOL closed;
+		int i, count = 0;
+
+		/* find the end of the figure */
+		for (end = start + 1; end < path->count; end++) {
+			if ((types [end] & PathPointTypePathTypeMask) == PathPointTypeStart)
+				break;
+		}
+		closed = ((types [end - 1] & PathPointTypeCloseSubpath) == PathPointTypeCloseSubpath);
+
+		if (!stroke_reserve (&stroker->figure, &stroker->figure_size, end - start)) {
+			status = OutOfMemory;
+			break;
+		}
+
+		/* drop duplicate points as they have no direction */
+		for (i = start; i < end; i++) {
+			if ((count > 0) && (points [i].X == stroker->figure [count - 1].X) && (points [i].Y == stroker->figure [count - 1].Y))
+				continue;
+			stroker->figure [count++] = points [i];
+		}
+		if (closed && (count > 1) && (stroker->figure [0].X == stroker->figure [count - 1].X) &&
+			(stroker->figure [0].Y == stroker->figure [count - 1].Y))
+			count--;
+
+		if (stroker->pen->dash_count > 0) {
+			if (!stroke_dashes (stroker, stroker->figure, count, closed)) {
+				status = OutOfMemory;
+				break;
+			}
+		} else {
+			stroke_lines (stroker, stroker->figure, count, closed, stroker->pen->line_cap, stroker->pen->end_cap);
+		}
+	}
+
+	if (stroker->figure)
+		GdipFree (stroker->figure);
+	if (stroker->dash)
+		GdipFree (stroker->dash);
+	if (stroker->reverse)
+		GdipFree (stroker->reverse);
+	if (stroker->left.points)
+		GdipFree (stroker->left.points);
+	if (stroker->right.points)
+		GdipFree (stroker->right.points);
+	if (stroker->start_cap.points)
+		GdipFree (stroker->start_cap.points);
+	if (stroker->end_cap.points)
+		GdipFree (stroker->end_cap.points);
+	if (stroker->contour.points)
+		GdipFree (stroker->contour.points);
+	return (status == Ok) ? stroker->status : status;
+}
+
+static void
+stroke_init (GpStroker *stroker, GpPen *pen, float width, float tolerance)
+{
+	memset (stroker, 0, sizeof (GpStroker));
+	stroker->pen = pen;
+	stroker->width = width;
+	stroker->hw = width / 2;
+	stroker->tolerance = MAX (tolerance, STROKE_MIN_TOLERANCE);
+	/* miters are the longest joins, anchors the largest caps */
+	stroker->reach = MAX (stroker->hw * MAX (pen->miter_limit, 1.0), width * STROKE_ANCHOR_SIZE * M_SQRT2);
+}
+
+/*
+ * gdip_path_stroke:
+ * @path: a flattened path
+ * @pen: the pen providing the joins, caps, miter limit and dashes
+ * @width: the width of the line
+ * @tolerance: the maximum distance between the round joins or caps and their lines
+ * @outline: the path receiving the outline
+ *
+ * Add the outline of the line drawn along @path to @outline.
+ */
+GpStatus
+gdip_path_stroke (GpPath *path, GpPen *pen, float width, float tolerance, GpPath *outline)
+{
+	GpStroker stroker;
+
+	stroke_init (&stroker, pen, width, tolerance);
+	stroker.outline = outline;
+	return stroke_path (&stroker, path);
+}
+
+/*
+ * gdip_path_stroke_is_point_visible:
+ *
+ * Return TRUE if the point (@x, @y) is covered by the outline gdip_path_stroke
+ * would create, without creating it.
+ */
+BOOL
+gdip_path_stroke_is_point_visible (GpPath *path, GpPen *pen, float width, float tolerance, float x, float y)
+{
+	GpStroker stroker;
+
+	stroke_init (&stroker, pen, width, tolerance);
+	stroker.hit_test = TRUE;
+	stroker.x = x;
+	stroker.y = y;
+	stroke_path (&stroker, path);
+	return stroker.hit;
+}
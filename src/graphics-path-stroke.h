@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * NOTE: This is a private header files and everything is subject to changes.
+ */
+
+#ifndef __GRAPHICS_PATH_STROKE_H__
+#define __GRAPHICS_PATH_STROKE_H__
+
+#include "graphics-path-private.h"
+#include "pen-private.h"
+
+/* round joins and caps are never approximated with less precision than this */
+#define STROKE_MIN_TOLERANCE		0.01
+
+/*
+ * The stroker works on flattened paths (i.e. lines only). The outline has one
+ * figure for each open figure or dash (both sides of the line and its caps)
+ * and two for each closed figure (both sides, in opposite directions). Lines
+ * narrower than the pen can make these figures overlap themselves, so the
+ * outline must be filled with FillModeWinding.
+ */
+GpStatus gdip_path_stroke (GpPath *path, GpPen *pen, float width, float tolerance, GpPath *outline) GDIP_INTERNAL;
+BOOL gdip_path_stroke_is_point_visible (GpPath *path, GpPen *pen, float width, float tolerance, float x, float y) GDIP_INTERNAL;
+
+#endif
@@ -25,6 +25,8 @@
  */
  
 #include "graphics-path-private.h"
+#include "graphics-path-stroke.h"
+#include "glyph-cache.h"
 #include "matrix-private.h"
 #include "font-private.h"
 #include "graphics-cairo-private.h"
@@ -92,6 +94,20 @@ gdip_path_has_curve (GpPath *path)
 	return FALSE;
 }
 
+void
+gdip_path_cairo_cache_invalidate (GpPath *path)
+{
+	if (!path->cairo_cache)
+		return;
+
+	if (path->cairo_cache->data)
+		GdipFree (path->cairo_cache->data);
+	if (path->cairo_cache->figures)
+		GdipFree (path->cairo_cache->figures);
+	GdipFree (path->cairo_cache);
+	path->cairo_cache = NULL;
+}
+
 /*
  * Return the correct point type when adding a new shape to the path.
  */
@@ -145,6 +161,7 @@ append (GpPath *path, float x, float y, PathPointType type, BOOL compress)
 	g_array_append_val (path->points, pt);
 	g_byte_array_append (path->types, &t, 1);
 	path->count++;
+	gdip_path_modified (path);
 
 	path->start_new_fig = FALSE;
 }
@@ -155,12 +172,114 @@ append_point (GpPath *path, GpPointF pt, PathPointType type, BOOL compress)
         append (path, pt.X, pt.Y, type, compress);
 }
 
+/*
+ * Make sure count more points can be added to the path without reallocating
+ * its arrays. GArray keeps its allocation when shrinking, so growing then
+ * restoring the length is enough to reserve the memory.
+ */
+static void
+reserve (GpPath *path, int count)
+{
+	int length = path->count;
+
+	if (count <= 0)
+		return;
+
+	g_array_set_size (path->points, length + count);
+	g_array_set_size (path->points, length);
+	g_byte_array_set_size (path->types, length + count);
+	g_byte_array_set_size (path->types, length);
+}
+
+/*
+ * Grow the path by count points and return the first new point (and type) so
+ * callers can fill whole spans at once. The caller is responsible for the types.
+ */
+static GpPointF *
+append_span (GpPath *path, int count, BYTE **types)
+{
+	int length = path->count;
+
+	g_array_set_size (path->points, length + count);
+	g_byte_array_set_size (path->types, length + count);
+	path->count += count;
+	path->start_new_fig = FALSE;
+	gdip_path_modified (path);
+
+	*types = path->types->data + length;
+	return &g_array_index (path->points, GpPointF, length);
+}
+
+/* return TRUE if the next point appended will keep its type (i.e. it continues the current figure) */
+static BOOL
+continues_figure (GpPath *path)
+{
+	if (path->start_new_fig || (path->count == 0))
+		return FALSE;
+
+	return !(g_array_index (path->types, BYTE, path->count - 1) & PathPointTypeCloseSubpath);
+}
+
+/* same as calling append (path, x, y, type, FALSE) for each point, but without per-point overhead */
+static void
+append_points (GpPath *path, const GpPointF *points, int count, PathPointType type)
+{
+	GpPointF *pt;
+	BYTE *t;
+
+	if (count <= 0)
+		return;
+
+	/* the first point may have to start a new figure */
+	if (!continues_figure (path)) {
+		append (path, points->X, points->Y, type, FALSE);
+		points++;
+		if (--count == 0)
+			return;
+	}
+
+	pt = append_span (path, count, &t);
+	memcpy (pt, points, count * sizeof (GpPointF));
+	memset (t, type, count);
+}
+
+static void
+append_points_i (GpPath *path, const GpPoint *points, int count, PathPointType type)
+{
+	GpPointF *pt;
+	BYTE *t;
+	int i;
+
+	if (count <= 0)
+		return;
+
+	if (!continues_figure (path)) {
+		append (path, points->X, points->Y, type, FALSE);
+		points++;
+		if (--count == 0)
+			return;
+	}
+
+	pt = append_span (path, count, &t);
+	for (i = 0; i < count; i++, pt++, points++) {
+		pt->X = points->X;
+		pt->Y = points->Y;
+	}
+	memset (t, type, count);
+}
+
 static void
 append_bezier (GpPath *path, float x1, float y1, float x2, float y2, float x3, float y3)
 {
-        append (path, x1, y1, PathPointTypeBezier3, FALSE);
-        append (path, x2, y2, PathPointTypeBezier3, FALSE);
-        append (path, x3, y3, PathPointTypeBezier3, FALSE);
+	GpPointF pts [3];
+
+	pts [0].X = x1;
+	pts [0].Y = y1;
+	pts [1].X = x2;
+	pts [1].Y = y2;
+	pts [2].X = x3;
+	pts [2].Y = y3;
+	append_points (path, pts, 3, PathPointTypeBezier3);
 }
 
 static void
@@ -169,6 +288,9 @@ append_curve (GpPath *path, const GpPointF *points, GpPointF *tangents, int offs
 	int i;
 	PathPointType ptype = ((type == CURVE_CLOSE) || (path->count == 0)) ? PathPointTypeStart : PathPointTypeLine;
 
+	/* first point and 3 points per segment (plus the closing one) */
+	reserve (path, 1 + 3 * (length + ((type == CURVE_CLOSE) ? 1 : 0)));
+
 	append_point (path, points [offset], ptype, TRUE);
 	for (i = offset; i < offset + length; i++) {
 		int j = i + 1;
@@ -217,6 +339,10 @@ GdipCreatePath (FillMode fillMode, GpPath **path)
 	(*path)->types = g_byte_array_new ();
 	(*path)->count = 0;
 	(*path)->start_new_fig = TRUE;
+	(*path)->version = 0;
+	(*path)->bounds_version = -1;
+	(*path)->cairo_cache = NULL;
+	(*path)->edge_index = NULL;
 
 	return Ok;
 }
@@ -250,6 +376,10 @@ GdipCreatePath2 (const GpPointF *points, const BYTE *types, int count, FillMode
         (*path)->count = count;
         (*path)->points = pts;
         (*path)->types = t;
+	(*path)->version = 0;
+	(*path)->bounds_version = -1;
+	(*path)->cairo_cache = NULL;
+	(*path)->edge_index = NULL;
         
         return Ok;
 }
@@ -279,10 +409,6 @@ GdipCreatePath2I (const GpPoint *points, const BYTE *types, int count, FillMode
 GpStatus
 GdipClonePath (GpPath *path, GpPath **clonePath)
 {
-	int i;
-	BYTE type;
-	GpPointF point;
-
 	if (!path || !clonePath)
 		return InvalidParameter;
 
@@ -292,16 +418,14 @@ GdipClonePath (GpPath *path, GpPath **clonePath)
 
         (*clonePath)->fill_mode = path->fill_mode;
         (*clonePath)->count = path->count;
-        (*clonePath)->points = g_array_new (FALSE, FALSE, sizeof (GpPointF));
-        (*clonePath)->types = g_byte_array_new ();
-	for (i = 0; i < path->count; i++) {
-		point = g_array_index (path->points, GpPointF, i);
-		type = g_array_index (path->types, BYTE, i);
-		g_array_append_val ((*clonePath)->points, point);
-		g_byte_array_append ((*clonePath)->types, &type, 1);
-	}
+        (*clonePath)->points = array_to_g_array ((GpPointF*) path->points->data, path->count);
+        (*clonePath)->types = array_to_g_byte_array (path->types->data, path->count);
 
 	(*clonePath)->start_new_fig = path->start_new_fig;
+	(*clonePath)->version = 0;
+	(*clonePath)->bounds_version = -1;
+	(*clonePath)->cairo_cache = NULL;
+	(*clonePath)->edge_index = NULL;
 
         return Ok;
 }
@@ -320,6 +444,8 @@ GdipDeletePath (GpPath *path)
 		g_byte_array_free (path->types, TRUE);
 	path->types = NULL;
 
+	gdip_path_cairo_cache_invalidate (path);
+	gdip_path_edge_index_free (path->edge_index);
 	GdipFree (path);
 	return Ok;
 }
@@ -341,10 +467,29 @@ GdipResetPath (GpPath *path)
 	path->types = g_byte_array_new ();
 	path->fill_mode = FillModeAlternate;
 	path->start_new_fig = TRUE;
+	gdip_path_modified (path);
 
 	return Ok;
 }
 
+/*
+ * GdipReservePathCapacity:
+ *
+ * libgdiplus extension (not exposed in System.Drawing.dll). Make room for
+ * @count points in the path so that building it, point by point or span by
+ * span, doesn't reallocate its arrays. A @count smaller than the current
+ * number of points is ignored, the path is never shrunk.
+ */
+GpStatus
+GdipReservePathCapacity (GpPath *path, int count)
+{
+	if (!path || (count < 0))
+		return InvalidParameter;
+
+	reserve (path, count - path->count);
+	return Ok;
+}
+
 GpStatus
 GdipGetPointCount (GpPath *path, int *count)
 {
@@ -474,6 +619,7 @@ GdipClosePathFigure (GpPath *path)
 	if (path->count > 0) {
 		BYTE *last = &g_array_index (path->types, BYTE, path->count - 1);
 		*last |= PathPointTypeCloseSubpath;
+		gdip_path_modified (path);
 	}
 	path->start_new_fig = TRUE;
 
@@ -483,10 +629,8 @@ GdipClosePathFigure (GpPath *path)
 GpStatus
 GdipClosePathFigures (GpPath *path)
 {
-	int index = 0;
-	BYTE currentType;
-	BYTE lastType;
-	GByteArray *oldTypes;
+	int index;
+	BYTE *types;
 
 	if (!path)
 		return InvalidParameter;
@@ -495,32 +639,19 @@ GdipClosePathFigures (GpPath *path)
 	if (path->count <= 1)
 		return Ok;
 
-	oldTypes = path->types;
-	path->types = g_byte_array_new ();
-
-	lastType = g_array_index (oldTypes, BYTE, index);
-	index++;
-
-	for (index = 1; index < path->count; index++) {
-		currentType = g_array_index (oldTypes, BYTE, index);
+	/* update the types in place to keep any reserved capacity */
+	types = path->types->data;
+	for (index = 2; index < path->count; index++) {
 		/* we dont close on the first point */
-		if ((currentType == PathPointTypeStart) && (index > 1)) {
-			lastType |= PathPointTypeCloseSubpath;
-			g_byte_array_append (path->types, &lastType, 1);
-		}
-		else
-			g_byte_array_append (path->types, &lastType, 1);
-
-		lastType = currentType;
+		if (types [index] == PathPointTypeStart)
+			types [index - 1] |= PathPointTypeCloseSubpath;
 	}
 
 	/* close at the end */
-	lastType |= PathPointTypeCloseSubpath;
-	g_byte_array_append (path->types, &lastType, 1);
+	types [path->count - 1] |= PathPointTypeCloseSubpath;
 
 	path->start_new_fig = TRUE;
-
-	g_byte_array_free (oldTypes, TRUE);
+	gdip_path_modified (path);
 
         return Ok;
 }
@@ -528,21 +659,14 @@ GdipClosePathFigures (GpPath *path)
 GpStatus
 GdipSetPathMarker (GpPath *path)
 {
-	BYTE current;
-
 	if (!path)
 		return InvalidParameter;
 
 	if (path->count == 0)
 		return Ok;
 
-	current = g_array_index (path->types, BYTE, path->count - 1);
-
-        g_byte_array_remove_index (path->types, path->count - 1);
-
-        current |= PathPointTypePathMarker;
-
-        g_byte_array_append (path->types, &current, 1);
+	path->types->data [path->count - 1] |= PathPointTypePathMarker;
+	gdip_path_modified (path);
 
         return Ok;
 }
@@ -551,31 +675,14 @@ GpStatus
 GdipClearPathMarkers (GpPath *path)
 {
         int i;
-	BYTE current;
-	GByteArray *cleared;
 
 	if (!path)
 		return InvalidParameter;
 
-	/* shortcut to avoid allocations */
-	if (path->count == 0)
-		return Ok;
-
-	cleared = g_byte_array_new ();
-
-        for (i = 0; i < path->count; i++) {
-                current = g_array_index (path->types, BYTE, i);
-
-                /* take out the marker if there is one */
-                if (current & PathPointTypePathMarker)
-                        current &= ~PathPointTypePathMarker;
-                
-                g_byte_array_append (cleared, &current, 1);                        
-        }
-
-        /* replace the existing with the cleared array */
-	g_byte_array_free (path->types, TRUE);
-        path->types = cleared;
+	/* take out the markers, if any */
+        for (i = 0; i < path->count; i++)
+		path->types->data [i] &= ~PathPointTypePathMarker;
+	gdip_path_modified (path);
 
         return Ok;
 }
@@ -690,7 +797,8 @@ GdipReversePath (GpPath *path)
 		last->X = temp.X;
 		last->Y = temp.Y;
         }
-        
+
+	gdip_path_modified (path);
         return Ok;
 }
 
@@ -720,15 +828,17 @@ GdipAddPathLine (GpPath *path, float x1, float y1, float x2, float y2)
 GpStatus
 GdipAddPathLine2 (GpPath *path, const GpPointF *points, int count)
 {
-	int i;
-	GpPointF *tmp;
-
 	if (!path || !points || (count < 0))
 		return InvalidParameter;
 
+	if (count == 0)
+		return Ok;
+
+	reserve (path, count);
+
 	/* only the first point can be compressed (i.e. removed if identical to previous) */
-	for (i = 0, tmp = (GpPointF*) points; i < count; i++, tmp++)
-		append (path, tmp->X, tmp->Y, PathPointTypeLine, (i == 0));
+	append (path, points->X, points->Y, PathPointTypeLine, TRUE);
+	append_points (path, points + 1, count - 1, PathPointTypeLine);
         
         return Ok;
 }
@@ -861,21 +971,16 @@ GdipAddPathBezier (GpPath *path,
 GpStatus
 GdipAddPathBeziers (GpPath *path, const GpPointF *points, int count)
 {
-	int i;
-	GpPointF *tmp = (GpPointF *) points;
-
 	if (!path || !points)
 		return InvalidParameter;
 
 	/* first bezier requires 4 points, other 3 more points */
 	if ((count < 4) || ((count % 3) != 1))
 		return InvalidParameter;
-        
-        append_point (path, *tmp, PathPointTypeLine, TRUE);
-        tmp++;
 
-        for (i = 1; i < count; i++, tmp++)
-                append_point (path, *tmp, PathPointTypeBezier3, FALSE);
+	reserve (path, count);
+        append_point (path, points [0], PathPointTypeLine, TRUE);
+	append_points (path, points + 1, count - 1, PathPointTypeBezier3);
 
         return Ok;
 }
@@ -963,16 +1068,29 @@ GdipAddPathClosedCurve2 (GpPath *path, const GpPointF *points, int count, float
 GpStatus
 GdipAddPathRectangle (GpPath *path, float x, float y, float width, float height)
 {
+	GpPointF *pt;
+	BYTE *types;
+
 	if (!path)
 		return InvalidParameter;
 
 	if ((width == 0.0) || (height == 0.0))
 		return Ok;
 
-        append (path, x, y, PathPointTypeStart, FALSE);
-        append (path, x + width, y, PathPointTypeLine, FALSE);
-        append (path, x + width, y + height, PathPointTypeLine, FALSE);
-        append (path, x, y + height, PathPointTypeLine | PathPointTypeCloseSubpath, FALSE);
+	/* a rectangle is always a new, closed, figure so all types are known */
+	pt = append_span (path, 4, &types);
+	pt [0].X = x;
+	pt [0].Y = y;
+	pt [1].X = x + width;
+	pt [1].Y = y;
+	pt [2].X = x + width;
+	pt [2].Y = y + height;
+	pt [3].X = x;
+	pt [3].Y = y + height;
+	types [0] = PathPointTypeStart;
+	types [1] = PathPointTypeLine;
+	types [2] = PathPointTypeLine;
+	types [3] = PathPointTypeLine | PathPointTypeCloseSubpath;
         
         return Ok;
 }
@@ -985,6 +1103,7 @@ GdipAddPathRectangles (GpPath *path, const GpRectF *rects, int count)
 	if (!path || !rects)
 		return InvalidParameter;
 
+	reserve (path, count * 4);
         for (i = 0; i < count; i++) {
                 float x = rects[i].X;
                 float y = rects[i].Y;
@@ -1007,6 +1126,8 @@ GdipAddPathEllipse (GpPath *path, float x, float y, float width, float height)
 	if (!path)
 		return InvalidParameter;
 
+	reserve (path, 13);
+
         /* origin */
         append (path, cx + rx, cy, PathPointTypeStart, FALSE);
 
@@ -1085,19 +1206,14 @@ GdipAddPathPie (GpPath *path, float x, float y, float width, float height, float
 GpStatus
 GdipAddPathPolygon (GpPath *path, const GpPointF *points, int count)
 {
-        int i;
-        GpPointF *tmp = (GpPointF *) points;
-
 	if (!path || !points || (count < 3))
 		return InvalidParameter;
 
-	/* note: polygon points are never compressed (i.e. removed if identical) */
-
-	append_point (path, *tmp, PathPointTypeStart, FALSE);
-	tmp ++;
+	reserve (path, count + 1);
 
-	for (i = 1; i < count; i++, tmp++)
-		append_point (path, *tmp, PathPointTypeLine, FALSE);
+	/* note: polygon points are never compressed (i.e. removed if identical) */
+	append_point (path, points [0], PathPointTypeStart, FALSE);
+	append_points (path, points + 1, count - 1, PathPointTypeLine);
 
         /*
          * Add a line from the last point back to the first point if
@@ -1115,8 +1231,8 @@ GdipAddPathPath (GpPath *path, GDIPCONST GpPath *addingPath, BOOL connect)
 {
         int i, length;
 	PathPointType first;
-        GpPointF *pts;
-        BYTE *types;
+        GpPointF *pts, *dest;
+        BYTE *types, *t;
 
 	if (!path || !addingPath)
 		return InvalidParameter;
@@ -1124,18 +1240,11 @@ GdipAddPathPath (GpPath *path, GDIPCONST GpPath *addingPath, BOOL connect)
         length = addingPath->count;
         if (length < 1)
                 return Ok;
-        
-        pts = gdip_calloc (sizeof (GpPointF), length);
-	if (!pts)
-		return OutOfMemory;
-        types = gdip_calloc (sizeof (BYTE), length);
-	if (!types) {
-		GdipFree (pts);
-		return OutOfMemory;
-	}
 
-        GdipGetPathPoints ((GpPath*)addingPath, pts, length);
-        GdipGetPathTypes ((GpPath*)addingPath, types, length);
+	/* the source arrays may move if we're adding a path to itself */
+	reserve (path, length);
+	pts = (GpPointF*) addingPath->points->data;
+	types = addingPath->types->data;
 
 	/* We can connect only open figures. If first figure is closed
 	 * it can't be connected.
@@ -1143,35 +1252,33 @@ GdipAddPathPath (GpPath *path, GDIPCONST GpPath *addingPath, BOOL connect)
 	first = connect ? gdip_get_first_point_type (path) : PathPointTypeStart;
 
 	append_point (path, pts [0], first, FALSE); 
+	if (length == 1)
+		return Ok;
 
-	for (i = 1; i < length; i++)
-		append_point (path, pts [i], types [i], FALSE);
-
-	GdipFree(pts);
-	GdipFree(types);
+	/* copy the remaining points and types at once, a point following a closed one starts a new figure */
+	dest = append_span (path, length - 1, &t);
+	memcpy (dest, pts + 1, (length - 1) * sizeof (GpPointF));
+	memcpy (t, types + 1, length - 1);
+	for (i = 0; i < length - 1; i++) {
+		if (*(t - 1) & PathPointTypeCloseSubpath)
+			*t = PathPointTypeStart;
+		t++;
+	}
 
 	return Ok;
 }
 
-/* MonoTODO - deal with layoutRect, format... */
-GpStatus 
-GdipAddPathString (GpPath *path, GDIPCONST WCHAR *string, int length, 
-	GDIPCONST GpFontFamily *family, int style, float emSize,
+#ifdef USE_PANGO_RENDERING
+/* append the outlines of the text laid out by pango */
+static GpStatus
+append_pango_outlines (GpPath *path, GDIPCONST WCHAR *string, int length, GpFont *font,
 	GDIPCONST GpRectF *layoutRect, GDIPCONST GpStringFormat *format)
 {
 	cairo_surface_t *cs;
 	cairo_t *cr;
 	cairo_path_t *cp;
-	cairo_text_extents_t extents;
-	cairo_matrix_t matrix;
-	GpFont *font = NULL;
-	GpStatus status;
-	BYTE *utf8 = NULL;
-
-	if (length == 0)
-		return Ok;
-	if (length < 0)
-		return InvalidParameter;
+	GpRectF box;
+	PangoLayout* layout; 
 
 	cs = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
 	if (cairo_surface_status (cs) != CAIRO_STATUS_SUCCESS) {
@@ -1186,44 +1293,14 @@ GdipAddPathString (GpPath *path, GDIPCONST WCHAR *string, int length,
 		return OutOfMemory;
 	}
 
-	utf8 = (BYTE*) ucs2_to_utf8 ((const gunichar2 *)string, -1);
-	if (!utf8) {
-		cairo_destroy (cr);
-		cairo_surface_destroy (cs);
-		return OutOfMemory;
-	}
-
-	status = GdipCreateFont (family, emSize, style, UnitPixel, &font);
-	if (status != Ok) {
-		if (font)
-			GdipDeleteFont (font);
-		GdipFree (utf8);
-		cairo_destroy (cr);
-		cairo_surface_destroy (cs);
-		return status;
-	}
-
 	if (layoutRect)
 		cairo_move_to (cr, layoutRect->X, layoutRect->Y + font->sizeInPixels);
 
-#ifdef USE_PANGO_RENDERING
-	{
-	GpRectF box;
-	PangoLayout* layout; 
-
 	cairo_save (cr);
-	layout = gdip_pango_setup_layout (cr, string, length, font, layoutRect, &box, format);
+	layout = gdip_pango_setup_layout (cr, string, length, font, layoutRect, &box, format, NULL);
 	pango_cairo_layout_path (cr, layout);
 	g_object_unref (layout);
 	cairo_restore (cr);
-	}
-#else
-	cairo_set_font_face (cr, gdip_get_cairo_font_face (font));
-	cairo_set_font_size (cr, font->sizeInPixels);
-	/* TODO - deal with layoutRect, format... ideally we would be calling a subset
-	   of GdipDrawString that already does everything *and* preserve the whole path */
-	cairo_text_path (cr, (const char*)utf8);
-#endif
 
 	/* get the font data from the cairo path and translate it as a gdi+ path */
 	cp = cairo_copy_path (cr);
@@ -1256,14 +1333,111 @@ GdipAddPathString (GpPath *path, GDIPCONST WCHAR *string, int length,
 		cairo_path_destroy (cp);
 	}
 
-	if (font) {
-		GdipDeleteFont (font);
-	}
-	GdipFree (utf8);
 	cairo_destroy (cr);
 	cairo_surface_destroy (cs);
 	return Ok;
 }
+#else
+/* append the (cached) outlines of the characters, starting at (x, y) */
+static GpStatus
+append_glyph_outlines (GpPath *path, const char *utf8, GpFont *font, double x, double y)
+{
+	const char *p;
+
+	gdip_glyph_cache_lock ();
+	for (p = utf8; *p; p = g_utf8_next_char (p)) {
+		GpGlyphOutline *outline = gdip_glyph_cache_get_outline (font, g_utf8_get_char (p));
+		GpPointF *pt;
+		BYTE *types, *first;
+		int i, j;
+
+		if (!outline) {
+			gdip_glyph_cache_unlock ();
+			return OutOfMemory;
+		}
+
+		if (outline->num_points > 0) {
+			pt = append_span (path, outline->num_points, &types);
+			first = types;
+			for (i = 0; i < outline->num_data; i += outline->data [i].header.length) {
+				cairo_path_data_t *data = &outline->data [i];
+				BYTE type;
+
+				switch (data->header.type) {
+				case CAIRO_PATH_MOVE_TO:
+					type = PathPointTypeStart;
+					break;
+				case CAIRO_PATH_LINE_TO:
+					type = PathPointTypeLine;
+					break;
+				case CAIRO_PATH_CURVE_TO:
+					type = PathPointTypeBezier;
+					break;
+				default:
+					/* close the figure on its last point */
+					if (types > first)
+						types [-1] |= PathPointTypeCloseSubpath;
+					continue;
+				}
+
+				for (j = 1; j < data->header.length; j++, pt++) {
+					pt->X = (float) (x + data [j].point.x);
+					pt->Y = (float) (y + data [j].point.y);
+					*types++ = type;
+				}
+			}
+		}
+
+		x += outline->x_advance;
+		y += outline->y_advance;
+	}
+	gdip_glyph_cache_unlock ();
+	return Ok;
+}
+#endif
+
+/* MonoTODO - deal with layoutRect, format... */
+GpStatus 
+GdipAddPathString (GpPath *path, GDIPCONST WCHAR *string, int length, 
+	GDIPCONST GpFontFamily *family, int style, float emSize,
+	GDIPCONST GpRectF *layoutRect, GDIPCONST GpStringFormat *format)
+{
+	GpFont *font = NULL;
+	GpStatus status;
+	BYTE *utf8 = NULL;
+
+	if (length == 0)
+		return Ok;
+	if (length < 0)
+		return InvalidParameter;
+
+	utf8 = (BYTE*) ucs2_to_utf8 ((const gunichar2 *)string, -1);
+	if (!utf8)
+		return OutOfMemory;
+
+	status = GdipCreateFont (family, emSize, style, UnitPixel, &font);
+	if (status != Ok) {
+		if (font)
+			GdipDeleteFont (font);
+		GdipFree (utf8);
+		return status;
+	}
+
+#ifdef USE_PANGO_RENDERING
+	status = append_pango_outlines (path, string, length, font, layoutRect, format);
+#else
+	/* TODO - deal with layoutRect, format... ideally we would be calling a subset
+	   of GdipDrawString that already does everything *and* preserve the whole path */
+	if (layoutRect)
+		status = append_glyph_outlines (path, (const char*) utf8, font, layoutRect->X, layoutRect->Y + font->sizeInPixels);
+	else
+		status = append_glyph_outlines (path, (const char*) utf8, font, 0, 0);
+#endif
+
+	GdipDeleteFont (font);
+	GdipFree (utf8);
+	return status;
+}
 
 /* MonoTODO - same limitations as GdipAddString */
 GpStatus
@@ -1293,15 +1467,17 @@ GdipAddPathLineI (GpPath *path, int x1, int y1, int x2, int y2)
 GpStatus
 GdipAddPathLine2I (GpPath* path, const GpPoint *points, int count)
 {
-	GpPoint *tmp;
-	int i;
-
 	if (!path || !points || (count < 0))
 		return InvalidParameter;
 
+	if (count == 0)
+		return Ok;
+
+	reserve (path, count);
+
 	/* only the first point can be compressed (i.e. removed if identical to previous) */
-	for (i = 0, tmp = (GpPoint*) points; i < count; i++, tmp++)
-		append (path, tmp->X, tmp->Y, PathPointTypeLine, (i == 0));
+	append (path, points->X, points->Y, PathPointTypeLine, TRUE);
+	append_points_i (path, points + 1, count - 1, PathPointTypeLine);
 
 	return Ok;
 }
@@ -1321,22 +1497,16 @@ GdipAddPathBezierI (GpPath *path, int x1, int y1, int x2, int y2, int x3, int y3
 GpStatus
 GdipAddPathBeziersI (GpPath *path, const GpPoint *points, int count)
 {
-	GpPoint *tmp;
-	int i;
-
 	if (!path || !points)
 		return InvalidParameter;
 
 	/* first bezier requires 4 points, other 3 more points */
 	if ((count < 4) || ((count % 3) != 1))
 		return InvalidParameter;
-        
-	tmp = (GpPoint*) points;
-        append (path, tmp->X, tmp->Y, PathPointTypeLine, TRUE);
-        tmp++;
 
-        for (i = 1; i < count; i++, tmp++)
-                append (path, tmp->X, tmp->Y, PathPointTypeBezier3, FALSE);
+	reserve (path, count);
+        append (path, points->X, points->Y, PathPointTypeLine, TRUE);
+	append_points_i (path, points + 1, count - 1, PathPointTypeBezier3);
 
         return Ok;
 }
@@ -1427,6 +1597,7 @@ GdipAddPathRectanglesI (GpPath *path, const GpRect *rects, int count)
 	if (!path || !rects)
 		return InvalidParameter;
 
+	reserve (path, count * 4);
         for (i = 0; i < count; i++) {
                 float x = (float) rects[i].X;
                 float y = (float) rects[i].Y;
@@ -1453,20 +1624,14 @@ GdipAddPathPieI (GpPath *path, int x, int y, int width, int height, float startA
 GpStatus
 GdipAddPathPolygonI (GpPath *path, const GpPoint *points, int count)
 {
-        int i;
-        GpPoint *tmp;
-
 	if (!path || !points || (count < 3))
 		return InvalidParameter;
 
-	/* note: polygon points are never compressed (i.e. removed if identical) */
-
-	tmp = (GpPoint *) points;
-	append (path, tmp->X, tmp->Y, PathPointTypeStart, FALSE);
-	tmp++;
+	reserve (path, count + 1);
 
-	for (i = 1; i < count; i++, tmp++)
-		append (path, tmp->X, tmp->Y, PathPointTypeLine, FALSE);
+	/* note: polygon points are never compressed (i.e. removed if identical) */
+	append (path, points->X, points->Y, PathPointTypeStart, FALSE);
+	append_points_i (path, points + 1, count - 1, PathPointTypeLine);
 
         /*
          * Add a line from the last point back to the first point if
@@ -1479,120 +1644,76 @@ GdipAddPathPolygonI (GpPath *path, const GpPoint *points, int count)
         return GdipClosePathFigure (path);
 }
 
-/* nr_curve_flatten comes from Sodipodi's libnr (public domain) available from http://www.sodipodi.com/ */
-/* Mono changes: converted to float (from double), added recursion limit, use GArray */
-static BOOL
-nr_curve_flatten (float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, float flatness, int level, GArray *points)
-{
-	float dx1_0, dy1_0, dx2_0, dy2_0, dx3_0, dy3_0, dx2_3, dy2_3, d3_0_2;
-	float s1_q, t1_q, s2_q, t2_q, v2_q;
-	float f2, f2_q;
-	float x00t, y00t, x0tt, y0tt, xttt, yttt, x1tt, y1tt, x11t, y11t;
-
-	dx1_0 = x1 - x0;
-	dy1_0 = y1 - y0;
-	dx2_0 = x2 - x0;
-	dy2_0 = y2 - y0;
-	dx3_0 = x3 - x0;
-	dy3_0 = y3 - y0;
-	dx2_3 = x3 - x2;
-	dy2_3 = y3 - y2;
-	f2 = flatness;
-	d3_0_2 = dx3_0 * dx3_0 + dy3_0 * dy3_0;
-	if (d3_0_2 < f2) {
-		float d1_0_2, d2_0_2;
-		d1_0_2 = dx1_0 * dx1_0 + dy1_0 * dy1_0;
-		d2_0_2 = dx2_0 * dx2_0 + dy2_0 * dy2_0;
-		if ((d1_0_2 < f2) && (d2_0_2 < f2)) {
-			goto nosubdivide;
-		} else {
-			goto subdivide;
-		}
-	}
-	f2_q = f2 * d3_0_2;
-	s1_q = dx1_0 * dx3_0 + dy1_0 * dy3_0;
-	t1_q = dy1_0 * dx3_0 - dx1_0 * dy3_0;
-	s2_q = dx2_0 * dx3_0 + dy2_0 * dy3_0;
-	t2_q = dy2_0 * dx3_0 - dx2_0 * dy3_0;
-	v2_q = dx2_3 * dx3_0 + dy2_3 * dy3_0;
-	if ((t1_q * t1_q) > f2_q) goto subdivide;
-	if ((t2_q * t2_q) > f2_q) goto subdivide;
-	if ((s1_q < 0.0) && ((s1_q * s1_q) > f2_q)) goto subdivide;
-	if ((v2_q < 0.0) && ((v2_q * v2_q) > f2_q)) goto subdivide;
-	if (s1_q >= s2_q) goto subdivide;
-
- nosubdivide:
-	{
-	GpPointF pt;
-
-	pt.X = x3;
-	pt.Y = y3;
-	g_array_append_val (points, pt);
-	return TRUE;
-	}
- subdivide:
-	/* things gets *VERY* memory intensive without a limit */
-	if (level >= FLATTEN_RECURSION_LIMIT)
-		return FALSE;
+/*
+ * Return the number of lines needed to approximate the bezier curve (p [0] to
+ * p [3]) within tolerance, or -1 if the curve would need too many points.
+ *
+ * The distance between a cubic curve and the chords of n equal steps is at most
+ * 1/8 * max|B''| / n^2 and |B''| <= 6 * max(|p0 - 2p1 + p2|, |p1 - 2p2 + p3|).
+ */
+static int
+gdip_bezier_segments (const GpPointF *p, double tolerance)
+{
+	double ddx1 = p [0].X - 2 * p [1].X + p [2].X;
+	double ddy1 = p [0].Y - 2 * p [1].Y + p [2].Y;
+	double ddx2 = p [1].X - 2 * p [2].X + p [3].X;
+	double ddy2 = p [1].Y - 2 * p [2].Y + p [3].Y;
+	double dd = sqrt (MAX (ddx1 * ddx1 + ddy1 * ddy1, ddx2 * ddx2 + ddy2 * ddy2));
+	double n;
 
-	x00t = (x0 + x1) * 0.5;
-	y00t = (y0 + y1) * 0.5;
-	x0tt = (x0 + 2 * x1 + x2) * 0.25;
-	y0tt = (y0 + 2 * y1 + y2) * 0.25;
-	x1tt = (x1 + 2 * x2 + x3) * 0.25;
-	y1tt = (y1 + 2 * y2 + y3) * 0.25;
-	x11t = (x2 + x3) * 0.5;
-	y11t = (y2 + y3) * 0.5;
-	xttt = (x0tt + x1tt) * 0.5;
-	yttt = (y0tt + y1tt) * 0.5;
+	if (dd == 0)
+		return 1;
+	if (!(tolerance > 0))
+		return -1;
 
-	if (!nr_curve_flatten (x0, y0, x00t, y00t, x0tt, y0tt, xttt, yttt, flatness, level+1, points)) return FALSE;
-	if (!nr_curve_flatten (xttt, yttt, x1tt, y1tt, x11t, y11t, x3, y3, flatness, level+1, points)) return FALSE;
-	return TRUE;
+	n = ceil (sqrt (0.75 * dd / tolerance));
+	/* things gets *VERY* memory intensive without a limit (and also catch NaN) */
+	if (!(n <= (1 << FLATTEN_RECURSION_LIMIT)))
+		return -1;
+	return (n < 1) ? 1 : (int) n;
 }
 
-static BOOL
-gdip_convert_bezier_to_lines (GpPath *path, int index, float flatness, GArray *flat_points, GByteArray *flat_types)
-{
-	GArray *points;
-	GpPointF start, first, second, end;
-	GpPointF pt;
-	BYTE type;
+/*
+ * Flatten the bezier curve (p [0] to p [3]) into n points (p [0] excluded) using
+ * forward differencing, i.e. only additions are needed for each point.
+ */
+static void
+gdip_bezier_flatten (const GpPointF *p, int n, GpPointF *points)
+{
+	double h = 1.0 / n;
+	double h2 = h * h;
+	double h3 = h2 * h;
+	/* polynomial coefficients (B(t) = a t^3 + b t^2 + c t + p0) */
+	double ax = -p [0].X + 3 * (p [1].X - p [2].X) + p [3].X;
+	double ay = -p [0].Y + 3 * (p [1].Y - p [2].Y) + p [3].Y;
+	double bx = 3 * (p [0].X - 2 * p [1].X + p [2].X);
+	double by = 3 * (p [0].Y - 2 * p [1].Y + p [2].Y);
+	double cx = 3 * (p [1].X - p [0].X);
+	double cy = 3 * (p [1].Y - p [0].Y);
+	/* first, second and third differences */
+	double x = p [0].X;
+	double y = p [0].Y;
+	double dx = ax * h3 + bx * h2 + cx * h;
+	double dy = ay * h3 + by * h2 + cy * h;
+	double ddx = 6 * ax * h3 + 2 * bx * h2;
+	double ddy = 6 * ay * h3 + 2 * by * h2;
+	double dddx = 6 * ax * h3;
+	double dddy = 6 * ay * h3;
 	int i;
 
-	if ((index <= 0) || (index + 2 >= path->count))
-		return FALSE; /* bad path data */
-
-	start = g_array_index (path->points, GpPointF, index - 1);
-	first = g_array_index (path->points, GpPointF, index);
-	second = g_array_index (path->points, GpPointF, index + 1);
-	end = g_array_index (path->points, GpPointF, index + 2);
-
-	/* we can't add points directly to the original list as we could end up with too much recursion */
-	points = g_array_new (FALSE, FALSE, sizeof (GpPointF));
-	if (!nr_curve_flatten (start.X, start.Y, first.X, first.Y, second.X, second.Y, end.X, end.Y, flatness, 0, points)) {
-		/* curved path is too complex (i.e. would result in too many points) to render as a polygon */
-		g_array_free (points, TRUE);
-		return FALSE;
+	for (i = 0; i < n - 1; i++) {
+		x += dx;
+		y += dy;
+		dx += ddx;
+		dy += ddy;
+		ddx += dddx;
+		ddy += dddy;
+		points [i].X = x;
+		points [i].Y = y;
 	}
 
-	/* recursion was within limits, append the result to the original supplied list */
-	if (points->len > 0) {
-		g_array_append_val (flat_points, g_array_index (points, GpPointF, 0));
-		type = PathPointTypeLine;
-		g_byte_array_append (flat_types, &type, 1);
-	}
-
-	/* always PathPointTypeLine */
-	type = PathPointTypeLine;
-	for (i = 1; i < points->len; i++) {
-		pt = g_array_index (points, GpPointF, i);
-		g_array_append_val (flat_points, pt);
-		g_byte_array_append (flat_types, &type, 1);
-	}
-
-	g_array_free (points, TRUE);
-	return TRUE;
+	/* avoid accumulating errors on the end point */
+	points [n - 1] = p [3];
 }
 
 GpStatus 
@@ -1601,7 +1722,11 @@ GdipFlattenPath (GpPath *path, GpMatrix *matrix, float flatness)
 	GpStatus status = Ok;
 	GArray *points;
 	GByteArray *types;
-	int i;
+	GpPointF *src, *dest;
+	BYTE *src_types, *dest_types;
+	/* note: the flatness was always compared to squared distances */
+	double tolerance = sqrt (fabs (flatness));
+	int i, count;
 
 	if (!path)
 		return InvalidParameter;
@@ -1617,51 +1742,65 @@ GdipFlattenPath (GpPath *path, GpMatrix *matrix, float flatness)
 	if (!gdip_path_has_curve (path))
 		return status;
 
-	points = g_array_new (FALSE, FALSE, sizeof (GpPointF));
-	types = g_byte_array_new ();
-
-	/* Iterate the current path and replace each bezier with multiple lines */
-	for (i = 0; i < path->count; i++) {
-		GpPointF point = g_array_index (path->points, GpPointF, i);
-		BYTE type = g_array_index (path->types, BYTE, i);
+	src = (GpPointF*) path->points->data;
+	src_types = path->types->data;
 
+	/* first pass: count the points of the flattened path */
+	for (i = 0, count = 0; i < path->count; i++) {
 		/* PathPointTypeBezier3 has the same value as PathPointTypeBezier */
-		if ((type & PathPointTypeBezier) == PathPointTypeBezier) {
-			if (!gdip_convert_bezier_to_lines (path, i, fabs (flatness), points, types)) {
-				/* uho, too much recursion - do not pass go, do not collect 200$ */
-				GpPointF pt;
-
-				/* free the the partial flat */
-				g_array_free (points, TRUE);
-				g_byte_array_free (types, TRUE);
-
-				/* mimic MS behaviour when recursion becomes a problem */
-				/* note: it's not really an empty rectangle as the last point isn't closing */
-				points = g_array_new (FALSE, FALSE, sizeof (GpPointF));
-				types = g_byte_array_new ();
-
-				pt.X = pt.Y = 0;
-				type = PathPointTypeStart;
-				g_array_append_val (points, pt);
-				g_byte_array_append (types, &type, 1);
-
-				type = PathPointTypeLine;
-				g_array_append_val (points, pt);
-				g_byte_array_append (types, &type, 1);
-
-				g_array_append_val (points, pt);
-				g_byte_array_append (types, &type, 1);
-
-				g_array_append_val (points, pt);
-				g_byte_array_append (types, &type, 1);
+		if ((src_types [i] & PathPointTypeBezier) == PathPointTypeBezier) {
+			/* beziers have 4 points: the previous one, the current and the next two */
+			int n = ((i > 0) && (i + 2 < path->count)) ? gdip_bezier_segments (src + i - 1, tolerance) : -1;
+			if (n < 0) {
+				/* uho, too many points (or bad path data) - do not pass go, do not collect 200$ */
+				count = -1;
 				break;
 			}
-			/* beziers have 4 points: the previous one, the current and the next two */
+			count += n;
 			i += 2;
 		} else {
-			/* no change required, just copy the point */
-			g_array_append_val (points, point);
-			g_byte_array_append (types, &type, 1);
+			count++;
+		}
+	}
+
+	if (count < 0) {
+		/* mimic MS behaviour when the curve becomes too complex */
+		/* note: it's not really an empty rectangle as the last point isn't closing */
+		count = 4;
+		points = g_array_sized_new (FALSE, TRUE, sizeof (GpPointF), count);
+		types = g_byte_array_sized_new (count);
+		g_array_set_size (points, count);
+		g_byte_array_set_size (types, count);
+		dest_types = types->data;
+		dest_types [0] = PathPointTypeStart;
+		dest_types [1] = dest_types [2] = dest_types [3] = PathPointTypeLine;
+		memset (points->data, 0, count * sizeof (GpPointF));
+	} else {
+		points = g_array_sized_new (FALSE, FALSE, sizeof (GpPointF), count);
+		types = g_byte_array_sized_new (count);
+		g_array_set_size (points, count);
+		g_byte_array_set_size (types, count);
+		dest = (GpPointF*) points->data;
+		dest_types = types->data;
+
+		/* second pass: replace each bezier with multiple lines */
+		for (i = 0; i < path->count; i++) {
+			if ((src_types [i] & PathPointTypeBezier) == PathPointTypeBezier) {
+				int n = gdip_bezier_segments (src + i - 1, tolerance);
+				/* lines keep the flags (e.g. closing) of the bezier end point */
+				BYTE type = (src_types [i + 2] & ~PathPointTypePathTypeMask) | PathPointTypeLine;
+
+				gdip_bezier_flatten (src + i - 1, n, dest);
+				memset (dest_types, PathPointTypeLine, n - 1);
+				dest_types [n - 1] = type;
+				dest += n;
+				dest_types += n;
+				i += 2;
+			} else {
+				/* no change required, just copy the point */
+				*dest++ = src [i];
+				*dest_types++ = src_types [i];
+			}
 		}
 	}
 
@@ -1675,8 +1814,9 @@ GdipFlattenPath (GpPath *path, GpMatrix *matrix, float flatness)
 	path->points = points;
 	path->types = types;
 	path->count = points->len;
+	gdip_path_modified (path);
 
-	/* note: no error code is given for excessive recursion */
+	/* note: no error code is given for excessive complexity */
 	return Ok;
 }
 
@@ -1718,12 +1858,13 @@ GdipWindingModeOutline (GpPath *path, GpMatrix *matrix, float flatness)
 	return NotImplemented;
 }
 
-/* MonoTODO */
 GpStatus 
 GdipWidenPath (GpPath *nativePath, GpPen *pen, GpMatrix *matrix, float flatness)
 {
-	static int called = 0;
 	GpStatus status;
+	GpPath *outline;
+	GByteArray *types;
+	GArray *points;
 
 	if (!nativePath || !pen)
 		return InvalidParameter;
@@ -1737,14 +1878,29 @@ GdipWidenPath (GpPath *nativePath, GpPen *pen, GpMatrix *matrix, float flatness)
 	if (status != Ok)
 		return status;
 
-	/* TODO inner path (same number of points as the prepared path) */
-
-	/* TODO outer path (twice the number of points as the prepared path) */
+	status = GdipCreatePath (FillModeWinding, &outline);
+	if (status != Ok)
+		return status;
 
-	if (!called) {
-		g_warning ("NOT IMPLEMENTED: GdipWidenPath");
-		called = 1;
+	/* like GDI+ the outline is never thinner than a pixel */
+	status = gdip_path_stroke (nativePath, pen, MAX (pen->width, 1.0), sqrt (fabs (flatness)), outline);
+	if (status != Ok) {
+		GdipDeletePath (outline);
+		return status;
 	}
+
+	/* the outline replaces the path content */
+	types = nativePath->types;
+	points = nativePath->points;
+	nativePath->types = outline->types;
+	nativePath->points = outline->points;
+	nativePath->count = outline->count;
+	nativePath->fill_mode = FillModeWinding;
+	nativePath->start_new_fig = TRUE;
+	gdip_path_modified (nativePath);
+	outline->types = types;
+	outline->points = points;
+	GdipDeletePath (outline);
 	return Ok;
 }
 
@@ -1785,42 +1941,125 @@ GdipWarpPath (GpPath *path, GpMatrix *matrix, const GpPointF *points, int count,
 GpStatus 
 GdipTransformPath (GpPath* path, GpMatrix *matrix)
 {
-        PointF *points;
-	int count;
-        GpStatus s;
-
 	if (!path)
 		return InvalidParameter;
 
-	count = path->count;
-	if (count == 0)
+	if (path->count == 0)
 		return Ok; /* GdipTransformMatrixPoints would fail */
 
-	/* avoid allocation/free/calculation for null/identity matrix */
+	/* avoid calculation for null/identity matrix */
 	if (gdip_is_matrix_empty (matrix))
 		return Ok;
 
-	points = g_array_to_array (path->points);
-	if (!points)
-		return OutOfMemory;
+	/* transform the points in place */
+	gdip_path_modified (path);
+	return GdipTransformMatrixPoints (matrix, (GpPointF*) path->points->data, path->count);
+}
 
-	s = GdipTransformMatrixPoints (matrix, points, count);
+/* extend [min, max] with the extrema of a cubic bezier (p0 to p3) along one axis */
+static void
+gdip_bezier_extrema (double p0, double p1, double p2, double p3, float *min, float *max)
+{
+	/* roots of the derivative, B'(t) / 3 = a t^2 + b t + c */
+	double a = -p0 + 3 * (p1 - p2) + p3;
+	double b = 2 * (p0 - 2 * p1 + p2);
+	double c = p1 - p0;
+	double t [2];
+	int i, n = 0;
+
+	if (fabs (a) < 1e-12) {
+		if (fabs (b) > 1e-12)
+			t [n++] = -c / b;
+	} else {
+		double d = b * b - 4 * a * c;
+		if (d >= 0) {
+			d = sqrt (d);
+			t [n++] = (-b + d) / (2 * a);
+			t [n++] = (-b - d) / (2 * a);
+		}
+	}
 
-        path->points = array_to_g_array (points, count);
+	for (i = 0; i < n; i++) {
+		double mt = 1 - t [i];
+		double v;
 
-        GdipFree (points);
-	if (!path->points)
-		return OutOfMemory;
+		if ((t [i] <= 0) || (t [i] >= 1))
+			continue;
 
-        return s;
+		v = mt * mt * mt * p0 + 3 * mt * mt * t [i] * p1 + 3 * mt * t [i] * t [i] * p2 + t [i] * t [i] * t [i] * p3;
+		if (v < *min)
+			*min = v;
+		if (v > *max)
+			*max = v;
+	}
+}
+
+static void
+gdip_path_get_point (GpPath *path, int index, const GpMatrix *matrix, GpPointF *pt)
+{
+	*pt = g_array_index (path->points, GpPointF, index);
+	if (matrix) {
+		double x = pt->X;
+		double y = pt->Y;
+		cairo_matrix_transform_point (matrix, &x, &y);
+		pt->X = x;
+		pt->Y = y;
+	}
+}
+
+/*
+ * Compute the exact bounds of the (non-empty) path, optionally transformed. Only
+ * the points on the path are considered, i.e. not the bezier control points.
+ */
+static void
+gdip_path_compute_bounds (GpPath *path, const GpMatrix *matrix, GpRectF *bounds)
+{
+	float min_x, min_y, max_x, max_y;
+	GpPointF pt;
+	int i;
+
+	gdip_path_get_point (path, 0, matrix, &pt);
+	min_x = max_x = pt.X;
+	min_y = max_y = pt.Y;
+
+	for (i = 1; i < path->count; i++) {
+		BYTE type = g_array_index (path->types, BYTE, i);
+
+		/* beziers have 4 points: the previous one, the current and the next two */
+		if (((type & PathPointTypePathTypeMask) == PathPointTypeBezier) && (i + 2 < path->count)) {
+			GpPointF p [4];
+			p [0] = pt;
+			gdip_path_get_point (path, i, matrix, &p [1]);
+			gdip_path_get_point (path, i + 1, matrix, &p [2]);
+			gdip_path_get_point (path, i + 2, matrix, &p [3]);
+
+			gdip_bezier_extrema (p [0].X, p [1].X, p [2].X, p [3].X, &min_x, &max_x);
+			gdip_bezier_extrema (p [0].Y, p [1].Y, p [2].Y, p [3].Y, &min_y, &max_y);
+			pt = p [3];
+			i += 2;
+		} else {
+			gdip_path_get_point (path, i, matrix, &pt);
+		}
+
+		if (pt.X < min_x)
+			min_x = pt.X;
+		if (pt.Y < min_y)
+			min_y = pt.Y;
+		if (pt.X > max_x)
+			max_x = pt.X;
+		if (pt.Y > max_y)
+			max_y = pt.Y;
+	}
+
+	bounds->X = min_x;
+	bounds->Y = min_y;
+	bounds->Width = max_x - min_x;
+	bounds->Height = max_y - min_y;
 }
 
 GpStatus 
 GdipGetPathWorldBounds (GpPath *path, GpRectF *bounds, const GpMatrix *matrix, const GpPen *pen)
 {
-	GpStatus status;
-	GpPath *workpath = NULL;
-
 	if (!path || !bounds)
 		return InvalidParameter;
 
@@ -1833,67 +2072,32 @@ GdipGetPathWorldBounds (GpPath *path, GpRectF *bounds, const GpMatrix *matrix, c
 		return Ok;
 	}
 
-	status = GdipClonePath (path, &workpath);
-	if (status != Ok) {
-		if (workpath)
-			GdipDeletePath (workpath);
-		return status;
-	}
-
-	/* We don't need a very precise flat value to get the bounds (GDI+ isn't, big time) -
-	 * however flattening helps by removing curves, making the rest of the algorithm a 
-	 * lot simpler.
-	 */
-
-	/* note: only the matrix is applied if no curves are present in the path */
-	status = GdipFlattenPath (workpath, (GpMatrix*)matrix, 25.0f);
-	if (status == Ok) {
-		int i;
-		GpPointF points;
-
-		points = g_array_index (workpath->points, GpPointF, 0);
-		bounds->X = points.X;		/* keep minimum X here */
-		bounds->Y = points.Y;		/* keep minimum Y here */
-		if (workpath->count == 1) {
-			/* special case #2 - Only one element */
-			bounds->Width = 0.0f;
-			bounds->Height = 0.0f;
-			GdipDeletePath (workpath);
-			return Ok;
+	if (gdip_is_matrix_empty ((GpMatrix*) matrix)) {
+		/* untransformed bounds are kept until the path is modified */
+		if (path->bounds_version != path->version) {
+			gdip_path_compute_bounds (path, NULL, &path->bounds);
+			path->bounds_version = path->version;
 		}
+		*bounds = path->bounds;
+	} else {
+		gdip_path_compute_bounds (path, matrix, bounds);
+	}
 
-		bounds->Width = points.X;	/* keep maximum X here */
-		bounds->Height = points.Y;	/* keep maximum Y here */
-
-		for (i = 1; i < workpath->count; i++) {
-			points = g_array_index (workpath->points, GpPointF, i);
-			if (points.X < bounds->X)
-				bounds->X = points.X;
-			if (points.Y < bounds->Y)
-				bounds->Y = points.Y;
-			if (points.X > bounds->Width)
-				bounds->Width = points.X;
-			if (points.Y > bounds->Height)
-				bounds->Height = points.Y;
-		}
+	/* special case #2 - Only one element */
+	if (path->count == 1)
+		return Ok;
 
-		/* convert maximum values (width/height) as length */
-		bounds->Width -= bounds->X;
-		bounds->Height -= bounds->Y;
-
-		if (pen) {
-			/* in calculation the pen's width is at least 1.0 */
-			float width = (pen->width < 1.0f) ? 1.0f : pen->width;
-			float halfw = (width / 2);
-			
-			bounds->X -= halfw;
-			bounds->Y -= halfw;
-			bounds->Width += width;
-			bounds->Height += width;
-		}
+	if (pen) {
+		/* in calculation the pen's width is at least 1.0 */
+		float width = (pen->width < 1.0f) ? 1.0f : pen->width;
+		float halfw = (width / 2);
+		
+		bounds->X -= halfw;
+		bounds->Y -= halfw;
+		bounds->Width += width;
+		bounds->Height += width;
 	}
-	GdipDeletePath (workpath);
-	return status;
+	return Ok;
 }
 
 GpStatus 
@@ -1919,47 +2123,12 @@ GdipGetPathWorldBoundsI (GpPath *path, GpRect *bounds, const GpMatrix *matrix, c
 GpStatus 
 GdipIsVisiblePathPoint (GpPath *path, float x, float y, GpGraphics *graphics, BOOL *result)
 {
-	GpStatus status = Ok;
-	cairo_surface_t* s = NULL;
-	GpGraphics *g;
-	GpUnit page_unit = UnitPixel;
-
 	if (!path || !result)
 		return InvalidParameter;
 
-	if (graphics) {
-		g = graphics;
-		cairo_save (g->ct);
-		page_unit = g->page_unit;
-	} else {
-		/* create a temporary context */
-		s = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
-		g = gdip_graphics_new (s);
-	}
-
-	cairo_new_path (g->ct);
 	/* unit tests shows that PageUnit isn't consireded (well x, y are probably considered to be the same unit format ) */
-	g->page_unit = UnitPixel;
-	status = gdip_plot_path (g, path, FALSE);
-	if (status == Ok) {
-		cairo_set_fill_rule (g->ct, gdip_convert_fill_mode (path->fill_mode));
-		cairo_set_antialias (g->ct, CAIRO_ANTIALIAS_NONE);
-		*result = cairo_in_fill (g->ct, x + 1.0 /* CAIRO_AA_OFFSET_X */, y + CAIRO_AA_OFFSET_Y);
-	} else {
-		*result = FALSE;
-	}
-
-	if (graphics) {
-		/* restore GpGraphics to original state */
-		cairo_restore (graphics->ct);
-		g->page_unit = page_unit;
-	} else {
-		/* delete temporary context */
-		cairo_surface_destroy (s);
-		GdipDeleteGraphics (g);
-	}
-
-	return status;
+	/* keep the offsets used when this was done with cairo_in_fill */
+	return gdip_path_contains_point (path, x + 1.0 /* CAIRO_AA_OFFSET_X */, y + CAIRO_AA_OFFSET_Y, result);
 }
 
 GpStatus 
@@ -1971,48 +2140,35 @@ GdipIsVisiblePathPointI (GpPath *path, int x, int y, GpGraphics *graphics, BOOL
 GpStatus 
 GdipIsOutlineVisiblePathPoint (GpPath *path, float x, float y, GpPen *pen, GpGraphics *graphics, BOOL *result)
 {
-	GpStatus status = Ok;
-	cairo_surface_t* s = NULL;
-	GpGraphics *g;
-	GpUnit page_unit = UnitPixel;
+	GpStatus status;
+	GpPath *lines = path;
 
 	if (!path || !pen || !result)
 		return InvalidParameter;
 
-	if (graphics) {
-		g = graphics;
-		cairo_save (graphics->ct);
-		page_unit = g->page_unit;
-	} else {
-		/* create a temporary context */
-		s = cairo_image_surface_create (CAIRO_FORMAT_A1, 1, 1);
-		g = gdip_graphics_new (s);
-	}
-
-	cairo_new_path (g->ct);
 	/* unit tests shows that PageUnit isn't consireded (well x, y are probably considered to be the same unit format ) */
-	g->page_unit = UnitPixel;
-	status = gdip_plot_path (g, path, FALSE);
-	if (status == Ok) {
-		/* we must fight around cairo AA */
-		cairo_set_antialias (g->ct, CAIRO_ANTIALIAS_NONE);
-		cairo_set_line_width (g->ct, pen->width - CAIRO_AA_OFFSET_Y);
-		*result = cairo_in_stroke (g->ct, x, y);
-	} else {
-		*result = FALSE;
-	}
+	/* the stroker works on lines only */
+	if (gdip_path_has_curve (path)) {
+		status = GdipClonePath (path, &lines);
+		if (status != Ok)
+			return status;
 
-	if (graphics) {
-		/* restore GpGraphics to original state */
-		cairo_restore (graphics->ct);
-		g->page_unit = page_unit;
-	} else {
-		/* delete temporary context */
-		cairo_surface_destroy (s);
-		GdipDeleteGraphics (g);
+		status = GdipFlattenPath (lines, NULL, FlatnessDefault);
+		if (status != Ok) {
+			GdipDeletePath (lines);
+			return status;
+		}
 	}
 
-	return status;
+	/* keep the (cairo AA compensated) width used when this was done with cairo_in_stroke */
+	if (pen->width - CAIRO_AA_OFFSET_Y > 0)
+		*result = gdip_path_stroke_is_point_visible (lines, pen, pen->width - CAIRO_AA_OFFSET_Y, sqrt (FlatnessDefault), x, y);
+	else
+		*result = FALSE;
+
+	if (lines != path)
+		GdipDeletePath (lines);
+	return Ok;
 }
 
 GpStatus 
@@ -33,6 +33,7 @@ GpStatus GdipCreatePath2I (GDIPCONST GpPoint *points, GDIPCONST BYTE *types, INT
 GpStatus GdipClonePath (GpPath *path, GpPath **clonePath);
 GpStatus GdipDeletePath (GpPath *path);
 GpStatus GdipResetPath (GpPath *path);
+GpStatus GdipReservePathCapacity (GpPath *path, INT count);
 
 GpStatus GdipGetPointCount (GpPath *path, INT *count);
 GpStatus GdipGetPathTypes (GpPath *path, BYTE *types, INT count);
@@ -198,6 +198,7 @@ GdipPathIterNextMarkerPath (GpPathIterator *iterator, int *resultCount, GpPath *
 		path->types = g_byte_array_new ();
 		path->count = 0;
 	}
+	gdip_path_modified (path);
 
 	for (index = iterator->markerPosition; index < iterator->path->count; index++) {
 		type = g_array_index (iterator->path->types, BYTE, index);
@@ -336,6 +337,7 @@ GdipPathIterNextSubpathPath (GpPathIterator *iterator, int *resultCount, GpPath
 		path->types = g_byte_array_new ();
 		path->count = 0;
 	}
+	gdip_path_modified (path);
 
 	/* Copy the starting point */
 	currentType = g_array_index (iterator->path->types, BYTE, iterator->subpathPosition);
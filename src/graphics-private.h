@@ -97,6 +97,8 @@ typedef struct {
 	int			org_x;
 	int			org_y;
 	int			text_contrast;
+	BOOL			line_decimation;
+	BOOL			culling;
 } GpState;
 
 typedef struct _Graphics {
@@ -128,6 +130,7 @@ typedef struct _Graphics {
 	TextRenderingHint	text_mode;
 	GpState*		saved_status;
 	int			saved_status_pos;
+	int			saved_status_size;
 	CompositingMode		composite_mode;
 	CompositingQuality	composite_quality;
 	PixelOffsetMode		pixel_mode;
@@ -136,6 +139,11 @@ typedef struct _Graphics {
 	float			dpi_x;
 	float			dpi_y;
 	int			text_contrast;
+	BOOL			line_decimation;	/* see GdipSetLineDecimation */
+	BOOL			culling;		/* see GdipSetGeometryCulling */
+#ifdef USE_PANGO_RENDERING
+	struct _PangoLayoutCache *text_layout;		/* reused by the pango text functions */
+#endif
 #ifdef CAIRO_HAS_QUARTZ_SURFACE
 	void		*cg_context;
 #endif
@@ -156,6 +164,10 @@ void gdip_cairo_move_to (GpGraphics *graphics, double x, double y, BOOL convert_
 void gdip_cairo_line_to (GpGraphics *graphics, double x, double y, BOOL convert_units, BOOL antialiasing) GDIP_INTERNAL;
 void gdip_cairo_curve_to (GpGraphics *graphics, double x1, double y1, double x2, double y2, double x3, double y3, 
 	BOOL convert_units, BOOL antialiasing) GDIP_INTERNAL;
+void gdip_cairo_points_matrix (GpGraphics *graphics, BOOL convert_units, BOOL antialiasing, cairo_matrix_t *matrix) GDIP_INTERNAL;
+void gdip_cairo_points (GpGraphics *graphics, GDIPCONST GpPointF *points, int count, BOOL convert_units, BOOL antialiasing,
+	cairo_path_data_t *data, int stride) GDIP_INTERNAL;
+void gdip_cairo_lines (GpGraphics *graphics, GDIPCONST GpPointF *points, int count, BOOL convert_units, BOOL antialiasing) GDIP_INTERNAL;
 
 #ifdef CAIRO_HAS_QUARTZ_SURFACE
 // For the Quartz backend to function we need a few structures and function declarations.
@@ -31,15 +31,20 @@
 #include "region-private.h"
 #include "graphics-path-private.h"
 #include "brush-private.h"
+#include "solidbrush-private.h"
 #include "matrix-private.h"
 #include "bitmap-private.h"
 #include "metafile-private.h"
+#ifdef USE_PANGO_RENDERING
+	#include "text-pango-private.h"
+#endif
 
 #include <cairo-features.h>
 
 #define	NO_CAIRO_AA
 
-#define MAX_GRAPHICS_STATE_STACK 512
+/* initial size of the saved state stack, doubled whenever it's full */
+#define GRAPHICS_STATE_STACK_SIZE 16
 
 float
 gdip_unit_conversion (Unit from, Unit to, float dpi, GraphicsType type, float nSrc)
@@ -125,6 +130,8 @@ gdip_graphics_reset (GpGraphics *graphics)
 	graphics->text_mode = TextRenderingHintSystemDefault;
 	graphics->pixel_mode = PixelOffsetModeDefault;
 	graphics->text_contrast = DEFAULT_TEXT_CONTRAST;
+	graphics->line_decimation = FALSE;
+	graphics->culling = FALSE;
 
 	GdipSetSmoothingMode(graphics, SmoothingModeNone);
 }
@@ -147,12 +154,16 @@ gdip_graphics_common_init (GpGraphics *graphics)
 	graphics->last_brush = NULL;
 	graphics->saved_status = NULL;
 	graphics->saved_status_pos = 0;
+	graphics->saved_status_size = 0;
 	graphics->render_origin_x = 0;
 	graphics->render_origin_y = 0;
 	graphics->dpi_x = graphics->dpi_y = 0;
 
 	graphics->display = NULL;
 	graphics->drawable = NULL;
+#ifdef USE_PANGO_RENDERING
+	graphics->text_layout = NULL;
+#endif
 
 	gdip_graphics_reset (graphics);
 }
@@ -359,6 +370,13 @@ GdipDeleteGraphics (GpGraphics *graphics)
 		graphics->clip_matrix = NULL;
 	}
 
+#ifdef USE_PANGO_RENDERING
+	if (graphics->text_layout) {
+		gdip_pango_layout_cache_free (graphics->text_layout);
+		graphics->text_layout = NULL;
+	}
+#endif
+
 	if (graphics->ct) {
 #ifdef CAIRO_HAS_XLIB_SURFACE
 		int (*old_error_handler)(Display *dpy, XErrorEvent *ev) = NULL;
@@ -387,7 +405,7 @@ GdipDeleteGraphics (GpGraphics *graphics)
 		GpState* pos_state = graphics->saved_status;
 		int i;
 		
-		for (i = 0; i < MAX_GRAPHICS_STATE_STACK; i++, pos_state++) {
+		for (i = 0; i < graphics->saved_status_size; i++, pos_state++) {
 			if (pos_state->clip)
 				GdipDeleteRegion (pos_state->clip);		
 		}
@@ -429,21 +447,25 @@ GdipRestoreGraphics (GpGraphics *graphics, unsigned int graphicsState)
 	
 ///printf("[%s %d] GdipRestoreGraphics called\n", __FILE__, __LINE__);
 
-	if (graphicsState >= MAX_GRAPHICS_STATE_STACK || graphicsState > graphics->saved_status_pos)
+	if (graphicsState >= graphics->saved_status_size || graphicsState > graphics->saved_status_pos)
 		return InvalidParameter;
 
 	pos_state = graphics->saved_status;
 	pos_state += graphicsState;	
 
+	if (!pos_state->clip)
+		return InvalidParameter;
+
 	/* Save from GpState to Graphics  */
 	gdip_cairo_matrix_copy (graphics->copy_of_ctm, &pos_state->matrix);
 	gdip_cairo_matrix_copy (&graphics->previous_matrix, &pos_state->previous_matrix);
 
 	GdipSetRenderingOrigin (graphics, pos_state->org_x, pos_state->org_y);
 
+	/* the saved clip is shared, it will be copied only if it gets modified */
 	if (graphics->clip)
 		GdipDeleteRegion (graphics->clip);
-	GdipCloneRegion (pos_state->clip, &graphics->clip);
+	graphics->clip = gdip_region_ref (pos_state->clip);
 	gdip_cairo_matrix_copy (graphics->clip_matrix, &pos_state->clip_matrix);
 
 	graphics->composite_mode = pos_state->composite_mode;
@@ -455,14 +477,14 @@ GdipRestoreGraphics (GpGraphics *graphics, unsigned int graphicsState)
 	graphics->text_mode = pos_state->text_mode;
 	graphics->pixel_mode = pos_state->pixel_mode;
 	graphics->text_contrast = pos_state->text_contrast;
+	graphics->line_decimation = pos_state->line_decimation;
+	graphics->culling = pos_state->culling;
 
 	graphics->saved_status_pos = graphicsState;
 
 	/* re-adjust clipping (region and matrix) */
 	cairo_set_matrix (graphics->ct, graphics->copy_of_ctm);
 
-	/* GdipCloneRegion was called, but for some reason, not registred as an allocation */
-	/* coverity[freed_arg] */
 	return cairo_SetGraphicsClip (graphics);
 }
 
@@ -476,12 +498,23 @@ GdipSaveGraphics (GpGraphics *graphics, unsigned int *state)
 
 ///printf("[%s %d] GdipSaveGraphics called\n", __FILE__, __LINE__);
 	if (graphics->saved_status == NULL) {
-		graphics->saved_status = gdip_calloc (MAX_GRAPHICS_STATE_STACK, sizeof (GpState));
+		graphics->saved_status = gdip_calloc (GRAPHICS_STATE_STACK_SIZE, sizeof (GpState));
+		if (!graphics->saved_status)
+			return OutOfMemory;
 		graphics->saved_status_pos = 0;
+		graphics->saved_status_size = GRAPHICS_STATE_STACK_SIZE;
 	}
 
-	if (graphics->saved_status_pos >= MAX_GRAPHICS_STATE_STACK) 
-		return OutOfMemory;
+	if (graphics->saved_status_pos >= graphics->saved_status_size) {
+		int size = graphics->saved_status_size * 2;
+		GpState *saved = gdip_realloc (graphics->saved_status, size * sizeof (GpState));
+		if (!saved)
+			return OutOfMemory;
+
+		memset (saved + graphics->saved_status_size, 0, (size - graphics->saved_status_size) * sizeof (GpState));
+		graphics->saved_status = saved;
+		graphics->saved_status_size = size;
+	}
 
 	pos_state = graphics->saved_status;
 	pos_state += graphics->saved_status_pos;
@@ -492,9 +525,10 @@ GdipSaveGraphics (GpGraphics *graphics, unsigned int *state)
 
 	gdip_cairo_matrix_copy (&pos_state->previous_matrix, &graphics->previous_matrix);
 
+	/* share the clip instead of copying it, see gdip_region_make_writable */
 	if (pos_state->clip)
 		GdipDeleteRegion (pos_state->clip);
-	GdipCloneRegion (graphics->clip, &pos_state->clip);
+	pos_state->clip = gdip_region_ref (graphics->clip);
 	gdip_cairo_matrix_copy (&pos_state->clip_matrix, graphics->clip_matrix);
 
 	pos_state->composite_mode = graphics->composite_mode;
@@ -506,6 +540,8 @@ GdipSaveGraphics (GpGraphics *graphics, unsigned int *state)
 	pos_state->text_mode = graphics->text_mode;
 	pos_state->pixel_mode = graphics->pixel_mode;
 	pos_state->text_contrast = graphics->text_contrast;
+	pos_state->line_decimation = graphics->line_decimation;
+	pos_state->culling = graphics->culling;
 	
 	*state = graphics->saved_status_pos;
 	graphics->saved_status_pos++;
@@ -964,6 +1000,42 @@ GdipDrawPath (GpGraphics *graphics, GpPen *pen, GpPath *path)
 	}
 }
 
+/*
+ * GdipDrawPaths:
+ *
+ * libgdiplus extension. Draw all the paths with the same pen, the result
+ * is the same as calling GdipDrawPath for each of them but the pen is only
+ * setup once.
+ */
+GpStatus
+GdipDrawPaths (GpGraphics *graphics, GpPen *pen, GpPath **paths, INT count)
+{
+	GpStatus status;
+	int i;
+
+	if (!graphics || !pen || !paths || (count < 0))
+		return InvalidParameter;
+
+	for (i = 0; i < count; i++) {
+		if (!paths [i])
+			return InvalidParameter;
+	}
+
+	switch (graphics->backend) {
+	case GraphicsBackEndCairo:
+		return cairo_DrawPaths (graphics, pen, paths, count);
+	case GraphicsBackEndMetafile:
+		for (i = 0; i < count; i++) {
+			status = metafile_DrawPath (graphics, pen, paths [i]);
+			if (status != Ok)
+				return status;
+		}
+		return Ok;
+	default:
+		return GenericError;
+	}
+}
+
 GpStatus
 GdipDrawPie (GpGraphics *graphics, GpPen *pen, float x, float y, float width, float height, float startAngle, float sweepAngle)
 {
@@ -1365,6 +1437,73 @@ GdipFillRectanglesI (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpRect *rec
 	}
 }
 
+/*
+ * GdipFillRectanglesARGB:
+ *
+ * libgdiplus extension. Fill each rectangle with its own solid color. The
+ * rectangles sharing a color are filled together, without changing how the
+ * overlapping ones are stacked.
+ */
+GpStatus
+GdipFillRectanglesARGB (GpGraphics *graphics, GDIPCONST GpRectF *rects, GDIPCONST ARGB *colors, INT count)
+{
+	GpSolidFill *brush = NULL;
+	GpStatus status;
+	int i;
+
+	if (!graphics || !rects || !colors || count <= 0)
+		return InvalidParameter;
+
+	switch (graphics->backend) {
+	case GraphicsBackEndCairo:
+		return cairo_FillRectanglesARGB (graphics, rects, colors, count);
+	case GraphicsBackEndMetafile:
+		status = GdipCreateSolidFill (colors [0], &brush);
+		for (i = 0; (i < count) && (status == Ok); i++) {
+			GdipSetSolidFillColor (brush, colors [i]);
+			status = metafile_FillRectangles (graphics, (GpBrush*) brush, &rects [i], 1);
+		}
+		if (brush)
+			GdipDeleteBrush ((GpBrush*) brush);
+		return status;
+	default:
+		return GenericError;
+	}
+}
+
+/*
+ * GdipFillEllipsesARGB:
+ *
+ * libgdiplus extension. Like GdipFillRectanglesARGB for the ellipses bounded
+ * by the rectangles.
+ */
+GpStatus
+GdipFillEllipsesARGB (GpGraphics *graphics, GDIPCONST GpRectF *rects, GDIPCONST ARGB *colors, INT count)
+{
+	GpSolidFill *brush = NULL;
+	GpStatus status;
+	int i;
+
+	if (!graphics || !rects || !colors || count <= 0)
+		return InvalidParameter;
+
+	switch (graphics->backend) {
+	case GraphicsBackEndCairo:
+		return cairo_FillEllipsesARGB (graphics, rects, colors, count);
+	case GraphicsBackEndMetafile:
+		status = GdipCreateSolidFill (colors [0], &brush);
+		for (i = 0; (i < count) && (status == Ok); i++) {
+			GdipSetSolidFillColor (brush, colors [i]);
+			status = metafile_FillEllipse (graphics, (GpBrush*) brush, rects [i].X, rects [i].Y, rects [i].Width, rects [i].Height);
+		}
+		if (brush)
+			GdipDeleteBrush ((GpBrush*) brush);
+		return status;
+	default:
+		return GenericError;
+	}
+}
+
 GpStatus
 GdipFillPie (GpGraphics *graphics, GpBrush *brush, float x, float y, float width, float height, 
 	float startAngle, float sweepAngle)
@@ -1422,6 +1561,42 @@ GdipFillPath (GpGraphics *graphics, GpBrush *brush, GpPath *path)
 	}
 }
 
+/*
+ * GdipFillPaths:
+ *
+ * libgdiplus extension. Fill all the paths with the same brush, the result
+ * is the same as calling GdipFillPath for each of them but the brush is only
+ * setup once.
+ */
+GpStatus
+GdipFillPaths (GpGraphics *graphics, GpBrush *brush, GpPath **paths, INT count)
+{
+	GpStatus status;
+	int i;
+
+	if (!graphics || !brush || !paths || (count < 0))
+		return InvalidParameter;
+
+	for (i = 0; i < count; i++) {
+		if (!paths [i])
+			return InvalidParameter;
+	}
+
+	switch (graphics->backend) {
+	case GraphicsBackEndCairo:
+		return cairo_FillPaths (graphics, brush, paths, count);
+	case GraphicsBackEndMetafile:
+		for (i = 0; i < count; i++) {
+			status = metafile_FillPath (graphics, brush, paths [i]);
+			if (status != Ok)
+				return status;
+		}
+		return Ok;
+	default:
+		return GenericError;
+	}
+}
+
 GpStatus
 GdipFillPolygon (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPointF *points, int count, FillMode fillMode)
 {
@@ -1719,6 +1894,65 @@ GdipGetTextContrast (GpGraphics *graphics, UINT *contrast)
 	return Ok;
 }
 
+/*
+ * GdipSetLineDecimation:
+ *
+ * libgdiplus extension. When enabled, lines and curves drawn by GdipDrawLines
+ * and GdipDrawCurve (and their variants) skip the points which would not
+ * change the rendered pixels, i.e. the ones falling in the same device pixel
+ * column as their neighbours. This is meant for very large polylines, like
+ * time series charts. Dashed lines are never decimated.
+ */
+GpStatus
+GdipSetLineDecimation (GpGraphics *graphics, BOOL enabled)
+{
+	if (!graphics)
+		return InvalidParameter;
+
+	graphics->line_decimation = enabled;
+	return Ok;
+}
+
+GpStatus
+GdipGetLineDecimation (GpGraphics *graphics, BOOL *enabled)
+{
+	if (!graphics || !enabled)
+		return InvalidParameter;
+
+	*enabled = graphics->line_decimation;
+	return Ok;
+}
+
+/*
+ * GdipSetGeometryCulling:
+ *
+ * libgdiplus extension. When enabled, the parts of the lines, polygons and
+ * paths which can't be visible inside the clip are not given to cairo. Large
+ * polylines and polygons are cut at the clip extents (grown by what the pen
+ * can draw), which doesn't change the rendered pixels. This is meant for
+ * drawing a small part of very large geometry, like a zoomed in map, and is
+ * disabled by default.
+ */
+GpStatus
+GdipSetGeometryCulling (GpGraphics *graphics, BOOL enabled)
+{
+	if (!graphics)
+		return InvalidParameter;
+
+	graphics->culling = enabled;
+	return Ok;
+}
+
+GpStatus
+GdipGetGeometryCulling (GpGraphics *graphics, BOOL *enabled)
+{
+	if (!graphics || !enabled)
+		return InvalidParameter;
+
+	*enabled = graphics->culling;
+	return Ok;
+}
+
 GpStatus
 GdipSetSmoothingMode (GpGraphics *graphics, SmoothingMode mode)
 {
@@ -1871,6 +2105,10 @@ GdipSetClipRect (GpGraphics *graphics, float x, float y, float width, float heig
 		GdipTransformRegion (region, &inverted);
 	}
 
+	status = gdip_region_make_writable (&graphics->clip);
+	if (status != Ok)
+		goto cleanup;
+
 	status = GdipCombineRegionRegion (graphics->clip, region, combineMode);	
 	if (status != Ok)
 		goto cleanup;
@@ -1908,6 +2146,10 @@ GdipSetClipPath (GpGraphics *graphics, GpPath *path, CombineMode combineMode)
 	if (!graphics || !path)
 		return InvalidParameter;
 
+	status = gdip_region_make_writable (&graphics->clip);
+	if (status != Ok)
+		return status;
+
 	status = GdipCombineRegionPath (graphics->clip, path, combineMode);	
 	if (status != Ok)
 		return status;
@@ -1945,6 +2187,10 @@ GdipSetClipRegion (GpGraphics *graphics, GpRegion *region, CombineMode combineMo
 		GdipTransformRegion (work, &inverted);
 	}
 
+	status = gdip_region_make_writable (&graphics->clip);
+	if (status != Ok)
+		goto cleanup;
+
 	status = GdipCombineRegionRegion (graphics->clip, work, combineMode);
 	if (status != Ok)
 		goto cleanup;
@@ -1997,7 +2243,17 @@ GdipResetClip (GpGraphics *graphics)
 	if (!graphics)
 		return InvalidParameter;
 
-	GdipSetInfinite (graphics->clip);
+	/* don't touch a clip shared with a saved state, start from a new one */
+	if (graphics->clip->ref_count > 1) {
+		GpRegion *clip;
+		GpStatus status = GdipCreateRegion (&clip);
+		if (status != Ok)
+			return status;
+		GdipDeleteRegion (graphics->clip);
+		graphics->clip = clip;
+	} else {
+		GdipSetInfinite (graphics->clip);
+	}
 	cairo_matrix_init_identity (graphics->clip_matrix);
 
 	switch (graphics->backend) {
@@ -2018,6 +2274,10 @@ GdipTranslateClip (GpGraphics *graphics, float dx, float dy)
 	if (!graphics)
 		return InvalidParameter;
 
+	status = gdip_region_make_writable (&graphics->clip);
+	if (status != Ok)
+		return status;
+
 	status = GdipTranslateRegion (graphics->clip, dx, dy);
 	if (status != Ok)
 		return status;
@@ -2371,26 +2631,80 @@ GdipGetPageUnit (GpGraphics *graphics, GpUnit *unit)
 	return Ok;
 }
 
+/* the transform from @space to device space (world -> page -> device) */
+static void
+gdip_space_to_device (GpGraphics *graphics, GpCoordinateSpace space, cairo_matrix_t *matrix)
+{
+	cairo_matrix_t world, page;
+
+	cairo_matrix_init_identity (matrix);
+	if (space == CoordinateSpaceDevice)
+		return;
+
+	/* page unit and page scale */
+	cairo_matrix_init_scale (&page,
+		gdip_unit_conversion (graphics->page_unit, UnitPixel, graphics->dpi_x, graphics->type, graphics->scale),
+		gdip_unit_conversion (graphics->page_unit, UnitPixel, graphics->dpi_y, graphics->type, graphics->scale));
+
+	if (space == CoordinateSpacePage) {
+		gdip_cairo_matrix_copy (matrix, &page);
+		return;
+	}
+
+	GdipGetWorldTransform (graphics, &world);
+	cairo_matrix_multiply (matrix, &world, &page);
+}
+
 GpStatus
 GdipTransformPoints (GpGraphics *graphics, GpCoordinateSpace destSpace, GpCoordinateSpace srcSpace, GpPointF *points, int count)
 {
-        static int      called = 0;
+	cairo_matrix_t matrix, dest;
+	cairo_status_t status;
 
-        if (!called) {
-                printf("NOT IMPLEMENTED YET:GdipTransformPoints (GpGraphics *graphics, GpCoordinateSpace destSpace %d, GpCoordinateSpace srcSpace %d, GpPointF *points, int count %d)\n", destSpace, srcSpace, count);
-        }
-        /* return NotImplemented; */
-        return Ok;
+	if (!graphics || !points || (count <= 0))
+		return InvalidParameter;
+	if ((destSpace < CoordinateSpaceWorld) || (destSpace > CoordinateSpaceDevice) ||
+		(srcSpace < CoordinateSpaceWorld) || (srcSpace > CoordinateSpaceDevice))
+		return InvalidParameter;
+
+	if (destSpace == srcSpace)
+		return Ok;
+
+	/* go to device space, then back to the destination space */
+	gdip_space_to_device (graphics, srcSpace, &matrix);
+	gdip_space_to_device (graphics, destSpace, &dest);
+	status = cairo_matrix_invert (&dest);
+	if (status != CAIRO_STATUS_SUCCESS)
+		return gdip_get_status (status);
+	cairo_matrix_multiply (&matrix, &matrix, &dest);
+
+	/* all points are converted by a single pass */
+	gdip_matrix_transform_points (&matrix, points, count);
+	return Ok;
 }
 
 GpStatus
 GdipTransformPointsI (GpGraphics *graphics, GpCoordinateSpace destSpace, GpCoordinateSpace srcSpace, GpPoint *points, int count)
 {
-        static int      called = 0;
+	GpPointF *pts;
+	GpStatus status;
+	int i;
 
-        if (!called) {
-                printf("NOT IMPLEMENTED YET:GdipTransformPointsI (GpGraphics *graphics, GpCoordinateSpace destSpace, GpCoordinateSpace srcSpace, GpPoint *points, int count)\n");
-        }
-        /* return NotImplemented; */
-        return Ok;
+	if (!graphics || !points || (count <= 0))
+		return InvalidParameter;
+
+	pts = convert_points (points, count);
+	if (!pts)
+		return OutOfMemory;
+
+	status = GdipTransformPoints (graphics, destSpace, srcSpace, pts, count);
+	if (status == Ok) {
+		for (i = 0; i < count; i++) {
+			points [i].X = iround (pts [i].X);
+			points [i].Y = iround (pts [i].Y);
+		}
+	}
+
+	GdipFree (pts);
+	return status;
 }
@@ -84,6 +84,7 @@ GpStatus GdipDrawLineI (GpGraphics *graphics, GpPen *pen, INT x1, INT y1, INT x2
 GpStatus GdipDrawLines (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPointF *points, INT count);
 GpStatus GdipDrawLinesI (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPoint *points, INT count);
 GpStatus GdipDrawPath (GpGraphics *graphics, GpPen *pen, GpPath *path);
+GpStatus GdipDrawPaths (GpGraphics *graphics, GpPen *pen, GpPath **paths, INT count);
 GpStatus GdipDrawPie (GpGraphics *graphics, GpPen *pen, REAL x, REAL y, REAL width, REAL height, REAL startAngle, REAL sweepAngle);
 GpStatus GdipDrawPieI (GpGraphics *graphics, GpPen *pen, INT x, INT y, INT width, INT height, REAL startAngle, REAL sweepAngle);
 GpStatus GdipDrawPolygon (GpGraphics *graphics, GpPen *pen, GDIPCONST GpPointF *points, INT count);
@@ -102,11 +103,14 @@ GpStatus GdipFillRectangle (GpGraphics *graphics, GpBrush *brush, REAL x1, REAL
 GpStatus GdipFillRectangleI (GpGraphics *graphics, GpBrush *brush, INT x1, INT y1, INT x2, INT y2);
 GpStatus GdipFillRectangles (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpRectF *rects, INT count);
 GpStatus GdipFillRectanglesI (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpRect *rects, INT count);
+GpStatus GdipFillRectanglesARGB (GpGraphics *graphics, GDIPCONST GpRectF *rects, GDIPCONST ARGB *colors, INT count);
+GpStatus GdipFillEllipsesARGB (GpGraphics *graphics, GDIPCONST GpRectF *rects, GDIPCONST ARGB *colors, INT count);
 GpStatus GdipFillPolygon (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPointF *points, INT count, FillMode fillMode);
 GpStatus GdipFillPolygonI (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPoint *points, INT count, FillMode fillMode);
 GpStatus GdipFillPolygon2 (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPointF *points, INT count);
 GpStatus GdipFillPolygon2I (GpGraphics *graphics, GpBrush *brush, GDIPCONST GpPoint *points, INT count);
 GpStatus GdipFillPath (GpGraphics *graphics, GpBrush *brush, GpPath *path);
+GpStatus GdipFillPaths (GpGraphics *graphics, GpBrush *brush, GpPath **paths, INT count);
 GpStatus GdipFillPie (GpGraphics *graphics, GpBrush *brush, REAL x, REAL y, REAL width, REAL height, REAL startAngle, REAL sweepAngle);
 GpStatus GdipFillPieI( GpGraphics *graphics, GpBrush *brush, INT x, INT y, INT width, INT height, REAL startAngle, REAL sweepAngle);
 GpStatus GdipFillRegion (GpGraphics *graphics, GpBrush *brush, GpRegion *region);
@@ -136,6 +140,10 @@ GpStatus GdipSetTextContrast (GpGraphics *graphics, UINT contrast);
 GpStatus GdipGetTextContrast (GpGraphics *graphics, UINT *contrast);
 GpStatus GdipSetTextRenderingHint (GpGraphics *graphics, TextRenderingHint mode);
 GpStatus GdipGetTextRenderingHint (GpGraphics *graphics, TextRenderingHint *mode);
+GpStatus GdipSetLineDecimation (GpGraphics *graphics, BOOL enabled);
+GpStatus GdipGetLineDecimation (GpGraphics *graphics, BOOL *enabled);
+GpStatus GdipSetGeometryCulling (GpGraphics *graphics, BOOL enabled);
+GpStatus GdipGetGeometryCulling (GpGraphics *graphics, BOOL *enabled);
 
 GpStatus GdipIsVisiblePoint (GpGraphics *graphics, REAL x, REAL y, BOOL *result);
 GpStatus GdipIsVisiblePointI (GpGraphics *graphics, INT x, INT y, BOOL *result);
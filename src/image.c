@@ -71,6 +71,7 @@ static BYTE *g_decoder_list;
 static int g_decoders = 0;
 static BYTE *g_encoder_list;
 static int g_encoders = 0;
+static GStaticMutex codecs_mutex = G_STATIC_MUTEX_INIT;
 
 static ImageFormat
 gdip_image_format_for_format_guid (GDIPCONST GUID *formatGUID)
@@ -128,8 +129,13 @@ signature_match (char *data, size_t data_size, int size, int count, BYTE* sig_pa
 static ImageFormat 
 get_image_format (char *sig_read, size_t size_read, ImageFormat *final)
 {
-	ImageCodecInfo *decoder = (ImageCodecInfo*)g_decoder_list;
+	ImageCodecInfo *decoder;
 	int index;
+
+	if (initCodecList () != Ok)
+		return INVALID;
+
+	decoder = (ImageCodecInfo*)g_decoder_list;
 	/* look at every decoder available, this will depends on how libgdiplus is compiled */
 	for (index = 0; index < g_decoders; index++, decoder++) {
 		/* for each signature in the codec */
@@ -2341,8 +2347,8 @@ GdipSaveImageToDelegate_linux (GpImage *image, GetBytesDelegate getBytesFunc, Pu
 	}
 }
 
-GpStatus
-initCodecList (void)
+static GpStatus
+build_codec_list (void)
 {
 	BYTE *dpos, *epos;
 	
@@ -2351,7 +2357,7 @@ initCodecList (void)
 		return OutOfMemory;
 
 	g_encoder_list = epos = GdipAlloc (sizeof (ImageCodecInfo) * ENCODERS_SUPPORTED);
-	if (!g_decoder_list) {
+	if (!g_encoder_list) {
 		GdipFree (g_decoder_list);
 		g_decoder_list = NULL;
 		return OutOfMemory;
@@ -2427,8 +2433,22 @@ initCodecList (void)
 	return Ok;
 }
 
+/* the list is built on first use, not at startup, as most processes never look at it */
+GpStatus
+initCodecList (void)
+{
+	GpStatus status = Ok;
+
+	g_static_mutex_lock (&codecs_mutex);
+	if (!g_decoder_list)
+		status = build_codec_list ();
+	g_static_mutex_unlock (&codecs_mutex);
+	return status;
+}
+
 void releaseCodecList (void)
 {
+	g_static_mutex_lock (&codecs_mutex);
 	if (g_decoder_list) {
 		GdipFree (g_decoder_list);
 		g_decoder_list = NULL;
@@ -2439,13 +2459,20 @@ void releaseCodecList (void)
 		g_encoder_list = NULL;
 		g_encoders = 0;
 	}
+	g_static_mutex_unlock (&codecs_mutex);
 }
 
 GpStatus
 GdipGetImageDecodersSize (UINT *numDecoders, UINT *size)
-{       
+{
+	GpStatus status;
+
 	if (!numDecoders || !size)
 		return InvalidParameter;
+
+	status = initCodecList ();
+	if (status != Ok)
+		return status;
 	
 	*numDecoders = g_decoders;
 	*size = sizeof (ImageCodecInfo) * g_decoders;
@@ -2455,7 +2482,10 @@ GdipGetImageDecodersSize (UINT *numDecoders, UINT *size)
 GpStatus
 GdipGetImageDecoders (UINT numDecoders, UINT size, ImageCodecInfo *decoders)
 {
-	if (!decoders || (numDecoders != g_decoders) || (size != sizeof (ImageCodecInfo) * g_decoders))
+	if (!decoders || (initCodecList () != Ok))
+		return GenericError;
+
+	if ((numDecoders != g_decoders) || (size != sizeof (ImageCodecInfo) * g_decoders))
 		return GenericError;
 
 	memcpy (decoders, g_decoder_list, size);
@@ -2465,8 +2495,14 @@ GdipGetImageDecoders (UINT numDecoders, UINT size, ImageCodecInfo *decoders)
 GpStatus
 GdipGetImageEncodersSize (UINT *numEncoders, UINT *size)
 {
+	GpStatus status;
+
 	if (!numEncoders || !size)
 		return InvalidParameter;
+
+	status = initCodecList ();
+	if (status != Ok)
+		return status;
 	
 	*numEncoders = g_encoders;
 	*size = sizeof (ImageCodecInfo) * g_encoders;
@@ -2476,7 +2512,10 @@ GdipGetImageEncodersSize (UINT *numEncoders, UINT *size)
 GpStatus
 GdipGetImageEncoders (UINT numEncoders, UINT size, ImageCodecInfo *encoders)
 {
-	if (!encoders || (numEncoders != g_encoders) || (size != sizeof (ImageCodecInfo) * g_encoders))
+	if (!encoders || (initCodecList () != Ok))
+		return GenericError;
+
+	if ((numEncoders != g_encoders) || (size != sizeof (ImageCodecInfo) * g_encoders))
 		return GenericError;
 
 	memcpy (encoders, g_encoder_list, size);
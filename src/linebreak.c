@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Line break opportunities following the Unicode line breaking algorithm (UAX #14).
+ *
+ * The class data is a compact subset of LineBreak.txt: Latin-1 is looked up directly, the
+ * punctuation, marks and digits of the common scripts through a sorted range table, and the
+ * CJK and Hangul blocks by their ranges. Everything else is alphabetic. There is no
+ * dictionary, so runs of South East Asian letters (SA) aren't broken.
+ */
+
+#include "gdiplus-private.h"
+#include "linebreak.h"
+
+#define AL	LineBreakAL
+#define BA	LineBreakBA
+#define BB	LineBreakBB
+#define B2	LineBreakB2
+#define BK	LineBreakBK
+#define CL	LineBreakCL
+#define CM	LineBreakCM
+#define CP	LineBreakCP
+#define CR	LineBreakCR
+#define EX	LineBreakEX
+#define GL	LineBreakGL
+#define H2	LineBreakH2
+#define H3	LineBreakH3
+#define HY	LineBreakHY
+#define ID	LineBreakID
+/* IN is taken by win32structs.h */
+#define IS	LineBreakIS
+#define JL	LineBreakJL
+#define JT	LineBreakJT
+#define JV	LineBreakJV
+#define LF	LineBreakLF
+#define NS	LineBreakNS
+#define NU	LineBreakNU
+#define OP	LineBreakOP
+#define PO	LineBreakPO
+#define PR	LineBreakPR
+#define QU	LineBreakQU
+#define RI	LineBreakRI
+#define SP	LineBreakSP
+#define SY	LineBreakSY
+#define WJ	LineBreakWJ
+#define ZW	LineBreakZW
+#define SOT	LineBreakSOT
+
+static const BYTE latin1_classes [256] = {
+	CM, CM, CM, CM, CM, CM, CM, CM, CM, BA, LF, BK, BK, CR, CM, CM,	/* 00 */
+	CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM,	/* 10 */
+	SP, EX, QU, AL, PR, PO, AL, QU, OP, CP, AL, PR, IS, HY, IS, SY,	/* 20 */
+	NU, NU, NU, NU, NU, NU, NU, NU, NU, NU, IS, IS, AL, AL, AL, EX,	/* 30 */
+	AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,	/* 40 */
+	AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, OP, PR, CP, AL, AL,	/* 50 */
+	AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,	/* 60 */
+	AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, OP, BA, CL, AL, CM,	/* 70 */
+	CM, CM, CM, CM, CM, BK, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM,	/* 80 */
+	CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM, CM,	/* 90 */
+	GL, OP, PO, PR, PR, PR, AL, AL, AL, AL, AL, QU, AL, BA, AL, AL,	/* A0 */
+	PO, PR, AL, AL, BB, AL, AL, AL, AL, AL, AL, QU, AL, AL, AL, OP,	/* B0 */
+	AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,	/* C0 */
+	AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,	/* D0 */
+	AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,	/* E0 */
+	AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,	/* F0 */
+};
+
+typedef struct {
+	gunichar	first;
+	gunichar	last;
+	BYTE		cls;
+} LineBreakRange;
+
+/* sorted, the code points above Latin-1 which aren't AL or covered by block_class */
+static const LineBreakRange ranges [] = {
+	{ 0x02C8, 0x02C8, BB }, { 0x02CC, 0x02CC, BB }, { 0x02DF, 0x02DF, BB },
+	{ 0x0300, 0x036F, CM }, { 0x037E, 0x037E, IS }, { 0x0483, 0x0489, CM },
+	{ 0x0589, 0x0589, IS }, { 0x058A, 0x058A, BA }, { 0x0591, 0x05BD, CM },
+	{ 0x05BE, 0x05BE, BA }, { 0x05BF, 0x05C7, CM }, { 0x0609, 0x060B, PO },
+	{ 0x060C, 0x060D, IS }, { 0x0610, 0x061A, CM }, { 0x061B, 0x061B, EX },
+	{ 0x061F, 0x061F, EX }, { 0x064B, 0x065F, CM }, { 0x0660, 0x0669, NU },
+	{ 0x066A, 0x066A, PO }, { 0x066B, 0x066C, NU }, { 0x0670, 0x0670, CM },
+	{ 0x06D4, 0x06D4, EX }, { 0x06D6, 0x06DC, CM }, { 0x06DF, 0x06E4, CM },
+	{ 0x06E7, 0x06E8, CM }, { 0x06EA, 0x06ED, CM }, { 0x06F0, 0x06F9, NU },
+	{ 0x0900, 0x0903, CM }, { 0x093A, 0x093C, CM }, { 0x093E, 0x094F, CM },
+	{ 0x0951, 0x0957, CM }, { 0x0962, 0x0963, CM }, { 0x0964, 0x0965, BA },
+	{ 0x0966, 0x096F, NU }, { 0x0981, 0x0983, CM }, { 0x09BC, 0x09BC, CM },
+	{ 0x09BE, 0x09CD, CM }, { 0x09E6, 0x09EF, NU }, { 0x0E31, 0x0E31, CM },
+	{ 0x0E34, 0x0E3A, CM }, { 0x0E3F, 0x0E3F, PR }, { 0x0E47, 0x0E4E, CM },
+	{ 0x0E50, 0x0E59, NU }, { 0x0E5A, 0x0E5B, BA }, { 0x0F0B, 0x0F0B, BA },
+	{ 0x1100, 0x115F, JL }, { 0x1160, 0x11A7, JV }, { 0x11A8, 0x11FF, JT },
+	{ 0x1680, 0x1680, BA }, { 0x17D4, 0x17D5, BA }, { 0x1806, 0x1806, BB },
+	{ 0x1AB0, 0x1AFF, CM }, { 0x1DC0, 0x1DFF, CM }, { 0x2000, 0x2006, BA },
+	{ 0x2007, 0x2007, GL }, { 0x2008, 0x200A, BA }, { 0x200B, 0x200B, ZW },
+	{ 0x200C, 0x200F, CM }, { 0x2010, 0x2010, BA }, { 0x2011, 0x2011, GL },
+	{ 0x2012, 0x2013, BA }, { 0x2014, 0x2014, B2 }, { 0x2018, 0x2019, QU },
+	{ 0x201A, 0x201A, OP }, { 0x201B, 0x201D, QU }, { 0x201E, 0x201E, OP },
+	{ 0x201F, 0x201F, QU }, { 0x2024, 0x2026, LineBreakIN }, { 0x2027, 0x2027, BA },
+	{ 0x2028, 0x2029, BK }, { 0x202A, 0x202E, CM }, { 0x202F, 0x202F, GL },
+	{ 0x2030, 0x2037, PO }, { 0x2039, 0x203A, QU }, { 0x203C, 0x203D, NS },
+	{ 0x2044, 0x2044, IS }, { 0x2045, 0x2045, OP }, { 0x2046, 0x2046, CL },
+	{ 0x2047, 0x2049, NS }, { 0x2056, 0x2056, BA }, { 0x2058, 0x205B, BA },
+	{ 0x205D, 0x205F, BA }, { 0x2060, 0x2060, WJ }, { 0x2061, 0x206F, CM },
+	{ 0x207D, 0x207D, OP }, { 0x207E, 0x207E, CP }, { 0x208D, 0x208D, OP },
+	{ 0x208E, 0x208E, CP }, { 0x20A0, 0x20A6, PR }, { 0x20A7, 0x20A7, PO },
+	{ 0x20A8, 0x20B5, PR }, { 0x20B6, 0x20B6, PO }, { 0x20B7, 0x20BA, PR },
+	{ 0x20BB, 0x20BB, PO }, { 0x20BC, 0x20BD, PR }, { 0x20BE, 0x20BE, PO },
+	{ 0x20BF, 0x20CF, PR }, { 0x20D0, 0x20F0, CM }, { 0x2103, 0x2103, PO },
+	{ 0x2109, 0x2109, PO }, { 0x2116, 0x2116, PR }, { 0x2212, 0x2213, PR },
+	{ 0x2308, 0x2308, OP }, { 0x2309, 0x2309, CL }, { 0x230A, 0x230A, OP },
+	{ 0x230B, 0x230B, CL }, { 0x2329, 0x2329, OP }, { 0x232A, 0x232A, CL },
+	{ 0x275B, 0x2760, QU }, { 0x2768, 0x2768, OP }, { 0x2769, 0x2769, CL },
+	{ 0x276A, 0x276A, OP }, { 0x276B, 0x276B, CL }, { 0x276C, 0x276C, OP },
+	{ 0x276D, 0x276D, CL }, { 0x276E, 0x276E, OP }, { 0x276F, 0x276F, CL },
+	{ 0x2770, 0x2770, OP }, { 0x2771, 0x2771, CL }, { 0x2772, 0x2772, OP },
+	{ 0x2773, 0x2773, CL }, { 0x2774, 0x2774, OP }, { 0x2775, 0x2775, CL },
+	{ 0x27C5, 0x27C5, OP }, { 0x27C6, 0x27C6, CL }, { 0x27E6, 0x27E6, OP },
+	{ 0x27E7, 0x27E7, CL }, { 0x27E8, 0x27E8, OP }, { 0x27E9, 0x27E9, CL },
+	{ 0x27EA, 0x27EA, OP }, { 0x27EB, 0x27EB, CL }, { 0x2E18, 0x2E18, OP },
+	{ 0x2E3A, 0x2E3B, B2 }, { 0x3000, 0x3000, BA }, { 0x3001, 0x3002, CL },
+	{ 0x3005, 0x3005, NS }, { 0x3008, 0x3008, OP }, { 0x3009, 0x3009, CL },
+	{ 0x300A, 0x300A, OP }, { 0x300B, 0x300B, CL }, { 0x300C, 0x300C, OP },
+	{ 0x300D, 0x300D, CL }, { 0x300E, 0x300E, OP }, { 0x300F, 0x300F, CL },
+	{ 0x3010, 0x3010, OP }, { 0x3011, 0x3011, CL }, { 0x3014, 0x3014, OP },
+	{ 0x3015, 0x3015, CL }, { 0x3016, 0x3016, OP }, { 0x3017, 0x3017, CL },
+	{ 0x3018, 0x3018, OP }, { 0x3019, 0x3019, CL }, { 0x301A, 0x301A, OP },
+	{ 0x301B, 0x301B, CL }, { 0x301C, 0x301C, NS }, { 0x301D, 0x301D, OP },
+	{ 0x301E, 0x301F, CL }, { 0x302A, 0x302F, CM }, { 0x303B, 0x303C, NS },
+	{ 0x3041, 0x3041, NS }, { 0x3043, 0x3043, NS }, { 0x3045, 0x3045, NS },
+	{ 0x3047, 0x3047, NS }, { 0x3049, 0x3049, NS }, { 0x3063, 0x3063, NS },
+	{ 0x3083, 0x3083, NS }, { 0x3085, 0x3085, NS }, { 0x3087, 0x3087, NS },
+	{ 0x308E, 0x308E, NS }, { 0x3095, 0x3096, NS }, { 0x3099, 0x309A, CM },
+	{ 0x309B, 0x309E, NS }, { 0x30A0, 0x30A1, NS }, { 0x30A3, 0x30A3, NS },
+	{ 0x30A5, 0x30A5, NS }, { 0x30A7, 0x30A7, NS }, { 0x30A9, 0x30A9, NS },
+	{ 0x30C3, 0x30C3, NS }, { 0x30E3, 0x30E3, NS }, { 0x30E5, 0x30E5, NS },
+	{ 0x30E7, 0x30E7, NS }, { 0x30EE, 0x30EE, NS }, { 0x30F5, 0x30F6, NS },
+	{ 0x30FB, 0x30FE, NS }, { 0x31F0, 0x31FF, NS }, { 0xFD3E, 0xFD3E, CL },
+	{ 0xFD3F, 0xFD3F, OP }, { 0xFE00, 0xFE0F, CM }, { 0xFE20, 0xFE2F, CM },
+	{ 0xFE50, 0xFE50, CL }, { 0xFE52, 0xFE52, CL }, { 0xFE54, 0xFE55, NS },
+	{ 0xFE56, 0xFE57, EX }, { 0xFE59, 0xFE59, OP }, { 0xFE5A, 0xFE5A, CL },
+	{ 0xFE5B, 0xFE5B, OP }, { 0xFE5C, 0xFE5C, CL }, { 0xFE5D, 0xFE5D, OP },
+	{ 0xFE5E, 0xFE5E, CL }, { 0xFEFF, 0xFEFF, WJ }, { 0xFF01, 0xFF01, EX },
+	{ 0xFF04, 0xFF04, PR }, { 0xFF05, 0xFF05, PO }, { 0xFF08, 0xFF08, OP },
+	{ 0xFF09, 0xFF09, CP }, { 0xFF0C, 0xFF0C, CL }, { 0xFF0E, 0xFF0E, CL },
+	{ 0xFF1A, 0xFF1B, NS }, { 0xFF1F, 0xFF1F, EX }, { 0xFF3B, 0xFF3B, OP },
+	{ 0xFF3D, 0xFF3D, CP }, { 0xFF5B, 0xFF5B, OP }, { 0xFF5D, 0xFF5D, CL },
+	{ 0xFF5F, 0xFF5F, OP }, { 0xFF60, 0xFF61, CL }, { 0xFF62, 0xFF62, OP },
+	{ 0xFF63, 0xFF64, CL }, { 0xFF65, 0xFF65, NS }, { 0xFF67, 0xFF70, NS },
+	{ 0xFF9E, 0xFF9F, NS }, { 0xFFE0, 0xFFE0, PO }, { 0xFFE1, 0xFFE1, PR },
+	{ 0xFFE5, 0xFFE6, PR }, { 0xFFF9, 0xFFFB, CM }, { 0x1F1E6, 0x1F1FF, RI },
+};
+
+/* the wide blocks, after the exceptions in the range table */
+static LineBreakClass
+block_class (gunichar ch)
+{
+	if (ch >= 0xAC00 && ch <= 0xD7A3)
+		return ((ch - 0xAC00) % 28 == 0) ? H2 : H3;
+
+	if ((ch >= 0x2E80 && ch <= 0x2FFF) ||		/* CJK radicals, Kangxi, description characters */
+	    (ch >= 0x3000 && ch <= 0x33FF) ||		/* CJK symbols, kana, bopomofo, compatibility */
+	    (ch >= 0x3400 && ch <= 0x4DBF) ||		/* CJK extension A */
+	    (ch >= 0x4E00 && ch <= 0x9FFF) ||		/* CJK unified ideographs */
+	    (ch >= 0xA000 && ch <= 0xA4CF) ||		/* Yi */
+	    (ch >= 0xF900 && ch <= 0xFAFF) ||		/* CJK compatibility ideographs */
+	    (ch >= 0xFE30 && ch <= 0xFE4F) ||		/* CJK compatibility forms */
+	    (ch >= 0xFF00 && ch <= 0xFF60) ||		/* fullwidth forms */
+	    (ch >= 0xFFE0 && ch <= 0xFFE6) ||
+	    (ch >= 0x1F300 && ch <= 0x1FAFF) ||		/* pictographs */
+	    (ch >= 0x20000 && ch <= 0x3FFFD))		/* supplementary ideographic planes */
+		return ID;
+
+	return AL;
+}
+
+LineBreakClass
+gdip_line_break_class (gunichar ch)
+{
+	int low, high;
+
+	if (ch < 0x100)
+		return latin1_classes [ch];
+
+	low = 0;
+	high = sizeof (ranges) / sizeof (ranges [0]) - 1;
+	while (low <= high) {
+		int mid = (low + high) / 2;
+
+		if (ch < ranges [mid].first)
+			high = mid - 1;
+		else if (ch > ranges [mid].last)
+			low = mid + 1;
+		else
+			return ranges [mid].cls;
+	}
+
+	return block_class (ch);
+}
+
+/* rules LB11 to LB31 for two classes which aren't spaces, marks or mandatory breaks; an
+ * indirect break (the % of the UAX #14 pair table) is only taken when spaces separate them */
+typedef enum {
+	PairProhibited,
+	PairIndirect,
+	PairDirect
+} PairAction;
+
+static PairAction
+pair_action (LineBreakClass before, LineBreakClass after)
+{
+	if (before == ZW)
+		return PairDirect;
+	if (before == WJ || after == WJ || before == GL || before == OP)
+		return PairProhibited;
+	if (after == GL)
+		return (before == BA || before == HY) ? PairDirect : PairIndirect;
+	if (after == CL || after == CP || after == EX || after == IS || after == SY)
+		return PairProhibited;
+	if (before == QU && after == OP)
+		return PairProhibited;
+	if ((before == CL || before == CP) && after == NS)
+		return PairProhibited;
+	if (before == B2 && after == B2)
+		return PairProhibited;
+	if (before == SOT || before == QU || after == QU)
+		return PairIndirect;
+	if (after == BA || after == HY || after == NS || before == BB)
+		return PairIndirect;
+	if (after == LineBreakIN)
+		return PairIndirect;
+
+	switch (after) {
+	case AL:
+		if (before == AL || before == NU || before == PR || before == PO || before == IS || before == CP)
+			return PairIndirect;
+		break;
+	case NU:
+		if (before == AL || before == NU || before == PR || before == PO || before == HY || before == IS ||
+		    before == SY || before == CP)
+			return PairIndirect;
+		break;
+	case ID:
+		if (before == PR)
+			return PairIndirect;
+		break;
+	case PO:
+		if (before == ID || before == NU || before == CL || before == CP || before == JL || before == JV ||
+		    before == JT || before == H2 || before == H3)
+			return PairIndirect;
+		break;
+	case PR:
+		if (before == NU || before == CL || before == CP)
+			return PairIndirect;
+		break;
+	case OP:
+		if (before == PR || before == PO || before == AL || before == NU)
+			return PairIndirect;
+		break;
+	case JL:
+		if (before == JL || before == PR)
+			return PairIndirect;
+		break;
+	case JV:
+		if (before == JL || before == JV || before == H2 || before == PR)
+			return PairIndirect;
+		break;
+	case JT:
+		if (before == JV || before == JT || before == H2 || before == H3 || before == PR)
+			return PairIndirect;
+		break;
+	case H2:
+	case H3:
+		if (before == JL || before == PR)
+			return PairIndirect;
+		break;
+	case RI:
+		if (before == RI)
+			return PairIndirect;
+		break;
+	default:
+		break;
+	}
+
+	return PairDirect;
+}
+
+void
+gdip_line_breaker_init (GpLineBreaker *breaker)
+{
+	breaker->cls = SOT;
+	breaker->spaces = FALSE;
+}
+
+/* returns whether a line may start with ch */
+LineBreakAction
+gdip_line_breaker_next (GpLineBreaker *breaker, WCHAR ch)
+{
+	LineBreakClass before = breaker->cls;
+	LineBreakClass cls;
+	PairAction action;
+
+	/* the pair is classified on its high surrogate, plane 2 and 3 are ideographic */
+	if (ch >= 0xDC00 && ch <= 0xDFFF)
+		return LineBreakProhibited;
+	if (ch >= 0xD800 && ch <= 0xDBFF)
+		cls = (ch >= 0xD840 && ch <= 0xD8BF) ? ID : ((ch == 0xD83C || ch == 0xD83D || ch == 0xD83E) ? ID : AL);
+	else
+		cls = gdip_line_break_class (ch);
+
+	/* LB4, LB5: always break after hard line breaks, but keep CR LF together */
+	if (before == BK || before == LF || (before == CR && cls != LF)) {
+		breaker->cls = (cls == SP || cls == CM) ? AL : cls;
+		breaker->spaces = FALSE;
+		return LineBreakMandatory;
+	}
+
+	/* LB6, LB7: never break before hard line breaks, spaces or ZW */
+	switch (cls) {
+	case BK:
+	case CR:
+	case LF:
+	case ZW:
+		breaker->cls = cls;
+		breaker->spaces = FALSE;
+		return LineBreakProhibited;
+	case SP:
+		breaker->spaces = TRUE;
+		return LineBreakProhibited;
+	case CM:
+		/* LB9: marks belong to what precedes them, LB10: after spaces they are alphabetic */
+		if (!breaker->spaces && before != SOT && before != ZW)
+			return LineBreakProhibited;
+		cls = AL;
+		break;
+	default:
+		break;
+	}
+
+	action = pair_action (before, cls);
+	breaker->cls = cls;
+	if (action == PairDirect || (action == PairIndirect && breaker->spaces)) {
+		breaker->spaces = FALSE;
+		return LineBreakAllowed;
+	}
+	breaker->spaces = FALSE;
+	return LineBreakProhibited;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * NOTE: This is a private header files and everything is subject to changes.
+ */
+
+#ifndef __LINEBREAK_H__
+#define __LINEBREAK_H__
+
+#include "win32structs.h"
+
+/* line breaking classes of UAX #14, the ones resolved by rule LB1 are mapped on AL, NS or CM */
+typedef enum {
+	LineBreakAL,		/* alphabetic, also AI, SA, SG and XX */
+	LineBreakBA,		/* break after */
+	LineBreakBB,		/* break before */
+	LineBreakB2,		/* break opportunity before and after */
+	LineBreakBK,		/* mandatory break, also NL */
+	LineBreakCL,		/* close punctuation */
+	LineBreakCM,		/* combining mark, also ZWJ */
+	LineBreakCP,		/* close parenthesis */
+	LineBreakCR,
+	LineBreakEX,		/* exclamation/interrogation */
+	LineBreakGL,		/* non-breaking glue */
+	LineBreakH2,		/* hangul LV syllable */
+	LineBreakH3,		/* hangul LVT syllable */
+	LineBreakHY,		/* hyphen */
+	LineBreakID,		/* ideographic */
+	LineBreakIN,		/* inseparable */
+	LineBreakIS,		/* infix numeric separator */
+	LineBreakJL,		/* hangul L jamo */
+	LineBreakJT,		/* hangul T jamo */
+	LineBreakJV,		/* hangul V jamo */
+	LineBreakLF,
+	LineBreakNS,		/* nonstarter, also CJ */
+	LineBreakNU,		/* numeric */
+	LineBreakOP,		/* open punctuation */
+	LineBreakPO,		/* postfix numeric */
+	LineBreakPR,		/* prefix numeric */
+	LineBreakQU,		/* quotation */
+	LineBreakRI,		/* regional indicator */
+	LineBreakSP,		/* space */
+	LineBreakSY,		/* symbols allowing break after */
+	LineBreakWJ,		/* word joiner */
+	LineBreakZW,		/* zero width space */
+	LineBreakSOT		/* start of text, never returned by gdip_line_break_class */
+} LineBreakClass;
+
+typedef enum {
+	LineBreakProhibited,
+	LineBreakAllowed,
+	LineBreakMandatory
+} LineBreakAction;
+
+/* the breaker sees the text one UTF-16 unit at a time, so a string is handled in a single pass */
+typedef struct {
+	LineBreakClass	cls;		/* of the last character that isn't a space or a combining mark */
+	BOOL		spaces;		/* spaces were seen after it */
+} GpLineBreaker;
+
+LineBreakClass gdip_line_break_class (gunichar ch) GDIP_INTERNAL;
+void gdip_line_breaker_init (GpLineBreaker *breaker) GDIP_INTERNAL;
+LineBreakAction gdip_line_breaker_next (GpLineBreaker *breaker, WCHAR ch) GDIP_INTERNAL;
+
+#endif
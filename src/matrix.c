@@ -325,24 +325,112 @@ GdipInvertMatrix (GpMatrix *matrix)
                 cairo_matrix_invert (matrix));
 }
 
+/*
+ * The point array kernels below pick a loop for the kind of matrix, once,
+ * instead of a full cairo_matrix_transform_point call per point. The loops
+ * have no dependency between iterations so the compiler can vectorize them.
+ */
+typedef enum {
+	MatrixKindIdentity,
+	MatrixKindTranslation,
+	MatrixKindScale,
+	MatrixKindAffine
+} MatrixKind;
+
+static MatrixKind
+gdip_matrix_kind (GpMatrix *matrix)
+{
+	if ((matrix->yx != 0.0) || (matrix->xy != 0.0))
+		return MatrixKindAffine;
+	if ((matrix->xx != 1.0) || (matrix->yy != 1.0))
+		return MatrixKindScale;
+	if ((matrix->x0 != 0.0) || (matrix->y0 != 0.0))
+		return MatrixKindTranslation;
+	return MatrixKindIdentity;
+}
+
+/* same result as cairo_matrix_transform_point on each point, in place */
+void
+gdip_matrix_transform_points (GpMatrix *matrix, GpPointF *pts, int count)
+{
+	double xx = matrix->xx, yx = matrix->yx, xy = matrix->xy, yy = matrix->yy;
+	double x0 = matrix->x0, y0 = matrix->y0;
+	int i;
+
+	switch (gdip_matrix_kind (matrix)) {
+	case MatrixKindIdentity:
+		break;
+	case MatrixKindTranslation:
+		for (i = 0; i < count; i++) {
+			pts [i].X = (float) (pts [i].X + x0);
+			pts [i].Y = (float) (pts [i].Y + y0);
+		}
+		break;
+	case MatrixKindScale:
+		for (i = 0; i < count; i++) {
+			pts [i].X = (float) (pts [i].X * xx + x0);
+			pts [i].Y = (float) (pts [i].Y * yy + y0);
+		}
+		break;
+	default:
+		for (i = 0; i < count; i++) {
+			double x = pts [i].X;
+			double y = pts [i].Y;
+
+			pts [i].X = (float) (xx * x + xy * y + x0);
+			pts [i].Y = (float) (yx * x + yy * y + y0);
+		}
+		break;
+	}
+}
+
+/* transform the points into the point slots of cairo path data, @stride elements apart */
+void
+gdip_matrix_transform_cairo_points (GpMatrix *matrix, GDIPCONST GpPointF *pts, int count, cairo_path_data_t *data, int stride)
+{
+	double xx = matrix->xx, yx = matrix->yx, xy = matrix->xy, yy = matrix->yy;
+	double x0 = matrix->x0, y0 = matrix->y0;
+	int i;
+
+	switch (gdip_matrix_kind (matrix)) {
+	case MatrixKindIdentity:
+		for (i = 0; i < count; i++, data += stride) {
+			data->point.x = pts [i].X;
+			data->point.y = pts [i].Y;
+		}
+		break;
+	case MatrixKindTranslation:
+		for (i = 0; i < count; i++, data += stride) {
+			data->point.x = pts [i].X + x0;
+			data->point.y = pts [i].Y + y0;
+		}
+		break;
+	case MatrixKindScale:
+		for (i = 0; i < count; i++, data += stride) {
+			data->point.x = pts [i].X * xx + x0;
+			data->point.y = pts [i].Y * yy + y0;
+		}
+		break;
+	default:
+		for (i = 0; i < count; i++, data += stride) {
+			double x = pts [i].X;
+			double y = pts [i].Y;
+
+			data->point.x = xx * x + xy * y + x0;
+			data->point.y = yx * x + yy * y + y0;
+		}
+		break;
+	}
+}
+
 GpStatus
 GdipTransformMatrixPoints (GpMatrix *matrix, GpPointF *pts, int count)
 {
-        int i;
-
 	if (!matrix || !pts || (count < 1))
 		return InvalidParameter;
-        
-        for (i = 0; i < count; i++, pts++) {
-                double x = pts->X;
-                double y = pts->Y;
-                cairo_matrix_transform_point (matrix, &x, &y);
 
-                pts->X = (float) x;
-                pts->Y = (float) y;
-        }
-
-        return Ok;
+	gdip_matrix_transform_points (matrix, pts, count);
+	return Ok;
 }
 
 GpStatus
@@ -411,6 +411,222 @@ gdip_region_bitmap_apply_alpha (GpBitmap *bitmap, GpRegionBitmap *alpha)
 }
 
 
+static int get_buffer_pos (GpRegionBitmap *shape, int x, int y);
+static int get_byte (GpRegionBitmap *shape, int x, int y);
+static BOOL bitmap_intersect (GpRegionBitmap *shape1, GpRegionBitmap *shape2);
+static GpRegionBitmap* gdip_region_bitmap_from_tree (GpPathTree *tree);
+
+
+/*
+ * is_bitmap_empty:
+ * @bitmap: a GpRegionBitmap
+ *
+ * Return TRUE if no pixel is set inside @bitmap.
+ */
+static BOOL
+is_bitmap_empty (GpRegionBitmap *bitmap)
+{
+	int i, size;
+
+	if (!bitmap->Mask || (bitmap->Width == 0) || (bitmap->Height == 0))
+		return TRUE;
+
+	size = (bitmap->Width * bitmap->Height >> 3);
+	for (i = 0; i < size; i++) {
+		if (bitmap->Mask [i])
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+/*
+ * path_may_intersect:
+ * @path: a GpPath
+ * @bitmap: a GpRegionBitmap
+ *
+ * Return FALSE if the points of @path (which, for curves, includes the 
+ * control points) are all outside of the @bitmap rectangle. This is a cheap
+ * way to know if a path can be ignored without rendering it.
+ */
+static BOOL
+path_may_intersect (GpPath *path, GpRegionBitmap *bitmap)
+{
+	float min_x, min_y, max_x, max_y;
+	int i;
+
+	if ((path->count == 0) || (bitmap->Width == 0) || (bitmap->Height == 0))
+		return FALSE;
+
+	min_x = max_x = g_array_index (path->points, GpPointF, 0).X;
+	min_y = max_y = g_array_index (path->points, GpPointF, 0).Y;
+	for (i = 1; i < path->count; i++) {
+		GpPointF *pt = &g_array_index (path->points, GpPointF, i);
+		if (pt->X < min_x)
+			min_x = pt->X;
+		else if (pt->X > max_x)
+			max_x = pt->X;
+		if (pt->Y < min_y)
+			min_y = pt->Y;
+		else if (pt->Y > max_y)
+			max_y = pt->Y;
+	}
+
+	/* keep a one pixel margin as the path bitmap is made of whole pixels */
+	return ((min_x - 1 < bitmap->X + bitmap->Width) && (max_x + 1 > bitmap->X) &&
+		(min_y - 1 < bitmap->Y + bitmap->Height) && (max_y + 1 > bitmap->Y));
+}
+
+
+/*
+ * combine_in_place:
+ * @acc: a GpRegionBitmap, modified by the operation
+ * @shape: a GpRegionBitmap
+ * @combineMode: the binary operator to apply between the two shapes
+ *
+ * Apply the @combineMode between @acc and @shape, storing the result in @acc
+ * when this is possible without growing it (i.e. @acc covers @shape for an 
+ * union or a xor). Return FALSE if the operation was not done.
+ */
+static BOOL
+combine_in_place (GpRegionBitmap *acc, GpRegionBitmap *shape, CombineMode combineMode)
+{
+	GpRect rect;
+	int x, y;
+
+	if (!acc->Mask)
+		return FALSE;
+
+	switch (combineMode) {
+	case CombineModeIntersect:
+		for (y = acc->Y; y < acc->Y + acc->Height; y++) {
+			int p = get_buffer_pos (acc, acc->X, y);
+			for (x = acc->X; x < acc->X + acc->Width; x += 8) {
+				acc->Mask [p++] &= get_byte (shape, x, y);
+			}
+		}
+		return TRUE;
+	case CombineModeExclude:
+		if (!bitmap_intersect (acc, shape))
+			return TRUE;
+		rect_intersect (acc, shape, &rect);
+		break;
+	case CombineModeUnion:
+	case CombineModeXor:
+		if ((shape->Width == 0) || (shape->Height == 0))
+			return TRUE;
+		if ((shape->X < acc->X) || (shape->Y < acc->Y) ||
+			(shape->X + shape->Width > acc->X + acc->Width) ||
+			(shape->Y + shape->Height > acc->Y + acc->Height)) {
+			return FALSE;
+		}
+		rect.X = shape->X;
+		rect.Y = shape->Y;
+		rect.Width = shape->Width;
+		rect.Height = shape->Height;
+		break;
+	default:
+		return FALSE;
+	}
+
+	for (y = rect.Y; y < rect.Y + rect.Height; y++) {
+		int p = get_buffer_pos (acc, rect.X, y);
+		for (x = rect.X; x < rect.X + rect.Width; x += 8) {
+			BYTE b = get_byte (shape, x, y);
+			switch (combineMode) {
+			case CombineModeExclude:
+				acc->Mask [p++] &= ~b;
+				break;
+			case CombineModeUnion:
+				acc->Mask [p++] |= b;
+				break;
+			default:
+				acc->Mask [p++] ^= b;
+				break;
+			}
+		}
+	}
+	return TRUE;
+}
+
+
+/*
+ * gdip_region_bitmap_from_chain:
+ * @tree: a GpPathTree node
+ *
+ * Return a new GpRegionBitmap for @tree where the chain of nodes sharing the
+ * same operation (e.g. ((a + b) + c) + d, as built by consecutive combine 
+ * calls) is processed as a single n-ary operation. Operands are accumulated
+ * in a single bitmap (when possible) and the ones that cannot change the 
+ * result (outside the bounds of an exclusion or intersection) are not
+ * rendered at all.
+ */
+static GpRegionBitmap*
+gdip_region_bitmap_from_chain (GpPathTree *tree)
+{
+	CombineMode mode = tree->mode;
+	GpPathTree **operands;
+	GpPathTree *node;
+	GpRegionBitmap *result;
+	int i, n;
+
+	/* count the operands of the chain */
+	for (n = 1, node = tree; !node->path && (node->mode == mode); node = node->branch1)
+		n++;
+
+	operands = (GpPathTree**) GdipAlloc (sizeof (GpPathTree*) * n);
+	if (!operands)
+		return NULL;
+
+	/* the deepest left branch is the first operand, the right branches follow, bottom-up */
+	i = n - 1;
+	for (node = tree; !node->path && (node->mode == mode); node = node->branch1)
+		operands [i--] = node->branch2;
+	operands [0] = node;
+
+	result = gdip_region_bitmap_from_tree (operands [0]);
+	for (i = 1; result && (i < n); i++) {
+		GpRegionBitmap *bitmap, *combined;
+
+		/* skip operands that can't change the result */
+		if (operands [i]->path && !path_may_intersect (operands [i]->path, result)) {
+			if (mode == CombineModeExclude)
+				continue;
+			if (mode == CombineModeIntersect) {
+				gdip_region_bitmap_free (result);
+				result = alloc_bitmap_with_buffer (0, 0, 0, 0, NULL);
+				break;
+			}
+		}
+
+		bitmap = gdip_region_bitmap_from_tree (operands [i]);
+		if (!bitmap) {
+			gdip_region_bitmap_free (result);
+			result = NULL;
+			break;
+		}
+
+		if (!combine_in_place (result, bitmap, mode)) {
+			combined = gdip_region_bitmap_combine (result, bitmap, mode);
+			gdip_region_bitmap_free (result);
+			result = combined;
+		}
+		gdip_region_bitmap_free (bitmap);
+
+		/* nothing can be intersected with an empty shape */
+		if (result && (mode == CombineModeIntersect) && is_bitmap_empty (result)) {
+			empty_bitmap (result);
+			break;
+		}
+	}
+
+	GdipFree (operands);
+	if (result)
+		gdip_region_bitmap_shrink (result, FALSE);
+	return result;
+}
+
+
 /*
  * gdip_region_bitmap_from_tree:
  * @tree: a GpPathTree
@@ -432,8 +648,11 @@ gdip_region_bitmap_from_tree (GpPathTree *tree)
 	if (tree->path) {
 		/* (a) only a path (the most common case) */
 		result = gdip_region_bitmap_from_path (tree->path);
+	} else if ((tree->mode != CombineModeComplement) && !tree->branch1->path && (tree->branch1->mode == tree->mode)) {
+		/* (b) a chain of items sharing the same operation */
+		result = gdip_region_bitmap_from_chain (tree);
 	} else {
-		/* (b) two items with an binary operation */
+		/* (c) two items with an binary operation */
 		GpRegionBitmap *bitmap1 = gdip_region_bitmap_from_tree (tree->branch1);
 		GpRegionBitmap *bitmap2 = gdip_region_bitmap_from_tree (tree->branch2);
 
@@ -487,6 +706,59 @@ gdip_region_bitmap_invalidate (GpRegion *region)
 }
 
 
+/*
+ * gdip_region_bitmap_translate:
+ * @bitmap: a GpRegionBitmap
+ * @dx: the horizontal offset
+ * @dy: the vertical offset
+ *
+ * Move @bitmap by @dx, @dy without rendering it again. Return FALSE if this
+ * isn't possible (i.e. the offsets are not whole pixels), in which case the
+ * bitmap must be re-created from its paths.
+ */
+BOOL
+gdip_region_bitmap_translate (GpRegionBitmap *bitmap, float dx, float dy)
+{
+	int x, y, c, shift, row_bytes, new_row_bytes;
+	BYTE *buffer;
+
+	if ((dx != floorf (dx)) || (dy != floorf (dy)))
+		return FALSE;
+
+	bitmap->Y += (int) dy;
+	x = bitmap->X + (int) dx;
+	/* the origin must stay a multiple of 8 */
+	shift = (x & 7);
+	if ((shift == 0) || !bitmap->Mask || (bitmap->Width == 0) || (bitmap->Height == 0)) {
+		bitmap->X = x - shift;
+		return TRUE;
+	}
+
+	/* move every pixel of the mask by shift pixels, in a bitmap one byte wider */
+	row_bytes = bitmap->Width >> 3;
+	new_row_bytes = row_bytes + 1;
+	buffer = alloc_bitmap_memory (new_row_bytes * bitmap->Height, TRUE);
+	if (!buffer)
+		return FALSE;
+
+	for (y = 0; y < bitmap->Height; y++) {
+		BYTE *src = bitmap->Mask + y * row_bytes;
+		BYTE *dest = buffer + y * new_row_bytes;
+		for (c = 0; c < row_bytes; c++) {
+			dest [c] |= (BYTE) (src [c] << shift);
+			dest [c + 1] |= (BYTE) (src [c] >> (8 - shift));
+		}
+	}
+
+	GdipFree (bitmap->Mask);
+	bitmap->Mask = buffer;
+	bitmap->X = x - shift;
+	bitmap->Width += 8;
+	bitmap->reduced = FALSE;
+	return TRUE;
+}
+
+
 /*
  * gdip_region_bitmap_from_path:
  * @path: a GpPath
@@ -802,7 +1074,47 @@ gdip_region_bitmap_is_point_visible (GpRegionBitmap *bitmap, int x, int y)
 
 
 /*
- * gdip_region_bitmap_is_point_visible:
+ * is_span_visible:
+ * @bitmap: a GpRegionBitmap
+ * @x1: the first horizontal position (inclusive)
+ * @x2: the last horizontal position (exclusive)
+ * @y: the vertical position
+ *
+ * Return TRUE if any point between @x1 and @x2 on line @y is set on the 
+ * bitmap. Whole bytes are checked at once.
+ *
+ * Note: No bounds check are done this internal shared function.
+ */
+static BOOL
+is_span_visible (GpRegionBitmap *bitmap, int x1, int x2, int y)
+{
+	int start = (y - bitmap->Y) * bitmap->Width + (x1 - bitmap->X);
+	int end = start + (x2 - x1);
+
+	/* leading bits, up to the first byte boundary */
+	while ((start < end) && (start & 7)) {
+		if (bitmap->Mask [start >> 3] & (1 << (start & 7)))
+			return TRUE;
+		start++;
+	}
+	/* full bytes */
+	while (end - start >= 8) {
+		if (bitmap->Mask [start >> 3])
+			return TRUE;
+		start += 8;
+	}
+	/* trailing bits */
+	while (start < end) {
+		if (bitmap->Mask [start >> 3] & (1 << (start & 7)))
+			return TRUE;
+		start++;
+	}
+	return FALSE;
+}
+
+
+/*
+ * gdip_region_bitmap_is_rect_visible:
  * @bitmap: a GpRegionBitmap
  * @rect: a pointer to a GpRect
  *
@@ -811,28 +1123,31 @@ gdip_region_bitmap_is_point_visible (GpRegionBitmap *bitmap, int x, int y)
 BOOL
 gdip_region_bitmap_is_rect_visible (GpRegionBitmap *bitmap, GpRect *rect)
 {
-	int x, y;
+	int x1, y1, x2, y2, y;
 
 	/* is this an empty bitmap ? */
 	if ((bitmap->Width == 0) || (bitmap->Height == 0))
 		return FALSE;
 
 	/* quick intersection checks */
-	if (bitmap->X < rect->X + rect->Width)
+	if (rect->X >= bitmap->X + bitmap->Width)
 		return FALSE;
-	if (bitmap->X + bitmap->Width > rect->X)
+	if (rect->X + rect->Width <= bitmap->X)
 		return FALSE;
-	if (bitmap->Y < rect->Y + rect->Height)
+	if (rect->Y >= bitmap->Y + bitmap->Height)
 		return FALSE;
-	if (bitmap->Y + bitmap->Height > rect->Y)
+	if (rect->Y + rect->Height <= bitmap->Y)
 		return FALSE;
 
-	/* TODO - optimize */
-	for (y = rect->Y; y < rect->Y + rect->Height; y++) {
-		for (x = rect->X; x < rect->X + rect->Width; x++) {
-			if (is_point_visible (bitmap, x, y))
-				return TRUE;
-		}
+	/* only look at the part of @rect that is inside the bitmap */
+	x1 = MAX (rect->X, bitmap->X);
+	x2 = MIN (rect->X + rect->Width, bitmap->X + bitmap->Width);
+	y1 = MAX (rect->Y, bitmap->Y);
+	y2 = MIN (rect->Y + rect->Height, bitmap->Y + bitmap->Height);
+
+	for (y = y1; y < y2; y++) {
+		if (is_span_visible (bitmap, x1, x2, y))
+			return TRUE;
 	}
 	return FALSE;
 }
@@ -58,6 +58,7 @@ GpRegionBitmap* gdip_region_bitmap_clone (GpRegionBitmap *bitmap) GDIP_INTERNAL;
 
 void gdip_region_bitmap_free (GpRegionBitmap *bitmap) GDIP_INTERNAL;
 void gdip_region_bitmap_invalidate (GpRegion *region) GDIP_INTERNAL;
+BOOL gdip_region_bitmap_translate (GpRegionBitmap *bitmap, float dx, float dy) GDIP_INTERNAL;
 
 BOOL gdip_region_bitmap_compare (GpRegionBitmap *shape1, GpRegionBitmap *shape2) GDIP_INTERNAL;
 BOOL gdip_region_bitmap_is_point_visible (GpRegionBitmap *bitmap, int x, int y) GDIP_INTERNAL;
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include "region-index.h"
+
+/*
+ * compare_rects:
+ *
+ * qsort callback ordering rectangles by Y, then by X.
+ */
+static int
+compare_rects (const void *a, const void *b)
+{
+	const GpRectF *r1 = (const GpRectF*) a;
+	const GpRectF *r2 = (const GpRectF*) b;
+
+	if (r1->Y != r2->Y)
+		return (r1->Y < r2->Y) ? -1 : 1;
+	if (r1->X != r2->X)
+		return (r1->X < r2->X) ? -1 : 1;
+	return 0;
+}
+
+
+/*
+ * rect_bounds:
+ * @rect: a GpRectF
+ * @bounds: the GpRegionIndexBounds to set
+ *
+ * Set @bounds to the area covered by @rect (which may not be normalized).
+ */
+static void
+rect_bounds (GpRectF *rect, GpRegionIndexBounds *bounds)
+{
+	bounds->left = MIN (rect->X, rect->X + rect->Width);
+	bounds->right = MAX (rect->X, rect->X + rect->Width);
+	bounds->top = MIN (rect->Y, rect->Y + rect->Height);
+	bounds->bottom = MAX (rect->Y, rect->Y + rect->Height);
+}
+
+
+/*
+ * union_bounds:
+ * @bounds: the GpRegionIndexBounds to grow
+ * @other: the GpRegionIndexBounds to add
+ */
+static void
+union_bounds (GpRegionIndexBounds *bounds, GpRegionIndexBounds *other)
+{
+	if (other->left < bounds->left)
+		bounds->left = other->left;
+	if (other->top < bounds->top)
+		bounds->top = other->top;
+	if (other->right > bounds->right)
+		bounds->right = other->right;
+	if (other->bottom > bounds->bottom)
+		bounds->bottom = other->bottom;
+}
+
+
+/*
+ * gdip_region_index_create:
+ * @rects: an array of GpRectF
+ * @count: the number of rectangles in @rects
+ *
+ * Build a read-only index over the @count rectangles. The rectangles are
+ * copied so the index stays valid until the region is modified (and the
+ * index freed).
+ *
+ * Return a new GpRegionIndex or NULL (e.g. out of memory).
+ */
+GpRegionIndex*
+gdip_region_index_create (GpRectF *rects, int count)
+{
+	GpRegionIndex *index;
+	int level, i, n;
+
+	if (!rects || (count < 1))
+		return NULL;
+
+	index = (GpRegionIndex*) GdipAlloc (sizeof (GpRegionIndex));
+	if (!index)
+		return NULL;
+
+	index->cnt = count;
+	index->levels = 0;
+	index->rects = (GpRectF*) GdipAlloc (sizeof (GpRectF) * count);
+	if (!index->rects) {
+		GdipFree (index);
+		return NULL;
+	}
+	memcpy (index->rects, rects, sizeof (GpRectF) * count);
+	qsort (index->rects, count, sizeof (GpRectF), compare_rects);
+
+	/* each level groups REGION_INDEX_FANOUT items of the level below (the rectangles for level 0) */
+	n = count;
+	for (level = 0; level < REGION_INDEX_MAX_LEVELS; level++) {
+		int nodes = (n + REGION_INDEX_FANOUT - 1) / REGION_INDEX_FANOUT;
+		GpRegionIndexBounds *bounds = (GpRegionIndexBounds*) GdipAlloc (sizeof (GpRegionIndexBounds) * nodes);
+		if (!bounds) {
+			gdip_region_index_free (index);
+			return NULL;
+		}
+
+		for (i = 0; i < n; i++) {
+			GpRegionIndexBounds child;
+			GpRegionIndexBounds *node = &bounds [i / REGION_INDEX_FANOUT];
+
+			if (level == 0)
+				rect_bounds (&index->rects [i], &child);
+			else
+				child = index->bounds [level - 1][i];
+
+			if ((i % REGION_INDEX_FANOUT) == 0)
+				*node = child;
+			else
+				union_bounds (node, &child);
+		}
+
+		index->nodes [level] = nodes;
+		index->bounds [level] = bounds;
+		index->levels++;
+
+		/* the top level is always scanned, stop once it's small enough */
+		if (nodes <= REGION_INDEX_FANOUT)
+			break;
+		n = nodes;
+	}
+
+	return index;
+}
+
+
+/*
+ * gdip_region_index_free:
+ * @index: a GpRegionIndex
+ *
+ * Free the index and all its memory.
+ */
+void
+gdip_region_index_free (GpRegionIndex *index)
+{
+	int level;
+
+	if (!index)
+		return;
+
+	for (level = 0; level < index->levels; level++)
+		GdipFree (index->bounds [level]);
+	if (index->rects)
+		GdipFree (index->rects);
+	GdipFree (index);
+}
+
+
+/*
+ * bounds_match:
+ * @bounds: the area covered by a node (or rectangle)
+ * @query: the area being looked up
+ * @point: TRUE if @query is a single point
+ *
+ * Return TRUE if @query can be inside @bounds. A point matches using the
+ * same rules as the rectangle regions (i.e. the right and bottom edges are
+ * excluded) while a rectangle must overlap @bounds.
+ */
+static BOOL
+bounds_match (GpRegionIndexBounds *bounds, GpRegionIndexBounds *query, BOOL point)
+{
+	if (point) {
+		return ((query->left >= bounds->left) && (query->left < bounds->right) &&
+			(query->top >= bounds->top) && (query->top < bounds->bottom));
+	}
+
+	return ((query->left < bounds->right) && (query->right > bounds->left) &&
+		(query->top < bounds->bottom) && (query->bottom > bounds->top));
+}
+
+
+/*
+ * lookup:
+ * @index: a GpRegionIndex
+ * @level: the level of @node (-1 for the rectangles)
+ * @node: the item, at @level, to look into
+ * @query: the area being looked up
+ * @point: TRUE if @query is a single point
+ *
+ * Return TRUE if any rectangle below @node matches @query.
+ */
+static BOOL
+lookup (GpRegionIndex *index, int level, int node, GpRegionIndexBounds *query, BOOL point)
+{
+	GpRegionIndexBounds bounds;
+	int first, last, i;
+
+	if (level < 0) {
+		GpRectF *rect = &index->rects [node];
+
+		/* like gdip_is_Point_in_RectF_Visible an empty or non-normalized rectangle never contains anything */
+		if ((rect->Width <= 0) || (rect->Height <= 0))
+			return FALSE;
+
+		rect_bounds (rect, &bounds);
+		return bounds_match (&bounds, query, point);
+	}
+
+	if (!bounds_match (&index->bounds [level][node], query, point))
+		return FALSE;
+
+	first = node * REGION_INDEX_FANOUT;
+	last = MIN (first + REGION_INDEX_FANOUT, (level == 0) ? index->cnt : index->nodes [level - 1]);
+	for (i = first; i < last; i++) {
+		if (lookup (index, level - 1, i, query, point))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+static BOOL
+lookup_top (GpRegionIndex *index, GpRegionIndexBounds *query, BOOL point)
+{
+	int top = index->levels - 1;
+	int i;
+
+	for (i = 0; i < index->nodes [top]; i++) {
+		if (lookup (index, top, i, query, point))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+/*
+ * gdip_region_index_is_point_visible:
+ * @index: a GpRegionIndex
+ * @x: the horizontal position
+ * @y: the vertical position
+ *
+ * Return TRUE if the @x,@y point is inside any of the indexed rectangles.
+ */
+BOOL
+gdip_region_index_is_point_visible (GpRegionIndex *index, float x, float y)
+{
+	GpRegionIndexBounds query;
+
+	query.left = query.right = x;
+	query.top = query.bottom = y;
+	return lookup_top (index, &query, TRUE);
+}
+
+
+/*
+ * gdip_region_index_is_rect_visible:
+ * @index: a GpRegionIndex
+ * @rect: a normalized GpRectF
+ *
+ * Return TRUE if _any_ part of @rect is inside the indexed rectangles.
+ */
+BOOL
+gdip_region_index_is_rect_visible (GpRegionIndex *index, GpRectF *rect)
+{
+	GpRegionIndexBounds query;
+
+	rect_bounds (rect, &query);
+	return lookup_top (index, &query, FALSE);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * NOTE: This is a private header files and everything is subject to changes.
+ */
+
+#ifndef __REGION_INDEX_H__
+#define __REGION_INDEX_H__
+
+#include "gdiplus-private.h"
+
+/*
+ * Regions with less rectangles than REGION_INDEX_MIN_RECTS are scanned 
+ * linearly, building an index isn't worth it for them.
+ */
+#define REGION_INDEX_MIN_RECTS		16
+
+/* number of children for each node of the index */
+#define REGION_INDEX_FANOUT		8
+#define REGION_INDEX_MAX_LEVELS		12
+
+typedef struct {
+	float left;
+	float top;
+	float right;
+	float bottom;
+} GpRegionIndexBounds;
+
+/*
+ * A packed (read-only) R-tree built over the rectangles of a region. The 
+ * rectangles are sorted by Y then X and grouped REGION_INDEX_FANOUT at a 
+ * time, each level keeping the bounds of the groups of the level below.
+ */
+typedef struct {
+	int			cnt;
+	GpRectF*		rects;
+	int			levels;
+	int			nodes [REGION_INDEX_MAX_LEVELS];
+	GpRegionIndexBounds*	bounds [REGION_INDEX_MAX_LEVELS];
+} GpRegionIndex;
+
+
+GpRegionIndex* gdip_region_index_create (GpRectF *rects, int count) GDIP_INTERNAL;
+void gdip_region_index_free (GpRegionIndex *index) GDIP_INTERNAL;
+
+BOOL gdip_region_index_is_point_visible (GpRegionIndex *index, float x, float y) GDIP_INTERNAL;
+BOOL gdip_region_index_is_rect_visible (GpRegionIndex *index, GpRectF *rect) GDIP_INTERNAL;
+
+#endif
@@ -299,6 +299,7 @@ gdip_region_translate_tree (GpPathTree *tree, float dx, float dy)
 			point->X += dx;
 			point->Y += dy;
 		}
+		gdip_path_modified (tree->path);
 	} else {
 		gdip_region_translate_tree (tree->branch1, dx, dy);
 		gdip_region_translate_tree (tree->branch2, dx, dy);
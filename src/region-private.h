@@ -38,6 +38,7 @@
 #include "gdiplus-private.h"
 #include "matrix-private.h"
 #include "region-bitmap.h"
+#include "region-index.h"
 #include "region-path-tree.h"
 
 /* In the integer world infinity has limited bounds ;-) */
@@ -51,12 +52,30 @@ typedef enum {
         RegionTypePath  = 3
 } RegionType;
 
+/*
+ * Cached cairo path for a region used as a graphics clip. The path is only
+ * valid for the clip matrix and cairo matrix (and units) it was built with.
+ */
+typedef struct {
+	cairo_path_data_t*	data;
+	int			num_data;
+	cairo_matrix_t		clip_matrix;
+	cairo_matrix_t		ctm;
+	GpUnit			page_unit;
+	int			type;
+	float			dpi_x;
+	float			dpi_y;
+} GpRegionClipCache;
+
 struct _Region {
 	guint32		type;
         int		cnt;
         GpRectF*	rects;
 	GpPathTree*	tree;
 	GpRegionBitmap*	bitmap;
+	GpRegionClipCache* clip_cache;
+	GpRegionIndex*	index;
+	int		ref_count;
 };
 
 BOOL gdip_is_InfiniteRegion (GpRegion *region) GDIP_INTERNAL;
@@ -65,6 +84,11 @@ BOOL gdip_is_Point_in_RectF_inclusive (float x, float y, GpRectF* rect) GDIP_INT
 void gdip_clear_region (GpRegion *region) GDIP_INTERNAL;
 void gdip_copy_region (GpRegion *source, GpRegion *dest) GDIP_INTERNAL;
 
+void gdip_region_clip_cache_invalidate (GpRegion *region) GDIP_INTERNAL;
+
+GpRegion* gdip_region_ref (GpRegion *region) GDIP_INTERNAL;
+GpStatus gdip_region_make_writable (GpRegion **region) GDIP_INTERNAL;
+
 #include "region.h"
 
 #endif
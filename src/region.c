@@ -83,6 +83,26 @@ gdip_is_Point_in_RectFs_Visible (float x, float y, GpRectF* r, int cnt)
         return FALSE;
 }
 
+/* Does any part of the (normalized) rect overlap one of the rects ? */
+static BOOL
+gdip_is_RectF_in_RectFs_Visible (GpRectF *rect, GpRectF* r, int cnt)
+{
+        GpRectF* rc = r;
+        int i;
+
+        for (i = 0; i < cnt; i++, rc++) {
+		/* empty rectangles contain no point, so they never overlap anything */
+		if ((rc->Width <= 0) || (rc->Height <= 0))
+			continue;
+		if ((rect->X < rc->X + rc->Width) && (rect->X + rect->Width > rc->X) &&
+			(rect->Y < rc->Y + rc->Height) && (rect->Y + rect->Height > rc->Y)) {
+			return TRUE;
+		}
+        }
+
+        return FALSE;
+}
+
 static void
 gdip_get_bounds (GpRectF *allrects, int allcnt, GpRectF *bound)
 {
@@ -275,6 +295,57 @@ gdip_getlowestrect (GpRectF *rects, int cnt, GpRectF* src, GpRectF* rslt)
 	return TRUE;
 }
 
+/* the cached cairo clip must be dropped every time the region shape changes */
+void
+gdip_region_clip_cache_invalidate (GpRegion *region)
+{
+	if (!region->clip_cache)
+		return;
+
+	if (region->clip_cache->data)
+		GdipFree (region->clip_cache->data);
+	GdipFree (region->clip_cache);
+	region->clip_cache = NULL;
+}
+
+static GpRegionClipCache*
+gdip_region_clip_cache_clone (GpRegionClipCache *cache)
+{
+	GpRegionClipCache *result = (GpRegionClipCache*) GdipAlloc (sizeof (GpRegionClipCache));
+	if (!result)
+		return NULL;
+
+	memcpy (result, cache, sizeof (GpRegionClipCache));
+	if (cache->num_data > 0) {
+		result->data = (cairo_path_data_t*) GdipAlloc (sizeof (cairo_path_data_t) * cache->num_data);
+		if (!result->data) {
+			GdipFree (result);
+			return NULL;
+		}
+		memcpy (result->data, cache->data, sizeof (cairo_path_data_t) * cache->num_data);
+	} else {
+		result->data = NULL;
+	}
+	return result;
+}
+
+static void
+gdip_region_index_invalidate (GpRegion *region)
+{
+	if (region->index) {
+		gdip_region_index_free (region->index);
+		region->index = NULL;
+	}
+}
+
+/* drop everything computed from the current shape of the region */
+static void
+gdip_region_invalidate_caches (GpRegion *region)
+{
+	gdip_region_clip_cache_invalidate (region);
+	gdip_region_index_invalidate (region);
+}
+
 void 
 gdip_clear_region (GpRegion *region)
 {
@@ -296,6 +367,7 @@ gdip_clear_region (GpRegion *region)
 		region->bitmap = NULL;
 	}
 
+	gdip_region_invalidate_caches (region);
 	region->cnt = 0;
 }
 
@@ -325,6 +397,16 @@ gdip_copy_region (GpRegion *source, GpRegion *dest)
 	} else {
 		dest->bitmap = NULL;
 	}
+
+	/* keep the cairo clip, it's still valid for an identical region (e.g. graphics save/restore) */
+	if (source->clip_cache) {
+		dest->clip_cache = gdip_region_clip_cache_clone (source->clip_cache);
+	} else {
+		dest->clip_cache = NULL;
+	}
+
+	/* the index is cheap to rebuild, if ever needed, from the copied rectangles */
+	dest->index = NULL;
 }
 
 /* convert a rectangle-based region to a path based region */
@@ -353,6 +435,313 @@ gdip_region_convert_to_path (GpRegion *region)
 	}
 }
 
+/*
+ * Scale and translate the rectangles of a rectangle-based region. Without any
+ * rotation or shearing in @matrix the result is still a set of rectangles.
+ * Return FALSE (without changing the region) if this isn't the case.
+ */
+static BOOL
+gdip_region_transform_rects (GpRegion *region, GpMatrix *matrix)
+{
+	int i;
+	GpRectF *rect;
+
+	if ((matrix->xy != 0.0f) || (matrix->yx != 0.0f))
+		return FALSE;
+
+	for (i = 0, rect = region->rects; i < region->cnt; i++, rect++) {
+		rect->X = rect->X * matrix->xx + matrix->x0;
+		rect->Y = rect->Y * matrix->yy + matrix->y0;
+		rect->Width *= matrix->xx;
+		rect->Height *= matrix->yy;
+
+		/* a negative scale factor mirrors the rectangle */
+		if (rect->Width < 0) {
+			rect->X += rect->Width;
+			rect->Width = -rect->Width;
+		}
+		if (rect->Height < 0) {
+			rect->Y += rect->Height;
+			rect->Height = -rect->Height;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Extract the rectangles of a path made only of closed, axis-aligned,
+ * rectangles (e.g. from GdipAddPathRectangle). Empty rectangles are ignored.
+ * Return FALSE if the path contains anything else, or if its fill mode 
+ * could make it different from the union (winding) or the xor (alternate)
+ * of its rectangles.
+ */
+static BOOL
+gdip_region_get_path_rects (GpPath *path, GpRectF **rects, int *count)
+{
+	GpPointF *points = (GpPointF*) path->points->data;
+	BYTE *types = path->types->data;
+	GpRectF *array = NULL;
+	int i, n = 0, orientation = 0;
+
+	if ((path->count == 0) || (path->count % 4 != 0))
+		return FALSE;
+
+	for (i = 0; i < path->count; i += 4) {
+		GpPointF *p = &points [i];
+		float area;
+
+		if (((types [i] & PathPointTypePathTypeMask) != PathPointTypeStart) ||
+			((types [i + 1] & PathPointTypePathTypeMask) != PathPointTypeLine) ||
+			((types [i + 2] & PathPointTypePathTypeMask) != PathPointTypeLine) ||
+			((types [i + 3] & PathPointTypePathTypeMask) != PathPointTypeLine) ||
+			!(types [i + 3] & PathPointTypeCloseSubpath)) {
+			break;
+		}
+
+		/* horizontal then vertical edges, or vertical then horizontal edges */
+		if (!(((p[0].Y == p[1].Y) && (p[1].X == p[2].X) && (p[2].Y == p[3].Y) && (p[3].X == p[0].X)) ||
+			((p[0].X == p[1].X) && (p[1].Y == p[2].Y) && (p[2].X == p[3].X) && (p[3].Y == p[0].Y)))) {
+			break;
+		}
+
+		/* with the winding rule overlapping rectangles must turn the same way */
+		area = (p[2].X - p[0].X) * (p[3].Y - p[1].Y) - (p[3].X - p[1].X) * (p[2].Y - p[0].Y);
+		if (area == 0)
+			continue;
+		if (path->fill_mode == FillModeWinding) {
+			int sign = (area > 0) ? 1 : -1;
+			if (orientation == 0)
+				orientation = sign;
+			else if (orientation != sign)
+				break;
+		}
+
+		if (!array) {
+			array = (GpRectF*) GdipAlloc (sizeof (GpRectF) * (path->count / 4));
+			if (!array)
+				return FALSE;
+		}
+		array [n].X = MIN (p[0].X, p[2].X);
+		array [n].Y = MIN (p[0].Y, p[2].Y);
+		array [n].Width = fabs (p[2].X - p[0].X);
+		array [n].Height = fabs (p[2].Y - p[0].Y);
+		n++;
+	}
+
+	if (i < path->count) {
+		if (array)
+			GdipFree (array);
+		return FALSE;
+	}
+
+	*rects = array;
+	*count = n;
+	return TRUE;
+}
+
+/*
+ * Return a new rectangle-based region covering the shape of a path made only
+ * of rectangles, or NULL if the path contains anything else.
+ */
+static GpRegion*
+gdip_region_from_path_rects (GpPath *path)
+{
+	GpRegion *result = NULL;
+	GpRectF *rects;
+	int i, count;
+
+	if (!gdip_region_get_path_rects (path, &rects, &count))
+		return NULL;
+
+	if (GdipCreateRegion (&result) == Ok) {
+		GdipSetEmpty (result);
+		for (i = 0; i < count; i++) {
+			if (GdipCombineRegionRect (result, &rects [i], 
+				(path->fill_mode == FillModeWinding) ? CombineModeUnion : CombineModeXor) != Ok) {
+				GdipDeleteRegion (result);
+				result = NULL;
+				break;
+			}
+		}
+	}
+
+	if (rects)
+		GdipFree (rects);
+	return result;
+}
+
+/*
+ * Combine a rectangle-based region with a path made of rectangles without
+ * converting the region into a path (and a bitmap).
+ */
+static GpStatus
+gdip_combine_rects_path (GpRegion *region, GpPath *path, CombineMode combineMode, BOOL *done)
+{
+	GpRegion *work;
+	GpRectF *rects;
+	GpStatus status;
+	int count;
+
+	*done = FALSE;
+	if (!gdip_region_get_path_rects (path, &rects, &count))
+		return Ok;
+
+	if (count == 1) {
+		status = GdipCombineRegionRect (region, rects, combineMode);
+	} else {
+		/* the (visible) path shape, as rectangles */
+		work = gdip_region_from_path_rects (path);
+		if (work) {
+			status = GdipCombineRegionRegion (region, work, combineMode);
+			GdipDeleteRegion (work);
+		} else {
+			status = OutOfMemory;
+		}
+	}
+
+	if (rects)
+		GdipFree (rects);
+	*done = TRUE;
+	return status;
+}
+
+/* a path holding all the rectangles of a rectangle-based region */
+static GpPath*
+gdip_region_rects_to_path (GpRegion *region)
+{
+	GpPath *path;
+	GpRectF *rect;
+	int i;
+
+	if (GdipCreatePath (FillModeAlternate, &path) != Ok)
+		return NULL;
+
+	for (i = 0, rect = region->rects; i < region->cnt; i++, rect++) {
+		GdipAddPathRectangle (path, rect->X, rect->Y, rect->Width, rect->Height);
+	}
+	return path;
+}
+
+/* replace a (rectangle-only) branch of a tree by a single path of its rectangles */
+static void
+gdip_region_fold_branch (GpPathTree *branch, GpRegion *rects)
+{
+	GpPath *path;
+
+	if (!rects)
+		return;
+
+	/* a single path can't be simplified */
+	if (!branch->path) {
+		path = gdip_region_rects_to_path (rects);
+		if (path) {
+			gdip_region_clear_tree (branch);
+			branch->path = path;
+			branch->branch1 = NULL;
+			branch->branch2 = NULL;
+		}
+	}
+	GdipDeleteRegion (rects);
+}
+
+/*
+ * Fold the rectangle-only parts of a path tree. If the whole @tree is made of
+ * rectangles a new rectangle-based region is returned (and the tree is left
+ * untouched). Otherwise every rectangle-only subtree of @tree is replaced by a
+ * single path of its (banded) rectangles and NULL is returned.
+ */
+static GpRegion*
+gdip_region_fold_tree (GpPathTree *tree)
+{
+	GpRegion *rects1, *rects2;
+
+	if (tree->path)
+		return gdip_region_from_path_rects (tree->path);
+
+	rects1 = gdip_region_fold_tree (tree->branch1);
+	rects2 = gdip_region_fold_tree (tree->branch2);
+	if (rects1 && rects2) {
+		GpStatus status = GdipCombineRegionRegion (rects1, rects2, tree->mode);
+		GdipDeleteRegion (rects2);
+		if (status == Ok)
+			return rects1;
+		GdipDeleteRegion (rects1);
+		return NULL;
+	}
+
+	gdip_region_fold_branch (tree->branch1, rects1);
+	gdip_region_fold_branch (tree->branch2, rects2);
+	return NULL;
+}
+
+/* turn a region made of a single path of rectangles back into a rectangle-based region */
+static void
+gdip_region_fold (GpRegion *region)
+{
+	GpRegion *rects;
+
+	if ((region->type != RegionTypePath) || !region->tree || !region->tree->path)
+		return;
+
+	rects = gdip_region_from_path_rects (region->tree->path);
+	if (rects) {
+		gdip_clear_region (region);
+		gdip_copy_region (rects, region);
+		GdipDeleteRegion (rects);
+	}
+}
+
+/*
+ * ((a op r1) op r2) is identical to (a op (r1 op' r2)) for union, intersection,
+ * xor and exclusion. When both r1 (the last operand of the tree) and r2 are 
+ * made of rectangles we combine them, as rectangles, instead of adding a new
+ * level to the tree. Return TRUE if @path was merged into @tree.
+ */
+static BOOL
+gdip_region_merge_operand (GpPathTree *tree, GpPath *path, CombineMode combineMode)
+{
+	GpRegion *rects1, *rects2;
+	CombineMode mode;
+	GpPath *merged;
+	GpStatus status;
+
+	if (tree->path || (tree->mode != combineMode) || !tree->branch2->path)
+		return FALSE;
+
+	switch (combineMode) {
+	case CombineModeUnion:
+	case CombineModeExclude:
+		mode = CombineModeUnion;
+		break;
+	case CombineModeIntersect:
+	case CombineModeXor:
+		mode = combineMode;
+		break;
+	default:
+		return FALSE;
+	}
+
+	rects2 = gdip_region_from_path_rects (path);
+	if (!rects2)
+		return FALSE;
+	rects1 = gdip_region_from_path_rects (tree->branch2->path);
+	if (!rects1) {
+		GdipDeleteRegion (rects2);
+		return FALSE;
+	}
+
+	status = GdipCombineRegionRegion (rects1, rects2, mode);
+	merged = (status == Ok) ? gdip_region_rects_to_path (rects1) : NULL;
+	GdipDeleteRegion (rects1);
+	GdipDeleteRegion (rects2);
+	if (!merged)
+		return FALSE;
+
+	GdipDeletePath (tree->branch2->path);
+	tree->branch2->path = merged;
+	return TRUE;
+}
+
 /*
  * Create a region (path-tree) from a path.
  */
@@ -376,6 +765,9 @@ gdip_createRegion (GpRegion **region, RegionType type, void *src)
         result->rects = NULL;
         result->tree = NULL;
         result->bitmap = NULL;
+	result->clip_cache = NULL;
+	result->index = NULL;
+	result->ref_count = 1;
 
         switch (type) {
         case RegionTypeRect:
@@ -453,6 +845,9 @@ GdipCreateRegionRgnData (GDIPCONST BYTE *regionData, int size, GpRegion **region
         result->rects = NULL;
 	result->tree = NULL;
         result->bitmap = NULL;
+	result->clip_cache = NULL;
+	result->index = NULL;
+	result->ref_count = 1;
 
 	switch (result->type) {
 	case RegionTypeRectF: {
@@ -506,10 +901,45 @@ GdipCloneRegion (GpRegion *region, GpRegion **cloneRegion)
 		return OutOfMemory;
 
 	gdip_copy_region (region, result);
+	result->ref_count = 1;
 	*cloneRegion = result;
         return Ok;
 }
 
+/*
+ * Regions can be shared internally (e.g. between a graphics clip and its saved
+ * states). Each owner must call GdipDeleteRegion once it's done with it.
+ */
+GpRegion*
+gdip_region_ref (GpRegion *region)
+{
+	if (region)
+		region->ref_count++;
+	return region;
+}
+
+/* copy-on-write: replace a shared region with a private copy before changing it */
+GpStatus
+gdip_region_make_writable (GpRegion **region)
+{
+	GpRegion *copy;
+	GpStatus status;
+
+	if (!region || !*region)
+		return InvalidParameter;
+
+	if ((*region)->ref_count == 1)
+		return Ok;
+
+	status = GdipCloneRegion (*region, &copy);
+	if (status != Ok)
+		return status;
+
+	(*region)->ref_count--;
+	*region = copy;
+	return Ok;
+}
+
 
 GpStatus
 GdipDeleteRegion (GpRegion *region)
@@ -517,6 +947,10 @@ GdipDeleteRegion (GpRegion *region)
         if (!region)
                 return InvalidParameter;
 
+	/* still used elsewhere */
+	if (--region->ref_count > 0)
+		return Ok;
+
 	gdip_clear_region (region);
         GdipFree (region);
 
@@ -977,6 +1411,8 @@ GdipCombineRegionRect (GpRegion *region, GDIPCONST GpRectF *rect, CombineMode co
         if (!region || !rect)
                 return InvalidParameter;
 
+	gdip_region_invalidate_caches (region);
+
 	/* allow the current region to "revert" to a simple RegionTypeRect if possible */
 	if (combineMode == CombineModeReplace)
 		GdipSetEmpty (region);
@@ -1081,14 +1517,94 @@ gdip_combine_exclude_from_infinite (GpRegion *region, GpPath *path)
 	return TRUE;
 }
 
+/*
+ * gdip_path_area_bounds:
+ *
+ * Set @bounds to the exact bounds of @path. Return FALSE if the path can't
+ * enclose any area (no points, or all of them on a line).
+ */
+static BOOL
+gdip_path_area_bounds (GpPath *path, GpRectF *bounds)
+{
+	if (GdipGetPathWorldBounds (path, bounds, NULL, NULL) != Ok)
+		return FALSE;
+	return (path->count > 0) && (bounds->Width > 0) && (bounds->Height > 0);
+}
+
+/*
+ * gdip_tree_area_bounds:
+ *
+ * Set @bounds to the union of the exact bounds of the paths in @tree, which
+ * contains whatever the tree operations produce. Return FALSE if none of the
+ * paths encloses any area.
+ */
+static BOOL
+gdip_tree_area_bounds (GpPathTree *tree, GpRectF *bounds)
+{
+	GpRectF b1, b2;
+	BOOL a1, a2;
+
+	if (!tree)
+		return FALSE;
+	if (tree->path)
+		return gdip_path_area_bounds (tree->path, bounds);
+
+	a1 = gdip_tree_area_bounds (tree->branch1, &b1);
+	a2 = gdip_tree_area_bounds (tree->branch2, &b2);
+	if (a1 && a2) {
+		float right = max (b1.X + b1.Width, b2.X + b2.Width);
+		float bottom = max (b1.Y + b1.Height, b2.Y + b2.Height);
+
+		bounds->X = min (b1.X, b2.X);
+		bounds->Y = min (b1.Y, b2.Y);
+		bounds->Width = right - bounds->X;
+		bounds->Height = bottom - bounds->Y;
+	} else if (a1) {
+		*bounds = b1;
+	} else if (a2) {
+		*bounds = b2;
+	}
+	return a1 || a2;
+}
+
+/*
+ * gdip_region_combine_is_noop:
+ *
+ * Return TRUE if combining a shape, with the exact @shape bounds, into the
+ * path-based @region can't change it. Only the exact geometry is used, never
+ * the bitmap, so nothing is lost if the region is later scaled.
+ */
+static BOOL
+gdip_region_combine_is_noop (GpRegion *region, BOOL has_area, GpRectF *shape, CombineMode combineMode)
+{
+	GpRectF bounds;
+
+	switch (combineMode) {
+	case CombineModeUnion:
+	case CombineModeXor:
+		return !has_area;
+	case CombineModeExclude:
+		if (!has_area || !gdip_tree_area_bounds (region->tree, &bounds))
+			return TRUE;
+		return ((shape->X >= bounds.X + bounds.Width) || (shape->X + shape->Width <= bounds.X) ||
+			(shape->Y >= bounds.Y + bounds.Height) || (shape->Y + shape->Height <= bounds.Y));
+	default:
+		return FALSE;
+	}
+}
+
 GpStatus
 GdipCombineRegionPath (GpRegion *region, GpPath *path, CombineMode combineMode)
 {
 	GpRegionBitmap *path_bitmap, *result;
+	GpRectF shape;
+	BOOL has_area;
 
 	if (!region || !path)
 		return InvalidParameter;
 
+	gdip_region_invalidate_caches (region);
+
 	/* special case #1 - replace */
 	if (combineMode == CombineModeReplace) {
 		gdip_clear_region (region);
@@ -1147,8 +1663,23 @@ GdipCombineRegionPath (GpRegion *region, GpPath *path, CombineMode combineMode)
 		}
 	}
 
-	if (region->type == RegionTypeRectF)
+	/* a single path of rectangles is better handled as a rectangle-based region */
+	gdip_region_fold (region);
+
+	if (region->type == RegionTypeRectF) {
+		/* keep the region rectangular if the path is only made of rectangles */
+		BOOL done;
+		GpStatus status = gdip_combine_rects_path (region, path, combineMode, &done);
+		if (done)
+			return status;
+
 		gdip_region_convert_to_path (region);
+	}
+
+	/* nothing to add (to the tree) if the path can't change the region */
+	has_area = gdip_path_area_bounds (path, &shape);
+	if (gdip_region_combine_is_noop (region, has_area, &shape, combineMode))
+		return Ok;
 
 	/* make sure the region's bitmap is available */
 	gdip_region_bitmap_ensure (region);
@@ -1156,6 +1687,8 @@ GdipCombineRegionPath (GpRegion *region, GpPath *path, CombineMode combineMode)
 
 	/* create a bitmap for the path to combine into the region */
 	path_bitmap = gdip_region_bitmap_from_path (path);
+	if (!path_bitmap)
+		return OutOfMemory;
 
 	result = gdip_region_bitmap_combine (region->bitmap, path_bitmap, combineMode);
 	gdip_region_bitmap_free (path_bitmap);
@@ -1165,6 +1698,10 @@ GdipCombineRegionPath (GpRegion *region, GpPath *path, CombineMode combineMode)
 	gdip_region_bitmap_free (region->bitmap);
 	region->bitmap = result;
 
+	/* merge rectangles into the last operand instead of growing the tree */
+	if (gdip_region_merge_operand (region->tree, path, combineMode))
+		return Ok;
+
 	/* add a copy of path into region1 tree */
 	if (region->tree->path) {
 		/* move the existing path into a new tree (branch1) ... */
@@ -1191,6 +1728,13 @@ gdip_combine_pathbased_region (GpRegion *region1, GpRegion *region2, CombineMode
 {
 	GpRegionBitmap *result;
 	GpPathTree* tmp;
+	GpRectF shape;
+	BOOL has_area;
+
+	/* nothing to add (to the tree) if region2 can't change region1 */
+	has_area = gdip_tree_area_bounds (region2->tree, &shape);
+	if (gdip_region_combine_is_noop (region1, has_area, &shape, combineMode))
+		return Ok;
 
 	/* if not available, construct the bitmaps for both regions */
 	gdip_region_bitmap_ensure (region1);
@@ -1201,6 +1745,7 @@ gdip_combine_pathbased_region (GpRegion *region1, GpRegion *region2, CombineMode
 	result = gdip_region_bitmap_combine (region1->bitmap, region2->bitmap, combineMode);
 	if (!result)
 		return NotImplemented;
+
 	gdip_region_bitmap_free (region1->bitmap);
 	region1->bitmap = result;
 
@@ -1224,7 +1769,12 @@ gdip_combine_pathbased_region (GpRegion *region1, GpRegion *region2, CombineMode
 	if (region2->tree->path) {
 		GdipClonePath (region2->tree->path, &region1->tree->branch2->path);
 	} else {
+		GpRegion *rects;
+
 		gdip_region_copy_tree (region2->tree, region1->tree->branch2);
+		/* and keep its rectangle-only parts as simple as possible */
+		rects = gdip_region_fold_tree (region1->tree->branch2);
+		gdip_region_fold_branch (region1->tree->branch2, rects);
 	}
 	return Ok;
 }
@@ -1236,6 +1786,8 @@ GdipCombineRegionRegion (GpRegion *region,  GpRegion *region2, CombineMode combi
         if (!region || !region2)
                 return InvalidParameter;
 
+	gdip_region_invalidate_caches (region);
+
 	/* special case to deal with copying empty and infinity regions */
 	/* CombineModeReplace is used by Graphics clipping */
 	if (combineMode == CombineModeReplace) {
@@ -1287,10 +1839,20 @@ GdipCombineRegionRegion (GpRegion *region,  GpRegion *region2, CombineMode combi
 		}
 	}
 
+	/* a single path of rectangles is better handled as a rectangle-based region */
+	gdip_region_fold (region);
+
 	if (region->type == RegionTypePath) {
 		gdip_region_convert_to_path (region2);
 		return gdip_combine_pathbased_region (region, region2, combineMode);
 	} else if (region2->type == RegionTypePath) {
+		/* a single path of rectangles doesn't require a path-based region */
+		if (region2->tree && region2->tree->path) {
+			BOOL done;
+			GpStatus status = gdip_combine_rects_path (region, region2->tree->path, combineMode, &done);
+			if (done)
+				return status;
+		}
 		gdip_region_convert_to_path (region);
 		return gdip_combine_pathbased_region (region, region2, combineMode);
 	}
@@ -1372,6 +1934,15 @@ GdipIsInfiniteRegion (GpRegion *region, GpGraphics *graphics, BOOL *result)
 }
 
 
+/* regions with many rectangles get a (lazily built) index to speed up hit testing */
+static GpRegionIndex*
+gdip_region_get_index (GpRegion *region)
+{
+	if (!region->index && (region->cnt >= REGION_INDEX_MIN_RECTS))
+		region->index = gdip_region_index_create (region->rects, region->cnt);
+	return region->index;
+}
+
 GpStatus
 GdipIsVisibleRegionPoint (GpRegion *region, float x, float y, GpGraphics *graphics, BOOL *result)
 {
@@ -1384,7 +1955,11 @@ GdipIsVisibleRegionPoint (GpRegion *region, float x, float y, GpGraphics *graphi
 
 		*result = gdip_region_bitmap_is_point_visible (region->bitmap, x, y);
 	} else {
-		*result = gdip_is_Point_in_RectFs_Visible (x, y, region->rects, region->cnt);
+		GpRegionIndex *index = gdip_region_get_index (region);
+		if (index)
+			*result = gdip_region_index_is_point_visible (index, x, y);
+		else
+			*result = gdip_is_Point_in_RectFs_Visible (x, y, region->rects, region->cnt);
 	}
 
         return Ok;
@@ -1424,7 +1999,7 @@ GdipIsVisibleRegionRect (GpRegion *region, float x, float y, float width, float
 
 		found = gdip_region_bitmap_is_rect_visible (region->bitmap, &rect);
 	} else {
-		float posy, posx;
+		GpRegionIndex *index;
 		GpRectF recthit;
 
 		recthit.X = x;
@@ -1432,14 +2007,13 @@ GdipIsVisibleRegionRect (GpRegion *region, float x, float y, float width, float
 		recthit.Width = width;
 		recthit.Height = height;
 
-		/* Any point of intersection ?*/
-		for (posy = 0; posy < recthit.Height && found == FALSE; posy++) {
-			for (posx = 0; posx < recthit.Width ; posx++) {
-				if (gdip_is_Point_in_RectFs_Visible (recthit.X + posx , recthit.Y + posy, region->rects, region->cnt) == TRUE) {
-					found = TRUE;
-					break;
-				}
-			}
+		/* a non-normalized rectangle doesn't cover any point */
+		if ((width < 0) || (height < 0)) {
+			found = FALSE;
+		} else if ((index = gdip_region_get_index (region))) {
+			found = gdip_region_index_is_rect_visible (index, &recthit);
+		} else {
+			found = gdip_is_RectF_in_RectFs_Visible (&recthit, region->rects, region->cnt);
 		}
 	}
 
@@ -1476,18 +2050,22 @@ GdipGetRegionScansCount (GpRegion *region, int* count, GpMatrix* matrix)
 			return status;
 		}
 
-		/* if required convert into a path-based region */
-		if (work->type != RegionTypePath)
-			gdip_region_convert_to_path (work);
+		if ((work->type == RegionTypeRectF) && gdip_region_transform_rects (work, matrix)) {
+			/* rectangles are still rectangles after a scale and/or translation */
+		} else {
+			/* if required convert into a path-based region */
+			if (work->type != RegionTypePath)
+				gdip_region_convert_to_path (work);
 
-		/* transform all the paths */
-		status = gdip_region_transform_tree (work->tree, matrix);
-		if (status != Ok) {
-			GdipDeleteRegion (work);
-			return status;
+			/* transform all the paths */
+			status = gdip_region_transform_tree (work->tree, matrix);
+			if (status != Ok) {
+				GdipDeleteRegion (work);
+				return status;
+			}
+			/* note: any existing bitmap has been invalidated */
+			gdip_region_bitmap_invalidate (work);
 		}
-		/* note: any existing bitmap has been invalidated */
-		gdip_region_bitmap_invalidate (work);
 	} else {
 		work = region;
 	}
@@ -1532,23 +2110,27 @@ GdipGetRegionScans (GpRegion *region, GpRectF* rects, int* count, GpMatrix* matr
 			return status;
 		}
 
-		/* if required convert into a path-based region */
-		if (work->type != RegionTypePath)
-			gdip_region_convert_to_path (work);
+		if ((work->type == RegionTypeRectF) && gdip_region_transform_rects (work, matrix)) {
+			/* rectangles are still rectangles after a scale and/or translation */
+		} else {
+			/* if required convert into a path-based region */
+			if (work->type != RegionTypePath)
+				gdip_region_convert_to_path (work);
 
-		/* transform all the paths */
-		status = gdip_region_transform_tree (work->tree, matrix);
-		if (status != Ok) {
-			GdipDeleteRegion (work);
-			return status;
+			/* transform all the paths */
+			status = gdip_region_transform_tree (work->tree, matrix);
+			if (status != Ok) {
+				GdipDeleteRegion (work);
+				return status;
+			}
+			/* note: any existing bitmap has been invalidated */
+			gdip_region_bitmap_invalidate (work);
 		}
-		/* note: any existing bitmap has been invalidated */
-		gdip_region_bitmap_invalidate (work);
 	} else {
 		work = region;
 	}
 
-	if (region->type == RegionTypePath) {
+	if (work->type == RegionTypePath) {
 		/* ensure the bitmap is usable */
 		gdip_region_bitmap_ensure (work);
 
@@ -1632,13 +2214,13 @@ GdipTranslateRegion (GpRegion *region, float dx, float dy)
 	if (gdip_is_InfiniteRegion (region))
 		return Ok;
 
+	gdip_region_invalidate_caches (region);
+
 	if (region->type == RegionTypePath) {
 		gdip_region_translate_tree (region->tree, dx, dy);
-		/* any existing bitmap is still valid _if_ we update it's origin */
-		if (region->bitmap) {
-			region->bitmap->X += dx;
-			region->bitmap->Y += dy;
-		}
+		/* any existing bitmap is still valid _if_ we can move it by whole pixels */
+		if (region->bitmap && !gdip_region_bitmap_translate (region->bitmap, dx, dy))
+			gdip_region_bitmap_invalidate (region);
 	} else if ((region->type == RegionTypeRectF) && region->rects) {
 	        int i;
 	        GpRectF *rect;
@@ -1657,27 +2239,6 @@ GdipTranslateRegionI (GpRegion *region, int dx, int dy)
         return GdipTranslateRegion (region, dx, dy);
 }
 
-/* this call doesn't exists in GDI+ */
-static GpStatus
-ScaleRegion (GpRegion *region, float sx, float sy)
-{
-	if (!region)
-		return InvalidParameter;
-
-	if ((region->type == RegionTypeRectF) && region->rects) {
-	        int i;
-	        GpRectF *rect;
-                for (i = 0, rect = region->rects ; i < region->cnt; i++, rect++) {
-                        rect->X *= sx;
-                        rect->Y *= sy;
-                        rect->Width *= sx;
-                        rect->Height *= sy;
-                }
-        }
-
-        return Ok;
-}
-
 GpStatus
 GdipTransformRegion (GpRegion *region, GpMatrix *matrix)
 {
@@ -1700,29 +2261,20 @@ GdipTransformRegion (GpRegion *region, GpMatrix *matrix)
 	if (gdip_is_InfiniteRegion (region))
 		return Ok;
 
+	gdip_region_invalidate_caches (region);
+
 	/* try to avoid heavy stuff (e.g. conversion to path, invalidating 
 	 * bitmap...) if the transform is:
-	 * - a translation + scale operations (for rectangle ebased region)
-	 * - only to do a scale operation (for a rectangle based region)
+	 * - any combination of scale and translation (for a rectangle based region)
 	 * - only to do a simple translation (for both rectangular and bitmap based regions)
 	 */
-	if ((matrix->xy == 0.0f) && (matrix->yx == 0.0f)) {
-		BOOL s = (((matrix->xx != 1.0f) || (matrix->yy != 1.0f)) && (region->type == RegionTypeRectF));
-		BOOL t = ((matrix->x0 != 0.0f) || (matrix->yx != 0.0f));
-		if (s) {
-			status = ScaleRegion (region, 
-				gdip_matrix_get_x_scale (matrix), 
-				gdip_matrix_get_y_scale (matrix));
-		}
-		if (t && (status == Ok)) {
-			status = GdipTranslateRegion (region, 
-				gdip_matrix_get_x_translation (matrix), 
-				gdip_matrix_get_y_translation (matrix));
-		}
+	if ((region->type == RegionTypeRectF) && gdip_region_transform_rects (region, matrix))
+		return Ok;
 
-		/* return now if we could optimize the transform (to avoid bitmaps) */
-		if (t || s)
-			return status;
+	if (gdip_is_matrix_a_translation (matrix)) {
+		return GdipTranslateRegion (region, 
+			gdip_matrix_get_x_translation (matrix), 
+			gdip_matrix_get_y_translation (matrix));
 	}
 
 	/* most matrix operations would change the rectangles into path so we always preempt this */
@@ -48,17 +48,27 @@
 #define STRING_DETAIL_LINESTART		(1<<5)
 
 #define text_DrawString			cairo_DrawString
+#define text_DrawStrings		cairo_DrawStrings
 #define text_MeasureString		cairo_MeasureString
 #define text_MeasureCharacterRanges	cairo_MeasureCharacterRanges
 
+/* glyphs of the strings of a batch, shown together until something else is drawn */
+typedef struct {
+	cairo_glyph_t	*glyphs;
+	int		count;
+	int		size;
+} GpGlyphBatch;
+
 /* cache for computed information during MeasureString that can be reused during DrawString */
 typedef struct {
-	BOOL	has_hotkeys;
-	int	align_horz;
-	int	align_vert;
-	int	line_height;
-	int	max_y;
-	int	descent;
+	BOOL		has_hotkeys;
+	int		align_horz;
+	int		align_vert;
+	int		line_height;
+	int		max_y;
+	int		descent;
+	BOOL		setup_done;	/* the font and brush were set by the caller */
+	GpGlyphBatch	*batch;		/* NULL to show the glyphs of each line at once */
 } GpDrawTextData;
 
 typedef struct {
@@ -73,6 +83,9 @@ typedef struct {
 GpStatus cairo_DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font, 
 	GDIPCONST RectF *rc, GDIPCONST GpStringFormat *format, GpBrush *brush) GDIP_INTERNAL;
 
+GpStatus cairo_DrawStrings (GpGraphics *graphics, GDIPCONST WCHAR **strings, GDIPCONST int *lengths, int count,
+	GDIPCONST GpFont *font, GDIPCONST RectF *rects, GDIPCONST GpStringFormat *format, GpBrush *brush) GDIP_INTERNAL;
+
 GpStatus cairo_MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font,
 	GDIPCONST RectF *rc, GDIPCONST GpStringFormat *format,  RectF *boundingBox, int *codepointsFitted, int *linesFilled)
 	GDIP_INTERNAL;
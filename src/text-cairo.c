@@ -34,6 +34,9 @@
 #include "graphics-cairo-private.h"
 #include "brush-private.h"
 #include "font-private.h"
+#include "glyph-cache.h"
+#include "text-layout-cache.h"
+#include "linebreak.h"
 
 /*
  * NOTE: all parameter's validations are done inside text.c
@@ -47,10 +50,24 @@ CalculateStringWidths (cairo_t *ct, GDIPCONST GpFont *gdiFont, GDIPCONST gunicha
 	size_t			i;
 	cairo_text_extents_t	ext;
 	GpStringDetailStruct	*CurrentDetail;
+	GpGlyphAdvances		*advances;
 	BYTE utf8[5];
 
 	CurrentDetail = StringDetails;
 
+	/* the advances are cached for the font, size, transform and font options */
+	gdip_glyph_cache_lock ();
+	advances = gdip_glyph_cache_get_advances (ct, (GpFont*) gdiFont);
+	if (advances) {
+		for (i = 0; i < StringDetailElements; i++) {
+			CurrentDetail->Width = gdip_glyph_advances_get (advances, ct, *(stringUnicode + i));
+			CurrentDetail++;
+		}
+		gdip_glyph_cache_unlock ();
+		return StringDetailElements;
+	}
+	gdip_glyph_cache_unlock ();
+
 	for (i = 0; i < StringDetailElements; i++) {
 		utf8[utf8_encode_ucs2char(*(stringUnicode + i), utf8)] = '\0';
 		cairo_text_extents(ct, (const char *) utf8, &ext);
@@ -111,6 +128,141 @@ CalculateStringWidthsUTF8 (cairo_t *ct, GDIPCONST GpFont *gdiFont, const BYTE *u
 }
 #endif
 
+/* everything a layout depends on, in the key before the tab stops, the string and the face name */
+typedef struct {
+	int		length;
+	int		style;
+	float		size;
+	float		width;
+	float		height;
+	int		flags;
+	int		alignment;
+	int		line_alignment;
+	int		trimming;
+	int		hotkey_prefix;
+	float		first_tab_offset;
+	int		tab_count;
+	int		text_mode;
+	double		xx;		/* device transform, the advances are hinted */
+	double		yx;
+	double		xy;
+	double		yy;
+	int		face_length;
+} LayoutKeyHeader;
+
+static BYTE*
+LayoutCacheKey (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font,
+	GDIPCONST RectF *rc, GDIPCONST GpStringFormat *format, float FontSize, int *size)
+{
+	LayoutKeyHeader	header;
+	cairo_matrix_t	ctm;
+	int		tabs = (format->tabStops && (format->numtabStops > 0)) ? format->numtabStops : 0;
+	BYTE		*key, *p;
+
+	/* the padding is part of the key too */
+	memset (&header, 0, sizeof (header));
+	header.length = length;
+	header.style = font->style;
+	header.size = FontSize;
+	header.width = rc->Width;
+	header.height = rc->Height;
+	header.flags = format->formatFlags;
+	header.alignment = format->alignment;
+	header.line_alignment = format->lineAlignment;
+	header.trimming = format->trimming;
+	header.hotkey_prefix = format->hotkeyPrefix;
+	header.first_tab_offset = format->firstTabOffset;
+	header.tab_count = tabs;
+	header.text_mode = graphics->text_mode;
+	cairo_get_matrix (graphics->ct, &ctm);
+	header.xx = ctm.xx;
+	header.yx = ctm.yx;
+	header.xy = ctm.xy;
+	header.yy = ctm.yy;
+	header.face_length = strlen ((const char *) font->face);
+
+	*size = sizeof (header) + tabs * sizeof (float) + length * sizeof (WCHAR) + header.face_length;
+	key = (BYTE*) GdipAlloc (*size);
+	if (!key)
+		return NULL;
+
+	p = key;
+	memcpy (p, &header, sizeof (header));
+	p += sizeof (header);
+	memcpy (p, format->tabStops, tabs * sizeof (float));
+	p += tabs * sizeof (float);
+	memcpy (p, stringUnicode, length * sizeof (WCHAR));
+	p += length * sizeof (WCHAR);
+	memcpy (p, font->face, header.face_length);
+	return key;
+}
+
+/* the layout was measured with a hotkey if one of the characters is marked so */
+static BOOL
+LayoutHasHotkeys (GpStringDetailStruct *StringDetails, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (StringDetails [i].Flags & STRING_DETAIL_HOTKEY)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* select the font, with the antialiasing of the text rendering hint */
+static void
+SetupFont (GpGraphics *graphics, GDIPCONST GpFont *font, float FontSize)
+{
+	cairo_font_options_t	*FontOptions;
+
+	/*
+	  Set aliasing mode
+	*/
+	FontOptions = cairo_font_options_create();
+	
+	switch(graphics->text_mode) {
+		default:
+		case TextRenderingHintSystemDefault: {
+			cairo_font_options_set_antialias(FontOptions, CAIRO_ANTIALIAS_DEFAULT);
+			//cairo_font_options_set_hint_style(FontOptions, CAIRO_HINT_STYLE_NONE);
+			//cairo_font_options_set_subpixel_order(FontOptions, CAIRO_SUBPIXEL_ORDER_DEFAULT);
+			//cairo_font_options_set_hint_style(FontOptions, CAIRO_HINT_STYLE_DEFAULT);
+			//cairo_font_options_set_hint_metrics(FontOptions, CAIRO_HINT_METRICS_DEFAULT);
+			break;
+		}
+
+		// FIXME - pick matching settings for each text mode
+    		case TextRenderingHintSingleBitPerPixelGridFit:
+    		case TextRenderingHintSingleBitPerPixel:
+    		case TextRenderingHintAntiAliasGridFit:
+    		case TextRenderingHintAntiAlias: {
+			cairo_font_options_set_antialias(FontOptions, CAIRO_ANTIALIAS_DEFAULT);
+			break;
+		}
+
+    		case TextRenderingHintClearTypeGridFit: {
+			cairo_font_options_set_antialias(FontOptions, CAIRO_ANTIALIAS_DEFAULT);
+			break;
+		}
+	}
+
+	cairo_set_font_options(graphics->ct, FontOptions);
+	cairo_font_options_destroy(FontOptions);
+
+	// Do we want this here?
+
+/* Commented out until we properly save/restore AA settings; should fix bug #76135
+	cairo_set_antialias(graphics->ct, CAIRO_ANTIALIAS_NONE);
+*/
+
+	/*
+	   Get font size information; how expensive is the cairo stuff here? 
+	*/	
+	cairo_set_font_face (graphics->ct, (cairo_font_face_t*) font->cairofnt);	/* Set our font; this will also be used for later drawing */
+	cairo_set_font_size (graphics->ct, FontSize);
+}
+
 static GpStatus
 MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length, GDIPCONST GpFont *font, 
 	GDIPCONST RectF *rc_org, GDIPCONST GpStringFormat *format, GpBrush *brush, RectF *boundingBox, 
@@ -128,8 +280,13 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 	float			*TabStops;
 	int			NumOfTabStops;
 	int			WrapPoint;		/* Array index of wrap character */
+	BOOL			BreakAnywhere;		/* Unwrapped text trimmed on characters */
+	GpLineBreaker		Breaker;
 	int			WrapX;			/* Width of text at wrap character */
 	float			CursorX;		/* Current X position of drawing cursor */
+	float			WrapWidth;		/* Width of the characters carried over on wrap */
+	float			WrapShift;		/* Their offset on the old line */
+	BOOL			WrapTab;		/* A tab is among them */
 	float			CursorY;		/* Current Y position of drawing cursor */
 	int			MaxX;			/* Largest X of cursor */
 	int			MaxXatY;		/* Y coordinate of line with largest X, needed for MaxX resetting on wrap */
@@ -140,9 +297,12 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 	int			AlignVert;		/* Vertical Alignment mode */
 	int			LineHeight;		/* Height of a line with given font */
 	cairo_font_extents_t	FontExtent;		/* Info about our font */
-	cairo_font_options_t	*FontOptions;
 	RectF 			rc_coords, *rc = &rc_coords;
 	float			FontSize;
+	BYTE			*LayoutKey;		/* Key of the layout in the cache */
+	int			LayoutKeySize;
+	int			DetailCount;		/* Length of the original string */
+	GpLayoutInfo		Layout;
 
 	if (OPTIMIZE_CONVERSION (graphics)) {
 		rc->X = rc_org->X;
@@ -168,54 +328,12 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 	if (data)
 		data->has_hotkeys = FALSE;
 
-	/*
-	  Set aliasing mode
-	*/
-	FontOptions = cairo_font_options_create();
-	
-	switch(graphics->text_mode) {
-		default:
-		case TextRenderingHintSystemDefault: {
-			cairo_font_options_set_antialias(FontOptions, CAIRO_ANTIALIAS_DEFAULT);
-			//cairo_font_options_set_hint_style(FontOptions, CAIRO_HINT_STYLE_NONE);
-			//cairo_font_options_set_subpixel_order(FontOptions, CAIRO_SUBPIXEL_ORDER_DEFAULT);
-			//cairo_font_options_set_hint_style(FontOptions, CAIRO_HINT_STYLE_DEFAULT);
-			//cairo_font_options_set_hint_metrics(FontOptions, CAIRO_HINT_METRICS_DEFAULT);
-			break;
-		}
-
-		// FIXME - pick matching settings for each text mode
-    		case TextRenderingHintSingleBitPerPixelGridFit:
-    		case TextRenderingHintSingleBitPerPixel:
-    		case TextRenderingHintAntiAliasGridFit:
-    		case TextRenderingHintAntiAlias: {
-			cairo_font_options_set_antialias(FontOptions, CAIRO_ANTIALIAS_DEFAULT);
-			break;
-		}
-
-    		case TextRenderingHintClearTypeGridFit: {
-			cairo_font_options_set_antialias(FontOptions, CAIRO_ANTIALIAS_DEFAULT);
-			break;
-		}
-	}
-
-	cairo_set_font_options(graphics->ct, FontOptions);
-	cairo_font_options_destroy(FontOptions);
-
-	// Do we want this here?
-
-/* Commented out until we properly save/restore AA settings; should fix bug #76135
-	cairo_set_antialias(graphics->ct, CAIRO_ANTIALIAS_NONE);
-*/
-
-	/*
-	   Get font size information; how expensive is the cairo stuff here? 
-	*/	
-	cairo_set_font_face (graphics->ct, (cairo_font_face_t*) font->cairofnt);	/* Set our font; this will also be used for later drawing */
-
 	/* this will always return the same value, except when printing */
 	FontSize = (graphics->type == gtPostScript) ? font->emSize : font->sizeInPixels;
-	cairo_set_font_size (graphics->ct, FontSize);
+
+	/* a batch sets the font up once for all its strings */
+	if (!data || !data->setup_done)
+		SetupFont (graphics, font, FontSize);
 	
 	cairo_font_extents (graphics->ct, &FontExtent);		/* Get the size we're looking for */
 /*	cairo_font_set_transform(font->cairofnt, SavedMatrix);*/	/* Restore the matrix */
@@ -224,6 +342,24 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 		LineHeight=1;
 	}
 
+	/* The same layout is often measured again, or measured then drawn */
+	DetailCount = StringLen;
+	LayoutKey = LayoutCacheKey (graphics, stringUnicode, DetailCount, font, rc, format, FontSize, &LayoutKeySize);
+	if (LayoutKey && gdip_layout_cache_lookup (LayoutKey, LayoutKeySize, CleanString, StringDetails, DetailCount, &Layout)) {
+		GdipFree (LayoutKey);
+		if (Layout.length == 0) {
+			*length = 0;
+			return Ok;
+		}
+
+		StringLen = Layout.length;
+		MaxX = Layout.max_x;
+		MaxY = Layout.max_y;
+		if (data)
+			data->has_hotkeys = Layout.has_hotkeys;
+		goto layout_done;
+	}
+
 #ifdef DRAWSTRING_DEBUG
 	printf("Font extents: ascent:%d, descent: %d, height:%d, maxXadvance:%d, maxYadvance:%d\n", (int)FontExtent.ascent, (int)FontExtent.descent, (int)FontExtent.height, (int)FontExtent.max_x_advance, (int)FontExtent.max_y_advance);
 #endif
@@ -243,11 +379,17 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 			StringLen = 1;
 	}
 
+	/* Break opportunities are found in the same pass, using the UAX #14 classes */
+	BreakAnywhere = ((format->formatFlags & StringFormatFlagsNoWrap) != 0) &&
+		((format->trimming == StringTrimmingCharacter) || (format->trimming == StringTrimmingNone));
+	gdip_line_breaker_init (&Breaker);
+
 	Dest=CleanString;
 	CurrentDetail=StringDetails;
 	for (i=0; i<StringLen; i++) {
 		switch(*Src) {
 			case '\r': { /* CR */
+				gdip_line_breaker_next (&Breaker, *Src);
 				Src++;
 				continue;
 			}
@@ -256,6 +398,7 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 				if (NumOfTabStops > 0) {
 					CurrentDetail->Flags |= STRING_DETAIL_TAB;
 				}
+				gdip_line_breaker_next (&Breaker, *Src);
 				Src++;
 				continue;
 			}
@@ -263,6 +406,7 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 			case '\n': { /* LF */
 				CurrentDetail->Flags |= STRING_DETAIL_LF;
 				CurrentDetail->Linefeeds++;
+				gdip_line_breaker_next (&Breaker, *Src);
 				Src++;
 				continue;
 			}
@@ -284,23 +428,11 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 					data->has_hotkeys = TRUE;
 				continue;
 			}
+		}
 
-			/* Boy, this must be slow, FIXME somehow */
-			default: {
-				if (((format->formatFlags & StringFormatFlagsNoWrap)==0) || ((format->trimming != StringTrimmingCharacter) && (format->trimming != StringTrimmingNone))) {
-					break;
-				}
-				/* Fall through */
-			}
-
-			case ' ':
-			case '.':
-			{
-				/* Mark where we can break for a new line */
-				CurrentDetail->Flags |= STRING_DETAIL_BREAK;
-				break;
-			}
-
+		/* Mark where a new line can start */
+		if ((gdip_line_breaker_next (&Breaker, *Src) != LineBreakProhibited) || BreakAnywhere) {
+			CurrentDetail->Flags |= STRING_DETAIL_BREAK;
 		}
 		*Dest=*Src;
 		Src++;
@@ -319,14 +451,22 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 
 	/* Don't bother doing anything else if the length is 0 */
 	if (StringLen == 0) {
+		if (LayoutKey) {
+			memset (&Layout, 0, sizeof (Layout));
+			gdip_layout_cache_insert (LayoutKey, LayoutKeySize, CleanString, StringDetails, DetailCount, &Layout);
+			GdipFree (LayoutKey);
+		}
 		*length = 0;
 		return Ok;
 	}
 	
 	/* Convert string from Gdiplus format to UTF8, suitable for cairo */
 	String = (BYTE*) ucs2_to_utf8 ((const gunichar2 *)CleanString, -1);
-	if (!String)
+	if (!String) {
+		if (LayoutKey)
+			GdipFree (LayoutKey);
 		return OutOfMemory;
+	}
 
 #ifdef DRAWSTRING_DEBUG
 	printf("Sanitized string: >%s<, length %d (utf8-length:%d)\n", String, StringLen, strlen((char *)String));
@@ -335,6 +475,8 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 	/* Generate size array */
 	if (CalculateStringWidths (graphics->ct, font, CleanString, StringLen, StringDetails)==0) {
 		/* FIXME; pick right return code */
+		if (LayoutKey)
+			GdipFree (LayoutKey);
 		GdipFree(String);
 		return Ok;
 	}
@@ -397,13 +539,9 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 #ifdef DRAWSTRING_DEBUG
 		printf("[%3d] X: %3d, Y:%3d, '%c'  | ", i, (int)CursorX, (int)CursorY, CleanString[i]>=32 ? CleanString[i] : '?');
 #endif
-		/* Remember where to wrap next, but only if wrapping allowed */
+		/* Remember where to wrap next, but only if wrapping allowed; spaces stay at the end of the old line */
 		if (((format->formatFlags & StringFormatFlagsNoWrap)==0) && (CurrentDetail->Flags & STRING_DETAIL_BREAK)) {
-			if (CleanString[i] == ' ') {
-				WrapPoint=i+1;	/* We skip the break char itself, keeping it at the end of the old line */
-			} else {
-				WrapPoint=i;
-			}
+			WrapPoint=i;
 
 			if (CursorX>MaxX) {
 				WrapX=CursorX;
@@ -454,19 +592,59 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 				/* New line */
 				CurrentLineStart=&(StringDetails[WrapPoint]);
 				CurrentLineStart->Flags|=STRING_DETAIL_LINESTART;
-				CurrentLineStart->LineLen=0;
-
-				/* Generate CursorX/Y for new line */
 				CursorY+=LineHeight;
-				CursorX=CurrentLineStart->Width;
 
-				i=WrapPoint;
+				/*
+				   The line positions are the running sums of the advances, so if the carried over
+				   characters fit on the new line they are just shifted there instead of being laid
+				   out again. There are no break points or new lines among them, but there may be
+				   a tab (e.g. followed by a closing bracket): its width depends on where it starts,
+				   so the characters are laid out again in that case.
+				*/
+				WrapShift = CurrentLineStart->PosX;
+				WrapWidth = CursorX - WrapShift;
+				WrapTab = FALSE;
+				for (j=WrapPoint; j<=i; j++) {
+					if (StringDetails[j].Flags & STRING_DETAIL_TAB) {
+						WrapTab = TRUE;
+						break;
+					}
+				}
+				if (!WrapTab && (WrapWidth <= FrameWidth)) {
+					BOOL	Hidden = FrameHeight && ((CursorY>FrameHeight) || ((format->formatFlags & StringFormatFlagsLineLimit) && (CursorY+LineHeight)>FrameHeight));
+
+					for (j=WrapPoint; j<i; j++) {
+						StringDetails[j].PosX-=WrapShift;
+						StringDetails[j].PosY=CursorY;
+						if (Hidden) {
+							StringDetails[j].Flags|=STRING_DETAIL_HIDDEN;
+						} else {
+							StringDetails[j].Flags&=~STRING_DETAIL_HIDDEN;
+						}
+					}
+					CurrentDetail->PosX-=WrapShift;
+					CurrentDetail->PosY=CursorY;
+					CurrentLineStart->LineLen=i-WrapPoint;
+
+					CursorX=WrapWidth;
+					if (MaxX<CursorX) {
+						MaxX=CursorX;
+						MaxXatY=CursorY;
+					}
+				} else {
+					CurrentLineStart->LineLen=0;
+
+					/* Generate CursorX/Y for new line */
+					CursorX=CurrentLineStart->Width;
+
+					i=WrapPoint;
+					CurrentDetail=&(StringDetails[WrapPoint]);
+					CurrentDetail->PosX=0;
+					CurrentDetail->PosY=CursorY;
+				}
 #ifdef DRAWSTRING_DEBUG
 				printf("\n<Forcing break at index %d, CursorX:%f, LineLen:%d>\n", WrapPoint, CursorX, CurrentLineStart->LineLen);
 #endif
-				CurrentDetail=&(StringDetails[WrapPoint]);
-				CurrentDetail->PosX=0;
-				CurrentDetail->PosY=CursorY;
 				WrapPoint=-1;
 			} else {
 				/*
@@ -645,6 +823,15 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 #endif
 	MaxY+=LineHeight+FontExtent.descent;
 
+	if (LayoutKey) {
+		Layout.length = StringLen;
+		Layout.max_x = MaxX;
+		Layout.max_y = MaxY;
+		Layout.has_hotkeys = LayoutHasHotkeys (StringDetails, DetailCount);
+		gdip_layout_cache_insert (LayoutKey, LayoutKeySize, CleanString, StringDetails, DetailCount, &Layout);
+		GdipFree (LayoutKey);
+	}
+
 #ifdef DRAWSTRING_DEBUG
 	printf("\n");
 
@@ -671,6 +858,7 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 	}
 #endif
 
+layout_done:
 	/* Prepare alignment handling */
 	AlignHorz = format->alignment;
 	if (format->formatFlags & StringFormatFlagsDirectionRightToLeft) {
@@ -755,6 +943,126 @@ MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int *length
 	return Ok;
 }
 
+/* marks the second half of a surrogate pair, drawn by the glyph of the first half */
+#define GLYPH_SKIP	((unsigned long) -1)
+
+/*
+ * Map the characters to the glyphs of the font set on the cairo context. Each
+ * glyph x is the offset of its character from the string start, using the
+ * cached advances (i.e. where cairo_show_text would put it). Returns NULL
+ * when the font doesn't allow it, the caller then draws the text.
+ */
+static cairo_glyph_t*
+MapStringGlyphs (GpGraphics *graphics, GDIPCONST GpFont *font, GDIPCONST WCHAR *chars, int count)
+{
+	GpGlyphAdvances	*advances;
+	cairo_glyph_t	*glyphs;
+	FT_Face		face;
+	double		x = 0;
+	int		i;
+
+	glyphs = (cairo_glyph_t*) GdipAlloc (count * sizeof (cairo_glyph_t));
+	if (!glyphs)
+		return NULL;
+
+	gdip_glyph_cache_lock ();
+	advances = gdip_glyph_cache_get_advances (graphics->ct, (GpFont*) font);
+	if (advances) {
+		for (i = 0; i < count; i++) {
+			glyphs [i].x = x;
+			glyphs [i].y = 0;
+			x += gdip_glyph_advances_get (advances, graphics->ct, chars [i]);
+		}
+	}
+	gdip_glyph_cache_unlock ();
+	if (!advances) {
+		GdipFree (glyphs);
+		return NULL;
+	}
+
+	/* the face can't stay locked while cairo measures the characters */
+	face = cairo_ft_scaled_font_lock_face (cairo_get_scaled_font (graphics->ct));
+	if (!face) {
+		GdipFree (glyphs);
+		return NULL;
+	}
+
+	for (i = 0; i < count; i++) {
+		if ((i < count - 1) && (chars [i] >= 0xD800) && (chars [i] < 0xDC00) &&
+			(chars [i + 1] >= 0xDC00) && (chars [i + 1] < 0xE000)) {
+			gunichar ch = 0x10000 + ((chars [i] - 0xD800) << 10) + (chars [i + 1] - 0xDC00);
+			glyphs [i].index = FT_Get_Char_Index (face, ch);
+			glyphs [++i].index = GLYPH_SKIP;
+		} else {
+			glyphs [i].index = FT_Get_Char_Index (face, chars [i]);
+		}
+	}
+
+	cairo_ft_scaled_font_unlock_face (cairo_get_scaled_font (graphics->ct));
+	return glyphs;
+}
+
+static void
+FlushGlyphBatch (GpGraphics *graphics, GpGlyphBatch *batch)
+{
+	if (batch && (batch->count > 0)) {
+		cairo_show_glyphs (graphics->ct, batch->glyphs, batch->count);
+		batch->count = 0;
+	}
+}
+
+/* add the glyphs to the batch, or show them when they don't fit */
+static void
+BatchGlyphs (GpGraphics *graphics, GpGlyphBatch *batch, cairo_glyph_t *glyphs, int count)
+{
+	if (batch->count + count > batch->size) {
+		int size = max (batch->count + count, batch->size * 2);
+		cairo_glyph_t *grown = (cairo_glyph_t*) gdip_realloc (batch->glyphs, size * sizeof (cairo_glyph_t));
+
+		if (!grown) {
+			FlushGlyphBatch (graphics, batch);
+			cairo_show_glyphs (graphics->ct, glyphs, count);
+			return;
+		}
+		batch->glyphs = grown;
+		batch->size = size;
+	}
+
+	memcpy (batch->glyphs + batch->count, glyphs, count * sizeof (cairo_glyph_t));
+	batch->count += count;
+}
+
+/* draw the glyphs of a line starting at (x, y), going down for vertical lines */
+static void
+ShowLineGlyphs (GpGraphics *graphics, cairo_glyph_t *glyphs, int count, double x, double y, BOOL vertical, GpGlyphBatch *batch)
+{
+	cairo_matrix_t matrix;
+	double start = glyphs [0].x;
+	int i, n = 0;
+
+	/* same conversion as gdip_cairo_move_to */
+	gdip_cairo_points_matrix (graphics, FALSE, TRUE, &matrix);
+	cairo_matrix_transform_point (&matrix, &x, &y);
+
+	/* the positions are computed in place, glyphs are only removed */
+	for (i = 0; i < count; i++) {
+		double offset = glyphs [i].x - start;
+
+		if (glyphs [i].index == GLYPH_SKIP)
+			continue;
+
+		glyphs [n].index = glyphs [i].index;
+		glyphs [n].x = vertical ? x : x + offset;
+		glyphs [n].y = vertical ? y + offset : y;
+		n++;
+	}
+
+	if (batch)
+		BatchGlyphs (graphics, batch, glyphs, n);
+	else
+		cairo_show_glyphs (graphics->ct, glyphs, n);
+}
+
 static GpStatus
 DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font, 
 	GDIPCONST RectF *rc_org, GDIPCONST GpStringFormat *fmt, GpBrush *brush, 
@@ -771,6 +1079,7 @@ DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GD
 	int MaxY = data->max_y;
 	cairo_font_extents_t FontExtent;
 	RectF rect, *rc = &rect;
+	cairo_glyph_t *glyphs;
 
 	cairo_font_extents (graphics->ct, &FontExtent);
 
@@ -792,6 +1101,7 @@ DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GD
 		printf("Setting clipping rectangle (%f, %f %fx%f)\n", rc->X, rc->Y, rc->Width, rc->Height);
 #endif		
 		/* We do not call cairo_reset_clip because we want to take previous clipping into account */
+		FlushGlyphBatch (graphics, data->batch);
 		gdip_cairo_rectangle (graphics, rc->X, rc->Y, rc->Width, rc->Height, TRUE);
 		cairo_clip (graphics->ct);
 		SetClipping = TRUE;
@@ -799,15 +1109,28 @@ DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GD
 
 	/* Setup cairo */
 
-	if (brush) {
+	if (data->setup_done) {
+		/* a batch sets the brush once */
+	} else if (brush) {
 		gdip_brush_setup (graphics, (GpBrush *)brush);
 	} else {
 		cairo_set_source_rgb (graphics->ct, 0., 0., 0.);
 	}
 
+	/* all the lines are drawn from a single mapping of the characters to glyphs */
+	glyphs = MapStringGlyphs (graphics, font, CleanString, StringLen);
+	if (glyphs && (fmt->formatFlags & StringFormatFlagsDirectionVertical)) {
+		cairo_matrix_t matrix;
+
+		/* rotate the glyphs, rather than the whole context for each line (the caller restores the font matrix) */
+		cairo_get_font_matrix (graphics->ct, &matrix);
+		cairo_matrix_rotate (&matrix, PI/2);
+		cairo_set_font_matrix (graphics->ct, &matrix);
+	}
+
 	for (i=0; i<StringLen; i++) {
 		if (StringDetails[i].Flags & STRING_DETAIL_LINESTART) {
-			BYTE *String;
+			BYTE *String = NULL;
 			int length = StringDetails[i].LineLen;
 			int current_line_length = min (length + i, StringLen);
 
@@ -822,10 +1145,12 @@ DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GD
 
 			if (length > StringLen - i)
 				length = StringLen - i;
-			String = (BYTE*) ucs2_to_utf8 ((const gunichar2 *)(CleanString+i), length);
+			if (!glyphs) {
+				String = (BYTE*) ucs2_to_utf8 ((const gunichar2 *)(CleanString+i), length);
 #ifdef DRAWSTRING_DEBUG
-			printf("Displaying line >%s< (%d chars)\n", String, length);
+				printf("Displaying line >%s< (%d chars)\n", String, length);
 #endif
+			}
 
 			if ((fmt->formatFlags & StringFormatFlagsDirectionVertical)==0) {
 				CursorX = rc->X + StringDetails[i].PosX;
@@ -852,8 +1177,13 @@ DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GD
 				case StringAlignmentFar: CursorY=rc->Y+rc->Height-MaxY+StringDetails[i].PosY+LineHeight; break;
 				}
 
-				gdip_cairo_move_to (graphics, CursorX, CursorY, FALSE, TRUE);
-				cairo_show_text (graphics->ct, (const char *) String);
+				if (glyphs) {
+					ShowLineGlyphs (graphics, glyphs + i, length, CursorX, CursorY, FALSE, data->batch);
+				} else {
+					FlushGlyphBatch (graphics, data->batch);
+					gdip_cairo_move_to (graphics, CursorX, CursorY, FALSE, TRUE);
+					cairo_show_text (graphics->ct, (const char *) String);
+				}
 			} else {
 				CursorY = rc->Y;
 				switch (AlignHorz) {
@@ -879,22 +1209,29 @@ DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GD
 				case StringAlignmentFar: CursorX=rc->X + StringDetails[i].PosX+rc->Width-MaxY+StringDetails[i].PosY; break;
 				}
 
-				/* Rotate text for vertical drawing */
-				cairo_save (graphics->ct);
-				gdip_cairo_move_to (graphics, CursorX, CursorY, FALSE, TRUE);
-				cairo_rotate (graphics->ct, PI/2);
-				cairo_show_text (graphics->ct, (const char *) String);
-				cairo_restore (graphics->ct);
+				if (glyphs) {
+					ShowLineGlyphs (graphics, glyphs + i, length, CursorX, CursorY, TRUE, data->batch);
+				} else {
+					/* Rotate text for vertical drawing */
+					FlushGlyphBatch (graphics, data->batch);
+					cairo_save (graphics->ct);
+					gdip_cairo_move_to (graphics, CursorX, CursorY, FALSE, TRUE);
+					cairo_rotate (graphics->ct, PI/2);
+					cairo_show_text (graphics->ct, (const char *) String);
+					cairo_restore (graphics->ct);
+				}
 			}
 
 #ifdef DRAWSTRING_DEBUG
 			printf("Drawing %d chars at %d x %d (width=%f pixels)\n", StringDetails[i].LineLen, (int)CursorX, (int)CursorY, StringDetails[i+StringDetails[i].LineLen-1].PosX);
 #endif
-			GdipFree (String);
+			if (String)
+				GdipFree (String);
 
 			if (font->style & (FontStyleUnderline | FontStyleStrikeout)) {
 				double line_width = cairo_get_line_width (graphics->ct);
 
+				FlushGlyphBatch (graphics, data->batch);
 				/* Calculate the width of the line */
 				cairo_set_line_width (graphics->ct, 1.0);
 				j=StringDetails[i+StringDetails[i].LineLen-1].PosX+StringDetails[i+StringDetails[i].LineLen-1].Width;
@@ -930,6 +1267,8 @@ DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GD
 	/* Handle Hotkey prefix */
 	if (fmt->hotkeyPrefix==HotkeyPrefixShow && data->has_hotkeys) {
 		GpStringDetailStruct *CurrentDetail = StringDetails;
+
+		FlushGlyphBatch (graphics, data->batch);
 		for (i=0; i<StringLen; i++) {
 			if (CurrentDetail->Flags & STRING_DETAIL_LINESTART) {
 				if ((fmt->formatFlags & StringFormatFlagsDirectionVertical)==0) {
@@ -979,6 +1318,13 @@ DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GD
 		}
 	}
 
+	if (glyphs)
+		GdipFree (glyphs);
+
+	/* the clip and the rotated font matrix only apply to this string */
+	if (SetClipping || (fmt->formatFlags & StringFormatFlagsDirectionVertical))
+		FlushGlyphBatch (graphics, data->batch);
+
 	/* Restore the graphics clipping region */
 	if (SetClipping)
 		cairo_SetGraphicsClip (graphics);
@@ -1018,6 +1364,9 @@ cairo_DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int leng
 	if (status != Ok)
 		return status;
 
+	data.setup_done = FALSE;
+	data.batch = NULL;
+
 	/* a NULL format is valid, it means get the generic default values (and free them later) */
 	if (!format) {
 		GdipStringFormatGetGenericDefault ((GpStringFormat **)&fmt);
@@ -1047,6 +1396,91 @@ cairo_DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int leng
 	return status;
 }
 
+/*
+ * Draw many strings with the same font, format and brush. The font and brush are set
+ * up once, the scratch buffers are shared, and the glyphs of consecutive strings are
+ * shown together unless something else (clipping, lines) must be drawn between them.
+ */
+GpStatus
+cairo_DrawStrings (GpGraphics *graphics, GDIPCONST WCHAR **strings, GDIPCONST int *lengths, int count,
+	GDIPCONST GpFont *font, GDIPCONST RectF *rects, GDIPCONST GpStringFormat *format, GpBrush *brush)
+{
+	cairo_matrix_t SavedMatrix, FontMatrix;
+	GpStringFormat *fmt;
+	GpStringDetailStruct *StringDetails;
+	WCHAR *CleanString;
+	GpDrawTextData data;
+	GpGlyphBatch batch;
+	GpStatus status;
+	int i, StringLen, MaxLen = 0;
+
+	for (i = 0; i < count; i++)
+		MaxLen = max (MaxLen, lengths [i]);
+	if (MaxLen == 0)
+		return Ok;
+
+	status = AllocStringData (&CleanString, &StringDetails, MaxLen);
+	if (status != Ok)
+		return status;
+
+	/* a NULL format is valid, it means get the generic default values (and free them later) */
+	if (!format) {
+		GdipStringFormatGetGenericDefault ((GpStringFormat **)&fmt);
+	} else {
+		fmt = (GpStringFormat *)format;
+	}
+
+	cairo_get_font_matrix (graphics->ct, &SavedMatrix);
+
+	SetupFont (graphics, font, (graphics->type == gtPostScript) ? font->emSize : font->sizeInPixels);
+	cairo_get_font_matrix (graphics->ct, &FontMatrix);
+	if (brush) {
+		gdip_brush_setup (graphics, brush);
+	} else {
+		cairo_set_source_rgb (graphics->ct, 0., 0., 0.);
+	}
+
+	memset (&batch, 0, sizeof (batch));
+	data.setup_done = TRUE;
+	data.batch = &batch;
+
+	for (i = 0; (i < count) && (status == Ok); i++) {
+		StringLen = lengths [i];
+		if (StringLen == 0)
+			continue;
+
+		/* MeasureString expects cleared details */
+		memset (StringDetails, 0, (StringLen + 1) * sizeof (GpStringDetailStruct));
+		status = MeasureString (graphics, strings [i], &StringLen, font, &rects [i], fmt, brush, NULL, NULL, NULL,
+			CleanString, StringDetails, &data);
+		if ((status == Ok) && (StringLen > 0)) {
+			status = DrawString (graphics, strings [i], StringLen, font, &rects [i], fmt, brush, CleanString,
+				StringDetails, &data);
+		}
+
+		/* vertical strings rotate the font */
+		if (fmt->formatFlags & StringFormatFlagsDirectionVertical)
+			cairo_set_font_matrix (graphics->ct, &FontMatrix);
+	}
+
+	FlushGlyphBatch (graphics, &batch);
+	if (batch.glyphs)
+		GdipFree (batch.glyphs);
+
+	/* Restore matrix to original values */
+	cairo_set_font_matrix (graphics->ct, &SavedMatrix);
+
+	/* Cleanup */
+	GdipFree (CleanString);
+	GdipFree (StringDetails);
+
+	/* we must delete the default stringformat (when one wasn't provided by the caller) */
+	if (format != fmt)
+		GdipDeleteStringFormat (fmt);
+
+	return status;
+}
+
 GpStatus
 cairo_MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font, GDIPCONST RectF *rc,
 	GDIPCONST GpStringFormat *format,  RectF *boundingBox, int *codepointsFitted, int *linesFilled)
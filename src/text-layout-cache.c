@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "text-layout-cache.h"
+
+#ifndef USE_PANGO_RENDERING
+
+/*
+ * Layouts computed by MeasureString, keyed by everything they depend on (the
+ * key bytes are built by the caller). Entries are kept in a list, most
+ * recently used first, so the oldest ones are dropped when the cache is full.
+ */
+typedef struct _LayoutCacheEntry {
+	guint				hash;
+	int				key_size;
+	BYTE				*key;
+	int				count;		/* number of details */
+	WCHAR				*clean_string;	/* info.length + 1 characters */
+	GpStringDetailStruct		*details;
+	GpLayoutInfo			info;
+	int				bytes;
+	struct _LayoutCacheEntry	*prev;
+	struct _LayoutCacheEntry	*next;
+} LayoutCacheEntry;
+
+static GStaticMutex layout_cache_mutex = G_STATIC_MUTEX_INIT;
+static GHashTable *layout_cache = NULL;		/* LayoutCacheEntry -> itself */
+static LayoutCacheEntry *layout_cache_first = NULL;
+static LayoutCacheEntry *layout_cache_last = NULL;
+static int layout_cache_entries = 0;
+static int layout_cache_bytes = 0;
+
+static guint
+layout_key_hash (const BYTE *key, int key_size)
+{
+	guint hash = 2166136261u;
+	int i;
+
+	/* FNV-1a */
+	for (i = 0; i < key_size; i++)
+		hash = (hash ^ key [i]) * 16777619u;
+	return hash;
+}
+
+static guint
+layout_entry_hash (gconstpointer entry)
+{
+	return ((const LayoutCacheEntry*) entry)->hash;
+}
+
+static gboolean
+layout_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const LayoutCacheEntry *ea = (const LayoutCacheEntry*) a;
+	const LayoutCacheEntry *eb = (const LayoutCacheEntry*) b;
+
+	return (ea->hash == eb->hash) && (ea->key_size == eb->key_size) && (memcmp (ea->key, eb->key, ea->key_size) == 0);
+}
+
+static void
+layout_entry_unlink (LayoutCacheEntry *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		layout_cache_first = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		layout_cache_last = entry->prev;
+	entry->prev = entry->next = NULL;
+}
+
+static void
+layout_entry_push (LayoutCacheEntry *entry)
+{
+	entry->prev = NULL;
+	entry->next = layout_cache_first;
+	if (layout_cache_first)
+		layout_cache_first->prev = entry;
+	layout_cache_first = entry;
+	if (!layout_cache_last)
+		layout_cache_last = entry;
+}
+
+static void
+layout_entry_free (LayoutCacheEntry *entry)
+{
+	GdipFree (entry->key);
+	GdipFree (entry->clean_string);
+	GdipFree (entry->details);
+	GdipFree (entry);
+}
+
+static void
+layout_entry_remove (LayoutCacheEntry *entry)
+{
+	g_hash_table_remove (layout_cache, entry);
+	layout_entry_unlink (entry);
+	layout_cache_entries--;
+	layout_cache_bytes -= entry->bytes;
+	layout_entry_free (entry);
+}
+
+/* copy the cached layout for @key, if any, into the caller's buffers */
+BOOL
+gdip_layout_cache_lookup (const BYTE *key, int key_size, WCHAR *clean_string, GpStringDetailStruct *details, int count,
+	GpLayoutInfo *info)
+{
+	LayoutCacheEntry search, *entry = NULL;
+
+	search.hash = layout_key_hash (key, key_size);
+	search.key_size = key_size;
+	search.key = (BYTE*) key;
+
+	g_static_mutex_lock (&layout_cache_mutex);
+	if (layout_cache)
+		entry = (LayoutCacheEntry*) g_hash_table_lookup (layout_cache, &search);
+
+	if (entry && (entry->count == count)) {
+		memcpy (clean_string, entry->clean_string, (entry->info.length + 1) * sizeof (WCHAR));
+		memcpy (details, entry->details, count * sizeof (GpStringDetailStruct));
+		*info = entry->info;
+
+		/* it's now the most recently used */
+		layout_entry_unlink (entry);
+		layout_entry_push (entry);
+	} else {
+		entry = NULL;
+	}
+	g_static_mutex_unlock (&layout_cache_mutex);
+
+	return (entry != NULL);
+}
+
+void
+gdip_layout_cache_insert (const BYTE *key, int key_size, GDIPCONST WCHAR *clean_string, GDIPCONST GpStringDetailStruct *details,
+	int count, GDIPCONST GpLayoutInfo *info)
+{
+	LayoutCacheEntry *entry, *existing;
+	int bytes;
+
+	bytes = sizeof (LayoutCacheEntry) + key_size + (info->length + 1) * sizeof (WCHAR) + count * sizeof (GpStringDetailStruct);
+	if (bytes > LAYOUT_CACHE_MAX_BYTES / 4)
+		return;
+
+	entry = (LayoutCacheEntry*) GdipAlloc (sizeof (LayoutCacheEntry));
+	if (!entry)
+		return;
+
+	entry->key = (BYTE*) GdipAlloc (key_size);
+	entry->clean_string = (WCHAR*) GdipAlloc ((info->length + 1) * sizeof (WCHAR));
+	entry->details = (GpStringDetailStruct*) GdipAlloc (count * sizeof (GpStringDetailStruct));
+	if (!entry->key || !entry->clean_string || !entry->details) {
+		if (entry->key)
+			GdipFree (entry->key);
+		if (entry->clean_string)
+			GdipFree (entry->clean_string);
+		if (entry->details)
+			GdipFree (entry->details);
+		GdipFree (entry);
+		return;
+	}
+
+	entry->hash = layout_key_hash (key, key_size);
+	entry->key_size = key_size;
+	memcpy (entry->key, key, key_size);
+	entry->count = count;
+	memcpy (entry->clean_string, clean_string, (info->length + 1) * sizeof (WCHAR));
+	memcpy (entry->details, details, count * sizeof (GpStringDetailStruct));
+	entry->info = *info;
+	entry->bytes = bytes;
+
+	g_static_mutex_lock (&layout_cache_mutex);
+	if (!layout_cache)
+		layout_cache = g_hash_table_new (layout_entry_hash, layout_entry_equal);
+
+	/* another thread may have added the same layout */
+	existing = (LayoutCacheEntry*) g_hash_table_lookup (layout_cache, entry);
+	if (existing)
+		layout_entry_remove (existing);
+
+	while (layout_cache_last && ((layout_cache_entries >= LAYOUT_CACHE_MAX_ENTRIES) ||
+		(layout_cache_bytes + bytes > LAYOUT_CACHE_MAX_BYTES)))
+		layout_entry_remove (layout_cache_last);
+
+	g_hash_table_insert (layout_cache, entry, entry);
+	layout_entry_push (entry);
+	layout_cache_entries++;
+	layout_cache_bytes += bytes;
+	g_static_mutex_unlock (&layout_cache_mutex);
+}
+
+void
+gdip_layout_cache_clear (void)
+{
+	g_static_mutex_lock (&layout_cache_mutex);
+	while (layout_cache_last)
+		layout_entry_remove (layout_cache_last);
+	if (layout_cache) {
+		g_hash_table_destroy (layout_cache);
+		layout_cache = NULL;
+	}
+	g_static_mutex_unlock (&layout_cache_mutex);
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 The libgdiplus contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * NOTE: This is a private header files and everything is subject to changes.
+ */
+
+#ifndef __TEXT_LAYOUT_CACHE_H__
+#define __TEXT_LAYOUT_CACHE_H__
+
+#include "gdiplus-private.h"
+
+#ifndef USE_PANGO_RENDERING
+
+#include "text-cairo-private.h"
+
+/* the least recently used layouts are dropped to keep the cache under these */
+#define LAYOUT_CACHE_MAX_ENTRIES	256
+#define LAYOUT_CACHE_MAX_BYTES		(2 * 1024 * 1024)
+
+/* what MeasureString computes, besides the cleaned string and the details */
+typedef struct {
+	int		length;		/* of the cleaned string, 0 when there's nothing to draw */
+	int		max_x;
+	int		max_y;
+	BOOL		has_hotkeys;
+} GpLayoutInfo;
+
+BOOL gdip_layout_cache_lookup (const BYTE *key, int key_size, WCHAR *clean_string, GpStringDetailStruct *details, int count,
+	GpLayoutInfo *info) GDIP_INTERNAL;
+void gdip_layout_cache_insert (const BYTE *key, int key_size, GDIPCONST WCHAR *clean_string, GDIPCONST GpStringDetailStruct *details,
+	int count, GDIPCONST GpLayoutInfo *info) GDIP_INTERNAL;
+void gdip_layout_cache_clear (void) GDIP_INTERNAL;
+
+#endif
+
+#endif
@@ -41,16 +41,33 @@
 #define GDIP_PANGOHACK_ACCELERATOR	((char)1)
 
 #define text_DrawString			pango_DrawString
+#define text_DrawStrings		pango_DrawStrings
 #define text_MeasureString		pango_MeasureString
 #define text_MeasureCharacterRanges	pango_MeasureCharacterRanges
 
 
+/* the layout (and its context) of the last string drawn or measured on a graphics, with what its text was made from */
+typedef struct _PangoLayoutCache {
+	PangoLayout	*layout;
+	WCHAR		*text;
+	int		length;
+	int		size;		/* of text, in characters */
+	int		text_flags;	/* the format flags changing the text or its attributes */
+	int		hotkey_prefix;
+	int		style;		/* underline and strikeout */
+	int		context_flags;	/* the format flags changing the context */
+} GpPangoLayoutCache;
+
 PangoLayout* gdip_pango_setup_layout (cairo_t *ct, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font, 
-	GDIPCONST RectF *rc, RectF *box, GDIPCONST GpStringFormat *format);
+	GDIPCONST RectF *rc, RectF *box, GDIPCONST GpStringFormat *format, GpPangoLayoutCache **cache);
+void gdip_pango_layout_cache_free (GpPangoLayoutCache *cache) GDIP_INTERNAL;
 
 GpStatus pango_DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font, 
 	GDIPCONST RectF *rc, GDIPCONST GpStringFormat *format, GpBrush *brush) GDIP_INTERNAL;
 
+GpStatus pango_DrawStrings (GpGraphics *graphics, GDIPCONST WCHAR **strings, GDIPCONST int *lengths, int count,
+	GDIPCONST GpFont *font, GDIPCONST RectF *rects, GDIPCONST GpStringFormat *format, GpBrush *brush) GDIP_INTERNAL;
+
 GpStatus pango_MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font,
 	GDIPCONST RectF *rc, GDIPCONST GpStringFormat *format, RectF *boundingBox, int *codepointsFitted, int *linesFilled)
 	GDIP_INTERNAL;
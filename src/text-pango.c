@@ -35,15 +35,54 @@
  * NOTE: all parameter's validations are done inside text.c
  */
 
-static PangoAttrList*
-gdip_get_layout_attributes (PangoLayout *layout)
+/* the format flags that change the text or its attributes, or the layout context */
+#define TEXT_FORMAT_FLAGS	(StringFormatFlagsMeasureTrailingSpaces | StringFormatFlagsNoFontFallback)
+#define CONTEXT_FORMAT_FLAGS	(StringFormatFlagsDirectionRightToLeft | StringFormatFlagsDirectionVertical)
+
+void
+gdip_pango_layout_cache_free (GpPangoLayoutCache *cache)
+{
+	if (cache->layout)
+		g_object_unref (cache->layout);
+	if (cache->text)
+		GdipFree (cache->text);
+	GdipFree (cache);
+}
+
+/* the layout still holds the text and the attributes the string would get */
+static BOOL
+gdip_pango_same_text (GpPangoLayoutCache *cache, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font,
+	GpStringFormat *fmt)
 {
-	PangoAttrList *list = pango_layout_get_attributes (layout);
-	if (!list)
-		list = pango_attr_list_new ();
-	else
-		pango_attr_list_ref (list);
-	return list;
+	return cache && cache->layout && (cache->length == length) &&
+		(cache->text_flags == (fmt->formatFlags & TEXT_FORMAT_FLAGS)) &&
+		(cache->hotkey_prefix == fmt->hotkeyPrefix) &&
+		(cache->style == (font->style & (FontStyleUnderline | FontStyleStrikeout))) &&
+		(memcmp (cache->text, stringUnicode, length * sizeof (WCHAR)) == 0);
+}
+
+/* remember the string of the layout, if this fails the next call sets the text again */
+static void
+gdip_pango_cache_text (GpPangoLayoutCache *cache, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font,
+	GpStringFormat *fmt)
+{
+	if (length > cache->size) {
+		WCHAR *text = (WCHAR *) GdipAlloc (length * sizeof (WCHAR));
+		if (!text) {
+			cache->length = -1;
+			return;
+		}
+		if (cache->text)
+			GdipFree (cache->text);
+		cache->text = text;
+		cache->size = length;
+	}
+
+	memcpy (cache->text, stringUnicode, length * sizeof (WCHAR));
+	cache->length = length;
+	cache->text_flags = fmt->formatFlags & TEXT_FORMAT_FLAGS;
+	cache->hotkey_prefix = fmt->hotkeyPrefix;
+	cache->style = font->style & (FontStyleUnderline | FontStyleStrikeout);
 }
 
 static void
@@ -68,9 +107,14 @@ gdip_process_accelerators (gchar *text, int length, PangoAttrList *list)
 	}
 }
 
+/*
+ * With a cache the layout of a graphics is reused: the context isn't created again and,
+ * when the string and its attributes didn't change, Pango keeps its itemization and lines
+ * unless the setters below actually change something.
+ */
 PangoLayout*
 gdip_pango_setup_layout (cairo_t *ct, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font, 
-	GDIPCONST RectF *rc, RectF *box, GDIPCONST GpStringFormat *format)
+	GDIPCONST RectF *rc, RectF *box, GDIPCONST GpStringFormat *format, GpPangoLayoutCache **cache)
 {
 	GpStringFormat *fmt;
 	PangoLayout *layout;
@@ -78,34 +122,40 @@ gdip_pango_setup_layout (cairo_t *ct, GDIPCONST WCHAR *stringUnicode, int length
 	PangoMatrix matrix = PANGO_MATRIX_INIT;
 	PangoRectangle logical;
 	PangoAttrList *list = NULL;
-
-	gchar *text = ucs2_to_utf8 (stringUnicode, length);
-	if (!text)
-		return NULL;
+	GpPangoLayoutCache *lc = NULL;
+	BOOL new_layout;
+	int context_flags;
+	gchar *text;
+
+	if (cache) {
+		if (!*cache) {
+			*cache = (GpPangoLayoutCache *) GdipAlloc (sizeof (GpPangoLayoutCache));
+			if (*cache)
+				memset (*cache, 0, sizeof (GpPangoLayoutCache));
+		}
+		lc = *cache;
+	}
 
 //g_warning ("layout >%s< (%d) [x %g, y %g, w %g, h %g] [font %s, %g points]", text, length, rc->X, rc->Y, rc->Width, rc->Height, font->face, font->emSize);
 
 	/* a NULL format is valid, it means get the generic default values (and free them later) */
 	if (!format) {
 		GpStatus status = GdipStringFormatGetGenericDefault ((GpStringFormat **)&fmt);
-		if (status != Ok) {
-			GdipFree (text);
+		if (status != Ok)
 			return NULL;
-		}
 	} else {
 		fmt = (GpStringFormat *)format;
 	}
 
-	/* unless specified we don't consider the trailing spaces, unless there is just one space (#80680) */
-	if ((fmt->formatFlags & StringFormatFlagsMeasureTrailingSpaces) == 0) {
-		while ((length > 0) && (isspace (*(text + length - 1))))
-			length--;
-		if (length == 0)
-			length = 1;
+	new_layout = !lc || !lc->layout;
+	if (new_layout) {
+		layout = pango_cairo_create_layout (ct);
+		if (lc)
+			lc->layout = layout;
+	} else {
+		layout = lc->layout;
 	}
 
-	layout = pango_cairo_create_layout (ct);
-
 	/* context is owned by Pango (i.e. not referenced counted) do not free */
 	context = pango_layout_get_context (layout);
 
@@ -122,11 +172,29 @@ gdip_pango_setup_layout (cairo_t *ct, GDIPCONST WCHAR *stringUnicode, int length
 		pango_layout_set_width (layout, width * PANGO_SCALE);
 	}
 	
+	/* a reused context goes back to the defaults when the direction flags change */
+	context_flags = fmt->formatFlags & CONTEXT_FORMAT_FLAGS;
+	if (!new_layout && (lc->context_flags != context_flags)) {
+		pango_layout_set_auto_dir (layout, TRUE);
+		pango_context_set_base_dir (context, PANGO_DIRECTION_WEAK_LTR);
+#ifdef PANGO_VERSION_CHECK
+#if PANGO_VERSION_CHECK(1,16,0)
+		pango_context_set_base_gravity (context, PANGO_GRAVITY_SOUTH);
+		pango_context_set_gravity_hint (context, PANGO_GRAVITY_HINT_NATURAL);
+#endif
+#endif
+		pango_layout_context_changed (layout);
+	}
+	if (lc)
+		lc->context_flags = context_flags;
+
 	if (fmt->formatFlags & StringFormatFlagsDirectionRightToLeft) {
 		/* with GDI+ the API not the renderer makes the direction decision */
 		pango_layout_set_auto_dir (layout, FALSE);
-		pango_context_set_base_dir (context, PANGO_DIRECTION_RTL);
-		pango_layout_context_changed (layout);
+		if (pango_context_get_base_dir (context) != PANGO_DIRECTION_RTL) {
+			pango_context_set_base_dir (context, PANGO_DIRECTION_RTL);
+			pango_layout_context_changed (layout);
+		}
 
 		/* horizontal alignment */
 		switch (fmt->alignment) {
@@ -157,7 +225,7 @@ gdip_pango_setup_layout (cairo_t *ct, GDIPCONST WCHAR *stringUnicode, int length
 
 #ifdef PANGO_VERSION_CHECK
 #if PANGO_VERSION_CHECK(1,16,0)
-	if (fmt->formatFlags & StringFormatFlagsDirectionVertical) {
+	if ((fmt->formatFlags & StringFormatFlagsDirectionVertical) && (pango_context_get_base_gravity (context) != PANGO_GRAVITY_EAST)) {
 		/* only since Pango 1.16 */
 		pango_context_set_base_gravity (context, PANGO_GRAVITY_EAST);
 		pango_context_set_gravity_hint (context, PANGO_GRAVITY_HINT_STRONG);
@@ -205,62 +273,93 @@ gdip_pango_setup_layout (cairo_t *ct, GDIPCONST WCHAR *stringUnicode, int length
 		break;
 	}
 
-	/* some stuff can only be done by manipulating the attributes (but we can avoid this most of the time) */
-	if ((fmt->formatFlags & StringFormatFlagsNoFontFallback) || (font->style & (FontStyleUnderline | FontStyleStrikeout))) {
-
-		list = gdip_get_layout_attributes (layout);
-
-		/* StringFormatFlagsNoFontFallback */
-		if (fmt->formatFlags & StringFormatFlagsNoFontFallback) {
-			PangoAttribute *attr = pango_attr_fallback_new (FALSE);
-			attr->start_index = 0;
-			attr->end_index = length;
-			pango_attr_list_insert (list, attr);
+	/* the text, and the attributes which depend on it, are only set again when they changed */
+	if (!gdip_pango_same_text (lc, stringUnicode, length, font, fmt)) {
+		int original_length = length;
+
+		text = ucs2_to_utf8 (stringUnicode, length);
+		if (!text) {
+			if (fmt != format)
+				GdipDeleteStringFormat (fmt);
+			if (new_layout) {
+				g_object_unref (layout);
+				if (lc)
+					lc->layout = NULL;
+			} else {
+				/* the layout was changed, its text must be set again */
+				lc->length = -1;
+			}
+			return NULL;
 		}
 
-		if (font->style & FontStyleUnderline) {
-			PangoAttribute *attr = pango_attr_underline_new (PANGO_UNDERLINE_SINGLE);
-			attr->start_index = 0;
-			attr->end_index = length;
-			pango_attr_list_insert (list, attr);
+		/* unless specified we don't consider the trailing spaces, unless there is just one space (#80680) */
+		if ((fmt->formatFlags & StringFormatFlagsMeasureTrailingSpaces) == 0) {
+			while ((length > 0) && (isspace (*(text + length - 1))))
+				length--;
+			if (length == 0)
+				length = 1;
 		}
 
-		if (font->style & FontStyleStrikeout) {
-			PangoAttribute *attr = pango_attr_strikethrough_new (TRUE);
-			attr->start_index = 0;
-			attr->end_index = length;
-			pango_attr_list_insert (list, attr);
+		/* some stuff can only be done by manipulating the attributes (but we can avoid this most of the time) */
+		if ((fmt->formatFlags & StringFormatFlagsNoFontFallback) || (font->style & (FontStyleUnderline | FontStyleStrikeout))) {
+
+			list = pango_attr_list_new ();
+
+			/* StringFormatFlagsNoFontFallback */
+			if (fmt->formatFlags & StringFormatFlagsNoFontFallback) {
+				PangoAttribute *attr = pango_attr_fallback_new (FALSE);
+				attr->start_index = 0;
+				attr->end_index = length;
+				pango_attr_list_insert (list, attr);
+			}
+
+			if (font->style & FontStyleUnderline) {
+				PangoAttribute *attr = pango_attr_underline_new (PANGO_UNDERLINE_SINGLE);
+				attr->start_index = 0;
+				attr->end_index = length;
+				pango_attr_list_insert (list, attr);
+			}
+
+			if (font->style & FontStyleStrikeout) {
+				PangoAttribute *attr = pango_attr_strikethrough_new (TRUE);
+				attr->start_index = 0;
+				attr->end_index = length;
+				pango_attr_list_insert (list, attr);
+			}
 		}
-	}
 
-	switch (fmt->hotkeyPrefix) {
-	case HotkeyPrefixHide:
-		/* we need to remove any accelerator from the string */
-		gdip_process_accelerators (text, length, NULL);
-		break;
-	case HotkeyPrefixShow:
-		/* optimization: is seems that we never see the hotkey when using an underline font */
-		if (font->style & FontStyleUnderline) {
-			/* so don't bother drawing it (and simply add the '&' character) */
+		switch (fmt->hotkeyPrefix) {
+		case HotkeyPrefixHide:
+			/* we need to remove any accelerator from the string */
 			gdip_process_accelerators (text, length, NULL);
-		} else {
-			/* find accelerator and add attribute to the next character (unless it's the prefix too) */
-			if (!list)
-				list = gdip_get_layout_attributes (layout);
-			gdip_process_accelerators (text, length, list);
+			break;
+		case HotkeyPrefixShow:
+			/* optimization: is seems that we never see the hotkey when using an underline font */
+			if (font->style & FontStyleUnderline) {
+				/* so don't bother drawing it (and simply add the '&' character) */
+				gdip_process_accelerators (text, length, NULL);
+			} else {
+				/* find accelerator and add attribute to the next character (unless it's the prefix too) */
+				if (!list)
+					list = pango_attr_list_new ();
+				gdip_process_accelerators (text, length, list);
+			}
+			break;
+		default:
+			break;
 		}
-		break;
-	default:
-		break;
-	}
 
-	if (list) {
-		pango_layout_set_attributes (layout, list);
-		pango_attr_list_unref (list);
-	}
+		/* a reused layout may have attributes from a previous string */
+		if (list || !new_layout)
+			pango_layout_set_attributes (layout, list);
+		if (list)
+			pango_attr_list_unref (list);
 
-	pango_layout_set_text (layout, text, length);
-	GdipFree (text);
+		pango_layout_set_text (layout, text, length);
+		GdipFree (text);
+		if (lc)
+			gdip_pango_cache_text (lc, stringUnicode, original_length, font, fmt);
+	}
 
 	pango_layout_get_pixel_extents (layout, NULL, &logical);
 //g_warning ("\tlogical\t[x %d, y %d, w %d, h %d]", logical.x, logical.y, logical.width, logical.height);
@@ -287,6 +386,9 @@ gdip_pango_setup_layout (cairo_t *ct, GDIPCONST WCHAR *stringUnicode, int length
 
 	pango_cairo_update_layout (ct, layout);
 
+	/* the callers release the layout, the cache keeps its own reference */
+	if (lc)
+		g_object_ref (layout);
 	return layout;
 }
 
@@ -299,7 +401,7 @@ pango_DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int leng
 
 	cairo_save (graphics->ct);
 
-	layout = gdip_pango_setup_layout (graphics->ct, stringUnicode, length, font, rc, &box, format);
+	layout = gdip_pango_setup_layout (graphics->ct, stringUnicode, length, font, rc, &box, format, &graphics->text_layout);
 	if (!layout) {
 		cairo_restore (graphics->ct);
 		return OutOfMemory;
@@ -320,6 +422,44 @@ pango_DrawString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int leng
 	return Ok;
 }
 
+/* the brush is set once, each string still has its own clip and layout (reused between the strings) */
+GpStatus
+pango_DrawStrings (GpGraphics *graphics, GDIPCONST WCHAR **strings, GDIPCONST int *lengths, int count,
+	GDIPCONST GpFont *font, GDIPCONST RectF *rects, GDIPCONST GpStringFormat *format, GpBrush *brush)
+{
+	PangoLayout *layout;
+	GpStatus status = Ok;
+	RectF box;
+	int i;
+
+	cairo_save (graphics->ct);
+
+	if (brush) {
+		gdip_brush_setup (graphics, brush);
+	} else {
+		cairo_set_source_rgb (graphics->ct, 0., 0., 0.);
+	}
+
+	for (i = 0; (i < count) && (status == Ok); i++) {
+		if (lengths [i] == 0)
+			continue;
+
+		cairo_save (graphics->ct);
+		layout = gdip_pango_setup_layout (graphics->ct, strings [i], lengths [i], font, &rects [i], &box, format, &graphics->text_layout);
+		if (layout) {
+			gdip_cairo_move_to (graphics, box.X, box.Y, FALSE, TRUE);
+			pango_cairo_show_layout (graphics->ct, layout);
+			g_object_unref (layout);
+		} else {
+			status = OutOfMemory;
+		}
+		cairo_restore (graphics->ct);
+	}
+
+	cairo_restore (graphics->ct);
+	return status;
+}
+
 GpStatus
 pango_MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int length, GDIPCONST GpFont *font, GDIPCONST RectF *rc,
 	GDIPCONST GpStringFormat *format, RectF *boundingBox, int *codepointsFitted, int *linesFilled)
@@ -328,7 +468,7 @@ pango_MeasureString (GpGraphics *graphics, GDIPCONST WCHAR *stringUnicode, int l
 
 	cairo_save (graphics->ct);
 
-	layout = gdip_pango_setup_layout (graphics->ct, stringUnicode, length, font, rc, boundingBox, format);
+	layout = gdip_pango_setup_layout (graphics->ct, stringUnicode, length, font, rc, boundingBox, format, &graphics->text_layout);
 	if (!layout) {
 		cairo_restore (graphics->ct);
 		return OutOfMemory;
@@ -361,7 +501,7 @@ pango_MeasureCharacterRanges (GpGraphics *graphics, GDIPCONST WCHAR *stringUnico
 
 	cairo_save (graphics->ct);
 
-	layout = gdip_pango_setup_layout (graphics->ct, stringUnicode, length, font, layoutRect, &boundingBox, format);
+	layout = gdip_pango_setup_layout (graphics->ct, stringUnicode, length, font, layoutRect, &boundingBox, format, &graphics->text_layout);
 	if (!layout) {
 		cairo_restore (graphics->ct);
 		return OutOfMemory;
@@ -412,6 +552,7 @@ pango_MeasureCharacterRanges (GpGraphics *graphics, GDIPCONST WCHAR *stringUnico
 	}
 
 cleanup:
+	g_object_unref (layout);
 	cairo_restore (graphics->ct);
 	return status;
 }
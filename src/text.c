@@ -34,6 +34,7 @@
 #endif
 
 #include "text-metafile-private.h"
+#include "glyph-cache.h"
 
 /*
  * Text API - validate and delegate
@@ -69,6 +70,72 @@ GdipDrawString (GpGraphics *graphics, GDIPCONST WCHAR *string, int length, GDIPC
 	}
 }
 
+/*
+ * GdipDrawStrings:
+ *
+ * libgdiplus extension. Draw many strings, each in its own layout rectangle, with
+ * the same font, format and brush. A NULL lengths array, or a length of -1, means
+ * the string is null-terminated, any other negative length is invalid. Like for
+ * GdipDrawString an empty rectangle only gives the origin of the string.
+ */
+GpStatus
+GdipDrawStrings (GpGraphics *graphics, GDIPCONST WCHAR **strings, GDIPCONST INT *lengths, INT count,
+	GDIPCONST GpFont *font, GDIPCONST RectF *layoutRects, GDIPCONST GpStringFormat *stringFormat, GpBrush *brush)
+{
+	GpStatus status;
+	int *sizes;
+	int i;
+
+	if (!graphics || !strings || !font || !layoutRects || (count < 0))
+		return InvalidParameter;
+
+	if (count == 0)
+		return Ok;
+
+	sizes = (int *) GdipAlloc (count * sizeof (int));
+	if (!sizes)
+		return OutOfMemory;
+
+	for (i = 0; i < count; i++) {
+		sizes [i] = lengths ? lengths [i] : -1;
+		if (sizes [i] < -1) {
+			GdipFree (sizes);
+			return InvalidParameter;
+		} else if (sizes [i] == -1) {
+			GDIPCONST WCHAR *ptr = strings [i];
+
+			sizes [i] = 0;
+			while (ptr && (*ptr != 0)) {
+				sizes [i]++;
+				ptr++;
+			}
+		}
+		if ((sizes [i] > 0) && !strings [i]) {
+			GdipFree (sizes);
+			return InvalidParameter;
+		}
+	}
+
+	switch (graphics->backend) {
+	case GraphicsBackEndCairo:
+		status = text_DrawStrings (graphics, strings, sizes, count, font, layoutRects, stringFormat, brush);
+		break;
+	case GraphicsBackEndMetafile:
+		status = Ok;
+		for (i = 0; (i < count) && (status == Ok); i++) {
+			if (sizes [i] > 0)
+				status = metafile_DrawString (graphics, strings [i], sizes [i], font, &layoutRects [i], stringFormat, brush);
+		}
+		break;
+	default:
+		status = GenericError;
+		break;
+	}
+
+	GdipFree (sizes);
+	return status;
+}
+
 GpStatus
 GdipMeasureString (GpGraphics *graphics, GDIPCONST WCHAR *string, int length, GDIPCONST GpFont *font, GDIPCONST RectF *layoutRect,
 	GDIPCONST GpStringFormat *stringFormat, RectF *boundingBox, int *codepointsFitted, int *linesFilled)
@@ -145,3 +212,26 @@ GdipMeasureCharacterRanges (GpGraphics *graphics, GDIPCONST WCHAR *string, int l
 		return GenericError;
 	}
 }
+
+/*
+ * GdipGetGlyphCacheStatistics:
+ *
+ * libgdiplus extension. Return the number of glyph outlines (used by
+ * GdipAddPathString) found in the cache and extracted on a miss, the same for
+ * the character advances (used to measure and draw strings), and the memory
+ * used by the cached faces, outlines and advances. The Pango backend has no
+ * such cache and returns NotImplemented.
+ */
+GpStatus
+GdipGetGlyphCacheStatistics (INT *outlineHits, INT *outlineMisses, INT *advanceHits, INT *advanceMisses, INT *bytes)
+{
+	if (!outlineHits || !outlineMisses || !advanceHits || !advanceMisses || !bytes)
+		return InvalidParameter;
+
+#ifdef USE_PANGO_RENDERING
+	return NotImplemented;
+#else
+	gdip_glyph_cache_get_stats (outlineHits, outlineMisses, advanceHits, advanceMisses, bytes);
+	return Ok;
+#endif
+}
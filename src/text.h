@@ -31,6 +31,9 @@
 GpStatus GdipDrawString (GpGraphics *graphics, GDIPCONST WCHAR *string, int length, GDIPCONST GpFont *font, 
 	GDIPCONST RectF *layoutRect, GDIPCONST GpStringFormat *stringFormat, GpBrush *brush);
 
+GpStatus GdipDrawStrings (GpGraphics *graphics, GDIPCONST WCHAR **strings, GDIPCONST INT *lengths, INT count,
+	GDIPCONST GpFont *font, GDIPCONST RectF *layoutRects, GDIPCONST GpStringFormat *stringFormat, GpBrush *brush);
+
 GpStatus GdipMeasureString (GpGraphics *graphics, GDIPCONST WCHAR *string, int length, GDIPCONST GpFont *font, 
 	GDIPCONST RectF *layoutRect, GDIPCONST GpStringFormat *stringFormat,  RectF *boundingBox, int *codepointsFitted,
 	int *linesFilled);
@@ -38,6 +41,8 @@ GpStatus GdipMeasureString (GpGraphics *graphics, GDIPCONST WCHAR *string, int l
 GpStatus GdipMeasureCharacterRanges (GpGraphics *graphics, GDIPCONST WCHAR *string, int length, GDIPCONST GpFont *font, 
 	GDIPCONST GpRectF *layoutRect, GDIPCONST GpStringFormat *stringFormat, int regionCount, GpRegion **regions);
 
+GpStatus GdipGetGlyphCacheStatistics (INT *outlineHits, INT *outlineMisses, INT *advanceHits, INT *advanceMisses, INT *bytes);
+
 /* missing API
 	GdipDrawDriverString
 	GdipMeasureDriverString
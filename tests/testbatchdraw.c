@@ -0,0 +1,271 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "testhelpers.h"
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/* a grid of small polygons, like the shapes of a map */
+#define WIDTH		500
+#define HEIGHT		500
+#define CELL		2
+#define ITEMS		((WIDTH / CELL) * (HEIGHT / CELL))
+#define COLORS		4
+
+static const ARGB colors[COLORS] = { 0xffff0000, 0xff00ff00, 0xff0000ff, 0xff808080 };
+
+static GpBitmap *
+create_bitmap (BYTE *scan0, GpGraphics **graphics)
+{
+	GpBitmap *bitmap;
+
+	memset (scan0, 0, WIDTH * HEIGHT * 4);
+	C (GdipCreateBitmapFromScan0 (WIDTH, HEIGHT, WIDTH * 4, PixelFormat32bppARGB, scan0, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, graphics));
+	return bitmap;
+}
+
+static void
+test_batch_draw ()
+{
+	BYTE *scan0 = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	BYTE *batched = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	GpPath **paths = (GpPath **) malloc (ITEMS * sizeof (GpPath *));
+	GpRectF *rects = (GpRectF *) malloc (ITEMS * sizeof (GpRectF));
+	ARGB *argb = (ARGB *) malloc (ITEMS * sizeof (ARGB));
+	GpSolidFill *brush;
+	GpGraphics *graphics;
+	GpBitmap *bitmap;
+	clock_t start;
+	int i;
+
+	assert (scan0 && batched && paths && rects && argb);
+	for (i = 0; i < ITEMS; i++) {
+		float x = (float) ((i % (WIDTH / CELL)) * CELL);
+		float y = (float) ((i / (WIDTH / CELL)) * CELL);
+		GpPointF triangle[3];
+
+		triangle[0].X = x;
+		triangle[0].Y = y;
+		triangle[1].X = x + CELL;
+		triangle[1].Y = y;
+		triangle[2].X = x;
+		triangle[2].Y = y + CELL;
+		C (GdipCreatePath (FillModeAlternate, &paths[i]));
+		C (GdipAddPathPolygon (paths[i], triangle, 3));
+
+		/* overlapping rectangles, the stacking order matters */
+		rects[i].X = x;
+		rects[i].Y = y;
+		rects[i].Width = CELL * 3;
+		rects[i].Height = CELL * 2;
+		argb[i] = colors[(i * 7) % COLORS];
+	}
+	C (GdipCreateSolidFill (colors[0], &brush));
+
+	/* paths, one call each */
+	bitmap = create_bitmap (scan0, &graphics);
+	start = clock ();
+	for (i = 0; i < ITEMS; i++)
+		C (GdipFillPath (graphics, (GpBrush *) brush, paths[i]));
+	report_timing ("GdipFillPath x %d: %.1f ms\n", ITEMS, elapsed (start));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	memcpy (batched, scan0, WIDTH * HEIGHT * 4);
+	/* the corner pixel of a cell is inside its triangle, the opposite one isn't */
+	assert (((ARGB *) batched)[0] == colors[0]);
+	assert (((ARGB *) batched)[(CELL - 1) * WIDTH + CELL - 1] == 0);
+
+#ifndef WIN32
+	/* the same paths at once, the (non overlapping) result must be the same */
+	bitmap = create_bitmap (scan0, &graphics);
+	start = clock ();
+	C (GdipFillPaths (graphics, (GpBrush *) brush, paths, ITEMS));
+	report_timing ("GdipFillPaths (%d paths): %.1f ms\n", ITEMS, elapsed (start));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	assert (memcmp (batched, scan0, WIDTH * HEIGHT * 4) == 0);
+#endif
+
+	/* rectangles, one call (and brush) each */
+	bitmap = create_bitmap (scan0, &graphics);
+	start = clock ();
+	for (i = 0; i < ITEMS; i++) {
+		C (GdipSetSolidFillColor (brush, argb[i]));
+		C (GdipFillRectangle (graphics, (GpBrush *) brush, rects[i].X, rects[i].Y, rects[i].Width, rects[i].Height));
+	}
+	report_timing ("GdipFillRectangle x %d: %.1f ms\n", ITEMS, elapsed (start));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	memcpy (batched, scan0, WIDTH * HEIGHT * 4);
+	/* the last rectangle is on top */
+	assert (((ARGB *) batched)[WIDTH * HEIGHT - 1] == argb[ITEMS - 1]);
+
+#ifndef WIN32
+	/* the same rectangles at once, the stacking order must be kept */
+	bitmap = create_bitmap (scan0, &graphics);
+	start = clock ();
+	C (GdipFillRectanglesARGB (graphics, rects, argb, ITEMS));
+	report_timing ("GdipFillRectanglesARGB (%d rectangles): %.1f ms\n", ITEMS, elapsed (start));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	assert (memcmp (batched, scan0, WIDTH * HEIGHT * 4) == 0);
+#endif
+
+	C (GdipDeleteBrush ((GpBrush *) brush));
+	for (i = 0; i < ITEMS; i++)
+		C (GdipDeletePath (paths[i]));
+	free (argb);
+	free (rects);
+	free (paths);
+	free (batched);
+	free (scan0);
+}
+
+#ifndef WIN32
+static void
+test_batch_overlaps ()
+{
+	BYTE *scan0 = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	BYTE *separate = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	GpPointF square[4] = { {10, 10}, {110, 10}, {110, 110}, {10, 110} };
+	GpPointF reversed[4] = { {60, 160}, {60, 60}, {160, 60}, {160, 160} };
+	GpRectF rects[4] = { {200, 10, 100, 100}, {250, 60, 100, 100}, {260, 70, 20, 20}, {300, 110, 100, 100} };
+	ARGB argb[4] = { 0x80ff0000, 0x80ff0000, 0xc00000ff, 0x80ff0000 };
+	GpRectF ellipses[2] = { {10, 300, 100, 100}, {160, 450, -100, -100} };
+	ARGB ellipse_colors[2] = { 0xff00ff00, 0xff00ff00 };
+	/* opaque items of one color, with seams inside a pixel and gaps of more than a pixel */
+	GpRectF seams[4] = { {10.5, 200, 20.25, 20}, {30.75, 200, 20, 20}, {60.25, 200.5, 20, 20}, {10.5, 220.4, 20, 20} };
+	ARGB seam_colors[4] = { 0xff0000ff, 0xff0000ff, 0xff0000ff, 0xff0000ff };
+	GpPath *paths[3];
+	GpSolidFill *brush;
+	GpPen *pen;
+	GpGraphics *graphics;
+	GpBitmap *bitmap;
+	int i;
+
+	assert (scan0 && separate);
+
+	/* overlapping paths are filled one after the other, neither combined by the fill mode nor painted once */
+	C (GdipCreatePath (FillModeAlternate, &paths[0]));
+	C (GdipAddPathPolygon (paths[0], square, 4));
+	C (GdipCreatePath (FillModeAlternate, &paths[1]));
+	C (GdipAddPathPolygon (paths[1], reversed, 4));
+	C (GdipCreatePath (FillModeWinding, &paths[2]));
+	C (GdipAddPathPolygon (paths[2], square, 4));
+	C (GdipCreateSolidFill (0x80ff0000, &brush));
+
+	bitmap = create_bitmap (scan0, &graphics);
+	for (i = 0; i < 3; i++)
+		C (GdipFillPath (graphics, (GpBrush *) brush, paths[i]));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	memcpy (separate, scan0, WIDTH * HEIGHT * 4);
+
+	bitmap = create_bitmap (scan0, &graphics);
+	C (GdipFillPaths (graphics, (GpBrush *) brush, paths, 3));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	assert (memcmp (separate, scan0, WIDTH * HEIGHT * 4) == 0);
+
+	/* a translucent pen paints the areas where the paths overlap twice too */
+	C (GdipCreatePen1 (0x80ff0000, 6, UnitPixel, &pen));
+	bitmap = create_bitmap (scan0, &graphics);
+	for (i = 0; i < 3; i++)
+		C (GdipDrawPath (graphics, pen, paths[i]));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	memcpy (separate, scan0, WIDTH * HEIGHT * 4);
+
+	bitmap = create_bitmap (scan0, &graphics);
+	C (GdipDrawPaths (graphics, pen, paths, 3));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	assert (memcmp (separate, scan0, WIDTH * HEIGHT * 4) == 0);
+	C (GdipDeletePen (pen));
+
+	/* translucent rectangles of the same color are painted twice where they overlap */
+	bitmap = create_bitmap (scan0, &graphics);
+	for (i = 0; i < 4; i++) {
+		C (GdipSetSolidFillColor (brush, argb[i]));
+		C (GdipFillRectangle (graphics, (GpBrush *) brush, rects[i].X, rects[i].Y, rects[i].Width, rects[i].Height));
+	}
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	memcpy (separate, scan0, WIDTH * HEIGHT * 4);
+
+	bitmap = create_bitmap (scan0, &graphics);
+	C (GdipFillRectanglesARGB (graphics, rects, argb, 4));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	assert (memcmp (separate, scan0, WIDTH * HEIGHT * 4) == 0);
+
+	/* with antialiasing, the edges of the items blend like separate fills do */
+	bitmap = create_bitmap (scan0, &graphics);
+	C (GdipSetSmoothingMode (graphics, SmoothingModeAntiAlias));
+	for (i = 0; i < 4; i++) {
+		C (GdipSetSolidFillColor (brush, seam_colors[i]));
+		C (GdipFillRectangle (graphics, (GpBrush *) brush, seams[i].X, seams[i].Y, seams[i].Width, seams[i].Height));
+		C (GdipFillEllipse (graphics, (GpBrush *) brush, seams[i].X + 200, seams[i].Y, seams[i].Width, seams[i].Height));
+	}
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	memcpy (separate, scan0, WIDTH * HEIGHT * 4);
+
+	bitmap = create_bitmap (scan0, &graphics);
+	C (GdipSetSmoothingMode (graphics, SmoothingModeAntiAlias));
+	C (GdipFillRectanglesARGB (graphics, seams, seam_colors, 4));
+	for (i = 0; i < 4; i++)
+		seams[i].X += 200;
+	C (GdipFillEllipsesARGB (graphics, seams, seam_colors, 4));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	assert (memcmp (separate, scan0, WIDTH * HEIGHT * 4) == 0);
+
+	/* an ellipse with a negative size doesn't cancel the overlapping one */
+	bitmap = create_bitmap (scan0, &graphics);
+	C (GdipFillEllipsesARGB (graphics, ellipses, ellipse_colors, 2));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	assert (((ARGB *) scan0)[375 * WIDTH + 85] == 0xff00ff00);
+
+	C (GdipDeleteBrush ((GpBrush *) brush));
+	for (i = 0; i < 3; i++)
+		C (GdipDeletePath (paths[i]));
+	free (separate);
+	free (scan0);
+}
+#endif
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_batch_draw ();
+#ifndef WIN32
+	test_batch_overlaps ();
+#endif
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
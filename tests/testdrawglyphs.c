@@ -0,0 +1,157 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+#define WIDTH		200
+#define HEIGHT		200
+
+/* the antialiased edges of a glyph may spill a bit out of its cell */
+#define MARGIN		2
+#define FAINT		0x40
+#define INKED		0x80
+
+/* "HH HH HH HH", one word per line in a narrow rectangle */
+static const WCHAR text[] = { 'H', 'H', ' ', 'H', 'H', ' ', 'H', 'H', ' ', 'H', 'H' };
+#define LENGTH		(int) (sizeof (text) / sizeof (WCHAR))
+#define WORDS		4
+
+static BOOL
+in_rect (GpRectF *rect, int x, int y, int margin)
+{
+	return (x >= rect->X - margin) && (x < rect->X + rect->Width + margin) &&
+		(y >= rect->Y - margin) && (y < rect->Y + rect->Height + margin);
+}
+
+/* draw the text and check the glyphs are where their characters were measured */
+static void
+check_glyphs (GpFont *font, StringAlignment align, float dx, float dy)
+{
+	BYTE *scan0 = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	CharacterRange ranges[WORDS];
+	GpRegion *regions[WORDS];
+	GpRectF words[WORDS];
+	GpStringFormat *format;
+	GpSolidFill *brush;
+	GpGraphics *graphics;
+	GpBitmap *bitmap;
+	RectF layout;
+	int i, x, y;
+
+	assert (scan0);
+	memset (scan0, 0, WIDTH * HEIGHT * 4);
+	C (GdipCreateBitmapFromScan0 (WIDTH, HEIGHT, WIDTH * 4, PixelFormat32bppARGB, scan0, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, &graphics));
+	C (GdipTranslateWorldTransform (graphics, dx, dy, MatrixOrderAppend));
+	C (GdipCreateSolidFill (0xff000000, &brush));
+	C (GdipCreateStringFormat (0, 0, &format));
+	C (GdipSetStringFormatAlign (format, align));
+
+	for (i = 0; i < WORDS; i++) {
+		ranges[i].First = i * 3;
+		ranges[i].Length = 2;
+		C (GdipCreateRegion (&regions[i]));
+	}
+
+	/* a bit more than a word wide, so each word is on its own line */
+	layout.X = 10;
+	layout.Y = 10;
+	layout.Width = 0;
+	layout.Height = 0;
+	C (GdipSetStringFormatMeasurableCharacterRanges (format, 1, ranges));
+	C (GdipMeasureCharacterRanges (graphics, text, 2, font, &layout, format, 1, regions));
+	C (GdipGetRegionBounds (regions[0], graphics, &words[0]));
+	layout.Width = words[0].Width * 1.5f;
+	layout.Height = HEIGHT - 20 - dy;
+
+	C (GdipSetStringFormatMeasurableCharacterRanges (format, WORDS, ranges));
+	C (GdipMeasureCharacterRanges (graphics, text, LENGTH, font, &layout, format, WORDS, regions));
+	for (i = 0; i < WORDS; i++) {
+		C (GdipGetRegionBounds (regions[i], graphics, &words[i]));
+		/* in pixels, the world transform moves the drawing */
+		words[i].X += dx;
+		words[i].Y += dy;
+		if (i > 0)
+			assert (words[i].Y > words[i - 1].Y);
+	}
+	C (GdipDrawString (graphics, text, LENGTH, font, &layout, format, (GpBrush *) brush));
+
+	/* every word is drawn in its cell, and nothing is drawn elsewhere */
+	for (i = 0; i < WORDS; i++) {
+		BOOL inked = FALSE;
+
+		for (y = 0; y < HEIGHT && !inked; y++) {
+			for (x = 0; x < WIDTH && !inked; x++)
+				inked = (scan0[(y * WIDTH + x) * 4 + 3] >= INKED) && in_rect (&words[i], x, y, 0);
+		}
+		assert (inked);
+	}
+	for (y = 0; y < HEIGHT; y++) {
+		for (x = 0; x < WIDTH; x++) {
+			BOOL inside = FALSE;
+
+			if (scan0[(y * WIDTH + x) * 4 + 3] < FAINT)
+				continue;
+			for (i = 0; i < WORDS && !inside; i++)
+				inside = in_rect (&words[i], x, y, MARGIN);
+			assert (inside);
+		}
+	}
+
+	for (i = 0; i < WORDS; i++)
+		C (GdipDeleteRegion (regions[i]));
+	C (GdipDeleteStringFormat (format));
+	C (GdipDeleteBrush ((GpBrush *) brush));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	free (scan0);
+}
+
+static void
+test_draw_glyphs ()
+{
+	GpFontFamily *family;
+	GpFont *font;
+
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipCreateFont (family, 16, FontStyleRegular, UnitPixel, &font));
+
+	check_glyphs (font, StringAlignmentNear, 0, 0);
+	check_glyphs (font, StringAlignmentCenter, 0, 0);
+	check_glyphs (font, StringAlignmentFar, 0, 0);
+	check_glyphs (font, StringAlignmentNear, 7, 3);
+	check_glyphs (font, StringAlignmentFar, 7, 3);
+
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+}
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_draw_glyphs ();
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
@@ -0,0 +1,193 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "testhelpers.h"
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/* a grid of short labels, like the ones of a map or a chart */
+#define WIDTH		800
+#define HEIGHT		600
+#define CELL_WIDTH	40
+#define CELL_HEIGHT	15
+#define LABELS		((WIDTH / CELL_WIDTH) * (HEIGHT / CELL_HEIGHT))
+#define FRAMES		10
+
+static GpBitmap *
+create_bitmap (BYTE *scan0, GpGraphics **graphics)
+{
+	GpBitmap *bitmap;
+
+	memset (scan0, 0, WIDTH * HEIGHT * 4);
+	C (GdipCreateBitmapFromScan0 (WIDTH, HEIGHT, WIDTH * 4, PixelFormat32bppARGB, scan0, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, graphics));
+	return bitmap;
+}
+
+/* draw the labels one call each, then at once, and check both give the same pixels */
+static void
+compare (const char *name, GDIPCONST WCHAR **labels, INT *lengths, GpRectF *rects, GpFont *font, GpBrush *brush)
+{
+	BYTE *scan0 = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	BYTE *single = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	GpGraphics *graphics;
+	GpBitmap *bitmap;
+	clock_t start;
+	int i, row, frame;
+
+	assert (scan0 && single);
+
+	bitmap = create_bitmap (scan0, &graphics);
+	start = clock ();
+	for (frame = 0; frame < FRAMES; frame++) {
+		for (i = 0; i < LABELS; i++)
+			C (GdipDrawString (graphics, labels[i], lengths[i], font, &rects[i], NULL, brush));
+	}
+	report_timing ("%s, GdipDrawString x %d: %.1f ms per frame\n", name, LABELS, elapsed (start) / FRAMES);
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	memcpy (single, scan0, WIDTH * HEIGHT * 4);
+
+	/* something was drawn in every row of labels */
+	for (row = 0; row < HEIGHT / CELL_HEIGHT; row++) {
+		ARGB *pixels = (ARGB *) (single + row * CELL_HEIGHT * WIDTH * 4);
+
+		for (i = 0; i < WIDTH * CELL_HEIGHT && pixels[i] == 0; i++)
+			;
+		assert (i < WIDTH * CELL_HEIGHT);
+	}
+
+#ifndef WIN32
+	bitmap = create_bitmap (scan0, &graphics);
+	start = clock ();
+	for (frame = 0; frame < FRAMES; frame++)
+		C (GdipDrawStrings (graphics, labels, lengths, LABELS, font, rects, NULL, brush));
+	report_timing ("%s, GdipDrawStrings (%d labels): %.1f ms per frame\n", name, LABELS, elapsed (start) / FRAMES);
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	assert (memcmp (single, scan0, WIDTH * HEIGHT * 4) == 0);
+#endif
+
+	free (single);
+	free (scan0);
+}
+
+static void
+test_draw_strings ()
+{
+	WCHAR **labels = (WCHAR **) malloc (LABELS * sizeof (WCHAR *));
+	INT *lengths = (INT *) malloc (LABELS * sizeof (INT));
+	GpRectF *rects = (GpRectF *) malloc (LABELS * sizeof (GpRectF));
+	GpFontFamily *family;
+	GpSolidFill *brush;
+	GpFont *font;
+	char text[16];
+	int i, j;
+
+	assert (labels && lengths && rects);
+	for (i = 0; i < LABELS; i++) {
+		sprintf (text, "P%d", i);
+		lengths[i] = (INT) strlen (text);
+		labels[i] = (WCHAR *) malloc ((lengths[i] + 1) * sizeof (WCHAR));
+		assert (labels[i]);
+		for (j = 0; j <= lengths[i]; j++)
+			labels[i][j] = (WCHAR) text[j];
+	}
+
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipCreateFont (family, 8, FontStyleRegular, UnitPixel, &font));
+	C (GdipCreateSolidFill (0xff000000, &brush));
+
+	/* labels drawn at a point, nothing is clipped */
+	for (i = 0; i < LABELS; i++) {
+		rects[i].X = (float) ((i % (WIDTH / CELL_WIDTH)) * CELL_WIDTH);
+		rects[i].Y = (float) ((i / (WIDTH / CELL_WIDTH)) * CELL_HEIGHT);
+		rects[i].Width = 0;
+		rects[i].Height = 0;
+	}
+	compare ("origins", (GDIPCONST WCHAR **) labels, lengths, rects, font, (GpBrush *) brush);
+
+	/* labels clipped to their cells */
+	for (i = 0; i < LABELS; i++) {
+		rects[i].Width = CELL_WIDTH / 2;
+		rects[i].Height = CELL_HEIGHT;
+	}
+	compare ("rectangles", (GDIPCONST WCHAR **) labels, lengths, rects, font, (GpBrush *) brush);
+
+	C (GdipDeleteBrush ((GpBrush *) brush));
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	for (i = 0; i < LABELS; i++)
+		free (labels[i]);
+	free (rects);
+	free (lengths);
+	free (labels);
+}
+
+#ifndef WIN32
+static void
+test_draw_strings_invalid_lengths ()
+{
+	WCHAR label[] = { 'P', '1', 0 };
+	GDIPCONST WCHAR *labels[2] = { label, label };
+	INT lengths[2] = { 2, -2 };
+	GpRectF rects[2] = { {0, 0, 0, 0}, {0, CELL_HEIGHT, 0, 0} };
+	BYTE *scan0 = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	GpFontFamily *family;
+	GpSolidFill *brush;
+	GpGraphics *graphics;
+	GpBitmap *bitmap;
+	GpFont *font;
+
+	assert (scan0);
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipCreateFont (family, 8, FontStyleRegular, UnitPixel, &font));
+	C (GdipCreateSolidFill (0xff000000, &brush));
+	bitmap = create_bitmap (scan0, &graphics);
+
+	/* only -1 means a null-terminated string */
+	assert (GdipDrawStrings (graphics, labels, lengths, 2, font, rects, NULL, (GpBrush *) brush) == InvalidParameter);
+	lengths[1] = -1;
+	C (GdipDrawStrings (graphics, labels, lengths, 2, font, rects, NULL, (GpBrush *) brush));
+
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	C (GdipDeleteBrush ((GpBrush *) brush));
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	free (scan0);
+}
+#endif
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_draw_strings ();
+#ifndef WIN32
+	test_draw_strings_invalid_lengths ();
+#endif
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
@@ -0,0 +1,335 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+#define WIDTH		120
+#define HEIGHT		40
+
+/* "Hamburgefonts" */
+static const WCHAR text[] = { 'H', 'a', 'm', 'b', 'u', 'r', 'g', 'e', 'f', 'o', 'n', 't', 's' };
+#define LENGTH		(int) (sizeof (text) / sizeof (WCHAR))
+
+/* draw the text with the font into scan0, and check something was drawn */
+static void
+draw_text (GpFont *font, BYTE *scan0)
+{
+	GpSolidFill *brush;
+	GpGraphics *graphics;
+	GpBitmap *bitmap;
+	RectF rect;
+	int i;
+
+	memset (scan0, 0, WIDTH * HEIGHT * 4);
+	C (GdipCreateBitmapFromScan0 (WIDTH, HEIGHT, WIDTH * 4, PixelFormat32bppARGB, scan0, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, &graphics));
+	C (GdipCreateSolidFill (0xff000000, &brush));
+	rect.X = 0;
+	rect.Y = 0;
+	rect.Width = 0;
+	rect.Height = 0;
+	C (GdipDrawString (graphics, text, LENGTH, font, &rect, NULL, (GpBrush *) brush));
+	C (GdipDeleteBrush ((GpBrush *) brush));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+
+	for (i = 0; i < WIDTH * HEIGHT && ((ARGB *) scan0)[i] == 0; i++)
+		;
+	assert (i < WIDTH * HEIGHT);
+}
+
+/* fonts created separately share their face, deleting one doesn't affect the others */
+static void
+test_shared_faces ()
+{
+	BYTE *first = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	BYTE *second = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	GpFontFamily *family, *clone;
+	GpFont *font, *other, *bold;
+
+	assert (first && second);
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipCloneFontFamily (family, &clone));
+
+	C (GdipCreateFont (family, 16, FontStyleRegular, UnitPixel, &font));
+	C (GdipCreateFont (clone, 16, FontStyleRegular, UnitPixel, &other));
+	draw_text (font, first);
+	draw_text (other, second);
+	assert (memcmp (first, second, WIDTH * HEIGHT * 4) == 0);
+
+	/* underline is drawn over the same face */
+	C (GdipDeleteFont (other));
+	C (GdipCreateFont (family, 16, FontStyleUnderline, UnitPixel, &other));
+	draw_text (other, second);
+	assert (memcmp (first, second, WIDTH * HEIGHT * 4) != 0);
+
+	/* a bold font is another face */
+	C (GdipCreateFont (family, 16, FontStyleBold, UnitPixel, &bold));
+	draw_text (bold, second);
+	assert (memcmp (first, second, WIDTH * HEIGHT * 4) != 0);
+
+	/* the remaining fonts keep their face */
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	C (GdipCreateFont (clone, 16, FontStyleRegular, UnitPixel, &font));
+	draw_text (font, second);
+	assert (memcmp (first, second, WIDTH * HEIGHT * 4) == 0);
+	draw_text (bold, second);
+
+	C (GdipDeleteFont (bold));
+	C (GdipDeleteFont (other));
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (clone));
+	free (second);
+	free (first);
+}
+
+#define STYLES		4
+
+static const int styles[STYLES] = { FontStyleRegular, FontStyleBold, FontStyleItalic, FontStyleBold | FontStyleItalic };
+
+typedef struct {
+	WORD	em_height;
+	WORD	ascent;
+	WORD	descent;
+	WORD	line_spacing;
+} Metrics;
+
+static void
+get_metrics (GpFontFamily *family, int style, Metrics *metrics)
+{
+	C (GdipGetEmHeight (family, style, &metrics->em_height));
+	C (GdipGetCellAscent (family, style, &metrics->ascent));
+	C (GdipGetCellDescent (family, style, &metrics->descent));
+	C (GdipGetLineSpacing (family, style, &metrics->line_spacing));
+	assert (metrics->em_height > 0);
+	assert (metrics->ascent > 0);
+	assert (metrics->line_spacing > 0);
+}
+
+/* each style has its own metrics, whatever the order they are read in and whichever object reads them */
+static void
+check_family_styles (GpFontFamily *family, GpFontCollection *collection)
+{
+	Metrics forward[STYLES], backward[STYLES], again;
+	WCHAR name[LF_FACESIZE];
+	GpFontFamily *other;
+	GpFont *font;
+	float height;
+	int i;
+
+	C (GdipGetFamilyName (family, name, 0));
+	for (i = 0; i < STYLES; i++)
+		get_metrics (family, styles[i], &forward[i]);
+
+	C (GdipCreateFontFamilyFromName (name, collection, &other));
+	for (i = STYLES - 1; i >= 0; i--)
+		get_metrics (other, styles[i], &backward[i]);
+	C (GdipDeleteFontFamily (other));
+
+	C (GdipCloneFontFamily (family, &other));
+	for (i = 0; i < STYLES; i++) {
+		assert (memcmp (&forward[i], &backward[i], sizeof (Metrics)) == 0);
+		get_metrics (other, styles[i], &again);
+		assert (memcmp (&forward[i], &again, sizeof (Metrics)) == 0);
+		get_metrics (family, styles[i], &again);
+		assert (memcmp (&forward[i], &again, sizeof (Metrics)) == 0);
+
+		/* the font height is the line spacing, scaled to the font size */
+		C (GdipCreateFont (family, 16, styles[i], UnitPixel, &font));
+		C (GdipGetFontHeightGivenDPI (font, 96, &height));
+		assert (height > 0);
+		assert (height - 16.0f * forward[i].line_spacing / forward[i].em_height < 0.01f);
+		assert (16.0f * forward[i].line_spacing / forward[i].em_height - height < 0.01f);
+		C (GdipDeleteFont (font));
+	}
+	C (GdipDeleteFontFamily (other));
+}
+
+static void
+test_family_styles ()
+{
+	GpFontFamily *family;
+
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	check_family_styles (family, NULL);
+	C (GdipDeleteFontFamily (family));
+
+	C (GdipGetGenericFontFamilySerif (&family));
+	check_family_styles (family, NULL);
+	C (GdipDeleteFontFamily (family));
+}
+
+#ifndef WIN32
+static const char *font_files[] = {
+	"/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+	"/usr/share/fonts/dejavu/DejaVuSans.ttf",
+	"/usr/share/fonts/TTF/DejaVuSans.ttf",
+	"/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
+	"/usr/share/fonts/liberation/LiberationSans-Regular.ttf",
+	"/usr/share/fonts/TTF/LiberationSans-Regular.ttf",
+	NULL
+};
+
+/* the content of the first font file found, or NULL */
+static BYTE *
+read_font_file (int *length)
+{
+	BYTE *data;
+	FILE *file = NULL;
+	int i;
+
+	for (i = 0; font_files[i] && !file; i++)
+		file = fopen (font_files[i], "rb");
+	if (!file)
+		return NULL;
+
+	fseek (file, 0, SEEK_END);
+	*length = (int) ftell (file);
+	fseek (file, 0, SEEK_SET);
+	data = (BYTE *) malloc (*length);
+	assert (data);
+	assert (fread (data, 1, *length, file) == (size_t) *length);
+	fclose (file);
+	return data;
+}
+
+/* a private collection with a copy of the font, the copy is freed once added */
+static GpFontCollection *
+add_memory_font (const BYTE *data, int length)
+{
+	GpFontCollection *collection = NULL;
+	BYTE *copy = (BYTE *) malloc (length);
+	int count;
+
+	assert (copy);
+	memcpy (copy, data, length);
+	C (GdipNewPrivateFontCollection (&collection));
+	C (GdipPrivateAddMemoryFont (collection, copy, length));
+	memset (copy, 0, length);
+	free (copy);
+
+	C (GdipGetFontCollectionFamilyCount (collection, &count));
+	assert (count == 1);
+	return collection;
+}
+
+static GpFontFamily *
+get_memory_family (GpFontCollection *collection)
+{
+	GpFontFamily *family = NULL;
+	int found;
+
+	C (GdipGetFontCollectionFamilyList (collection, 1, &family, &found));
+	assert (found == 1);
+	return family;
+}
+
+/* the same font added to several collections, which are deleted while their fonts are in use */
+static void
+test_memory_fonts ()
+{
+	BYTE *first = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	BYTE *second = (BYTE *) malloc (WIDTH * HEIGHT * 4);
+	GpFontCollection *collection, *other;
+	GpFontFamily *family, *other_family, *clone;
+	WCHAR name[LF_FACESIZE], other_name[LF_FACESIZE];
+	GpFont *font, *other_font;
+	BYTE *data;
+	int length;
+
+	data = read_font_file (&length);
+	if (!data) {
+		printf ("test_memory_fonts: no font file found, skipped\n");
+		free (second);
+		free (first);
+		return;
+	}
+	assert (first && second);
+
+	collection = add_memory_font (data, length);
+	other = add_memory_font (data, length);
+	family = get_memory_family (collection);
+	other_family = get_memory_family (other);
+	C (GdipGetFamilyName (family, name, 0));
+	C (GdipGetFamilyName (other_family, other_name, 0));
+	assert (memcmp (name, other_name, sizeof (name)) == 0);
+
+	C (GdipCreateFont (family, 16, FontStyleRegular, UnitPixel, &font));
+	C (GdipCreateFont (other_family, 16, FontStyleRegular, UnitPixel, &other_font));
+	draw_text (font, first);
+	draw_text (other_font, second);
+	assert (memcmp (first, second, WIDTH * HEIGHT * 4) == 0);
+	check_family_styles (family, collection);
+
+	/* the other collection still has the font, the listed families don't outlive their collection */
+	C (GdipCloneFontFamily (other_family, &clone));
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	C (GdipDeletePrivateFontCollection (&collection));
+	draw_text (other_font, second);
+	assert (memcmp (first, second, WIDTH * HEIGHT * 4) == 0);
+	C (GdipCreateFont (clone, 16, FontStyleRegular, UnitPixel, &font));
+	draw_text (font, second);
+	assert (memcmp (first, second, WIDTH * HEIGHT * 4) == 0);
+	check_family_styles (clone, other);
+	C (GdipDeleteFont (font));
+
+	/* the fonts created before the last collection is deleted can still be used */
+	C (GdipDeleteFontFamily (other_family));
+	C (GdipDeletePrivateFontCollection (&other));
+	draw_text (other_font, second);
+	C (GdipDeleteFont (other_font));
+	C (GdipDeleteFontFamily (clone));
+
+	/* once released, the font can be added again */
+	collection = add_memory_font (data, length);
+	family = get_memory_family (collection);
+	C (GdipGetFamilyName (family, other_name, 0));
+	assert (memcmp (name, other_name, sizeof (name)) == 0);
+	C (GdipCreateFont (family, 16, FontStyleRegular, UnitPixel, &font));
+	draw_text (font, second);
+	assert (memcmp (first, second, WIDTH * HEIGHT * 4) == 0);
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	C (GdipDeletePrivateFontCollection (&collection));
+
+	free (data);
+	free (second);
+	free (first);
+}
+#endif
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_shared_faces ();
+	test_family_styles ();
+#ifndef WIN32
+	test_memory_fonts ();
+#endif
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef __TESTHELPERS_H__
+#define __TESTHELPERS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+
+/* milliseconds of processor time since start */
+static double
+elapsed (clock_t start)
+{
+	return (double) (clock () - start) * 1000 / CLOCKS_PER_SEC;
+}
+
+/* the tests check results, their times are only printed when GDIPLUS_TEST_TIMINGS is set */
+static void
+report_timing (const char *format, ...)
+{
+	va_list args;
+
+	if (!getenv ("GDIPLUS_TEST_TIMINGS"))
+		return;
+
+	va_start (args, format);
+	vprintf (format, args);
+	va_end (args);
+}
+
+#endif
@@ -0,0 +1,217 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/* "one two three four five six", wrapped on many lines in a narrow rectangle */
+static const WCHAR text[] = { 'o', 'n', 'e', ' ', 't', 'w', 'o', ' ', 't', 'h', 'r', 'e', 'e', ' ',
+	'f', 'o', 'u', 'r', ' ', 'f', 'i', 'v', 'e', ' ', 's', 'i', 'x' };
+#define LENGTH		(int) (sizeof (text) / sizeof (WCHAR))
+
+/* "a<tab>b" */
+static const WCHAR tabbed[] = { 'a', '\t', 'b' };
+
+static GpGraphics *graphics;
+static GpFontFamily *family;
+
+static void
+measure (const WCHAR *string, int length, GpFont *font, float width, GpStringFormat *format, RectF *bounds, int *lines)
+{
+	RectF rect;
+	int fitted;
+
+	rect.X = 0;
+	rect.Y = 0;
+	rect.Width = width;
+	rect.Height = 0;
+	C (GdipMeasureString (graphics, string, length, font, &rect, format, bounds, &fitted, lines));
+}
+
+/* the left of the first character, the bounds of GdipMeasureString always start at the rectangle */
+static float
+first_char_left (const WCHAR *string, int length, GpFont *font, float width, GpStringFormat *format)
+{
+	CharacterRange range;
+	GpRegion *region;
+	RectF rect, bounds;
+
+	range.First = 0;
+	range.Length = 1;
+	C (GdipSetStringFormatMeasurableCharacterRanges (format, 1, &range));
+	rect.X = 0;
+	rect.Y = 0;
+	rect.Width = width;
+	rect.Height = 0;
+	C (GdipCreateRegion (&region));
+	C (GdipMeasureCharacterRanges (graphics, string, length, font, &rect, format, 1, &region));
+	C (GdipGetRegionBounds (region, graphics, &bounds));
+	C (GdipDeleteRegion (region));
+	return bounds.X;
+}
+
+/* the same measure twice gives the same result, whether it was cached or not */
+static void
+measure_twice (const WCHAR *string, int length, GpFont *font, float width, GpStringFormat *format, RectF *bounds, int *lines)
+{
+	RectF again;
+	int lines_again;
+
+	measure (string, length, font, width, format, bounds, lines);
+	measure (string, length, font, width, format, &again, &lines_again);
+	assert (memcmp (bounds, &again, sizeof (RectF)) == 0);
+	assert (*lines == lines_again);
+}
+
+static void
+test_layout_rect ()
+{
+	GpStringFormat *format;
+	GpFont *font;
+	RectF wide, narrow;
+	int wide_lines, narrow_lines;
+
+	C (GdipCreateFont (family, 12, FontStyleRegular, UnitPixel, &font));
+	C (GdipCreateStringFormat (0, 0, &format));
+
+	measure_twice (text, LENGTH, font, 1000, format, &wide, &wide_lines);
+	assert (wide.Width > 0);
+	assert (wide_lines == 1);
+	measure_twice (text, LENGTH, font, wide.Width / 3, format, &narrow, &narrow_lines);
+	assert (narrow_lines > 2);
+	assert (narrow.Height > wide.Height);
+
+	/* back to the first rectangle */
+	measure_twice (text, LENGTH, font, 1000, format, &narrow, &narrow_lines);
+	assert (narrow_lines == 1);
+	assert (memcmp (&wide, &narrow, sizeof (RectF)) == 0);
+
+	C (GdipDeleteStringFormat (format));
+	C (GdipDeleteFont (font));
+}
+
+/* the format is changed in place, the cache must notice it */
+static void
+test_format_changes ()
+{
+	GpStringFormat *format;
+	GpFont *font;
+	RectF bounds, changed;
+	REAL stops[1];
+	float left;
+	int lines, changed_lines;
+
+	C (GdipCreateFont (family, 12, FontStyleRegular, UnitPixel, &font));
+	C (GdipCreateStringFormat (0, 0, &format));
+
+	measure_twice (text, LENGTH, font, 1000, format, &bounds, &lines);
+	measure_twice (text, LENGTH, font, bounds.Width / 3, format, &bounds, &lines);
+	assert (lines > 2);
+
+	C (GdipSetStringFormatFlags (format, StringFormatFlagsNoWrap));
+	measure_twice (text, LENGTH, font, bounds.Width, format, &changed, &changed_lines);
+	assert (changed_lines == 1);
+	C (GdipSetStringFormatFlags (format, 0));
+
+	/* centered in a wide rectangle, the text no longer starts on the left */
+	left = first_char_left (text, LENGTH, font, 1000, format);
+	C (GdipSetStringFormatAlign (format, StringAlignmentCenter));
+	assert (first_char_left (text, LENGTH, font, 1000, format) > left + 100);
+	C (GdipSetStringFormatAlign (format, StringAlignmentNear));
+	assert (first_char_left (text, LENGTH, font, 1000, format) == left);
+
+	/* the tab ends on the next stop */
+	stops[0] = 50;
+	C (GdipSetStringFormatTabStops (format, 0, 1, stops));
+	measure_twice (tabbed, 3, font, 1000, format, &bounds, &lines);
+	stops[0] = 150;
+	C (GdipSetStringFormatTabStops (format, 0, 1, stops));
+	measure_twice (tabbed, 3, font, 1000, format, &changed, &changed_lines);
+	assert (changed.Width > bounds.Width + 50);
+
+	C (GdipDeleteStringFormat (format));
+	C (GdipDeleteFont (font));
+}
+
+/* a new font may get the address of a deleted one, only its settings matter */
+static void
+test_font_changes ()
+{
+	GpStringFormat *format;
+	GpFontFamily *serif;
+	GpFont *font;
+	RectF small, large, bold;
+	int lines;
+
+	C (GdipCreateStringFormat (0, 0, &format));
+
+	C (GdipCreateFont (family, 12, FontStyleRegular, UnitPixel, &font));
+	measure_twice (text, LENGTH, font, 1000, format, &small, &lines);
+	C (GdipDeleteFont (font));
+
+	C (GdipCreateFont (family, 24, FontStyleRegular, UnitPixel, &font));
+	measure_twice (text, LENGTH, font, 1000, format, &large, &lines);
+	C (GdipDeleteFont (font));
+	assert (large.Width > small.Width * 1.5f);
+	assert (large.Height > small.Height * 1.5f);
+
+	/* 12 points are 16 pixels at 96 dpi */
+	C (GdipCreateFont (family, 12, FontStyleRegular, UnitPoint, &font));
+	measure_twice (text, LENGTH, font, 1000, format, &large, &lines);
+	C (GdipDeleteFont (font));
+	assert (large.Width > small.Width);
+
+	/* another style or family is another face */
+	C (GdipCreateFont (family, 12, FontStyleBold, UnitPixel, &font));
+	measure_twice (text, LENGTH, font, 1000, format, &bold, &lines);
+	C (GdipDeleteFont (font));
+	C (GdipGetGenericFontFamilySerif (&serif));
+	C (GdipCreateFont (serif, 12, FontStyleRegular, UnitPixel, &font));
+	measure_twice (text, LENGTH, font, 1000, format, &large, &lines);
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (serif));
+	assert ((bold.Width != small.Width) || (large.Width != small.Width));
+
+	C (GdipDeleteStringFormat (format));
+}
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GpBitmap *bitmap;
+
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	C (GdipCreateBitmapFromScan0 (100, 100, 0, PixelFormat32bppARGB, NULL, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, &graphics));
+	C (GdipGetGenericFontFamilySansSerif (&family));
+
+	test_layout_rect ();
+	test_format_changes ();
+	test_font_changes ();
+
+	C (GdipDeleteFontFamily (family));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
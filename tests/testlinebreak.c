@@ -0,0 +1,280 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "testhelpers.h"
+
+#ifndef WIN32
+/* the breaker is internal to the library, the test is built with its own copy */
+#define GDIP_INTERNAL
+#include "linebreak.h"
+#endif
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/* paragraphs of up to REPEATS samples are wrapped in columns ITERATIONS different widths */
+#define REPEATS		64
+#define ITERATIONS	20
+#define COLUMN		120
+
+/* UTF-16 text in a few scripts, with the punctuation the line breaker cares about */
+static const unsigned short sample[] = {
+	/* English */
+	0x0054, 0x0068, 0x0065, 0x0020, 0x0071, 0x0075, 0x0069, 0x0063, 0x006B, 0x0020,
+	0x0062, 0x0072, 0x006F, 0x0077, 0x006E, 0x0020, 0x0066, 0x006F, 0x0078, 0x0020,
+	0x006A, 0x0075, 0x006D, 0x0070, 0x0073, 0x0020, 0x006F, 0x0076, 0x0065, 0x0072,
+	0x0020, 0x0074, 0x0068, 0x0065, 0x0020, 0x006C, 0x0061, 0x007A, 0x0079, 0x0020,
+	0x0064, 0x006F, 0x0067, 0x0020, 0x0028, 0x0061, 0x0067, 0x0061, 0x0069, 0x006E,
+	0x0029, 0x002C, 0x0020, 0x0033, 0x002E, 0x0031, 0x0034, 0x0025, 0x0020, 0x0066,
+	0x0061, 0x0073, 0x0074, 0x0065, 0x0072, 0x002E, 0x0020,
+	/* German */
+	0x0047, 0x0072, 0x00F6, 0x00DF, 0x0065, 0x0072, 0x0065, 0x0020, 0x0053, 0x0074,
+	0x0072, 0x0061, 0x00DF, 0x0065, 0x006E, 0x0062, 0x0061, 0x0068, 0x006E, 0x0065,
+	0x006E, 0x0020, 0x0066, 0x0061, 0x0068, 0x0072, 0x0065, 0x006E, 0x0020, 0x00FC,
+	0x0062, 0x0065, 0x0072, 0x0020, 0x0064, 0x0069, 0x0065, 0x0020, 0x0042, 0x0072,
+	0x00FC, 0x0063, 0x006B, 0x0065, 0x002E, 0x0020,
+	/* Greek */
+	0x0397, 0x0020, 0x03B3, 0x03C1, 0x03AE, 0x03B3, 0x03BF, 0x03C1, 0x03B7, 0x0020,
+	0x03BA, 0x03B1, 0x03C6, 0x03AD, 0x0020, 0x03B1, 0x03BB, 0x03B5, 0x03C0, 0x03BF,
+	0x03CD, 0x0020, 0x03C0, 0x03B7, 0x03B4, 0x03AC, 0x0020, 0x03C0, 0x03AC, 0x03BD,
+	0x03C9, 0x0020, 0x03B1, 0x03C0, 0x03CC, 0x0020, 0x03C4, 0x03BF, 0x03BD, 0x0020,
+	0x03C3, 0x03BA, 0x03CD, 0x03BB, 0x03BF, 0x002E, 0x0020,
+	/* Russian */
+	0x0421, 0x044A, 0x0435, 0x0448, 0x044C, 0x0020, 0x0436, 0x0435, 0x0020, 0x0435,
+	0x0449, 0x0451, 0x0020, 0x044D, 0x0442, 0x0438, 0x0445, 0x0020, 0x043C, 0x044F,
+	0x0433, 0x043A, 0x0438, 0x0445, 0x0020, 0x0444, 0x0440, 0x0430, 0x043D, 0x0446,
+	0x0443, 0x0437, 0x0441, 0x043A, 0x0438, 0x0445, 0x0020, 0x0431, 0x0443, 0x043B,
+	0x043E, 0x043A, 0x002C, 0x0020, 0x0434, 0x0430, 0x0020, 0x0432, 0x044B, 0x043F,
+	0x0435, 0x0439, 0x0020, 0x0447, 0x0430, 0x044E, 0x002E, 0x0020,
+	/* Chinese */
+	0x6211, 0x80FD, 0x541E, 0x4E0B, 0x73BB, 0x7483, 0x800C, 0x4E0D, 0x4F24, 0x8EAB,
+	0x4F53, 0x3002, 0x300C, 0x4F60, 0x597D, 0x300D, 0xFF0C, 0x4E16, 0x754C, 0xFF01,
+	/* Japanese */
+	0x3044, 0x308D, 0x306F, 0x306B, 0x307B, 0x3078, 0x3068, 0x3001, 0x3061, 0x308A,
+	0x306C, 0x308B, 0x3092, 0x3002, 0x30AB, 0x30BF, 0x30AB, 0x30CA, 0x306E, 0x30C6,
+	0x30AD, 0x30B9, 0x30C8, 0x3063, 0x3067, 0x3059, 0x3002,
+	/* Korean */
+	0xB2E4, 0xB78C, 0xC950, 0x0020, 0xD5CC, 0x0020, 0xCCC7, 0xBC14, 0xD034, 0xC5D0,
+	0x0020, 0xD0C0, 0xACE0, 0xD30C, 0x002E, 0x0020,
+};
+
+#define SAMPLE_LENGTH	((int) (sizeof (sample) / sizeof (sample[0])))
+
+static WCHAR *
+make_paragraph (int repeats)
+{
+	WCHAR *text = (WCHAR *) malloc (repeats * SAMPLE_LENGTH * sizeof (WCHAR));
+	int i;
+
+	assert (text);
+	for (i = 0; i < repeats * SAMPLE_LENGTH; i++)
+		text[i] = (WCHAR) sample[i % SAMPLE_LENGTH];
+	return text;
+}
+
+#ifndef WIN32
+/* expected has a '|' where a line may start, a '!' where it must and a '.' elsewhere */
+static void
+check_breaks (const unsigned short *text, const char *expected)
+{
+	GpLineBreaker breaker;
+	int i;
+
+	gdip_line_breaker_init (&breaker);
+	for (i = 0; expected[i]; i++) {
+		LineBreakAction action = gdip_line_breaker_next (&breaker, (WCHAR) text[i]);
+
+		switch (expected[i]) {
+		case '|':
+			assert (action == LineBreakAllowed);
+			break;
+		case '!':
+			assert (action == LineBreakMandatory);
+			break;
+		default:
+			assert (action == LineBreakProhibited);
+			break;
+		}
+	}
+}
+
+static void
+test_break_positions ()
+{
+	/* "The quick  fox": after the spaces, not before them */
+	static const unsigned short words[] = { 'T', 'h', 'e', ' ', 'q', 'u', 'i', 'c', 'k', ' ', ' ', 'f', 'o', 'x' };
+	/* between any two ideographs */
+	static const unsigned short ideographs[] = { 0x6211, 0x80FD, 0x541E, 0x4E0B };
+	/* never before the ideographic full stop (U+3002), but after it */
+	static const unsigned short full_stop[] = { 0x6211, 0x80FD, 0x3002, 0x4F60 };
+	/* not after the opening bracket, nor before the closing one and the comma */
+	static const unsigned short brackets[] = { 0x6211, 0x300C, 0x4F60, 0x597D, 0x300D, 0xFF0C };
+	/* after the spaces between latin and CJK */
+	static const unsigned short mixed[] = { 'a', 'b', ' ', 0x6211, 0x80FD };
+	/* CR LF is a single hard break */
+	static const unsigned short newline[] = { 'a', '\r', '\n', 'b' };
+
+	check_breaks (words, "....|......|..");
+	check_breaks (ideographs, ".|||");
+	check_breaks (full_stop, ".|.|");
+	check_breaks (brackets, ".|.|..");
+	check_breaks (mixed, "...||");
+	check_breaks (newline, "...!");
+}
+#endif
+
+static void
+test_line_break ()
+{
+	GpBitmap *bitmap;
+	GpGraphics *graphics;
+	GpFontFamily *family;
+	GpFont *font;
+	GpStringFormat *format;
+	RectF rect, bounds;
+	int repeats, previous;
+
+	C (GdipCreateBitmapFromScan0 (100, 100, 0, PixelFormat32bppARGB, NULL, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, &graphics));
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipCreateFont (family, 12, FontStyleRegular, UnitPixel, &font));
+	C (GdipCreateStringFormat (0, 0, &format));
+
+	/* the time per character should stay about the same as the paragraphs grow */
+	for (repeats = 1; repeats <= REPEATS; repeats *= 4) {
+		WCHAR *text = make_paragraph (repeats);
+		int length = repeats * SAMPLE_LENGTH;
+		int fitted, lines, i;
+		clock_t start;
+		double ms;
+
+		previous = length;
+		start = clock ();
+		for (i = 0; i < ITERATIONS; i++) {
+			/* a new width each time, so the layouts aren't cached */
+			rect.X = 0;
+			rect.Y = 0;
+			rect.Width = COLUMN + i;
+			rect.Height = 0;
+			C (GdipMeasureString (graphics, text, length, font, &rect, format, &bounds, &fitted, &lines));
+			assert (fitted == length);
+			assert (lines > 1);
+			/* the columns get wider */
+			assert (lines <= previous);
+			previous = lines;
+		}
+		ms = elapsed (start);
+		report_timing ("GdipMeasureString (%d characters, %d times): %.1f ms, %.3f us/character\n",
+			length, ITERATIONS, ms, ms * 1000 / ((double) length * ITERATIONS));
+		free (text);
+	}
+
+	C (GdipDeleteStringFormat (format));
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+}
+
+/* the left of a character of the string laid out in a column of the given width */
+static float
+char_left (GpGraphics *graphics, const WCHAR *text, int length, GpFont *font, GpStringFormat *format, float width, int index)
+{
+	CharacterRange range;
+	GpRegion *region;
+	RectF rect, bounds;
+
+	range.First = index;
+	range.Length = 1;
+	C (GdipSetStringFormatMeasurableCharacterRanges (format, 1, &range));
+	rect.X = 0;
+	rect.Y = 0;
+	rect.Width = width;
+	rect.Height = 0;
+	C (GdipCreateRegion (&region));
+	C (GdipMeasureCharacterRanges (graphics, text, length, font, &rect, format, 1, &region));
+	C (GdipGetRegionBounds (region, graphics, &bounds));
+	C (GdipDeleteRegion (region));
+	return bounds.X;
+}
+
+static void
+test_wrap_tab ()
+{
+	/* "aa bb<tab>)c", the line can only break after the space: a tab followed by ')' isn't a break */
+	static const WCHAR text[] = { 'a', 'a', ' ', 'b', 'b', '\t', ')', 'c' };
+	GpBitmap *bitmap;
+	GpGraphics *graphics;
+	GpFontFamily *family;
+	GpFont *font;
+	GpStringFormat *format;
+	RectF rect, bounds;
+	REAL stop;
+	float width, wrapped, alone;
+	int fitted, lines;
+
+	C (GdipCreateBitmapFromScan0 (100, 100, 0, PixelFormat32bppARGB, NULL, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, &graphics));
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipCreateFont (family, 12, FontStyleRegular, UnitPixel, &font));
+	C (GdipCreateStringFormat (0, 0, &format));
+
+	/* the tab stops are set so "aa bb" ends after the first one and "bb" before it */
+	rect.X = 0;
+	rect.Y = 0;
+	rect.Width = 0;
+	rect.Height = 0;
+	C (GdipMeasureString (graphics, text, 5, font, &rect, format, &bounds, &fitted, &lines));
+	stop = bounds.Width * 0.75f;
+	C (GdipSetStringFormatTabStops (format, 0, 1, &stop));
+
+	/* the last character doesn't fit, "bb<tab>)c" is wrapped on a new line */
+	C (GdipMeasureString (graphics, text, 8, font, &rect, format, &bounds, &fitted, &lines));
+	width = bounds.Width - 1;
+	rect.Width = width;
+	C (GdipMeasureString (graphics, text, 8, font, &rect, format, &bounds, &fitted, &lines));
+	assert (lines == 2);
+
+	/* where the tab ends depends on where it starts, the new line is laid out again */
+	wrapped = char_left (graphics, text, 8, font, format, width, 6);
+	alone = char_left (graphics, text + 3, 5, font, format, width, 3);
+	assert (wrapped == alone);
+
+	C (GdipDeleteStringFormat (format));
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+}
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+#ifndef WIN32
+	test_break_positions ();
+#endif
+	test_line_break ();
+	test_wrap_tab ();
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
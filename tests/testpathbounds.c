@@ -0,0 +1,158 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+#define SAMPLES		10000
+#define TOLERANCE	0.01f
+
+static void
+check_bounds (GpPath *path, GpMatrix *matrix, float x, float y, float width, float height)
+{
+	GpRectF bounds;
+
+	C (GdipGetPathWorldBounds (path, &bounds, matrix, NULL));
+	assert (fabs (bounds.X - x) < TOLERANCE);
+	assert (fabs (bounds.Y - y) < TOLERANCE);
+	assert (fabs (bounds.Width - width) < TOLERANCE);
+	assert (fabs (bounds.Height - height) < TOLERANCE);
+}
+
+/* the bounds of a densely sampled bezier, transformed by matrix (if any) */
+static void
+sample_bezier (GpPointF *p, GpMatrix *matrix, GpRectF *bounds)
+{
+	float left = 0, top = 0, right = 0, bottom = 0;
+	int i;
+
+	for (i = 0; i <= SAMPLES; i++) {
+		double t = (double) i / SAMPLES, u = 1 - t;
+		GpPointF pt;
+
+		pt.X = (float) (u * u * u * p[0].X + 3 * u * u * t * p[1].X + 3 * u * t * t * p[2].X + t * t * t * p[3].X);
+		pt.Y = (float) (u * u * u * p[0].Y + 3 * u * u * t * p[1].Y + 3 * u * t * t * p[2].Y + t * t * t * p[3].Y);
+		if (matrix)
+			C (GdipTransformMatrixPoints (matrix, &pt, 1));
+
+		if ((i == 0) || (pt.X < left))
+			left = pt.X;
+		if ((i == 0) || (pt.X > right))
+			right = pt.X;
+		if ((i == 0) || (pt.Y < top))
+			top = pt.Y;
+		if ((i == 0) || (pt.Y > bottom))
+			bottom = pt.Y;
+	}
+
+	bounds->X = left;
+	bounds->Y = top;
+	bounds->Width = right - left;
+	bounds->Height = bottom - top;
+}
+
+/* the bounds of a curve are those of the curve itself, not of its control points */
+static void
+test_bezier_bounds ()
+{
+	GpPointF arch[4] = { {0, 0}, {0, 100}, {100, 100}, {100, 0} };
+	GpPointF loop[4] = { {10, 10}, {400, -100}, {-300, 200}, {100, 100} };
+	GpPath *path;
+	GpMatrix *matrix;
+	GpRectF expected;
+
+	/* the top of the arch is at 3/4 of the control points height */
+	C (GdipCreatePath (FillModeAlternate, &path));
+	C (GdipAddPathBezier (path, arch[0].X, arch[0].Y, arch[1].X, arch[1].Y, arch[2].X, arch[2].Y, arch[3].X, arch[3].Y));
+	check_bounds (path, NULL, 0, 0, 100, 75);
+	C (GdipDeletePath (path));
+
+	/* extrema on both axes, inside the control points bounds */
+	C (GdipCreatePath (FillModeAlternate, &path));
+	C (GdipAddPathBeziers (path, loop, 4));
+	sample_bezier (loop, NULL, &expected);
+	assert (expected.X < 10 && expected.X + expected.Width > 100);
+	assert (expected.Y > -100 && expected.Y + expected.Height < 200);
+	check_bounds (path, NULL, expected.X, expected.Y, expected.Width, expected.Height);
+
+	/* the extrema move with a rotation, they are searched after the transformation */
+	C (GdipCreateMatrix (&matrix));
+	C (GdipRotateMatrix (matrix, 30, MatrixOrderAppend));
+	C (GdipTranslateMatrix (matrix, 20, -10, MatrixOrderAppend));
+	sample_bezier (loop, matrix, &expected);
+	check_bounds (path, matrix, expected.X, expected.Y, expected.Width, expected.Height);
+
+	/* and the untransformed bounds are still right afterwards */
+	sample_bezier (loop, NULL, &expected);
+	check_bounds (path, NULL, expected.X, expected.Y, expected.Width, expected.Height);
+
+	C (GdipDeleteMatrix (matrix));
+	C (GdipDeletePath (path));
+}
+
+/* the bounds follow the changes of the path */
+static void
+test_bounds_after_edits ()
+{
+	GpPath *path;
+	GpMatrix *matrix;
+
+	C (GdipCreatePath (FillModeAlternate, &path));
+	C (GdipAddPathRectangle (path, 10, 20, 30, 40));
+	check_bounds (path, NULL, 10, 20, 30, 40);
+
+	C (GdipAddPathLine (path, 0, 0, 100, 50));
+	check_bounds (path, NULL, 0, 0, 100, 60);
+
+	C (GdipCreateMatrix (&matrix));
+	C (GdipTranslateMatrix (matrix, 5, -5, MatrixOrderAppend));
+	C (GdipTransformPath (path, matrix));
+	check_bounds (path, NULL, 5, -5, 100, 60);
+
+	/* reversing and closing doesn't move any point */
+	C (GdipReversePath (path));
+	C (GdipClosePathFigures (path));
+	check_bounds (path, NULL, 5, -5, 100, 60);
+
+	C (GdipResetPath (path));
+	check_bounds (path, NULL, 0, 0, 0, 0);
+	C (GdipAddPathEllipse (path, 50, 50, 20, 10));
+	check_bounds (path, NULL, 50, 50, 20, 10);
+
+	/* flattening keeps the points of the ellipse on its outline */
+	C (GdipFlattenPath (path, NULL, 0.25f));
+	check_bounds (path, NULL, 50, 50, 20, 10);
+
+	C (GdipDeleteMatrix (matrix));
+	C (GdipDeletePath (path));
+}
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_bezier_bounds ();
+	test_bounds_after_edits ();
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
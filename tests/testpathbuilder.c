@@ -0,0 +1,127 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "testhelpers.h"
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/* number of vertices of the large paths built by the benchmark */
+#define VERTICES	1000000
+#define POLYGONS	10000
+
+static GpPointF *
+make_points (int count)
+{
+	GpPointF *points = (GpPointF *) malloc (count * sizeof (GpPointF));
+	int i;
+
+	assert (points);
+	for (i = 0; i < count; i++) {
+		points[i].X = (float) (i % 1000);
+		points[i].Y = (float) (i / 1000);
+	}
+	return points;
+}
+
+static void
+test_path_builder ()
+{
+	GpPath *path;
+	GpPointF *points = make_points (VERTICES);
+	GpPointF *result;
+	BYTE *types;
+	clock_t start;
+	int count, figures, i;
+
+	/* one large polyline */
+	C (GdipCreatePath (FillModeAlternate, &path));
+	start = clock ();
+	C (GdipAddPathLine2 (path, points, VERTICES));
+	report_timing ("GdipAddPathLine2 (%d points): %.1f ms\n", VERTICES, elapsed (start));
+
+	C (GdipGetPointCount (path, &count));
+	assert (count == VERTICES);
+
+	result = (GpPointF *) malloc (count * sizeof (GpPointF));
+	/* large enough for the polygons, which may get an extra closing point each */
+	types = (BYTE *) malloc (VERTICES + POLYGONS);
+	assert (result && types);
+	C (GdipGetPathPoints (path, result, count));
+	C (GdipGetPathTypes (path, types, count));
+	assert (types[0] == PathPointTypeStart);
+	for (i = 1; i < count; i++) {
+		assert (types[i] == PathPointTypeLine);
+		assert (result[i].X == points[i].X && result[i].Y == points[i].Y);
+	}
+	C (GdipDeletePath (path));
+
+	/* many small polygons */
+	C (GdipCreatePath (FillModeAlternate, &path));
+#ifndef WIN32
+	C (GdipReservePathCapacity (path, (VERTICES / POLYGONS + 1) * POLYGONS));
+#endif
+	start = clock ();
+	for (i = 0; i < POLYGONS; i++)
+		C (GdipAddPathPolygon (path, points + i * (VERTICES / POLYGONS), VERTICES / POLYGONS));
+	report_timing ("GdipAddPathPolygon (%d x %d points): %.1f ms\n", POLYGONS, VERTICES / POLYGONS, elapsed (start));
+
+	C (GdipGetPointCount (path, &count));
+	assert (count >= VERTICES && count <= VERTICES + POLYGONS);
+	C (GdipGetPathTypes (path, types, count));
+	assert (types[0] == PathPointTypeStart);
+	assert (types[count - 1] & PathPointTypeCloseSubpath);
+	/* one closed figure per polygon */
+	for (i = 0, figures = 0; i < count; i++) {
+		if ((types[i] & PathPointTypePathTypeMask) == PathPointTypeStart)
+			figures++;
+	}
+	assert (figures == POLYGONS);
+	C (GdipDeletePath (path));
+
+	/* beziers, the first point is a line and the others are bezier control/end points */
+	C (GdipCreatePath (FillModeAlternate, &path));
+	start = clock ();
+	C (GdipAddPathBeziers (path, points, VERTICES - ((VERTICES - 1) % 3)));
+	report_timing ("GdipAddPathBeziers: %.1f ms\n", elapsed (start));
+
+	C (GdipGetPointCount (path, &count));
+	assert (count == VERTICES - ((VERTICES - 1) % 3));
+	C (GdipGetPathTypes (path, types, count));
+	assert (types[0] == PathPointTypeStart);
+	for (i = 1; i < count; i++)
+		assert (types[i] == PathPointTypeBezier);
+	C (GdipDeletePath (path));
+
+	free (types);
+	free (result);
+	free (points);
+}
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_path_builder ();
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
@@ -0,0 +1,302 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#include <cairo.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+#define TEXT		"Hello, glyph cache!"
+/* cairo paths are in 24.8 fixed point, the cache adds the glyph positions after the conversion */
+#define TOLERANCE	0.01
+/* see glyph-cache.h */
+#define GLYPH_CACHE_MAX_BYTES	(4 * 1024 * 1024)
+
+#ifndef WIN32
+static void
+get_text (WCHAR *text)
+{
+	int i;
+
+	for (i = 0; TEXT[i]; i++)
+		text[i] = TEXT[i];
+	text[i] = 0;
+}
+
+/* the path GdipAddPathString built with cairo_text_path, before the glyph cache */
+static int
+get_cairo_path (const char *family, int style, float size, GpPointF *points, BYTE *types, int max)
+{
+	cairo_surface_t *surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+	cairo_t *cr = cairo_create (surface);
+	cairo_path_t *cp;
+	int i, j, n = 0;
+
+	cairo_select_font_face (cr, family,
+		(style & FontStyleItalic) ? CAIRO_FONT_SLANT_ITALIC : CAIRO_FONT_SLANT_NORMAL,
+		(style & FontStyleBold) ? CAIRO_FONT_WEIGHT_BOLD : CAIRO_FONT_WEIGHT_NORMAL);
+	cairo_set_font_size (cr, size);
+	cairo_text_path (cr, TEXT);
+	cp = cairo_copy_path (cr);
+
+	for (i = 0; i < cp->num_data; i += cp->data[i].header.length) {
+		cairo_path_data_t *data = &cp->data[i];
+		BYTE type;
+
+		switch (data->header.type) {
+		case CAIRO_PATH_MOVE_TO:
+			/* the current point left after the text isn't part of the outlines */
+			if (i + data->header.length >= cp->num_data)
+				continue;
+			type = PathPointTypeStart;
+			break;
+		case CAIRO_PATH_LINE_TO:
+			type = PathPointTypeLine;
+			break;
+		case CAIRO_PATH_CURVE_TO:
+			type = PathPointTypeBezier;
+			break;
+		default:
+			if (n > 0)
+				types[n - 1] |= PathPointTypeCloseSubpath;
+			continue;
+		}
+
+		for (j = 1; j < data->header.length; j++) {
+			assert (n < max);
+			points[n].X = data[j].point.x;
+			points[n].Y = data[j].point.y;
+			types[n++] = type;
+		}
+	}
+
+	cairo_path_destroy (cp);
+	cairo_destroy (cr);
+	cairo_surface_destroy (surface);
+	return n;
+}
+
+static void
+check_path_string (GpFontFamily *family, const char *name, int style, float size)
+{
+	GpPointF *expected = (GpPointF *) malloc (10000 * sizeof (GpPointF));
+	GpPointF *points = (GpPointF *) malloc (10000 * sizeof (GpPointF));
+	BYTE *expected_types = (BYTE *) malloc (10000);
+	BYTE *types = (BYTE *) malloc (10000);
+	WCHAR text[sizeof (TEXT)];
+	int expected_count, count, hits, misses, bytes, previous_hits, previous_misses, pass, i;
+	int advance_hits, advance_misses;
+	GpPath *path;
+
+	assert (expected && points && expected_types && types);
+	get_text (text);
+	expected_count = get_cairo_path (name, style, size, expected, expected_types, 10000);
+	assert (expected_count > 0);
+
+	/* the first time the outlines are extracted, the second time they come from the cache */
+	for (pass = 0; pass < 2; pass++) {
+		C (GdipGetGlyphCacheStatistics (&previous_hits, &previous_misses, &advance_hits, &advance_misses, &bytes));
+
+		C (GdipCreatePath (FillModeAlternate, &path));
+		C (GdipAddPathString (path, text, -1, family, style, size, NULL, NULL));
+		C (GdipGetPointCount (path, &count));
+		assert (count == expected_count);
+		C (GdipGetPathPoints (path, points, count));
+		C (GdipGetPathTypes (path, types, count));
+		C (GdipDeletePath (path));
+
+		for (i = 0; i < count; i++) {
+			assert (types[i] == expected_types[i]);
+			assert (fabs (points[i].X - expected[i].X) <= TOLERANCE);
+			assert (fabs (points[i].Y - expected[i].Y) <= TOLERANCE);
+		}
+
+		C (GdipGetGlyphCacheStatistics (&hits, &misses, &advance_hits, &advance_misses, &bytes));
+		assert (bytes > 0 && bytes <= GLYPH_CACHE_MAX_BYTES);
+		if (pass == 1) {
+			assert (misses == previous_misses);
+			assert (hits >= previous_hits + (int) strlen (TEXT));
+		}
+	}
+
+	free (types);
+	free (expected_types);
+	free (points);
+	free (expected);
+}
+
+static void
+test_path_string ()
+{
+	GpFontFamily *family;
+	WCHAR wname[LF_FACESIZE];
+	char name[LF_FACESIZE];
+	int hits, misses, advance_hits, advance_misses, bytes, i;
+
+	/* the Pango backend lays the text out itself, it has no glyph cache */
+	if (GdipGetGlyphCacheStatistics (&hits, &misses, &advance_hits, &advance_misses, &bytes) == NotImplemented)
+		return;
+
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipGetFamilyName (family, wname, 0));
+	for (i = 0; i < LF_FACESIZE; i++)
+		name[i] = (char) wname[i];
+	name[LF_FACESIZE - 1] = 0;
+
+	check_path_string (family, name, FontStyleRegular, 12);
+	check_path_string (family, name, FontStyleRegular, 37.5);
+	check_path_string (family, name, FontStyleBold, 12);
+
+	C (GdipDeleteFontFamily (family));
+}
+
+static void
+test_budget ()
+{
+	GpFontFamily *family;
+	WCHAR text[sizeof (TEXT)];
+	int hits, misses, advance_hits, advance_misses, bytes, size;
+	GpPath *path;
+
+	if (GdipGetGlyphCacheStatistics (&hits, &misses, &advance_hits, &advance_misses, &bytes) == NotImplemented)
+		return;
+
+	/* each size is a face of its own, together they don't fit in the budget */
+	get_text (text);
+	C (GdipGetGenericFontFamilySerif (&family));
+	C (GdipCreatePath (FillModeAlternate, &path));
+	for (size = 8; size < 200; size++) {
+		C (GdipAddPathString (path, text, -1, family, FontStyleRegular, (float) size, NULL, NULL));
+		C (GdipResetPath (path));
+		C (GdipGetGlyphCacheStatistics (&hits, &misses, &advance_hits, &advance_misses, &bytes));
+		assert (bytes > 0 && bytes <= GLYPH_CACHE_MAX_BYTES);
+	}
+	C (GdipDeletePath (path));
+	C (GdipDeleteFontFamily (family));
+}
+
+/* measuring reads the advances, the outlines are only for paths */
+static void
+test_advance_statistics ()
+{
+	WCHAR text[sizeof (TEXT)];
+	GpFontFamily *family;
+	GpGraphics *graphics;
+	GpBitmap *bitmap;
+	GpFont *font;
+	RectF rect, bounds;
+	int hits, misses, advance_hits, advance_misses, bytes, pass;
+	int previous_hits, previous_misses, previous_advance_hits, previous_advance_misses;
+
+	if (GdipGetGlyphCacheStatistics (&hits, &misses, &advance_hits, &advance_misses, &bytes) == NotImplemented)
+		return;
+
+	get_text (text);
+	rect.X = 0;
+	rect.Y = 0;
+	rect.Width = 0;
+	rect.Height = 0;
+	C (GdipCreateBitmapFromScan0 (10, 10, 0, PixelFormat32bppARGB, NULL, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, &graphics));
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipCreateFont (family, 13, FontStyleItalic, UnitPixel, &font));
+
+	/* the first time the advances are measured, the second time they come from the cache */
+	for (pass = 0; pass < 2; pass++) {
+		C (GdipGetGlyphCacheStatistics (&previous_hits, &previous_misses, &previous_advance_hits, &previous_advance_misses, &bytes));
+		C (GdipMeasureString (graphics, text, -1, font, &rect, NULL, &bounds, NULL, NULL));
+		C (GdipGetGlyphCacheStatistics (&hits, &misses, &advance_hits, &advance_misses, &bytes));
+		assert (hits == previous_hits);
+		assert (misses == previous_misses);
+		if (pass == 0)
+			assert (advance_hits + advance_misses >= previous_advance_hits + previous_advance_misses + (int) strlen (TEXT));
+		else {
+			assert (advance_misses == previous_advance_misses);
+			assert (advance_hits >= previous_advance_hits + (int) strlen (TEXT));
+		}
+	}
+
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+}
+
+/* characters from U+0800 are kept in a hash table, they are counted in the budget too */
+#define OTHERS		4000
+
+static void
+test_advances_budget ()
+{
+	WCHAR *text = (WCHAR *) malloc (OTHERS * sizeof (WCHAR));
+	GpFontFamily *family;
+	GpGraphics *graphics;
+	GpBitmap *bitmap;
+	GpFont *font;
+	RectF rect, bounds;
+	int hits, misses, advance_hits, advance_misses, bytes, size, i;
+
+	if (GdipGetGlyphCacheStatistics (&hits, &misses, &advance_hits, &advance_misses, &bytes) == NotImplemented) {
+		free (text);
+		return;
+	}
+
+	assert (text);
+	for (i = 0; i < OTHERS; i++)
+		text[i] = (WCHAR) (0x4e00 + i);
+	rect.X = 0;
+	rect.Y = 0;
+	rect.Width = 0;
+	rect.Height = 0;
+
+	/* each size is a table of its own, together they don't fit in the budget */
+	C (GdipCreateBitmapFromScan0 (10, 10, 0, PixelFormat32bppARGB, NULL, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, &graphics));
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	for (size = 8; size < 48; size++) {
+		C (GdipCreateFont (family, (float) size, FontStyleRegular, UnitPixel, &font));
+		C (GdipMeasureString (graphics, text, OTHERS, font, &rect, NULL, &bounds, NULL, NULL));
+		C (GdipDeleteFont (font));
+		C (GdipGetGlyphCacheStatistics (&hits, &misses, &advance_hits, &advance_misses, &bytes));
+		assert (bytes > 0 && bytes <= GLYPH_CACHE_MAX_BYTES);
+	}
+	C (GdipDeleteFontFamily (family));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	free (text);
+}
+#endif
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+#ifndef WIN32
+	test_path_string ();
+	test_budget ();
+	test_advance_statistics ();
+	test_advances_budget ();
+#endif
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
@@ -0,0 +1,143 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/*
+ * A staircase: a straight left side and a right side alternating between two
+ * columns every STEP, both made of STEPS vertical edges. That's enough edges
+ * for an index, with 2 * STEPS bands of STEP / 2, so the steps (horizontal
+ * edges) are on band boundaries and there is another boundary in the middle
+ * of each step.
+ */
+#define STEPS		16
+#define STEP		20
+#define NARROW		100
+#define WIDE		110
+
+/* GdipIsVisiblePathPoint tests (x + 1, y + 0.5), the offsets used by cairo before */
+#define OFFSET_X	1.0f
+#define OFFSET_Y	0.5f
+
+static float
+step_right (int step)
+{
+	return (step & 1) ? WIDE : NARROW;
+}
+
+static GpPath *
+create_staircase (FillMode mode)
+{
+	GpPointF points[4 * STEPS + 1];
+	GpPath *path;
+	int i, n = 0;
+
+	for (i = 0; i < STEPS; i++) {
+		points[n].X = step_right (i);
+		points[n++].Y = (float) (i * STEP);
+		points[n].X = step_right (i);
+		points[n++].Y = (float) ((i + 1) * STEP);
+	}
+	for (i = STEPS; i >= 0; i--) {
+		points[n].X = 0;
+		points[n++].Y = (float) (i * STEP);
+	}
+
+	C (GdipCreatePath (mode, &path));
+	C (GdipAddPathPolygon (path, points, n));
+	return path;
+}
+
+/* the top and left edges are inside, the bottom and right ones are outside */
+static BOOL
+staircase_contains (float x, float y)
+{
+	int step;
+
+	if ((y < 0) || (y >= STEPS * STEP) || (x < 0))
+		return FALSE;
+	step = (int) (y / STEP);
+	return x < step_right (step);
+}
+
+static void
+test_staircase (FillMode mode)
+{
+	float columns[7] = { -0.5f, 0, 50, NARROW - 0.5f, NARROW, 105, WIDE };
+	GpPath *path = create_staircase (mode);
+	BOOL result;
+	int i, j;
+
+	for (i = -1; i <= 2 * STEPS + 1; i++) {
+		/* on the band boundaries, which are the steps for even i, and just above them */
+		float rows[2];
+
+		rows[0] = (float) (i * STEP / 2);
+		rows[1] = rows[0] - 0.25f;
+		for (j = 0; j < 7; j++) {
+			int r;
+
+			for (r = 0; r < 2; r++) {
+				C (GdipIsVisiblePathPoint (path, columns[j] - OFFSET_X, rows[r] - OFFSET_Y, NULL, &result));
+				assert (result == staircase_contains (columns[j], rows[r]));
+			}
+		}
+	}
+
+	C (GdipDeletePath (path));
+}
+
+/* curves are indexed too, once flattened */
+static void
+test_ellipse ()
+{
+	GpPath *path;
+	BOOL result;
+
+	C (GdipCreatePath (FillModeAlternate, &path));
+	C (GdipAddPathEllipse (path, 0, 0, 200, 100));
+
+	C (GdipIsVisiblePathPoint (path, 100 - OFFSET_X, 50 - OFFSET_Y, NULL, &result));
+	assert (result);
+	C (GdipIsVisiblePathPoint (path, 1 - OFFSET_X, 50 - OFFSET_Y, NULL, &result));
+	assert (result);
+	C (GdipIsVisiblePathPoint (path, 100 - OFFSET_X, 1 - OFFSET_Y, NULL, &result));
+	assert (result);
+	C (GdipIsVisiblePathPoint (path, 10 - OFFSET_X, 10 - OFFSET_Y, NULL, &result));
+	assert (!result);
+	C (GdipIsVisiblePathPoint (path, 100 - OFFSET_X, 100 - OFFSET_Y, NULL, &result));
+	assert (!result);
+
+	C (GdipDeletePath (path));
+}
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_staircase (FillModeAlternate);
+	test_staircase (FillModeWinding);
+	test_ellipse ();
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
@@ -0,0 +1,154 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/* a row of 10x10 squares, 20 units apart; enough of them get an index, a few are scanned */
+#define FEW		4
+#define MANY		32
+#define STEP		20
+#define SIZE		10
+
+static GpRegion *
+create_squares (int count)
+{
+	GpRegion *region;
+	GpRectF rect;
+	int i;
+
+	rect.X = 0;
+	rect.Y = 0;
+	rect.Width = SIZE;
+	rect.Height = SIZE;
+	C (GdipCreateRegionRect (&rect, &region));
+	for (i = 1; i < count; i++) {
+		rect.X = (float) (i * STEP);
+		C (GdipCombineRegionRect (region, &rect, CombineModeUnion));
+	}
+	return region;
+}
+
+static BOOL
+is_visible (GpRegion *region, float x, float y, float width, float height)
+{
+	BOOL result;
+
+	C (GdipIsVisibleRegionRect (region, x, y, width, height, NULL, &result));
+	return result;
+}
+
+/* a rectangle is visible when it shares some area with the region, touching an edge isn't enough */
+static void
+check_square (GpRegion *region, float x, BOOL last)
+{
+	/* inside, and across the right edge, the top edge and a corner */
+	assert (is_visible (region, x + 9.5f, 5, 0.25f, 0.25f));
+	assert (is_visible (region, x + 9.9f, 5, 0.2f, 0.2f));
+	assert (is_visible (region, x + 5, -0.1f, 0.2f, 0.2f));
+	assert (is_visible (region, x - 0.25f, -0.25f, 0.5f, 0.5f));
+
+	/* on the outside of the left, right and bottom edges, and near a corner */
+	assert (!is_visible (region, x - 0.5f, 5, 0.5f, 0.5f));
+	assert (!is_visible (region, x + 10, 5, 0.5f, 0.5f));
+	assert (!is_visible (region, x + 5, 10, 0.5f, 0.5f));
+	assert (!is_visible (region, x + 10.1f, 10.1f, 0.1f, 0.1f));
+
+	/* within the gap to the next square, then a bit over it */
+	assert (!is_visible (region, x + 10.25f, 2, 9.5f, 5));
+	if (!last)
+		assert (is_visible (region, x + 10.25f, 2, 9.8f, 5));
+}
+
+static void
+test_subpixel_rects ()
+{
+	int counts[2] = { FEW, MANY };
+	int c, i;
+
+	for (c = 0; c < 2; c++) {
+		GpRegion *region = create_squares (counts[c]);
+
+		for (i = 0; i < counts[c]; i++)
+			check_square (region, (float) (i * STEP), i == counts[c] - 1);
+		C (GdipDeleteRegion (region));
+	}
+}
+
+static void
+test_region_copies ()
+{
+	GpRegion *region = create_squares (MANY);
+	GpRegion *clone, *clip;
+	GpBitmap *bitmap;
+	GpGraphics *graphics;
+	unsigned int state;
+
+	/* the first query builds the index, a clone doesn't share it */
+	assert (is_visible (region, 2, 2, 1, 1));
+	C (GdipCloneRegion (region, &clone));
+	C (GdipTranslateRegion (clone, 5, 0));
+	assert (is_visible (clone, 12, 2, 1, 1));
+	assert (!is_visible (clone, 2, 2, 1, 1));
+	assert (is_visible (region, 2, 2, 1, 1));
+	assert (!is_visible (region, 12, 2, 1, 1));
+
+	/* changing a region drops the index built before */
+	C (GdipTranslateRegion (region, 0, 5));
+	assert (!is_visible (region, 2, 2, 1, 1));
+	assert (is_visible (region, 2, 12, 1, 1));
+	C (GdipTranslateRegion (region, 0, -5));
+
+	/* a saved clip is shared until the clip changes, then each keeps its own squares */
+	C (GdipCreateBitmapFromScan0 (MANY * STEP, STEP, 0, PixelFormat32bppARGB, NULL, &bitmap));
+	C (GdipGetImageGraphicsContext (bitmap, &graphics));
+	C (GdipCreateRegion (&clip));
+	C (GdipSetClipRegion (graphics, region, CombineModeReplace));
+	C (GdipSaveGraphics (graphics, &state));
+	C (GdipSetClipRect (graphics, 0, 0, 3 * STEP, STEP, CombineModeIntersect));
+
+	C (GdipGetClip (graphics, clip));
+	assert (is_visible (clip, 2 * STEP + 9.9f, 5, 0.2f, 0.2f));
+	assert (!is_visible (clip, 3 * STEP + 5, 5, 1, 1));
+
+	C (GdipRestoreGraphics (graphics, state));
+	C (GdipGetClip (graphics, clip));
+	assert (is_visible (clip, 3 * STEP + 5, 5, 1, 1));
+	assert (!is_visible (clip, 3 * STEP + 10, 5, 0.5f, 0.5f));
+	assert (is_visible (region, 3 * STEP + 5, 5, 1, 1));
+
+	C (GdipDeleteRegion (clip));
+	C (GdipDeleteGraphics (graphics));
+	C (GdipDisposeImage (bitmap));
+	C (GdipDeleteRegion (clone));
+	C (GdipDeleteRegion (region));
+}
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_subpixel_rects ();
+	test_region_copies ();
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}
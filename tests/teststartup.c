@@ -0,0 +1,138 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "testhelpers.h"
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/* startup and shutdown are repeated to get measurable times */
+#define ROUNDS	20
+
+static const WCHAR filename[] = { 't','e','s','t','s','t','a','r','t','u','p','.','b','m','p', 0 };
+
+static BOOL
+is_bmp_codec (ImageCodecInfo *codec)
+{
+	const char *mime = "image/bmp";
+	int i;
+
+	for (i = 0; mime [i]; i++) {
+		if (codec->MimeType [i] != mime [i])
+			return FALSE;
+	}
+	return codec->MimeType [i] == 0;
+}
+
+/* what a process that only converts images does: find an encoder, save and decode */
+static void
+image_round_trip ()
+{
+	GpBitmap *bitmap;
+	GpImage *image;
+	ImageCodecInfo *encoders;
+	UINT count, size, width, i;
+	CLSID *bmp = NULL;
+
+	C (GdipGetImageEncodersSize (&count, &size));
+	assert (count > 0);
+	encoders = (ImageCodecInfo *) malloc (size);
+	assert (encoders);
+	C (GdipGetImageEncoders (count, size, encoders));
+	for (i = 0; i < count; i++) {
+		if (is_bmp_codec (&encoders [i]))
+			bmp = &encoders [i].Clsid;
+	}
+	assert (bmp);
+
+	C (GdipCreateBitmapFromScan0 (16, 16, 0, PixelFormat32bppARGB, NULL, &bitmap));
+	C (GdipSaveImageToFile ((GpImage *) bitmap, filename, bmp, NULL));
+	C (GdipDisposeImage ((GpImage *) bitmap));
+	free (encoders);
+
+	C (GdipLoadImageFromFile (filename, &image));
+	C (GdipGetImageWidth (image, &width));
+	assert (width == 16);
+	C (GdipDisposeImage (image));
+}
+
+static void
+test_startup ()
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GpFontCollection *collection;
+	GpFontFamily *family;
+	GpFont *font;
+	WCHAR name[LF_FACESIZE];
+	clock_t start;
+	REAL size;
+	int families, i;
+
+	memset (&gdiplusStartupInput, 0, sizeof (gdiplusStartupInput));
+	gdiplusStartupInput.GdiplusVersion = 1;
+
+	start = clock ();
+	for (i = 0; i < ROUNDS; i++) {
+		C (GdiplusStartup (&gdiplusToken, &gdiplusStartupInput, NULL));
+		GdiplusShutdown (gdiplusToken);
+	}
+	report_timing ("GdiplusStartup + GdiplusShutdown: %.2f ms\n", elapsed (start) / ROUNDS);
+
+	/* images only, fonts are never touched */
+	start = clock ();
+	for (i = 0; i < ROUNDS; i++) {
+		C (GdiplusStartup (&gdiplusToken, &gdiplusStartupInput, NULL));
+		image_round_trip ();
+		GdiplusShutdown (gdiplusToken);
+	}
+	report_timing ("startup, image save and load, shutdown: %.2f ms\n", elapsed (start) / ROUNDS);
+
+	/* the first font use pays for the font subsystem */
+	C (GdiplusStartup (&gdiplusToken, &gdiplusStartupInput, NULL));
+	start = clock ();
+	C (GdipGetGenericFontFamilySansSerif (&family));
+	C (GdipCreateFont (family, 12, 0, UnitPoint, &font));
+	report_timing ("first font: %.2f ms\n", elapsed (start));
+
+	start = clock ();
+	C (GdipNewInstalledFontCollection (&collection));
+	C (GdipGetFontCollectionFamilyCount (collection, &families));
+	report_timing ("installed font collection (%d families): %.2f ms\n", families, elapsed (start));
+	assert (families > 0);
+
+	/* the font is usable after all the restarts */
+	C (GdipGetFontSize (font, &size));
+	assert (size == 12);
+	C (GdipGetFamilyName (family, name, 0));
+	assert (name[0] != 0);
+
+	C (GdipDeleteFont (font));
+	C (GdipDeleteFontFamily (family));
+	GdiplusShutdown (gdiplusToken);
+
+	remove ("teststartup.bmp");
+}
+
+int
+main(int argc, char**argv)
+{
+	test_startup ();
+	return 0;
+}
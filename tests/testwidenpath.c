@@ -0,0 +1,192 @@
+#ifdef WIN32
+#ifndef __cplusplus
+#error Please compile with a C++ compiler.
+#endif
+#include <windows.h>
+#include <GdiPlus.h>
+#else
+#include <GdiPlusFlat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "testhelpers.h"
+
+#define C(func) assert(func == Ok)
+
+#ifdef WIN32
+using namespace Gdiplus;
+using namespace DllExports;
+#endif
+
+/* size of the polyline widened by the benchmark */
+#define VERTICES	100000
+#define HIT_TESTS	1000
+
+static GpPath *
+make_polyline (int count)
+{
+	GpPointF *points = (GpPointF *) malloc (count * sizeof (GpPointF));
+	GpPath *path;
+	int i;
+
+	assert (points);
+	/* a zigzag, every vertex gets a join */
+	for (i = 0; i < count; i++) {
+		points[i].X = (float) (i % 1000) * 10;
+		points[i].Y = (float) ((i / 1000) * 20 + (i & 1) * 10);
+	}
+	C (GdipCreatePath (FillModeAlternate, &path));
+	C (GdipAddPathLine2 (path, points, count));
+	free (points);
+	return path;
+}
+
+static void
+test_widen_line ()
+{
+	GpPath *path;
+	GpPen *pen;
+	GpRectF bounds;
+	FillMode mode;
+	int count;
+
+	C (GdipCreatePen1 (0xff000000, 10, UnitPixel, &pen));
+	C (GdipCreatePath (FillModeAlternate, &path));
+	C (GdipAddPathLine (path, 10, 10, 110, 10));
+	C (GdipWidenPath (path, pen, NULL, 0.25));
+
+	C (GdipGetPointCount (path, &count));
+	assert (count >= 4);
+	C (GdipGetPathFillMode (path, &mode));
+	assert (mode == FillModeWinding);
+	C (GdipGetPathWorldBounds (path, &bounds, NULL, NULL));
+	assert (bounds.X == 10 && bounds.Y == 5 && bounds.Width == 100 && bounds.Height == 10);
+
+	C (GdipDeletePath (path));
+	C (GdipDeletePen (pen));
+}
+
+static int
+get_figure_count (GpPath *path)
+{
+	BYTE *types;
+	int count, figures = 0, i;
+
+	C (GdipGetPointCount (path, &count));
+	types = (BYTE *) malloc (count);
+	assert (types);
+	C (GdipGetPathTypes (path, types, count));
+	for (i = 0; i < count; i++) {
+		if ((types[i] & PathPointTypePathTypeMask) == PathPointTypeStart)
+			figures++;
+	}
+	free (types);
+	return figures;
+}
+
+static void
+test_widen_single_outline ()
+{
+	GpPointF zigzag[] = { {10, 10}, {40, 60}, {70, 10}, {100, 60}, {130, 10} };
+	GpPath *path;
+	GpPen *pen;
+	BOOL visible;
+
+	C (GdipCreatePen1 (0xff000000, 12, UnitPixel, &pen));
+	C (GdipSetPenLineJoin (pen, LineJoinRound));
+	C (GdipSetPenStartCap (pen, LineCapRound));
+	C (GdipSetPenEndCap (pen, LineCapTriangle));
+
+	/* one figure going around the whole line, joins and caps included */
+	C (GdipCreatePath (FillModeAlternate, &path));
+	C (GdipAddPathLine2 (path, zigzag, 5));
+	C (GdipWidenPath (path, pen, NULL, 0.25));
+	assert (get_figure_count (path) == 1);
+
+	/* nothing overlaps, even around the joins and caps */
+	C (GdipSetPathFillMode (path, FillModeAlternate));
+	C (GdipIsVisiblePathPoint (path, 40, 58, NULL, &visible));
+	assert (visible);
+	C (GdipIsVisiblePathPoint (path, 70, 12, NULL, &visible));
+	assert (visible);
+	C (GdipIsVisiblePathPoint (path, 9, 10, NULL, &visible));
+	assert (visible);
+	C (GdipIsVisiblePathPoint (path, 70, 30, NULL, &visible));
+	assert (!visible);
+	C (GdipDeletePath (path));
+
+	/* a closed figure gets both sides of the line, the inside stays empty */
+	C (GdipCreatePath (FillModeAlternate, &path));
+	C (GdipAddPathRectangle (path, 20, 20, 80, 80));
+	C (GdipWidenPath (path, pen, NULL, 0.25));
+	assert (get_figure_count (path) == 2);
+	C (GdipSetPathFillMode (path, FillModeAlternate));
+	C (GdipIsVisiblePathPoint (path, 20, 20, NULL, &visible));
+	assert (visible);
+	C (GdipIsVisiblePathPoint (path, 60, 60, NULL, &visible));
+	assert (!visible);
+	C (GdipDeletePath (path));
+
+	C (GdipDeletePen (pen));
+}
+
+static void
+test_widen_benchmark ()
+{
+	GpPath *path = make_polyline (VERTICES);
+	GpPen *pen;
+	clock_t start;
+	BOOL visible;
+	int count, i;
+
+	C (GdipCreatePen1 (0xff000000, 4, UnitPixel, &pen));
+	C (GdipSetPenLineJoin (pen, LineJoinRound));
+
+	start = clock ();
+	for (i = 0; i < HIT_TESTS; i++) {
+		C (GdipIsOutlineVisiblePathPoint (path, (float) (i % 1000) * 10, 1000, pen, NULL, &visible));
+		/* every other point is a vertex of the zigzag */
+		if ((i & 1) == 0)
+			assert (visible);
+	}
+	report_timing ("GdipIsOutlineVisiblePathPoint (%d x %d points): %.1f ms\n", HIT_TESTS, VERTICES, elapsed (start));
+
+	/* on a vertex, then far away */
+	C (GdipIsOutlineVisiblePathPoint (path, 0, 0, pen, NULL, &visible));
+	assert (visible);
+	C (GdipIsOutlineVisiblePathPoint (path, -100, -100, pen, NULL, &visible));
+	assert (!visible);
+
+	start = clock ();
+	C (GdipWidenPath (path, pen, NULL, 0.25));
+	report_timing ("GdipWidenPath (%d points): %.1f ms\n", VERTICES, elapsed (start));
+
+	C (GdipGetPointCount (path, &count));
+	assert (count > VERTICES);
+	assert (get_figure_count (path) == 1);
+	C (GdipIsVisiblePathPoint (path, 0, 0, NULL, &visible));
+	assert (visible);
+	C (GdipIsVisiblePathPoint (path, -100, -100, NULL, &visible));
+	assert (!visible);
+
+	C (GdipDeletePen (pen));
+	C (GdipDeletePath (path));
+}
+
+int
+main(int argc, char**argv)
+{
+	GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	test_widen_line ();
+	test_widen_single_outline ();
+	test_widen_benchmark ();
+
+	GdiplusShutdown(gdiplusToken);
+	return 0;
+}